@@ -17,7 +17,9 @@ THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "ComputerName.h"
 #include "DMBridgeException.h"
 #include "Logger.h"
-#include "RegistryUtils.h"
+#include "RpcMetrics.h"
+#include "Tracing.h"
+#include "RegistryStore.h"
 
 constexpr wchar_t* TcpNameKey = L"system\\currentcontrolset\\services\\tcpip\\parameters";
 constexpr wchar_t* TcpNameValue = L"NV HostName";
@@ -31,20 +33,30 @@ using namespace std;
 
 // Define the private mutex
 mutex ComputerName::_setNameMutex;
+mutex ComputerName::_refreshMutex;
+atomic<bool> ComputerName::_watching(false);
+Utils::AtomicSnapshot<ComputerName::Names> ComputerName::_names;
+shared_ptr<Utils::IRegistryStore> ComputerName::_registryStore = make_shared<Utils::Win32RegistryStore>();
 
 /* Map Generated rpc method signatures to class */
 /* -------------------------------------------- */
 HRESULT SetComputerNameRpc(_In_ handle_t, _In_ const wchar_t *computerName)
 {
-	return ComputerName::Set(computerName);
+	TRACE_SPAN(span, "rpc");
+	RPC_METRICS_SCOPE(metrics);
+	return metrics.Complete(ComputerName::Set(computerName));
 }
 HRESULT GetComputerNameRpc(_In_ handle_t, _Outptr_ long *size, _Outptr_ wchar_t **computerName)
 {
-	return ComputerName::Get(*size, *computerName);
+	TRACE_SPAN(span, "rpc");
+	RPC_METRICS_SCOPE(metrics);
+	return metrics.Complete(ComputerName::Get(*size, *computerName));
 }
 HRESULT IsComputerRenamePendingRpc(_In_ handle_t, _Outptr_ BOOL* isPending)
 {
-	return ComputerName::IsRenamePending(isPending);
+	TRACE_SPAN(span, "rpc");
+	RPC_METRICS_SCOPE(metrics);
+	return metrics.Complete(ComputerName::IsRenamePending(isPending));
 }
 /* -------------------------------------------- */
 
@@ -74,6 +86,9 @@ HRESULT ComputerName::Set(_In_ const wstring& computerName)
 			TRACEP("Failed to set computer name. Error: ", result);
 			return HRESULT_FROM_WIN32(result);
 		}
+
+		// Do not wait for the registry notification to report the new name.
+		Refresh();
 	}
 	catch (...)
 	{
@@ -96,30 +111,30 @@ HRESULT ComputerName::Get(_Outptr_ long &size, _Outptr_ wchar_t *&computerName)
 
 	try
 	{
-		wchar_t buffer[MAX_COMPUTERNAME_LENGTH + 1] = { 0 };
-		size = sizeof(buffer) / sizeof(wchar_t);
-		DWORD dwSize = static_cast<DWORD>(size);
-
-		if (!GetComputerNameEx(ComputerNamePhysicalNetBIOS, buffer, &dwSize))
-		{
-			DWORD lastError = GetLastError();
-			TRACEP("Failed to GetComputerNameEx(). Error: ", lastError);
-			return HRESULT_FROM_WIN32(lastError);
-		}
-
-		computerName = (wchar_t*)midl_user_allocate(size * sizeof(wchar_t));
-		if (computerName == NULL)
-		{
-			TRACE("Failed to get computer name. Could not allocate memory.");
-			return E_OUTOFMEMORY;
-		}
-
-		errno_t copyErr = wcscpy_s(computerName, size, (const wchar_t*)(buffer));
-		if (copyErr != 0)
+		return ReadNames([&size, &computerName](const Names& names)
 		{
-			TRACEP("Failed to get computer name. Could not copy buffer to out pointer. Errno: ", copyErr);
-			return E_FAIL;
-		}
+			if (FAILED(names.activeResult))
+			{
+				TRACEP("Failed to GetComputerNameEx(). Error: ", names.activeResult);
+				return names.activeResult;
+			}
+
+			size = MAX_COMPUTERNAME_LENGTH + 1;
+			computerName = (wchar_t*)midl_user_allocate(size * sizeof(wchar_t));
+			if (computerName == NULL)
+			{
+				TRACE("Failed to get computer name. Could not allocate memory.");
+				return E_OUTOFMEMORY;
+			}
+
+			errno_t copyErr = wcscpy_s(computerName, size, names.active.c_str());
+			if (copyErr != 0)
+			{
+				TRACEP("Failed to get computer name. Could not copy buffer to out pointer. Errno: ", copyErr);
+				return E_FAIL;
+			}
+			return S_OK;
+		});
 	}
 	catch (...)
 	{
@@ -132,8 +147,6 @@ HRESULT ComputerName::Get(_Outptr_ long &size, _Outptr_ wchar_t *&computerName)
 		}
 		return HRESULT_FROM_WIN32(lastError);
 	}
-
-	return S_OK;
 }
 
 HRESULT ComputerName::IsRenamePending(_Outptr_ BOOL* isPending)
@@ -146,43 +159,30 @@ HRESULT ComputerName::IsRenamePending(_Outptr_ BOOL* isPending)
 		return HRESULT_FROM_WIN32(ERROR_BAD_ARGUMENTS);
 	}
 
-	// Treat this method as an atomic operation
-	TRACE("Aquiring lock");
-	lock_guard<mutex> lock(_setNameMutex);
-	TRACE("Lock aquired");
-
 	*isPending = false;
 
 	try
 	{
-		wstring pendingName;
-		wstring activeName;
-
-		if (Utils::TryReadRegistryValue(CompNameKey1, CompNameValue, pendingName) != ERROR_SUCCESS)
-		{
-			DWORD lastError = GetLastError();
-			TRACEP("Failed to get registry computer name. Error: ", lastError);
-			return HRESULT_FROM_WIN32(lastError);
-		}
-
-		wchar_t buffer[MAX_COMPUTERNAME_LENGTH + 1] = { 0 };
-		size_t dwSize_t = sizeof(buffer) / sizeof(wchar_t);
-		DWORD dwSize = static_cast<DWORD>(dwSize_t);
-
-		if (!GetComputerNameEx(ComputerNamePhysicalNetBIOS, buffer, &dwSize))
+		return ReadNames([isPending](const Names& names)
 		{
-			DWORD lastError = GetLastError();
-			TRACEP("Failed to GetComputerNameEx(). Error: ", lastError);
-			return HRESULT_FROM_WIN32(lastError);
-		}
-
-		activeName = wstring(buffer);
-
-		if (_wcsicmp(pendingName.c_str(), activeName.c_str()) != 0)
-		{
-			TRACE("Name change is pending");
-			*isPending = true;
-		}
+			if (FAILED(names.pendingResult))
+			{
+				TRACEP("Failed to get registry computer name. Error: ", names.pendingResult);
+				return names.pendingResult;
+			}
+			if (FAILED(names.activeResult))
+			{
+				TRACEP("Failed to GetComputerNameEx(). Error: ", names.activeResult);
+				return names.activeResult;
+			}
+
+			if (_wcsicmp(names.pending.c_str(), names.active.c_str()) != 0)
+			{
+				TRACE("Name change is pending");
+				*isPending = true;
+			}
+			return S_OK;
+		});
 	}
 	catch (const DMBridgeExceptionWithErrorCode& e)
 	{
@@ -205,8 +205,64 @@ HRESULT ComputerName::IsRenamePending(_Outptr_ BOOL* isPending)
 		}
 		return HRESULT_FROM_WIN32(lastError);
 	}
+}
 
-	return S_OK;
+void ComputerName::StartWatching()
+{
+	TRACE(__FUNCTION__);
+
+	_registryStore->WatchKey(CompNameKey1, []()
+	{
+		TRACE("Pending computer name changed");
+		Refresh();
+	});
+	Refresh();
+	_watching = true;
+}
+
+void ComputerName::Refresh()
+{
+	// Serialize refreshes so an older read is never published over a newer one.
+	lock_guard<mutex> lock(_refreshMutex);
+
+	unique_ptr<Names> names(new Names());
+
+	wchar_t buffer[MAX_COMPUTERNAME_LENGTH + 1] = { 0 };
+	DWORD dwSize = static_cast<DWORD>(sizeof(buffer) / sizeof(wchar_t));
+	if (GetComputerNameEx(ComputerNamePhysicalNetBIOS, buffer, &dwSize))
+	{
+		names->active = buffer;
+		names->activeResult = S_OK;
+	}
+	else
+	{
+		names->activeResult = HRESULT_FROM_WIN32(GetLastError());
+	}
+
+	LSTATUS status = _registryStore->TryReadValue(CompNameKey1, CompNameValue, names->pending);
+	names->pendingResult = HRESULT_FROM_WIN32(status);
+
+	_names.Publish(move(names));
+}
+
+// Readers share the cached names without locking. The names are read again
+// first when they are not being watched, or when the last read failed.
+template<class Read>
+HRESULT ComputerName::ReadNames(Read read)
+{
+	bool current = _watching && _names.Read([](const Names* names)
+	{
+		return names != nullptr && SUCCEEDED(names->activeResult) && SUCCEEDED(names->pendingResult);
+	});
+	if (!current)
+	{
+		Refresh();
+	}
+
+	return _names.Read([&read](const Names* names)
+	{
+		return read(*names);
+	});
 }
 
 /*
@@ -224,31 +280,21 @@ long ComputerName::UpdateNameInRegistry(_In_ const wstring& computerName)
 	TRACE("Lock aquired");
 	TRACEP(L"Setting computer name to: ", computerName);
 
-	const wchar_t* wcharComputerName = computerName.c_str();
-
-	size_t len = (wcslen(wcharComputerName) + 1) * sizeof(wchar_t);
-	DWORD dwLen = static_cast<DWORD>(len);
-
-	long result = ERROR_SUCCESS;
-	result = RegSetKeyValue(HKEY_LOCAL_MACHINE, CompNameKey1, CompNameValue, REG_SZ, (LPBYTE)wcharComputerName, dwLen);
-	if (result != ERROR_SUCCESS)
-	{
-		TRACEP(L"Failed to update registry key: ", CompNameKey1);
-		return result;
-	}
-
-	result = RegSetKeyValue(HKEY_LOCAL_MACHINE, CompNameKey2, CompNameValue, REG_SZ, (LPBYTE)wcharComputerName, dwLen);
-	if (result != ERROR_SUCCESS)
+	// All three names are updated or none is, so a failed rename cannot leave
+	// them disagreeing.
+	try
 	{
-		TRACEP(L"Failed to update registry key: ", CompNameKey2);
-		return result;
+		_registryStore->WriteValues({
+			{ CompNameKey1, CompNameValue, computerName },
+			{ CompNameKey2, CompNameValue, computerName },
+			{ TcpNameKey, TcpNameValue, computerName }
+		});
 	}
-
-	result = RegSetKeyValue(HKEY_LOCAL_MACHINE, TcpNameKey, TcpNameValue, REG_SZ, (LPBYTE)wcharComputerName, dwLen);
-	if (result != ERROR_SUCCESS)
+	catch (const DMBridgeExceptionWithErrorCode& e)
 	{
-		TRACEP(L"Failed to update registry key: ", TcpNameKey);
-		return result;
+		TRACEP(L"Failed to update registry computer name. Error: ", e.ErrorCode());
+		// Prevent a 0'd error from returning ERROR_SUCCESS
+		return e.ErrorCode() == ERROR_SUCCESS ? ERROR_GEN_FAILURE : e.ErrorCode();
 	}
 
 	return ERROR_SUCCESS;
@@ -261,6 +307,7 @@ long ComputerName::UpdateNameInRegistry(_In_ const wstring& computerName)
 bool ComputerName::IsValidName(_In_ const wstring& computerName)
 {
 	TRACE(__FUNCTION__);
+	TRACE_SPAN(span, "validation");
 
 	wregex allowedCharacters(L"^[a-zA-Z0-9\-.]+$");
 	wcmatch match;
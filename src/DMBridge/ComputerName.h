@@ -16,6 +16,10 @@ THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #pragma once
 
 #include "stdafx.h"
+#include <atomic>
+#include <memory>
+#include "AtomicSnapshot.h"
+#include "RegistryStore.h"
 
 class ComputerName
 {
@@ -24,9 +28,37 @@ public:
 	static HRESULT Set(_In_ const std::wstring&);
 	static HRESULT IsRenamePending(_Outptr_ BOOL* isPending);
 
+	// Replaces the system registry; must be called before the RPC server starts.
+	static void ApplyRegistryStore(const std::shared_ptr<Utils::IRegistryStore>& registryStore)
+	{
+		_watching = false;
+		_registryStore = registryStore;
+	}
+
+	// Caches the active and pending names and refreshes them when the pending
+	// name changes in the registry. Until then, every call reads both names.
+	static void StartWatching();
+
 private:
+	// Read together, so a caller never compares names from different moments.
+	struct Names
+	{
+		std::wstring active;
+		HRESULT activeResult;
+		std::wstring pending;
+		HRESULT pendingResult;
+	};
+
 	static bool IsValidName(_In_ const std::wstring&);
 	static long UpdateNameInRegistry(_In_ const std::wstring&);
+	static void Refresh();
+
+	template<class Read>
+	static HRESULT ReadNames(Read read);
 
 	static std::mutex _setNameMutex;
+	static std::mutex _refreshMutex;
+	static std::atomic<bool> _watching;
+	static Utils::AtomicSnapshot<Names> _names;
+	static std::shared_ptr<Utils::IRegistryStore> _registryStore;
 };
\ No newline at end of file
@@ -0,0 +1,58 @@
+/*
+Copyright 2018 Microsoft
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH
+THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "stdafx.h"
+#include "ConfigBinder.h"
+
+using namespace std;
+using namespace Utils;
+
+namespace ConfigBinding
+{
+	wstring Position(const JsonTokenizer& tokenizer)
+	{
+		return L"line " + to_wstring(tokenizer.Line()) + L", column " + to_wstring(tokenizer.Column());
+	}
+
+	bool ReadStringList(JsonTokenizer& tokenizer, JsonToken first, const wstring& listName, vector<wstring>& list)
+	{
+		list.clear();
+		if (first != JsonToken::BeginArray)
+		{
+			TRACEP(L"Warning: Not an array, ignoring it: ", listName + L" at " + Position(tokenizer));
+			tokenizer.SkipValue(first);
+			return false;
+		}
+
+		for (JsonToken token = tokenizer.Next(); token != JsonToken::EndArray; token = tokenizer.Next())
+		{
+			if (token != JsonToken::String)
+			{
+				TRACEP(L"Warning: Non-string in ", listName + L" at " + Position(tokenizer));
+				tokenizer.SkipValue(token);
+				continue;
+			}
+
+			wstring str = MultibyteToWide(tokenizer.Text().c_str());
+			if (str.size() == 0)
+			{
+				TRACEP(L"Warning: Empty string in ", listName + L" at " + Position(tokenizer));
+				continue;
+			}
+			list.push_back(move(str));
+		}
+		return true;
+	}
+}
@@ -0,0 +1,167 @@
+/*
+Copyright 2018 Microsoft
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH
+THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include "stdafx.h"
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+#include "JsonTokenizer.h"
+#include "Logger.h"
+#include "StringUtils.h"
+
+namespace ConfigBinding
+{
+	// "line 3, column 14", for warnings about the last token.
+	std::wstring Position(const Utils::JsonTokenizer& tokenizer);
+
+	// Reads an array of non-empty strings; other elements are skipped with a
+	// warning. Returns false, having skipped the value, if it is not an array.
+	bool ReadStringList(Utils::JsonTokenizer& tokenizer, Utils::JsonToken first, const std::wstring& listName, std::vector<std::wstring>& list);
+}
+
+// Fills a settings struct straight from the tokens of a config file, from a
+// schema of the members to bind. Members that are not bound are skipped and
+// no Json::Value is built. As with Json::Value, the last of several members
+// with the same name wins.
+template<class T>
+class ConfigBinder
+{
+public:
+	struct Field
+	{
+		// Reads the member's value, whose first token is 'first'.
+		std::function<void(Utils::JsonTokenizer& tokenizer, Utils::JsonToken first, T& target)> read;
+
+		// Undoes 'read', for a member that is set again.
+		std::function<void(T& target)> reset;
+	};
+
+	// Binds the member at 'path', e.g. { "servicemanager", "whitelist" }.
+	ConfigBinder& Bind(const std::vector<std::string>& path, const Field& field)
+	{
+		Node* node = &_root;
+		for (const std::string& name : path)
+		{
+			Node* member = node->Find(name);
+			if (member == nullptr)
+			{
+				node->members.emplace_back(new Node(name));
+				member = node->members.back().get();
+			}
+			node = member;
+		}
+		node->field = field;
+		return *this;
+	}
+
+	// Binds 'list' to an array of strings, and 'isSet' to whether the member
+	// was an array.
+	static Field StringList(std::vector<std::wstring> T::* list, bool T::* isSet, const std::wstring& listName)
+	{
+		Field field;
+		field.read = [list, isSet, listName](Utils::JsonTokenizer& tokenizer, Utils::JsonToken first, T& target)
+		{
+			target.*isSet = ConfigBinding::ReadStringList(tokenizer, first, listName, target.*list);
+		};
+		field.reset = [list, isSet](T& target)
+		{
+			(target.*list).clear();
+			target.*isSet = false;
+		};
+		return field;
+	}
+
+	// Throws Utils::JsonSyntaxError for malformed JSON, or for a root that is
+	// not an object. 'target' may have been partly filled by then.
+	void Parse(const char* begin, const char* end, T& target) const
+	{
+		Utils::JsonTokenizer tokenizer(begin, end);
+		if (tokenizer.Next() != Utils::JsonToken::BeginObject)
+		{
+			tokenizer.Fail("Expected the config to be an object");
+		}
+		ParseObject(tokenizer, _root, target);
+	}
+
+private:
+	struct Node
+	{
+		Node(const std::string& name = std::string()) :
+			name(name)
+		{}
+
+		Node* Find(const std::string& memberName) const
+		{
+			for (const std::unique_ptr<Node>& member : members)
+			{
+				if (member->name == memberName)
+				{
+					return member.get();
+				}
+			}
+			return nullptr;
+		}
+
+		std::string name;
+		std::vector<std::unique_ptr<Node>> members;
+		Field field;
+	};
+
+	static void ParseObject(Utils::JsonTokenizer& tokenizer, const Node& node, T& target)
+	{
+		for (Utils::JsonToken token = tokenizer.Next(); token != Utils::JsonToken::EndObject; token = tokenizer.Next())
+		{
+			const Node* member = node.Find(tokenizer.Text());
+			Utils::JsonToken first = tokenizer.Next();
+			if (member == nullptr)
+			{
+				tokenizer.SkipValue(first);
+				continue;
+			}
+
+			Reset(*member, target);
+			if (member->field.read)
+			{
+				member->field.read(tokenizer, first, target);
+			}
+			else if (first == Utils::JsonToken::BeginObject)
+			{
+				ParseObject(tokenizer, *member, target);
+			}
+			else
+			{
+				TRACEP(L"Warning: Config section is not an object, ignoring it: ", Utils::MultibyteToWide(member->name.c_str()) + L" at " + ConfigBinding::Position(tokenizer));
+				tokenizer.SkipValue(first);
+			}
+		}
+	}
+
+	static void Reset(const Node& node, T& target)
+	{
+		if (node.field.reset)
+		{
+			node.field.reset(target);
+		}
+		for (const std::unique_ptr<Node>& member : node.members)
+		{
+			Reset(*member, target);
+		}
+	}
+
+	Node _root;
+};
@@ -0,0 +1,349 @@
+/*
+Copyright 2018 Microsoft
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH
+THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "stdafx.h"
+#include <cstring>
+#include "ConfigCache.h"
+#include "JsonTokenizer.h"
+#include "Logger.h"
+#include "MappedFile.h"
+#include "StringUtils.h"
+#include "Tracing.h"
+
+using namespace std;
+using namespace ConfigUtils;
+
+namespace
+{
+	const char Magic[4] = { 'D', 'M', 'B', 'C' };
+
+	// Header::flags
+	const uint32_t HasApiList = 0x1;
+	const uint32_t HasWhitelist = 0x2;
+
+	struct Header
+	{
+		char magic[4];
+		uint32_t formatVersion;
+		uint32_t charSize;
+		uint32_t flags;
+		uint64_t sourceSize;
+		uint64_t sourceLastWriteTime;
+		uint64_t sourceHash;
+		uint64_t payloadSize;
+		uint64_t checksum;
+	};
+
+	// The checksum only has to catch a torn or corrupted file.
+	uint64_t Checksum(const char* data, size_t size)
+	{
+		return ContentHash(data, size);
+	}
+
+	size_t Padded(size_t size)
+	{
+		return (size + 3) & ~static_cast<size_t>(3);
+	}
+
+	void Append(vector<char>& data, const void* value, size_t size)
+	{
+		const char* bytes = static_cast<const char*>(value);
+		data.insert(data.end(), bytes, bytes + size);
+	}
+
+	void AppendStrings(vector<char>& data, const vector<wstring>& strings)
+	{
+		uint32_t count = static_cast<uint32_t>(strings.size());
+		Append(data, &count, sizeof(count));
+		for (const wstring& str : strings)
+		{
+			uint32_t length = static_cast<uint32_t>(str.size());
+			Append(data, &length, sizeof(length));
+			Append(data, str.data(), length * sizeof(wchar_t));
+			data.resize(Padded(data.size()), 0);
+		}
+	}
+
+	// Reads the payload, failing instead of reading past its end.
+	class PayloadReader
+	{
+	public:
+		PayloadReader(const char* data, size_t size) :
+			_data(data),
+			_size(size),
+			_offset(0)
+		{}
+
+		bool ReadStrings(vector<wstring>& strings)
+		{
+			uint32_t count = 0;
+			if (!Read(&count, sizeof(count)))
+			{
+				return false;
+			}
+
+			strings.clear();
+			for (uint32_t i = 0; i < count; ++i)
+			{
+				uint32_t length = 0;
+				if (!Read(&length, sizeof(length)) || length > (_size - _offset) / sizeof(wchar_t))
+				{
+					return false;
+				}
+
+				strings.emplace_back(length, L'\0');
+				if (!Read(&strings.back()[0], length * sizeof(wchar_t)))
+				{
+					return false;
+				}
+				_offset = Padded(_offset);
+			}
+			return true;
+		}
+
+		bool AtEnd() const
+		{
+			return _offset == _size;
+		}
+
+	private:
+		bool Read(void* value, size_t size)
+		{
+			if (size > _size - _offset)
+			{
+				return false;
+			}
+			memcpy(value, _data + _offset, size);
+			_offset += size;
+			return true;
+		}
+
+		const char* _data;
+		size_t _size;
+		size_t _offset;
+	};
+
+	bool ReadCacheFile(const wstring& cacheFile, vector<char>& data)
+	{
+		ifstream file(Utils::FileStreamName(cacheFile), ifstream::binary | ifstream::ate);
+		if (!file.good())
+		{
+			return false;
+		}
+
+		streamoff size = file.tellg();
+		if (size <= 0)
+		{
+			return false;
+		}
+		data.resize(static_cast<size_t>(size));
+		file.seekg(0);
+		return file.read(data.data(), data.size()).good();
+	}
+
+	bool TryReadHeader(const char* data, size_t size, Header& header)
+	{
+		if (size < sizeof(header))
+		{
+			return false;
+		}
+		memcpy(&header, data, sizeof(header));
+
+		if (memcmp(header.magic, Magic, sizeof(Magic)) != 0 ||
+			header.formatVersion != ConfigCache::FormatVersion ||
+			header.charSize != sizeof(wchar_t) ||
+			header.payloadSize != size - sizeof(header))
+		{
+			TRACE(L"Config cache is not in the current format");
+			return false;
+		}
+		return true;
+	}
+
+	bool TryReadPayload(const char* data, const Header& header, CompiledConfig& config)
+	{
+		const char* payload = data + sizeof(header);
+		if (Checksum(payload, static_cast<size_t>(header.payloadSize)) != header.checksum)
+		{
+			TRACE(L"Warning: Config cache failed its checksum");
+			return false;
+		}
+
+		CompiledConfig newConfig;
+		newConfig.hasApiList = (header.flags & HasApiList) != 0;
+		newConfig.hasWhitelist = (header.flags & HasWhitelist) != 0;
+		PayloadReader reader(payload, static_cast<size_t>(header.payloadSize));
+		if (!reader.ReadStrings(newConfig.apiList) || !reader.ReadStrings(newConfig.whitelist) || !reader.AtEnd())
+		{
+			TRACE(L"Warning: Config cache is malformed");
+			return false;
+		}
+
+		config = newConfig;
+		return true;
+	}
+
+	// Points a cache at another version of the same content.
+	void SetSource(vector<char>& data, const FileVersion& source)
+	{
+		Header header;
+		memcpy(&header, data.data(), sizeof(header));
+		header.sourceSize = source.size;
+		header.sourceLastWriteTime = source.lastWriteTime;
+		memcpy(data.data(), &header, sizeof(header));
+	}
+
+	// The cache only saves time; failing to write it is not an error.
+	void WriteCacheFile(const wstring& cacheFile, const vector<char>& data)
+	{
+		// Replace the file in one step so a crash never leaves it half written.
+		wstring tempFileName = cacheFile + L".tmp";
+		{
+			ofstream file(Utils::FileStreamName(tempFileName), ofstream::binary | ofstream::trunc);
+			file.write(data.data(), data.size());
+			if (!file.good())
+			{
+				TRACEP(L"Warning: Failed to write config cache: ", tempFileName);
+				return;
+			}
+		}
+
+		if (!MoveFileEx(tempFileName.c_str(), cacheFile.c_str(), MOVEFILE_REPLACE_EXISTING))
+		{
+			TRACEP(L"Warning: Failed to replace config cache. Error: ", GetLastError());
+			DeleteFile(tempFileName.c_str());
+		}
+	}
+}
+
+namespace ConfigCache
+{
+	const CompiledConfig Load(const wstring& configFile)
+	{
+		TRACE(__FUNCTION__);
+		TRACE_SPAN(span, "config");
+
+		// Taken before the file is parsed, so a change made while parsing
+		// leaves a cache that the next start sees as out of date.
+		FileVersion source;
+		if (!TryGetFileVersion(configFile, source))
+		{
+			TRACEP(L"Config file not found, applying defaults: ", configFile);
+			return CompiledConfig();
+		}
+
+		wstring cacheFile = GetCacheFilePath(configFile);
+		vector<char> data;
+		bool hasCache = ReadCacheFile(cacheFile, data);
+		CompiledConfig config;
+		if (hasCache && TryDeserialize(data.data(), data.size(), source, config))
+		{
+			TRACEP(L"Using compiled config: ", cacheFile);
+			return config;
+		}
+
+		try
+		{
+			Utils::MappedFile mapped(configFile);
+			uint64_t sourceHash = ContentHash(mapped.Data(), mapped.Size());
+			if (hasCache && TryDeserializeContent(data.data(), data.size(), sourceHash, config))
+			{
+				// Touched or written again unchanged, e.g. by a deployment.
+				TRACEP(L"Config file content is unchanged, using compiled config: ", cacheFile);
+				SetSource(data, source);
+			}
+			else
+			{
+				try
+				{
+					config = CompileConfig(mapped.Data(), mapped.Data() + mapped.Size());
+				}
+				catch (const Utils::JsonSyntaxError&)
+				{
+					TraceSyntaxErrors(mapped.Data(), mapped.Data() + mapped.Size());
+					throw;
+				}
+				data = Serialize(config, source, sourceHash);
+			}
+		}
+		catch (const exception& e)
+		{
+			TRACEP(L"Failed to load config file, applying defaults. Error: ", e.what());
+			return CompiledConfig();
+		}
+
+		WriteCacheFile(cacheFile, data);
+		return config;
+	}
+
+	const wstring GetCacheFilePath(const wstring& configFile)
+	{
+		return configFile + L".cache";
+	}
+
+	const vector<char> Serialize(const CompiledConfig& config, const FileVersion& source, uint64_t sourceHash)
+	{
+		vector<char> payload;
+		AppendStrings(payload, config.apiList);
+		AppendStrings(payload, config.whitelist);
+
+		Header header = {};
+		memcpy(header.magic, Magic, sizeof(Magic));
+		header.formatVersion = FormatVersion;
+		header.charSize = sizeof(wchar_t);
+		header.flags = (config.hasApiList ? HasApiList : 0) | (config.hasWhitelist ? HasWhitelist : 0);
+		header.sourceSize = source.size;
+		header.sourceLastWriteTime = source.lastWriteTime;
+		header.sourceHash = sourceHash;
+		header.payloadSize = payload.size();
+		header.checksum = Checksum(payload.data(), payload.size());
+
+		vector<char> data;
+		data.reserve(sizeof(header) + payload.size());
+		Append(data, &header, sizeof(header));
+		data.insert(data.end(), payload.begin(), payload.end());
+		return data;
+	}
+
+	bool TryDeserialize(const char* data, size_t size, const FileVersion& source, CompiledConfig& config)
+	{
+		Header header;
+		if (!TryReadHeader(data, size, header))
+		{
+			return false;
+		}
+		if (header.sourceSize != source.size || header.sourceLastWriteTime != source.lastWriteTime)
+		{
+			TRACE(L"Config cache is out of date");
+			return false;
+		}
+		return TryReadPayload(data, header, config);
+	}
+
+	bool TryDeserializeContent(const char* data, size_t size, uint64_t sourceHash, CompiledConfig& config)
+	{
+		Header header;
+		if (!TryReadHeader(data, size, header))
+		{
+			return false;
+		}
+		if (header.sourceHash != sourceHash)
+		{
+			TRACE(L"Config cache was compiled from other content");
+			return false;
+		}
+		return TryReadPayload(data, header, config);
+	}
+}
@@ -0,0 +1,53 @@
+/*
+Copyright 2018 Microsoft
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH
+THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include "stdafx.h"
+#include <vector>
+#include "ConfigUtils.h"
+
+// A binary form of the compiled config, kept next to the config file, so a
+// service start whose config file has not changed reads one small file
+// instead of parsing JSON and converting every string.
+//
+// Layout, in native byte order: a Header, then the API list and the
+// whitelist, each a uint32_t count followed by that many strings. A string is
+// a uint32_t length followed by its wchar_t units, padded to 4 bytes. Nothing
+// is stored as a pointer or offset, so the file can be read in place.
+namespace ConfigCache
+{
+	constexpr uint32_t FormatVersion = 2;
+
+	// Returns the config compiled from 'configFile': from its cache when the
+	// cache was compiled from the file as it is now, otherwise by parsing the
+	// file and writing the cache for the next start. A file whose size or
+	// last write time changed but whose content hash did not is not parsed
+	// again; only the cache is rewritten. A file that is missing or fails to
+	// parse compiles to the defaults and is not cached.
+	const ConfigUtils::CompiledConfig Load(const std::wstring& configFile);
+
+	const std::wstring GetCacheFilePath(const std::wstring& configFile);
+
+	// 'sourceHash' is ConfigUtils::ContentHash() of the source.
+	const std::vector<char> Serialize(const ConfigUtils::CompiledConfig& config, const ConfigUtils::FileVersion& source, uint64_t sourceHash);
+
+	// Fails for data that is truncated, fails its checksum, was written by
+	// another format version, or was compiled from another version of the source.
+	bool TryDeserialize(const char* data, size_t size, const ConfigUtils::FileVersion& source, ConfigUtils::CompiledConfig& config);
+
+	// As TryDeserialize(), but only fails for a source with different content.
+	bool TryDeserializeContent(const char* data, size_t size, uint64_t sourceHash, ConfigUtils::CompiledConfig& config);
+}
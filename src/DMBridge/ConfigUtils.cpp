@@ -14,46 +14,84 @@ THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 */
 
 #include "stdafx.h"
+#include <cstring>
+#include "ConfigBinder.h"
 #include "ConfigUtils.h"
 #include "Constants.h"
-#include "RegistryUtils.h"
+#include "JsonPushParser.h"
+#include "JsonTokenizer.h"
+#include "MappedFile.h"
+#include "RegistryStore.h"
+#include "StringUtils.h"
+#include "Tracing.h"
+
+constexpr const char* ApiKey = "api";
+constexpr const char* NTServiceSection = "servicemanager";
+constexpr const char* WhitelistKey = "whitelist";
 
 using namespace std;
 using namespace Json;
 
-namespace ConfigUtils
+namespace
 {
-	const Json::Value SafelyGetSection(const Json::Value& root, const std::string& section)
-	{
-		TRACE(__FUNCTION__);
-		try
-		{
-			return root[section];
-		}
-		catch (const Json::LogicError& e)
-		{
-			TRACEP(L"Failed to get JSON section. Error: ", e.what());
-		}
-
-		return new Json::Value();
-	}
+	const uint64_t Prime1 = 11400714785074694791ull;
+	const uint64_t Prime2 = 14029467366897019727ull;
+	const uint64_t Prime3 = 1609587929392839161ull;
+	const uint64_t Prime4 = 9650029242287828579ull;
+	const uint64_t Prime5 = 2870177450012600261ull;
+
+	uint64_t RotateLeft(uint64_t value, int bits)
+	{
+		return (value << bits) | (value >> (64 - bits));
+	}
+
+	// Native byte order, which is little endian on every target.
+	uint64_t Read64(const char* data)
+	{
+		uint64_t value;
+		memcpy(&value, data, sizeof(value));
+		return value;
+	}
 
+	uint32_t Read32(const char* data)
+	{
+		uint32_t value;
+		memcpy(&value, data, sizeof(value));
+		return value;
+	}
+
+	uint64_t Round(uint64_t accumulator, uint64_t input)
+	{
+		accumulator += input * Prime2;
+		return RotateLeft(accumulator, 31) * Prime1;
+	}
+
+	uint64_t MergeRound(uint64_t hash, uint64_t accumulator)
+	{
+		hash ^= Round(0, accumulator);
+		return hash * Prime1 + Prime4;
+	}
+}
+
+namespace ConfigUtils
+{
 	const Value LoadConfigFile()
+	{
+		return LoadConfigFile(Utils::Win32RegistryStore());
+	}
+
+	const Value LoadConfigFile(const Utils::IRegistryStore& registryStore)
 	{
 		TRACE(__FUNCTION__);
+		TRACE_SPAN(span, "config");
 
-		wstring file = DefaultConfigFile;
-		if (Utils::TryReadRegistryValue(IoTDMRegistryRoot, RegConfigFile, file) == ERROR_SUCCESS)
+		try
 		{
-			if (file.length() == 0)
-			{
-				file = DefaultConfigFile;
-			}
+			return ParseJSONFile(GetConfigFilePath(registryStore));
 		}
-
-		try
+		catch (const Utils::JsonSyntaxError& e)
 		{
-			return ParseJSONFile(file);
+			TRACEP(L"Failed to parse config file. Error: ", e.what());
 		}
 		catch (const std::runtime_error& e)
 		{
@@ -68,7 +106,134 @@ namespace ConfigUtils
 			TRACEP(L"Config error. Unknown exception caught. Error: ", GetLastError());
 		}
 
-		return new Json::Value();
+		return Json::Value();
+	}
+
+	const CompiledConfig CompileConfig(const string& text)
+	{
+		return CompileConfig(text.data(), text.data() + text.size());
+	}
+
+	const CompiledConfig CompileConfig(const char* begin, const char* end)
+	{
+		TRACE(__FUNCTION__);
+
+		typedef ConfigBinder<CompiledConfig> Binder;
+		static const Binder binder = []()
+		{
+			Binder schema;
+			schema.Bind({ ApiKey }, Binder::StringList(&CompiledConfig::apiList, &CompiledConfig::hasApiList, L"API list"));
+			schema.Bind({ NTServiceSection, WhitelistKey }, Binder::StringList(&CompiledConfig::whitelist, &CompiledConfig::hasWhitelist, L"whitelist"));
+			return schema;
+		}();
+
+		CompiledConfig config;
+		binder.Parse(begin, end, config);
+		return config;
+	}
+
+	const CompiledConfig CompileConfigFile(const wstring& file)
+	{
+		TRACE(__FUNCTION__);
+		TRACEP(L"Compiling config file: ", file);
+
+		Utils::MappedFile mapped(file);
+		try
+		{
+			return CompileConfig(mapped.Data(), mapped.Data() + mapped.Size());
+		}
+		catch (const Utils::JsonSyntaxError&)
+		{
+			TraceSyntaxErrors(mapped.Data(), mapped.Data() + mapped.Size());
+			throw;
+		}
+	}
+
+	void TraceSyntaxErrors(const char* begin, const char* end)
+	{
+		for (const Utils::JsonDiagnostic& diagnostic : Utils::ValidateJson(begin, end))
+		{
+			TRACEP(L"Config syntax error: ", diagnostic.ToString().c_str());
+		}
+	}
+
+	bool TryGetFileVersion(const wstring& file, FileVersion& version)
+	{
+		WIN32_FILE_ATTRIBUTE_DATA attributes;
+		if (!GetFileAttributesEx(file.c_str(), GetFileExInfoStandard, &attributes))
+		{
+			return false;
+		}
+
+		version.size = (static_cast<uint64_t>(attributes.nFileSizeHigh) << 32) | attributes.nFileSizeLow;
+		version.lastWriteTime = (static_cast<uint64_t>(attributes.ftLastWriteTime.dwHighDateTime) << 32) | attributes.ftLastWriteTime.dwLowDateTime;
+		return true;
+	}
+
+	uint64_t ContentHash(const char* data, size_t size)
+	{
+		const char* end = data + size;
+		uint64_t hash;
+		if (size >= 32)
+		{
+			// Four independent lanes, so the multiplies overlap.
+			uint64_t lanes[4] = { Prime1 + Prime2, Prime2, 0, 0 - Prime1 };
+			for (; end - data >= 32; data += 32)
+			{
+				for (int i = 0; i < 4; ++i)
+				{
+					lanes[i] = Round(lanes[i], Read64(data + 8 * i));
+				}
+			}
+
+			hash = RotateLeft(lanes[0], 1) + RotateLeft(lanes[1], 7) + RotateLeft(lanes[2], 12) + RotateLeft(lanes[3], 18);
+			for (uint64_t lane : lanes)
+			{
+				hash = MergeRound(hash, lane);
+			}
+		}
+		else
+		{
+			hash = Prime5;
+		}
+
+		hash += size;
+		for (; end - data >= 8; data += 8)
+		{
+			hash ^= Round(0, Read64(data));
+			hash = RotateLeft(hash, 27) * Prime1 + Prime4;
+		}
+		if (end - data >= 4)
+		{
+			hash ^= Read32(data) * Prime1;
+			hash = RotateLeft(hash, 23) * Prime2 + Prime3;
+			data += 4;
+		}
+		for (; data < end; ++data)
+		{
+			hash ^= static_cast<unsigned char>(*data) * Prime5;
+			hash = RotateLeft(hash, 11) * Prime1;
+		}
+
+		hash ^= hash >> 33;
+		hash *= Prime2;
+		hash ^= hash >> 29;
+		hash *= Prime3;
+		hash ^= hash >> 32;
+		return hash;
+	}
+
+	const wstring GetConfigFilePath(const Utils::IRegistryStore& registryStore)
+	{
+		wstring file = DefaultConfigFile;
+		if (registryStore.TryReadValue(IoTDMRegistryRoot, RegConfigFile, file) == ERROR_SUCCESS)
+		{
+			if (file.length() == 0)
+			{
+				file = DefaultConfigFile;
+			}
+		}
+		return file;
 	}
 
 	const Value ParseJSONFile(const wstring& file)
@@ -82,20 +247,22 @@ namespace ConfigUtils
 
 		TRACEP(L"Loading config file: ", file);
 
-		CharReaderBuilder builder;
-		ifstream jsonIfStream(file, ifstream::binary);
-		if (!jsonIfStream.good())
-		{
-			throw runtime_error("Failed to open config file");
-		}
-		string errs;
-		Value root;
-
-		if (!Json::parseFromStream(builder, jsonIfStream, &root, &errs))
-		{
-			Json::throwRuntimeError(errs);
+		// Parsed in place from the mapping, so the text is never copied onto
+		// the heap.
+		Utils::MappedFile mapped(file);
+		Utils::JsonValueBuilder builder;
+		Utils::JsonPushParser parser(builder);
+		try
+		{
+			parser.Feed(mapped.Data(), mapped.Size());
+			parser.Finish();
+		}
+		catch (const Utils::JsonSyntaxError&)
+		{
+			TraceSyntaxErrors(mapped.Data(), mapped.Data() + mapped.Size());
+			throw;
 		}
 
-		return root;
+		return move(builder.Root());
 	}
 }
\ No newline at end of file
@@ -17,10 +17,55 @@ THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 #include "stdafx.h"
 #include "Logger.h"
+#include "RegistryStore.h"
 
 namespace ConfigUtils
 {
+	// The settings the bridge reads from the config file, validated and with
+	// their strings converted. A list that is not set keeps its defaults.
+	struct CompiledConfig
+	{
+		bool hasApiList = false;
+		std::vector<std::wstring> apiList;
+		bool hasWhitelist = false;
+		std::vector<std::wstring> whitelist;
+	};
+
+	// Identifies a version of a file well enough to tell that it changed.
+	struct FileVersion
+	{
+		uint64_t size;
+		uint64_t lastWriteTime;
+
+		bool operator==(const FileVersion& other) const
+		{
+			return size == other.size && lastWriteTime == other.lastWriteTime;
+		}
+	};
+
 	const Json::Value LoadConfigFile(void);
+	const Json::Value LoadConfigFile(const Utils::IRegistryStore& registryStore);
+	const std::wstring GetConfigFilePath(const Utils::IRegistryStore& registryStore);
 	const Json::Value ParseJSONFile(const std::wstring& file);
-	const Json::Value SafelyGetSection(const Json::Value& root, const std::string& section);
+
+	// Compiles config file text straight from its tokens. Throws
+	// Utils::JsonSyntaxError, with the line and column, if it is malformed or
+	// not an object.
+	const CompiledConfig CompileConfig(const std::string& text);
+	const CompiledConfig CompileConfig(const char* begin, const char* end);
+
+	// Compiles the file in place, from a read-only mapping of it.
+	const CompiledConfig CompileConfigFile(const std::wstring& file);
+
+	// Traces every syntax error in config file text, not only the first one
+	// that stopped the parse, so a broken file can be fixed in one pass.
+	void TraceSyntaxErrors(const char* begin, const char* end);
+
+	bool TryGetFileVersion(const std::wstring& file, FileVersion& version);
+
+	// XXH64, with seed 0, of the file's bytes: tells a file whose content
+	// changed from one that was only touched or written again unchanged, at
+	// a fraction of the cost of parsing it. It is not meant to stand up to
+	// deliberate collisions.
+	uint64_t ContentHash(const char* data, size_t size);
 };
\ No newline at end of file
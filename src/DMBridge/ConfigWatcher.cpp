@@ -0,0 +1,152 @@
+/*
+Copyright 2018 Microsoft
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH
+THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "stdafx.h"
+#include "ConfigWatcher.h"
+#include "ConfigUtils.h"
+#include "DMBridgeException.h"
+#include "Logger.h"
+#include "MappedFile.h"
+#include "Tracing.h"
+
+using namespace std;
+
+ConfigWatcher::ConfigWatcher(const shared_ptr<Utils::IRegistryStore>& registryStore, const ApplyFunction& apply) :
+	_registryStore(registryStore),
+	_apply(apply),
+	_hasContentHash(false),
+	_contentHash(0),
+	_stopEvent(NULL)
+{
+	_version = CurrentVersion();
+	if (_version.exists)
+	{
+		try
+		{
+			Utils::MappedFile mapped(_version.path);
+			_contentHash = ConfigUtils::ContentHash(mapped.Data(), mapped.Size());
+			_hasContentHash = true;
+		}
+		catch (const exception&)
+		{
+			// The first change is applied whatever its content.
+		}
+	}
+}
+
+ConfigWatcher::~ConfigWatcher()
+{
+	if (_stopEvent == NULL)
+	{
+		return;
+	}
+
+	SetEvent(_stopEvent);
+	_thread.Join();
+	CloseHandle(_stopEvent);
+}
+
+void ConfigWatcher::Start(DWORD intervalMs)
+{
+	TRACE(__FUNCTION__);
+
+	_stopEvent = CreateEvent(NULL, TRUE /*manual reset*/, FALSE, NULL);
+	if (_stopEvent == NULL)
+	{
+		throw DMBridgeExceptionWithErrorCode("Failed to create config watch stop event.", GetLastError());
+	}
+
+	// Polling the file's attributes works for a config file on any volume and
+	// costs one file system and one registry query per interval.
+	_thread = thread([this, intervalMs]()
+	{
+		while (WaitForSingleObject(_stopEvent, intervalMs) == WAIT_TIMEOUT)
+		{
+			try
+			{
+				CheckForChanges();
+			}
+			catch (const DMBridgeExceptionWithErrorCode& e)
+			{
+				TRACEP("Failed to apply the changed config file. Error: ", e.ErrorCode());
+			}
+			catch (...)
+			{
+				TRACE("Failed to apply the changed config file. Unknown exception caught.");
+			}
+		}
+	});
+}
+
+bool ConfigWatcher::CheckForChanges()
+{
+	lock_guard<mutex> lock(_checkMutex);
+
+	FileVersion version = CurrentVersion();
+	if (version == _version)
+	{
+		return false;
+	}
+
+	// Remember the version before using it, so a file that fails is not
+	// tried again until it changes.
+	_version = version;
+	if (!version.exists)
+	{
+		TRACEP(L"Config file is missing, keeping the current config: ", version.path);
+		return false;
+	}
+
+	TRACE_SPAN(span, "config");
+	TRACEP(L"Config file changed: ", version.path);
+	ConfigUtils::CompiledConfig config;
+	uint64_t contentHash = 0;
+	try
+	{
+		Utils::MappedFile mapped(version.path);
+		contentHash = ConfigUtils::ContentHash(mapped.Data(), mapped.Size());
+		if (_hasContentHash && contentHash == _contentHash)
+		{
+			TRACE(L"Config file content is unchanged, keeping the current config");
+			return false;
+		}
+		config = ConfigUtils::CompileConfig(mapped.Data(), mapped.Data() + mapped.Size());
+	}
+	catch (const exception& e)
+	{
+		TRACEP(L"Failed to parse the changed config file, keeping the current config. Error: ", e.what());
+		return false;
+	}
+
+	_apply(config);
+	_contentHash = contentHash;
+	_hasContentHash = true;
+	return true;
+}
+
+ConfigWatcher::FileVersion ConfigWatcher::CurrentVersion() const
+{
+	FileVersion version = {};
+	version.path = ConfigUtils::GetConfigFilePath(*_registryStore);
+	version.exists = ConfigUtils::TryGetFileVersion(version.path, version.file);
+	return version;
+}
+
+bool ConfigWatcher::FileVersion::operator==(const FileVersion& other) const
+{
+	return path == other.path &&
+		exists == other.exists &&
+		(!exists || file == other.file);
+}
@@ -0,0 +1,70 @@
+/*
+Copyright 2018 Microsoft
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH
+THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include "stdafx.h"
+#include <functional>
+#include <memory>
+#include "ConfigUtils.h"
+#include "JoiningThread.h"
+#include "RegistryStore.h"
+
+// Applies the configuration file again whenever it changes, so edits to the
+// whitelist or to the enabled APIs take effect without restarting the
+// service. A file that cannot be read or parsed is skipped and the last
+// configuration stays in effect.
+class ConfigWatcher
+{
+public:
+	typedef std::function<void(const ConfigUtils::CompiledConfig& config)> ApplyFunction;
+
+	// Changes are looked for from the file as it is when the watcher is created.
+	ConfigWatcher(const std::shared_ptr<Utils::IRegistryStore>& registryStore, const ApplyFunction& apply);
+	~ConfigWatcher();
+
+	// Checks the file every 'intervalMs' milliseconds on a background thread
+	// until the watcher is destroyed.
+	void Start(DWORD intervalMs);
+
+	// Applies the file if its path, size or last write time changed since
+	// the last check and its content differs from the config in effect.
+	// Returns whether it was applied.
+	bool CheckForChanges();
+
+private:
+	ConfigWatcher(const ConfigWatcher&);            // prevent copy
+	ConfigWatcher& operator=(const ConfigWatcher&);  // prevent assignment
+
+	struct FileVersion
+	{
+		std::wstring path;
+		bool exists;
+		ConfigUtils::FileVersion file;
+
+		bool operator==(const FileVersion& other) const;
+	};
+
+	FileVersion CurrentVersion() const;
+
+	std::shared_ptr<Utils::IRegistryStore> _registryStore;
+	ApplyFunction _apply;
+	std::mutex _checkMutex;
+	FileVersion _version;
+	bool _hasContentHash;
+	uint64_t _contentHash;
+	HANDLE _stopEvent;
+	Utils::JoiningThread _thread;
+};
@@ -18,8 +18,6 @@ THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "DMBridgeException.h"
 #include "StringUtils.h"
 
-constexpr char* API_KEY = "api";
-
 using namespace std;
 using namespace Json;
 
@@ -29,15 +27,17 @@ DMBridgeConfig::DMBridgeConfig()
 	ApplyDefaults();
 }
 
-DMBridgeConfig::DMBridgeConfig(const Json::Value& root)
+DMBridgeConfig::DMBridgeConfig(const ConfigUtils::CompiledConfig& config)
 {
 	TRACE(__FUNCTION__);
 
-	if (root.isNull() || !ParseJSON(root))
+	if (!config.hasApiList)
 	{
-		TRACE("Failed to use config, applying defaults");
+		TRACE(L"Warning: API list not defined, applying defaults");
 		ApplyDefaults();
+		return;
 	}
+	EnableAPIs(config.apiList);
 }
 
 
@@ -51,7 +51,8 @@ map<wstring, RPC_IF_HANDLE, Utils::CaseInsensitiveLess> DMBridgeConfig::MakeInte
         { L"telemetry", Telemetry_v1_0_s_ifspec},
         { L"tpm", Tpm_v1_0_s_ifspec},
         { L"shutdownmgmt", ShutdownMgmt_v1_0_s_ifspec},
-        { L"uwpappmgmt", UwpAppMgmt_v1_0_s_ifspec}
+        { L"uwpappmgmt", UwpAppMgmt_v1_0_s_ifspec},
+        { L"metrics", Metrics_v1_0_s_ifspec}
     };
 
 	return interfaceMap;
@@ -71,35 +72,13 @@ void DMBridgeConfig::ApplyDefaults()
 	_enabledAPIIntefaces = apiInterfaces;
 }
 
-bool DMBridgeConfig::ParseJSON(const Json::Value& root)
+void DMBridgeConfig::EnableAPIs(const vector<wstring>& apiNames)
 {
 	TRACE(__FUNCTION__);
-	if (root.isNull() || !root.isObject())
-	{
-		TRACE(L"Warning: Configuration is empty");
-		return false;
-	}
-	if (!root[API_KEY].isArray())
-	{
-		TRACE(L"Warning: API list not defined");
-		return false;
-	}
 
 	set<RPC_IF_HANDLE> interfacesToEnable;
-	for (const Json::Value& apiVal : root[API_KEY])
+	for (const wstring& apiStr : apiNames)
 	{
-		if (!apiVal.isString())
-		{
-			TRACE(L"Warning: Non-string in API list");
-			continue;
-		}
-		wstring apiStr = Utils::MultibyteToWide(apiVal.asString().c_str());
-		if (apiStr.size() == 0)
-		{
-			TRACE(L"Warning: Empty string in API list");
-			continue;
-		}
-
 		auto interfaceSearch = _interfaceMap.find(apiStr);
 		if (interfaceSearch == _interfaceMap.end())
 		{
@@ -111,6 +90,4 @@ bool DMBridgeConfig::ParseJSON(const Json::Value& root)
 	}
 
 	_enabledAPIIntefaces.assign(interfacesToEnable.begin(), interfacesToEnable.end());
-
-	return true;
 }
@@ -16,6 +16,7 @@ THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #pragma once
 
 #include "stdafx.h"
+#include "ConfigUtils.h"
 #include "IConfig.h"
 #include "StringUtils.h"
 
@@ -23,7 +24,7 @@ class DMBridgeConfig : public IConfig
 {
 public:
 	DMBridgeConfig();
-	DMBridgeConfig(const Json::Value& root);
+	DMBridgeConfig(const ConfigUtils::CompiledConfig& config);
 
 	std::vector<RPC_IF_HANDLE> GetAPIInterfaces() const
 	{
@@ -32,8 +33,8 @@ public:
 
 private:
 	std::map<std::wstring, RPC_IF_HANDLE, Utils::CaseInsensitiveLess> MakeInterfaceMap();
-	bool ParseJSON(const Json::Value& root);
 	void ApplyDefaults();
+	void EnableAPIs(const std::vector<std::wstring>& apiNames);
 
 	const std::map<std::wstring, RPC_IF_HANDLE, Utils::CaseInsensitiveLess> _interfaceMap = MakeInterfaceMap();
 	std::vector<RPC_IF_HANDLE> _enabledAPIIntefaces;
@@ -14,9 +14,13 @@ THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 */
 
 #include "stdafx.h"
+#include <algorithm>
+#include <iterator>
+#include "ComputerName.h"
 #include "DMBridgeException.h"
 #include "DMBridgeServer.h"
 #include "RpcConstants.h"
+#include "TelemetryLevel.h"
 
 
 // The capability that UWP apps must have inorder to be able to use the Rpc endpoints
@@ -24,7 +28,11 @@ constexpr wchar_t* REQUIRED_CAPABILITY = L"systemManagement";
 constexpr int RPC_MIN_CALLS = 1;
 constexpr int RPC_DONT_WAIT = 0;
 
+std::mutex DMBridgeServer::_configMutex;
 std::unique_ptr<DMBridgeConfig> DMBridgeServer::_config;
+bool DMBridgeServer::_isSetup = false;
+SECURITY_DESCRIPTOR DMBridgeServer::_securityDescriptor = {};
+std::set<RPC_IF_HANDLE> DMBridgeServer::_registeredInterfaces;
 
 using namespace std;
 
@@ -53,6 +61,24 @@ void DMBridgeServer::Setup()
 		throw;
 	}
 
+	// Not fatal: without the watches, every call reads the registry itself.
+	try
+	{
+		ComputerName::StartWatching();
+	}
+	catch (const DMBridgeExceptionWithErrorCode& e)
+	{
+		TRACEP(L"Error: Failed to watch the computer name. Error ", e.ErrorCode());
+	}
+	try
+	{
+		TelemetryLevel::StartWatching();
+	}
+	catch (const DMBridgeExceptionWithErrorCode& e)
+	{
+		TRACEP(L"Error: Failed to watch the telemetry level. Error ", e.ErrorCode());
+	}
+
 	status = RpcServerUseProtseqEp(
 		(RPC_WSTR)RPC_PROTOCOL_SEQUENCE,
 		RPC_C_PROTSEQ_MAX_REQS_DEFAULT,
@@ -66,13 +92,15 @@ void DMBridgeServer::Setup()
 	
 	try
 	{
+		lock_guard<mutex> lock(_configMutex);
+		_securityDescriptor = rpcSecurityDescriptor;
+		_isSetup = true;
 		if (_config == nullptr)
 		{
 			TRACE(L"Error: Null configuration, cannot register interfaces.");
 			return;
 		}
-		auto interfaces = _config->GetAPIInterfaces();
-		RegisterInterfaces(&rpcSecurityDescriptor, interfaces);
+		UpdateInterfaces();
 	}
 	catch (const DMBridgeExceptionWithErrorCode)
 	{
@@ -88,6 +116,18 @@ void DMBridgeServer::Setup()
 	}
 }
 
+void DMBridgeServer::ApplyConfig(unique_ptr<DMBridgeConfig>& config)
+{
+	TRACE(__FUNCTION__);
+
+	lock_guard<mutex> lock(_configMutex);
+	_config = move(config);
+	if (_isSetup)
+	{
+		UpdateInterfaces();
+	}
+}
+
 void DMBridgeServer::Listen()
 {
 	TRACE(__FUNCTION__);
@@ -102,6 +142,29 @@ void DMBridgeServer::Listen()
 	{
 		throw DMBridgeExceptionWithErrorCode("Failed to listen for RPC", status);
 	}
+	TraceStartupTime();
+}
+
+// Logs how long the process took to start serving calls, the number a
+// config cache or other startup change is measured against.
+void DMBridgeServer::TraceStartupTime()
+{
+	FILETIME creationTime, exitTime, kernelTime, userTime;
+	if (!GetProcessTimes(GetCurrentProcess(), &creationTime, &exitTime, &kernelTime, &userTime))
+	{
+		return;
+	}
+
+	FILETIME now;
+	GetSystemTimeAsFileTime(&now);
+	ULARGE_INTEGER start, end;
+	start.LowPart = creationTime.dwLowDateTime;
+	start.HighPart = creationTime.dwHighDateTime;
+	end.LowPart = now.dwLowDateTime;
+	end.HighPart = now.dwHighDateTime;
+
+	// FILETIME counts 100ns intervals.
+	TRACEP(L"Listening for RPC calls. Milliseconds since process start: ", (end.QuadPart - start.QuadPart) / 10000);
 }
 
 void DMBridgeServer::StopListening()
@@ -141,9 +204,45 @@ void DMBridgeServer::RegisterInterfaces(
 		{
 			throw DMBridgeExceptionWithErrorCode("Failed to register interface", status);
 		}
+		_registeredInterfaces.insert(rpcInterface);
+	}
+}
+
+void DMBridgeServer::UnregisterInterfaces(const std::vector<RPC_IF_HANDLE>& interfaces)
+{
+	TRACE(__FUNCTION__);
+	TRACEP("Number of interfaces: ", interfaces.size());
+	RPC_STATUS status = RPC_S_OK;
+	for (RPC_IF_HANDLE rpcInterface : interfaces)
+	{
+		// Calls already running on the interface are left to finish.
+		status = RpcServerUnregisterIf(rpcInterface, nullptr, FALSE /*WaitForCallsToComplete*/);
+		if (status != RPC_S_OK)
+		{
+			throw DMBridgeExceptionWithErrorCode("Failed to unregister interface", status);
+		}
+		_registeredInterfaces.erase(rpcInterface);
 	}
 }
 
+// Only touches the interfaces whose state changes, so reloading the config
+// does not interrupt calls to the interfaces that stay enabled.
+void DMBridgeServer::UpdateInterfaces()
+{
+	TRACE(__FUNCTION__);
+
+	vector<RPC_IF_HANDLE> enabledInterfaces = _config->GetAPIInterfaces();
+	set<RPC_IF_HANDLE> enabled(enabledInterfaces.begin(), enabledInterfaces.end());
+
+	vector<RPC_IF_HANDLE> removed;
+	set_difference(_registeredInterfaces.begin(), _registeredInterfaces.end(), enabled.begin(), enabled.end(), back_inserter(removed));
+	vector<RPC_IF_HANDLE> added;
+	set_difference(enabled.begin(), enabled.end(), _registeredInterfaces.begin(), _registeredInterfaces.end(), back_inserter(added));
+
+	UnregisterInterfaces(removed);
+	RegisterInterfaces(&_securityDescriptor, added);
+}
+
 SECURITY_DESCRIPTOR DMBridgeServer::GenerateSecurityDescriptor(const WCHAR* capability)
 {
 	TRACE(__FUNCTION__);
@@ -28,14 +28,21 @@ public:
 	static void Listen(void);
 	static void StopListening(void);
 
-	static void ApplyConfig(std::unique_ptr<DMBridgeConfig>& config)
-	{
-		_config = std::move(config);
-	}
+	// Before Setup(), only keeps the config for it. After, registers the
+	// interfaces the config enables and unregisters the ones it no longer does.
+	static void ApplyConfig(std::unique_ptr<DMBridgeConfig>& config);
 
 private:
 	static SECURITY_DESCRIPTOR GenerateSecurityDescriptor(const WCHAR* customCapability);
 	static void RegisterInterfaces(SECURITY_DESCRIPTOR* securityDescriptor, const std::vector<RPC_IF_HANDLE>& interfaces);
+	static void UnregisterInterfaces(const std::vector<RPC_IF_HANDLE>& interfaces);
+	static void UpdateInterfaces();
+	static void TraceStartupTime();
 
+	// Guards the members below; RPC calls never take it.
+	static std::mutex _configMutex;
 	static std::unique_ptr<DMBridgeConfig> _config;
+	static bool _isSetup;
+	static SECURITY_DESCRIPTOR _securityDescriptor;
+	static std::set<RPC_IF_HANDLE> _registeredInterfaces;
 };
\ No newline at end of file
@@ -19,6 +19,11 @@ THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "DMBridgeService.h"
 #include "Logger.h"
 #include "DMBridgeException.h"
+#include "Constants.h"
+#include "RegistryUtils.h"
+#include "RpcMetrics.h"
+#include "StringUtils.h"
+#include "Tracing.h"
 
 using namespace std;
 using namespace std::chrono;
@@ -75,10 +80,66 @@ void WINAPI DMBridgeService::ServiceCtrlHandler(DWORD ctrl)
 	case SERVICE_CONTROL_INTERROGATE:
 		TRACE("Service interrogate received...");
 		break;
+	case ServiceControlPublishStats:
+		TRACE("Service publish stats received...");
+		s_service->PublishStats();
+		break;
+	case ServiceControlStartTracing:
+		TRACE("Service start tracing received...");
+		Utils::Tracer::Instance().Start();
+		break;
+	case ServiceControlStopTracing:
+		TRACE("Service stop tracing received...");
+		s_service->WriteTrace();
+		break;
 	default: break;
 	}
 }
 
+void DMBridgeService::PublishStats()
+{
+	TRACE(__FUNCTION__);
+
+	try
+	{
+		Json::StreamWriterBuilder builder;
+		builder["indentation"] = "";
+		string stats = Json::writeString(builder, Utils::RpcMetrics::Instance().SnapshotJson());
+		Utils::WriteRegistryValue(IoTDMRegistryRoot, RegRpcStats, Utils::MultibyteToWide(stats.c_str()));
+	}
+	catch (const DMBridgeExceptionWithErrorCode& e)
+	{
+		TRACEP("Failed to publish rpc stats. Error: ", e.ErrorCode());
+	}
+	catch (...)
+	{
+		TRACE("Failed to publish rpc stats. Unknown exception caught.");
+	}
+}
+
+void DMBridgeService::WriteTrace()
+{
+	TRACE(__FUNCTION__);
+
+	Utils::Tracer::Instance().Stop();
+
+	wstring traceFileName;
+	if (Utils::TryReadRegistryValue(IoTDMRegistryRoot, RegTraceFile, traceFileName) != ERROR_SUCCESS || traceFileName.empty())
+	{
+		TRACE("No trace file set. Discarding trace.");
+		return;
+	}
+
+	ofstream traceFile(traceFileName, ios::out | ios::trunc);
+	if (!traceFile)
+	{
+		TRACEP(L"Failed to open trace file: ", traceFileName.c_str());
+		return;
+	}
+	Utils::Tracer::Instance().WriteChromeTrace(traceFile);
+	TRACEP(L"Wrote trace to: ", traceFileName.c_str());
+}
+
 DMBridgeService::DMBridgeService(const wstring& serviceName)
 {
 	TRACE(__FUNCTION__);
@@ -48,6 +48,8 @@ private:
 	void Start();
 	void Stop();
 	void Shutdown();
+	void PublishStats();
+	void WriteTrace();
 
 	virtual void OnStart();
 	virtual void OnStop();
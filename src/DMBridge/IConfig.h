@@ -20,7 +20,7 @@ THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 class IConfig
 {
 public:
+	virtual ~IConfig() {}
 private:
-	virtual bool ParseJSON(const Json::Value& root) = 0;
 	virtual void ApplyDefaults() = 0;
 };
\ No newline at end of file
@@ -0,0 +1,64 @@
+/*
+Copyright 2018 Microsoft
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH
+THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "stdafx.h"
+#include "Metrics.h"
+#include "Logger.h"
+#include "RpcMetrics.h"
+#include "StringUtils.h"
+
+using namespace std;
+
+/* Map generated rpc method signatures to class */
+/* -------------------------------------------- */
+HRESULT GetRpcMetricsRpc(_In_ handle_t, _Outptr_ int *size, _Outptr_ wchar_t **metricsJson)
+{
+	return Metrics::GetRpcMetrics(*size, *metricsJson);
+}
+/* -------------------------------------------- */
+
+HRESULT Metrics::GetRpcMetrics(_Outptr_ int &size, _Outptr_ wchar_t *&metricsJson)
+{
+	TRACE(__FUNCTION__);
+
+	try
+	{
+		Json::StreamWriterBuilder builder;
+		builder["indentation"] = "";
+		const wstring value = Utils::MultibyteToWide(Json::writeString(builder, Utils::RpcMetrics::Instance().SnapshotJson()).c_str());
+
+		size = static_cast<int>(value.size()) + 1;
+		metricsJson = (wchar_t*)midl_user_allocate(size * sizeof(wchar_t));
+		if (metricsJson == NULL)
+		{
+			TRACE("Failed to get rpc metrics. Could not allocate memory.");
+			return E_OUTOFMEMORY;
+		}
+
+		errno_t copyErr = wcscpy_s(metricsJson, size, value.c_str());
+		if (copyErr != 0)
+		{
+			TRACEP("Failed to get rpc metrics. Could not copy buffer to out pointer. Errno: ", copyErr);
+			return E_FAIL;
+		}
+	}
+	catch (...)
+	{
+		TRACE("Failed to get rpc metrics. Unknown exception caught.");
+		return E_FAIL;
+	}
+
+	return S_OK;
+}
@@ -16,12 +16,14 @@ THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "stdafx.h"
 #include "NTService.h"
 #include "Logger.h"
+#include "RpcMetrics.h"
+#include "Tracing.h"
 #include "ServiceManager.h"
 #include "DMBridgeException.h"
 
 // https://msdn.microsoft.com/en-us/library/ms682450(VS.85).aspx
 constexpr int MaxServiceNameLength = 256;
-std::unique_ptr<NTServiceConfig> NTService::_config;
+Utils::AtomicSnapshot<NTServiceConfig> NTService::_config;
 
 using namespace std;
 
@@ -29,20 +31,28 @@ using namespace std;
 /* -------------------------------------------- */
 HRESULT StartServiceRpc(_In_ handle_t, _In_ wchar_t *serviceName)
 {
-	return NTService::Start(serviceName);
+	TRACE_SPAN(span, "rpc");
+	RPC_METRICS_SCOPE(metrics);
+	return metrics.Complete(NTService::Start(serviceName));
 }
 HRESULT StopServiceRpc(_In_ handle_t, _In_ wchar_t *serviceName)
 {
-	return NTService::Stop(serviceName);
+	TRACE_SPAN(span, "rpc");
+	RPC_METRICS_SCOPE(metrics);
+	return metrics.Complete(NTService::Stop(serviceName));
 }
 HRESULT QueryServiceRpc(_In_ handle_t, _In_ wchar_t* serviceName, _Outptr_ INT32* status)
 {
-	return NTService::Query(serviceName, status);
+	TRACE_SPAN(span, "rpc");
+	RPC_METRICS_SCOPE(metrics);
+	return metrics.Complete(NTService::Query(serviceName, status));
 }
 
 HRESULT SetServiceStartModeRpc(_In_ handle_t, _In_ wchar_t* serviceName, _In_ INT32 status)
 {
-    return NTService::SetStartMode(serviceName, status);
+    TRACE_SPAN(span, "rpc");
+    RPC_METRICS_SCOPE(metrics);
+    return metrics.Complete(NTService::SetStartMode(serviceName, status));
 }
 
 /* -------------------------------------------- */
@@ -236,13 +246,15 @@ bool NTService::IsWhitelisted(_In_ const wstring& serviceName)
 {
 	TRACE(__FUNCTION__);
 
-	if (_config == nullptr)
+	return _config.Read([&serviceName](const NTServiceConfig* config)
 	{
-		TRACE("NTServiceConfig is null");
-		return false;
-	}
-	auto whitelist = _config->GetWhitelist();
-	return (whitelist.find(serviceName) != whitelist.end());
+		if (config == nullptr)
+		{
+			TRACE("NTServiceConfig is null");
+			return false;
+		}
+		return config->IsWhitelisted(serviceName);
+	});
 }
 
 /*
@@ -253,6 +265,7 @@ bool NTService::IsWhitelisted(_In_ const wstring& serviceName)
 bool NTService::IsValidName(_In_ const wstring& serviceName)
 {
 	TRACE(__FUNCTION__);
+	TRACE_SPAN(span, "validation");
 	// Start at x01 as x00 is an invalid sequence
 	wregex namePattern(L"^[^\x01-\x1F\/\\\\]+$");
 	wcmatch match;
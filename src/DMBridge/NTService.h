@@ -16,6 +16,7 @@ THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #pragma once
 
 #include "stdafx.h"
+#include "AtomicSnapshot.h"
 #include "NTServiceConfig.h"
 
 class NTService
@@ -26,9 +27,11 @@ public:
     static HRESULT Query(_In_ const std::wstring&, _Outptr_ INT32* status);
     static HRESULT SetStartMode(_In_ const std::wstring&, _In_ INT32 status);
 
+	// Safe to call while RPC calls are running: calls already checking the
+	// whitelist finish with the configuration they started with.
 	static void ApplyConfig(std::unique_ptr<NTServiceConfig>& config)
 	{
-		_config = std::move(config);
+		_config.Publish(std::move(config));
 	}
 
 private:
@@ -36,5 +39,5 @@ private:
 	static bool IsWhitelisted(_In_ const std::wstring&);
 	static HRESULT ValidateNameArgument(_In_ const std::wstring& serviceName, _In_ const bool enforceWhitelist);
 
-	static std::unique_ptr<NTServiceConfig> _config;
+	static Utils::AtomicSnapshot<NTServiceConfig> _config;
 };
\ No newline at end of file
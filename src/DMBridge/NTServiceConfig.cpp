@@ -18,9 +18,6 @@ THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "DMBridgeException.h"
 #include "StringUtils.h"
 
-constexpr char* NTServiceSection = "servicemanager";
-constexpr char* WhitelistKey = "whitelist";
-
 using namespace std;
 using namespace Json;
 
@@ -30,15 +27,17 @@ NTServiceConfig::NTServiceConfig()
 	ApplyDefaults();
 }
 
-NTServiceConfig::NTServiceConfig(const Json::Value& root)
+NTServiceConfig::NTServiceConfig(const ConfigUtils::CompiledConfig& config)
 {
 	TRACE(__FUNCTION__);
 
-	if (root.isNull() || !ParseJSON(root))
+	if (!config.hasWhitelist)
 	{
-		TRACE("Failed to use config, applying defaults");
+		TRACE(L"Warning: Whitelist not defined, applying defaults");
 		ApplyDefaults();
+		return;
 	}
+	ApplyWhitelist(config.whitelist);
 }
 
 void NTServiceConfig::ApplyDefaults()
@@ -50,42 +49,16 @@ void NTServiceConfig::ApplyDefaults()
 	};
 }
 
-bool NTServiceConfig::ParseJSON(const Json::Value& root)
+void NTServiceConfig::ApplyWhitelist(const vector<wstring>& services)
 {
 	TRACE(__FUNCTION__);
 
-	if (root.isNull() || !root.isObject())
-	{
-		TRACE(L"Warning: Configuration is empty");
-		return false;
-	}
-
 	set<wstring, Utils::CaseInsensitiveLess> newWhitelist;
-
-	if (!root[WhitelistKey].isArray())
+	for (const wstring& serviceStr : services)
 	{
-		TRACE(L"Warning: Whitelist not defined");
-		return false;
-	}
-	for (const Json::Value& serviceVal : root[WhitelistKey])
-	{
-		if (!serviceVal.isString())
-		{
-			TRACE(L"Warning: Non-string in whitelist");
-			continue;
-		}
-
-		wstring serviceStr = Utils::MultibyteToWide(serviceVal.asString().c_str());
-		if (serviceStr.size() == 0)
-		{
-			TRACE(L"Warning: Empty string in whitelist");
-			continue;
-		}
-
 		TRACEP(L"Adding service to whitelist, if not already present: ", serviceStr);
 		newWhitelist.insert(serviceStr);
 	}
 
 	_whitelist = newWhitelist;
-	return true;
 }
@@ -16,6 +16,7 @@ THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #pragma once
 
 #include "stdafx.h"
+#include "ConfigUtils.h"
 #include "IConfig.h"
 #include "StringUtils.h"
 
@@ -23,16 +24,21 @@ class NTServiceConfig: public IConfig
 {
 public:
 	NTServiceConfig();
-	NTServiceConfig(const Json::Value& root);
+	NTServiceConfig(const ConfigUtils::CompiledConfig& config);
 
 	std::set<std::wstring, Utils::CaseInsensitiveLess> GetWhitelist() const
 	{
 		return _whitelist;
 	}
 
+	bool IsWhitelisted(const std::wstring& serviceName) const
+	{
+		return _whitelist.find(serviceName) != _whitelist.end();
+	}
+
 private:
-	bool ParseJSON(const Json::Value& root);
 	void ApplyDefaults();
+	void ApplyWhitelist(const std::vector<std::wstring>& services);
 
 	std::set<std::wstring, Utils::CaseInsensitiveLess> _whitelist;
 };
\ No newline at end of file
@@ -16,6 +16,8 @@ THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "stdafx.h"
 #include "ShutdownMgmt.h"
 #include "Logger.h"
+#include "RpcMetrics.h"
+#include "Tracing.h"
 #include "DMProcess.h"
 
 using namespace std;
@@ -29,7 +31,9 @@ constexpr wchar_t ShutdownExeRestart[] = L" -r ";
 
 HRESULT ShutdownRpc(_In_ handle_t, _In_ INT32 delayInSeconds, _In_ boolean restart)
 {
-    return ShutdownMgmt::Shutdown(delayInSeconds, restart);
+    TRACE_SPAN(span, "rpc");
+    RPC_METRICS_SCOPE(metrics);
+    return metrics.Complete(ShutdownMgmt::Shutdown(delayInSeconds, restart));
 }
 
 /* -------------------------------------------- */
@@ -17,7 +17,9 @@ THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "TelemetryLevel.h"
 #include "DMBridgeException.h"
 #include "Logger.h"
-#include "RegistryUtils.h"
+#include "RpcMetrics.h"
+#include "Tracing.h"
+#include "RegistryStore.h"
 
 constexpr int MinTelemetryLevel = 0;
 constexpr int MaxTelemetryLevel = 3;
@@ -28,16 +30,24 @@ using namespace std;
 
 // Define the private mutex
 mutex TelemetryLevel::_setLevelMutex;
+mutex TelemetryLevel::_refreshMutex;
+atomic<bool> TelemetryLevel::_watching(false);
+atomic<TelemetryLevel::CachedLevel> TelemetryLevel::_level(TelemetryLevel::CachedLevel{ 0, ERROR_FILE_NOT_FOUND });
+shared_ptr<Utils::IRegistryStore> TelemetryLevel::_registryStore = make_shared<Utils::Win32RegistryStore>();
 
 /* Map generated rpc method signatures to class */
 /* -------------------------------------------- */
 HRESULT SetTelemetryLevelRpc(_In_ handle_t, _In_ INT32 level)
 {
-	return TelemetryLevel::Set(level);
+	TRACE_SPAN(span, "rpc");
+	RPC_METRICS_SCOPE(metrics);
+	return metrics.Complete(TelemetryLevel::Set(level));
 }
 HRESULT GetTelemetryLevelRpc(_In_ handle_t, _Outptr_ INT32 *level)
 {
-	return TelemetryLevel::Get(level);
+	TRACE_SPAN(span, "rpc");
+	RPC_METRICS_SCOPE(metrics);
+	return metrics.Complete(TelemetryLevel::Get(level));
 }
 /* -------------------------------------------- */
 
@@ -59,7 +69,13 @@ HRESULT TelemetryLevel::Set(_In_ const INT32 level)
 		TRACE("Aquiring lock");
 		lock_guard<mutex> lock(_setLevelMutex);
 		TRACE("Lock aquired");
-		Utils::WriteRegistryValue(TelemetryLevelKey, TelemetryLevelValue, dwLevel);
+		_registryStore->WriteValue(TelemetryLevelKey, TelemetryLevelValue, dwLevel);
+
+		// Do not wait for the registry notification to report the new level.
+		// Publish it as a refresh would, so that a refresh that read the level
+		// before the write cannot publish that after this.
+		lock_guard<mutex> refreshLock(_refreshMutex);
+		_level = CachedLevel{ level, ERROR_SUCCESS };
 	}
 	catch (const DMBridgeExceptionWithErrorCode& e)
 	{
@@ -97,9 +113,20 @@ HRESULT TelemetryLevel::Get(_Outptr_ INT32* level)
 
 	try
 	{
-		DWORD dwLevel = 0;
-		Utils::TryReadRegistryValue(TelemetryLevelKey, TelemetryLevelValue, dwLevel);
-		*level = static_cast<INT32>(dwLevel);
+		CachedLevel cached = _level;
+		// Read again while not watching, or when the last read failed.
+		if (!_watching || (cached.status != ERROR_SUCCESS && cached.status != ERROR_FILE_NOT_FOUND))
+		{
+			cached = ReadLevel();
+		}
+
+		// Without the policy value, the level has never been set.
+		if (cached.status != ERROR_SUCCESS && cached.status != ERROR_FILE_NOT_FOUND)
+		{
+			TRACEP("Failed to read telemetry level. Error: ", cached.status);
+			return HRESULT_FROM_WIN32(cached.status);
+		}
+		*level = cached.level;
 	}
 	catch (const DMBridgeExceptionWithErrorCode& e)
 	{
@@ -124,4 +151,32 @@ HRESULT TelemetryLevel::Get(_Outptr_ INT32* level)
 	}
 
 	return S_OK;
-}
\ No newline at end of file
+}
+
+void TelemetryLevel::StartWatching()
+{
+	TRACE(__FUNCTION__);
+
+	_registryStore->WatchKey(TelemetryLevelKey, []()
+	{
+		TRACE("Telemetry level changed");
+		Refresh();
+	});
+	Refresh();
+	_watching = true;
+}
+
+TelemetryLevel::CachedLevel TelemetryLevel::ReadLevel()
+{
+	DWORD dwLevel = 0;
+	LSTATUS status = _registryStore->TryReadValue(TelemetryLevelKey, TelemetryLevelValue, dwLevel);
+	return CachedLevel{ status == ERROR_SUCCESS ? static_cast<INT32>(dwLevel) : 0, static_cast<INT32>(status) };
+}
+
+void TelemetryLevel::Refresh()
+{
+	// Serialize refreshes, and Set()'s publish, so an older read is never
+	// published over a newer one.
+	lock_guard<mutex> lock(_refreshMutex);
+	_level = ReadLevel();
+}
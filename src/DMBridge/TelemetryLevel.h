@@ -16,12 +16,42 @@ THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #pragma once
 
 #include "stdafx.h"
+#include <atomic>
+#include <memory>
+#include "RegistryStore.h"
 
 class TelemetryLevel
 {
 public:
 	static HRESULT Set(_In_ const INT32 level);
 	static HRESULT Get(_Outptr_ INT32* level);
+
+	// Replaces the system registry; must be called before the RPC server starts.
+	static void ApplyRegistryStore(const std::shared_ptr<Utils::IRegistryStore>& registryStore)
+	{
+		_watching = false;
+		_registryStore = registryStore;
+	}
+
+	// Caches the level and refreshes it when it changes in the registry.
+	// Until then, every call reads the registry.
+	static void StartWatching();
 private:
+	// The level with the status of the read that found it, small enough
+	// for readers to load it without a lock.
+	struct CachedLevel
+	{
+		INT32 level;
+		INT32 status;
+	};
+
+	static CachedLevel ReadLevel();
+	static void Refresh();
+
+	// Get() takes neither; it only loads the cached level.
 	static std::mutex _setLevelMutex;
+	static std::mutex _refreshMutex;
+	static std::atomic<bool> _watching;
+	static std::atomic<CachedLevel> _level;
+	static std::shared_ptr<Utils::IRegistryStore> _registryStore;
 };
\ No newline at end of file
@@ -17,7 +17,11 @@ THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "Tpm.h"
 #include "DMBridgeException.h"
 #include "Logger.h"
+#include "RpcMetrics.h"
+#include "Tracing.h"
 #include "DMProcess.h"
+#include "JsonPath.h"
+#include "JsonPushParser.h"
 #include "StringUtils.h"
 #include "../SharedUtilities/json/json.h"
 
@@ -25,96 +29,68 @@ using namespace std;
 
 constexpr wchar_t GetTpmInfoCmd[] = L"Limpet.exe -azuredps -enrollmentinfo -json";
 
-constexpr char JsonAttestation[] = "attestation";
-constexpr char JsonTpm[] = "tpm";
-constexpr char JsonEK[] = "endorsementKey";
-constexpr char JsonRegId[] = "registrationId";
+// What is kept of the output of limpet -enrollmentinfo -json, an array whose
+// first element describes the TPM.
+static const vector<Utils::JsonPath> LimpetInfoPaths = {
+    Utils::JsonPath("/0/attestation/tpm/endorsementKey"),
+    Utils::JsonPath("/0/registrationId"),
+};
+constexpr size_t EKPath = 0;
+constexpr size_t RegIdPath = 1;
 
 /* Map Generated rpc method signatures to class */
 /* -------------------------------------------- */
 
 HRESULT GetEndorsementKeyRpc(_In_ handle_t, _Outptr_ int *size, _Outptr_ wchar_t **ek)
 {
-    return Tpm::GetEndorsementKey(*size, *ek);
+    TRACE_SPAN(span, "rpc");
+    RPC_METRICS_SCOPE(metrics);
+    return metrics.Complete(Tpm::GetEndorsementKey(*size, *ek));
 }
 HRESULT GetRegistrationIdRpc(_In_ handle_t, _Outptr_ int *size, _Outptr_ wchar_t **regId)
 {
-    return Tpm::GetRegistrationId(*size, *regId);
+    TRACE_SPAN(span, "rpc");
+    RPC_METRICS_SCOPE(metrics);
+    return metrics.Complete(Tpm::GetRegistrationId(*size, *regId));
 }
 HRESULT GetConnectionStringRpc(_In_ handle_t, INT32 slot, int expiryInSeconds, _Outptr_ int *size, _Outptr_ wchar_t **cs)
 {
-    return Tpm::GetConnectionString(slot, expiryInSeconds, *size, *cs);
+    TRACE_SPAN(span, "rpc");
+    RPC_METRICS_SCOPE(metrics);
+    return metrics.Complete(Tpm::GetConnectionString(slot, expiryInSeconds, *size, *cs));
 }
 /* -------------------------------------------- */
 
-HRESULT JsonObjectFromString(const string& stringValue, Json::Value& root)
-{
-    istringstream payloadStream(stringValue);
-    string errorsList;
-    Json::CharReaderBuilder builder;
-    if (!Json::parseFromStream(builder, payloadStream, &root, &errorsList))
-    {
-        return E_FAIL;
-    }
-    return S_OK;
-}
-
 HRESULT TpmInfoFromLimpet(
-    const string& limpetJsonOutput,
+    const Utils::JsonPathExtractor& limpetInfo,
     string& ek,
     string& regId)
 {
-    Json::Value jsonArray;
-    HRESULT hr = JsonObjectFromString(limpetJsonOutput, jsonArray);
-    if (FAILED(hr))
-    {
-        return hr;
-    }
-
-    if (jsonArray.isNull() || !jsonArray.isArray())
-    {
-        return E_FAIL;
-    }
-
-    Json::Value jsonObject;
-    for (Json::Value::const_iterator it = jsonArray.begin(); it != jsonArray.end(); ++it)
-    {
-        // One element only...
-        jsonObject = *it;
-        break;
-    }
-
-    if (jsonObject.isNull() || !jsonObject.isObject())
+    const Json::Value* jsonEK = limpetInfo.Find(EKPath);
+    if (jsonEK == nullptr || !jsonEK->isString())
     {
         return E_FAIL;
     }
+    ek = jsonEK->asString();
 
-    Json::Value jsonAttestation = jsonObject[JsonAttestation];
-    if (jsonAttestation.isNull() || !jsonAttestation.isObject())
+    const Json::Value* jsonRegId = limpetInfo.Find(RegIdPath);
+    if (jsonRegId == nullptr || !jsonRegId->isString())
     {
         return E_FAIL;
     }
+    regId = jsonRegId->asString();
 
-    Json::Value jsonTpm = jsonAttestation[JsonTpm];
-    if (jsonTpm.isNull() || !jsonTpm.isObject())
-    {
-        return E_FAIL;
-    }
-    Json::Value jsonEK = jsonTpm[JsonEK];
-    if (!jsonEK.isString())
-    {
-        return E_FAIL;
-    }
-    ek = jsonEK.asString();
+    return S_OK;
+}
 
-    Json::Value jsonRegId = jsonObject[JsonRegId];
-    if (!jsonRegId.isString())
-    {
-        return E_FAIL;
-    }
-    regId = jsonRegId.asString();
+wstring Tpm::LimpetCommand(const wstring& params)
+{
+    wchar_t sys32dir[MAX_PATH];
+    GetSystemDirectoryW(sys32dir, _countof(sys32dir));
 
-    return S_OK;
+    wchar_t fullCommand[MAX_PATH];
+    swprintf_s(fullCommand, _countof(fullCommand), L"%ls\\%ls %ls", sys32dir, L"limpet.exe", params.c_str());
+    return fullCommand;
 }
 
 string Tpm::RunLimpet(const wstring& params)
@@ -122,19 +98,62 @@ string Tpm::RunLimpet(const wstring& params)
     TRACE(__FUNCTION__);
 
     string output;
+    unsigned long returnCode;
 
-    // build limpet command and invoke it  
-    wchar_t sys32dir[MAX_PATH];
-    GetSystemDirectoryW(sys32dir, _countof(sys32dir));
+    Process::Launch(LimpetCommand(params), returnCode, output);
 
-    wchar_t fullCommand[MAX_PATH];
-    swprintf_s(fullCommand, _countof(fullCommand), L"%s\\%s %s", sys32dir, L"limpet.exe", params.c_str());
+    return output;
+}
+
+HRESULT Tpm::RunLimpetJson(const wstring& params, Utils::IJsonHandler& handler)
+{
+    TRACE(__FUNCTION__);
 
+    // The output is parsed as it comes off the pipe rather than gathered
+    // into a string first.
+    Utils::JsonPushParser parser(handler);
+    bool failed = false;
     unsigned long returnCode;
 
-    Process::Launch(fullCommand, returnCode, output);
+    Process::Launch(LimpetCommand(params), returnCode, [&parser, &failed](const char* data, size_t size)
+    {
+        if (failed)
+        {
+            return;
+        }
+        // Nothing may be thrown out of here: Process::Launch would not
+        // close the process handles.
+        try
+        {
+            parser.Feed(data, size);
+        }
+        catch (const exception& e)
+        {
+            TRACEP("Failed to parse limpet output: ", e.what());
+            failed = true;
+        }
+        catch (...)
+        {
+            TRACE("Failed to parse limpet output. Unknown exception caught.");
+            failed = true;
+        }
+    });
+
+    if (failed)
+    {
+        return E_FAIL;
+    }
+    try
+    {
+        parser.Finish();
+    }
+    catch (const exception& e)
+    {
+        TRACEP("Failed to parse limpet output: ", e.what());
+        return E_FAIL;
+    }
 
-    return output;
+    return S_OK;
 }
 
 HRESULT Tpm::GetHostNameAndDeviceId(int logicalId, string& serviceUrl)
@@ -202,11 +221,16 @@ HRESULT Tpm::GetEndorsementKey(_Outptr_ int &size, _Outptr_ wchar_t *&ek)
 {
     TRACE(__FUNCTION__);
 
-    const string output = RunLimpet(L" -azuredps -enrollmentinfo -json");
+    Utils::JsonPathExtractor limpetInfo(LimpetInfoPaths);
+    HRESULT hr = RunLimpetJson(L" -azuredps -enrollmentinfo -json", limpetInfo);
+    if (FAILED(hr))
+    {
+        return hr;
+    }
 
     string ekStr;
     string regIdStr;
-    HRESULT hr = TpmInfoFromLimpet(output, ekStr, regIdStr);
+    hr = TpmInfoFromLimpet(limpetInfo, ekStr, regIdStr);
     if (FAILED(hr))
     {
         return hr;
@@ -219,11 +243,16 @@ HRESULT Tpm::GetRegistrationId(_Outptr_ int &size, _Outptr_ wchar_t *&regId)
 {
     TRACE(__FUNCTION__);
 
-    const string output = RunLimpet(L" -azuredps -enrollmentinfo -json");
+    Utils::JsonPathExtractor limpetInfo(LimpetInfoPaths);
+    HRESULT hr = RunLimpetJson(L" -azuredps -enrollmentinfo -json", limpetInfo);
+    if (FAILED(hr))
+    {
+        return hr;
+    }
 
     string ekStr;
     string regIdStr;
-    HRESULT hr = TpmInfoFromLimpet(output, ekStr, regIdStr);
+    hr = TpmInfoFromLimpet(limpetInfo, ekStr, regIdStr);
     if (FAILED(hr))
     {
         return hr;
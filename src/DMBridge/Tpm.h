@@ -16,6 +16,7 @@ THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #pragma once
 
 #include "stdafx.h"
+#include "JsonPushParser.h"
 
 class Tpm
 {
@@ -25,7 +26,9 @@ public:
     static HRESULT GetConnectionString(_In_ int slot, _In_ int expiryInSeconds, _Outptr_ int &size, _Outptr_ wchar_t *&cs);
 private:
     static HRESULT WriteRpcOutputString(const std::wstring& value, _Outptr_ int &rawValueSize, _Outptr_ wchar_t *&rawValue);
-    static std::string Tpm::RunLimpet(const std::wstring& params);
+    static std::wstring LimpetCommand(const std::wstring& params);
+    static std::string RunLimpet(const std::wstring& params);
+    static HRESULT RunLimpetJson(const std::wstring& params, Utils::IJsonHandler& handler);
     static HRESULT GetHostNameAndDeviceId(int logicalId, std::string& serviceUrl);
     static HRESULT GetSASToken(int logicalId, unsigned int durationInSeconds, std::string& sasToken);
 };
\ No newline at end of file
@@ -16,6 +16,8 @@ THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "stdafx.h"
 #include "UwpAppMgmt.h"
 #include "Logger.h"
+#include "RpcMetrics.h"
+#include "Tracing.h"
 #include "DMProcess.h"
 
 using namespace std;
@@ -40,7 +42,9 @@ enum StartupType
 
 HRESULT SetAppStartupRpc(_In_ handle_t, _In_ const wchar_t *pkgFamilyName, _In_ INT32 startupType)
 {
-    return UwpAppMgmt::SetAppStartup(pkgFamilyName, startupType);
+    TRACE_SPAN(span, "rpc");
+    RPC_METRICS_SCOPE(metrics);
+    return metrics.Complete(UwpAppMgmt::SetAppStartup(pkgFamilyName, startupType));
 }
 
 /* -------------------------------------------- */
@@ -0,0 +1,43 @@
+/*
+Copyright 2018 Microsoft
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH
+THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "pch.h"
+#include "MetricsBridge.h"
+#include "RpcUtilities.h"
+
+using namespace winrt;
+using namespace RpcUtils;
+
+namespace winrt::DMBridgeComponent::implementation
+{
+    /// <remarks>
+    /// Retrieve the per-method rpc latency statistics of the bridge service.
+    /// <remarks>
+    /// <returns>A JSON document with one entry per rpc method.</returns>
+    hstring MetricsBridge::GetRpcMetrics()
+    {
+        wchar_t* metricsPtr = NULL;
+        int size = 0;
+
+        check_hresult(
+            RpcNormalize(::GetRpcMetricsRpc, this->rpcBinding, &size, &metricsPtr));
+
+        // Copy the string before it is freed
+        hstring metrics = metricsPtr;
+        MIDL_user_free(metricsPtr);
+
+        return metrics;
+    }
+}
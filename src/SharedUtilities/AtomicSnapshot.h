@@ -0,0 +1,83 @@
+/*
+Copyright 2018 Microsoft
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH
+THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include "WriterReaderPhaser.h"
+
+namespace Utils
+{
+	// A value that many threads read and few replace. Readers never block:
+	// they enter the phaser, use the current value and leave. Publish() swaps
+	// in a new value and frees the old one once every reader that could have
+	// seen it has left. The phaser's writers are this class's readers.
+	template<class T>
+	class AtomicSnapshot
+	{
+	public:
+		AtomicSnapshot() :
+			_value(nullptr)
+		{}
+
+		~AtomicSnapshot()
+		{
+			delete _value.load();
+		}
+
+		// Calls read() with the current value, or nullptr before the first
+		// Publish(). The value must not be used after read() returns.
+		template<class Reader>
+		auto Read(Reader read) const -> decltype(read(static_cast<const T*>(nullptr)))
+		{
+			ReadScope scope(_phaser);
+			return read(_value.load());
+		}
+
+		void Publish(std::unique_ptr<T> value)
+		{
+			std::lock_guard<std::mutex> lock(_phaser.ReaderLock());
+			std::unique_ptr<T> oldValue(_value.exchange(value.release()));
+			_phaser.FlipPhase();
+		}
+
+	private:
+		AtomicSnapshot(const AtomicSnapshot&);            // prevent copy
+		AtomicSnapshot& operator=(const AtomicSnapshot&);  // prevent assignment
+
+		class ReadScope
+		{
+		public:
+			ReadScope(WriterReaderPhaser& phaser) :
+				_phaser(phaser),
+				_epoch(phaser.WriterEnter())
+			{}
+
+			~ReadScope()
+			{
+				_phaser.WriterExit(_epoch);
+			}
+
+		private:
+			WriterReaderPhaser& _phaser;
+			int64_t _epoch;
+		};
+
+		std::atomic<T*> _value;
+		mutable WriterReaderPhaser _phaser;
+	};
+}
@@ -0,0 +1,664 @@
+/*
+Copyright 2018 Microsoft
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH
+THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#include "stdafx.h"
+#include <cmath>
+#include <cstring>
+#include "Cbor.h"
+
+using namespace std;
+
+namespace Utils
+{
+	static constexpr uint8_t UnsignedType = 0;
+	static constexpr uint8_t NegativeType = 1;
+	static constexpr uint8_t ByteStringType = 2;
+	static constexpr uint8_t TextStringType = 3;
+	static constexpr uint8_t ArrayType = 4;
+	static constexpr uint8_t MapType = 5;
+	static constexpr uint8_t TagType = 6;
+
+	static constexpr uint8_t Indefinite = 31;
+	static constexpr uint8_t Break = 0xff;
+
+	static constexpr uint8_t SimpleFalse = 0xf4;
+	static constexpr uint8_t SimpleTrue = 0xf5;
+	static constexpr uint8_t SimpleNull = 0xf6;
+	static constexpr uint8_t SimpleUndefined = 0xf7;
+	static constexpr uint8_t HalfFloat = 0xf9;
+	static constexpr uint8_t SingleFloat = 0xfa;
+	static constexpr uint8_t DoubleFloat = 0xfb;
+
+	// The half float of 'bits', a single float, if it has one that is exact.
+	static bool ToHalf(uint32_t bits, uint16_t& half)
+	{
+		uint16_t sign = static_cast<uint16_t>((bits >> 16) & 0x8000);
+		int exponent = static_cast<int>((bits >> 23) & 0xff);
+		uint32_t mantissa = bits & 0x7fffff;
+		if (exponent == 0xff)
+		{
+			// Infinity; NaN is handled before.
+			half = sign | 0x7c00;
+			return true;
+		}
+		if (exponent == 0)
+		{
+			half = sign;
+			return mantissa == 0;
+		}
+
+		exponent -= 127;
+		if (exponent >= -14 && exponent <= 15)
+		{
+			half = static_cast<uint16_t>(sign | ((exponent + 15) << 10) | (mantissa >> 13));
+			return (mantissa & 0x1fff) == 0;
+		}
+		if (exponent >= -24 && exponent < -14)
+		{
+			uint32_t shift = static_cast<uint32_t>(-1 - exponent);
+			uint32_t significand = mantissa | 0x800000;
+			half = static_cast<uint16_t>(sign | (significand >> shift));
+			return (significand & ((1u << shift) - 1)) == 0;
+		}
+		return false;
+	}
+
+	static double FromHalf(uint16_t half)
+	{
+		int exponent = (half >> 10) & 0x1f;
+		int mantissa = half & 0x3ff;
+		double value;
+		if (exponent == 0)
+		{
+			value = ldexp(mantissa, -24);
+		}
+		else if (exponent != 0x1f)
+		{
+			value = ldexp(mantissa + 1024, exponent - 25);
+		}
+		else
+		{
+			value = mantissa == 0 ? INFINITY : NAN;
+		}
+		return (half & 0x8000) != 0 ? -value : value;
+	}
+
+	CborFormatError::CborFormatError(const string& message, size_t offset) :
+		runtime_error("Offset " + to_string(offset) + ": " + message),
+		_offset(offset)
+	{}
+
+	CborWriter::CborWriter(Json::WriteBuffer& out) :
+		_out(out)
+	{}
+
+	void CborWriter::WriteNull()
+	{
+		_out.append(static_cast<char>(SimpleNull));
+	}
+
+	void CborWriter::WriteBool(bool value)
+	{
+		_out.append(static_cast<char>(value ? SimpleTrue : SimpleFalse));
+	}
+
+	void CborWriter::WriteInt(int64_t value)
+	{
+		if (value < 0)
+		{
+			// -1 - value, without overflowing for INT64_MIN.
+			WriteHead(NegativeType, ~static_cast<uint64_t>(value));
+		}
+		else
+		{
+			WriteHead(UnsignedType, static_cast<uint64_t>(value));
+		}
+	}
+
+	void CborWriter::WriteUInt(uint64_t value)
+	{
+		WriteHead(UnsignedType, value);
+	}
+
+	void CborWriter::WriteDouble(double value)
+	{
+		char bytes[9];
+		size_t size;
+		float single = static_cast<float>(value);
+		if (isnan(value))
+		{
+			bytes[0] = static_cast<char>(HalfFloat);
+			bytes[1] = static_cast<char>(0x7e);
+			bytes[2] = 0;
+			size = 3;
+		}
+		else if (static_cast<double>(single) == value)
+		{
+			uint32_t bits;
+			memcpy(&bits, &single, sizeof(bits));
+			uint16_t half;
+			if (ToHalf(bits, half))
+			{
+				bytes[0] = static_cast<char>(HalfFloat);
+				bytes[1] = static_cast<char>(half >> 8);
+				bytes[2] = static_cast<char>(half);
+				size = 3;
+			}
+			else
+			{
+				bytes[0] = static_cast<char>(SingleFloat);
+				for (size_t i = 0; i < 4; ++i)
+				{
+					bytes[1 + i] = static_cast<char>(bits >> (24 - 8 * i));
+				}
+				size = 5;
+			}
+		}
+		else
+		{
+			uint64_t bits;
+			memcpy(&bits, &value, sizeof(bits));
+			bytes[0] = static_cast<char>(DoubleFloat);
+			for (size_t i = 0; i < 8; ++i)
+			{
+				bytes[1 + i] = static_cast<char>(bits >> (56 - 8 * i));
+			}
+			size = 9;
+		}
+		_out.append(bytes, size);
+	}
+
+	void CborWriter::WriteString(const char* data, size_t size)
+	{
+		WriteHead(TextStringType, size);
+		_out.append(data, size);
+	}
+
+	void CborWriter::BeginArray(size_t count)
+	{
+		WriteHead(ArrayType, count);
+	}
+
+	void CborWriter::BeginObject(size_t count)
+	{
+		WriteHead(MapType, count);
+	}
+
+	void CborWriter::BeginArray()
+	{
+		_out.append(static_cast<char>((ArrayType << 5) | Indefinite));
+	}
+
+	void CborWriter::BeginObject()
+	{
+		_out.append(static_cast<char>((MapType << 5) | Indefinite));
+	}
+
+	void CborWriter::End()
+	{
+		_out.append(static_cast<char>(Break));
+	}
+
+	void CborWriter::WriteValue(const Json::Value& value)
+	{
+		switch (value.type())
+		{
+		case Json::nullValue:
+			WriteNull();
+			break;
+		case Json::intValue:
+			WriteInt(value.asLargestInt());
+			break;
+		case Json::uintValue:
+			WriteUInt(value.asLargestUInt());
+			break;
+		case Json::realValue:
+			WriteDouble(value.asDouble());
+			break;
+		case Json::stringValue:
+		{
+			const char* begin;
+			const char* end;
+			value.getString(&begin, &end);
+			WriteString(begin, static_cast<size_t>(end - begin));
+			break;
+		}
+		case Json::booleanValue:
+			WriteBool(value.asBool());
+			break;
+		case Json::arrayValue:
+		{
+			Json::ArrayIndex size = value.size();
+			BeginArray(size);
+			for (Json::ArrayIndex i = 0; i < size; ++i)
+			{
+				WriteValue(value[i]);
+			}
+			break;
+		}
+		case Json::objectValue:
+			BeginObject(value.size());
+			for (Json::Value::const_iterator it = value.begin(); it != value.end(); ++it)
+			{
+				const char* end;
+				const char* name = it.memberName(&end);
+				WriteString(name, static_cast<size_t>(end - name));
+				WriteValue(*it);
+			}
+			break;
+		}
+	}
+
+	// The initial byte, then the argument in the fewest bytes that hold it.
+	void CborWriter::WriteHead(uint8_t majorType, uint64_t argument)
+	{
+		char bytes[9];
+		size_t size;
+		uint8_t type = static_cast<uint8_t>(majorType << 5);
+		if (argument < 24)
+		{
+			bytes[0] = static_cast<char>(type | argument);
+			size = 1;
+		}
+		else
+		{
+			size_t length;
+			if (argument <= 0xff)
+			{
+				bytes[0] = static_cast<char>(type | 24);
+				length = 1;
+			}
+			else if (argument <= 0xffff)
+			{
+				bytes[0] = static_cast<char>(type | 25);
+				length = 2;
+			}
+			else if (argument <= 0xffffffff)
+			{
+				bytes[0] = static_cast<char>(type | 26);
+				length = 4;
+			}
+			else
+			{
+				bytes[0] = static_cast<char>(type | 27);
+				length = 8;
+			}
+			for (size_t i = 0; i < length; ++i)
+			{
+				bytes[1 + i] = static_cast<char>(argument >> (8 * (length - 1 - i)));
+			}
+			size = 1 + length;
+		}
+		_out.append(bytes, size);
+	}
+
+	CborReader::CborReader(const char* begin, const char* end) :
+		_begin(begin),
+		_current(begin),
+		_end(end),
+		_itemStart(begin),
+		_done(false),
+		_text{ nullptr, 0 },
+		_uint(0),
+		_double(0)
+	{}
+
+	CborItem CborReader::Next()
+	{
+		if (_done)
+		{
+			_itemStart = _current;
+			return CborItem::End;
+		}
+
+		bool isKey = false;
+		if (!_containers.empty())
+		{
+			Container& container = _containers.back();
+			bool isEnd;
+			if (container.isIndefinite)
+			{
+				isEnd = _current != _end && static_cast<uint8_t>(*_current) == Break;
+			}
+			else
+			{
+				isEnd = container.remaining == 0;
+			}
+
+			if (isEnd)
+			{
+				_itemStart = _current;
+				bool isObject = container.isObject;
+				if (container.isIndefinite)
+				{
+					if (isObject && container.remaining % 2 != 0)
+					{
+						Fail("Expected the value of a member");
+					}
+					++_current;
+				}
+				_containers.pop_back();
+				_done = _containers.empty();
+				return isObject ? CborItem::EndObject : CborItem::EndArray;
+			}
+
+			// Names and values alternate, starting from an even count.
+			isKey = container.isObject && container.remaining % 2 == 0;
+			if (container.isIndefinite)
+			{
+				++container.remaining;
+			}
+			else
+			{
+				--container.remaining;
+			}
+		}
+
+		CborItem item = ReadItem(isKey);
+		if (_containers.empty())
+		{
+			_done = true;
+		}
+		return item;
+	}
+
+	void CborReader::SkipValue(CborItem first)
+	{
+		if (first != CborItem::BeginObject && first != CborItem::BeginArray)
+		{
+			return;
+		}
+		size_t depth = _containers.size() - 1;
+		while (_containers.size() > depth)
+		{
+			Next();
+		}
+	}
+
+	void CborReader::Fail(const string& message) const
+	{
+		throw CborFormatError(message, Offset());
+	}
+
+	CborItem CborReader::ReadItem(bool isKey)
+	{
+		_itemStart = _current;
+		for (;;)
+		{
+			uint8_t initial = static_cast<uint8_t>(*Take(1));
+			uint8_t majorType = initial >> 5;
+			uint8_t additional = initial & 0x1f;
+			if (majorType == TagType)
+			{
+				ReadArgument(additional);
+				continue;
+			}
+			if (isKey && majorType != TextStringType && majorType != ByteStringType)
+			{
+				Fail("Expected a string as the name of a member");
+			}
+
+			switch (majorType)
+			{
+			case UnsignedType:
+				_uint = ReadArgument(additional);
+				return CborItem::Unsigned;
+			case NegativeType:
+				_uint = ReadArgument(additional);
+				return CborItem::Negative;
+			case ByteStringType:
+			case TextStringType:
+				ReadString(majorType, additional);
+				return isKey ? CborItem::Key : CborItem::String;
+			case ArrayType:
+				Push(false, additional);
+				return CborItem::BeginArray;
+			case MapType:
+				Push(true, additional);
+				return CborItem::BeginObject;
+			}
+
+			switch (initial)
+			{
+			case SimpleFalse:
+				return CborItem::False;
+			case SimpleTrue:
+				return CborItem::True;
+			case SimpleNull:
+			case SimpleUndefined:
+				return CborItem::Null;
+			case HalfFloat:
+				_double = FromHalf(static_cast<uint16_t>(ReadArgument(25)));
+				return CborItem::Double;
+			case SingleFloat:
+			{
+				uint32_t bits = static_cast<uint32_t>(ReadArgument(26));
+				float single;
+				memcpy(&single, &bits, sizeof(single));
+				_double = single;
+				return CborItem::Double;
+			}
+			case DoubleFloat:
+			{
+				uint64_t bits = ReadArgument(27);
+				memcpy(&_double, &bits, sizeof(_double));
+				return CborItem::Double;
+			}
+			case Break:
+				Fail("Unexpected break");
+			default:
+				Fail("Unsupported simple value");
+			}
+		}
+	}
+
+	// The argument of a head, in its additional information or in the 1, 2,
+	// 4 or 8 big-endian bytes that follow.
+	uint64_t CborReader::ReadArgument(uint8_t additional)
+	{
+		if (additional < 24)
+		{
+			return additional;
+		}
+		if (additional > 27)
+		{
+			Fail("Invalid additional information");
+		}
+
+		size_t length = size_t(1) << (additional - 24);
+		const char* bytes = Take(length);
+		uint64_t argument = 0;
+		for (size_t i = 0; i < length; ++i)
+		{
+			argument = (argument << 8) | static_cast<uint8_t>(bytes[i]);
+		}
+		return argument;
+	}
+
+	// Only a string sent in chunks is copied, to join them.
+	void CborReader::ReadString(uint8_t majorType, uint8_t additional)
+	{
+		if (additional != Indefinite)
+		{
+			uint64_t size = ReadArgument(additional);
+			_text.data = Take(size);
+			_text.size = static_cast<size_t>(size);
+			return;
+		}
+
+		_chunks.clear();
+		for (;;)
+		{
+			uint8_t initial = static_cast<uint8_t>(*Take(1));
+			if (initial == Break)
+			{
+				break;
+			}
+			if ((initial >> 5) != majorType || (initial & 0x1f) == Indefinite)
+			{
+				Fail("Invalid chunk of a string");
+			}
+			uint64_t size = ReadArgument(initial & 0x1f);
+			_chunks.append(Take(size), static_cast<size_t>(size));
+		}
+		_text.data = _chunks.data();
+		_text.size = _chunks.size();
+	}
+
+	const char* CborReader::Take(uint64_t size)
+	{
+		if (size > static_cast<uint64_t>(_end - _current))
+		{
+			Fail("Unexpected end of input");
+		}
+		const char* taken = _current;
+		_current += size;
+		return taken;
+	}
+
+	void CborReader::Push(bool isObject, uint8_t additional)
+	{
+		if (_containers.size() >= MaxDepth)
+		{
+			Fail("Exceeded the nesting limit");
+		}
+
+		Container container = { isObject, additional == Indefinite, 0 };
+		if (!container.isIndefinite)
+		{
+			// Every item takes at least a byte, which also keeps a map's
+			// count of names and values from overflowing.
+			uint64_t count = ReadArgument(additional);
+			uint64_t available = static_cast<uint64_t>(_end - _current);
+			if (count > (isObject ? available / 2 : available))
+			{
+				Fail("Unexpected end of input");
+			}
+			container.remaining = isObject ? count * 2 : count;
+		}
+		_containers.push_back(container);
+	}
+
+	string CborEncode(const Json::Value& value)
+	{
+		Json::WriteBuffer out;
+		CborWriter writer(out);
+		writer.WriteValue(value);
+		return out.take();
+	}
+
+	// The same types Json::OurReader::decodeNumber gives: an integer that
+	// fits is an Int, or a UInt when it is positive and above Json::Value::
+	// maxInt; anything else is a double.
+	Json::Value CborDecode(const char* begin, const char* end)
+	{
+		CborReader reader(begin, end);
+		Json::Value root;
+		vector<Json::Value*> containers;
+		string key;
+		for (;;)
+		{
+			Json::Value value;
+			CborItem item = reader.Next();
+			switch (item)
+			{
+			case CborItem::EndObject:
+			case CborItem::EndArray:
+				containers.pop_back();
+				if (containers.empty())
+				{
+					return root;
+				}
+				continue;
+			case CborItem::Key:
+			{
+				CborText text = reader.Text();
+				key.assign(text.data, text.size);
+				continue;
+			}
+			case CborItem::BeginObject:
+				value = Json::Value(Json::objectValue);
+				break;
+			case CborItem::BeginArray:
+				value = Json::Value(Json::arrayValue);
+				break;
+			case CborItem::String:
+			{
+				CborText text = reader.Text();
+				value = Json::Value(text.data, text.data + text.size);
+				break;
+			}
+			case CborItem::Unsigned:
+				if (reader.UInt() <= Json::Value::LargestUInt(Json::Value::maxInt))
+				{
+					value = Json::Value(Json::Value::LargestInt(reader.UInt()));
+				}
+				else
+				{
+					value = Json::Value(Json::Value::LargestUInt(reader.UInt()));
+				}
+				break;
+			case CborItem::Negative:
+				if (reader.UInt() <= Json::Value::LargestUInt(Json::Value::maxLargestInt))
+				{
+					value = Json::Value(-1 - Json::Value::LargestInt(reader.UInt()));
+				}
+				else
+				{
+					value = Json::Value(-1.0 - static_cast<double>(reader.UInt()));
+				}
+				break;
+			case CborItem::Double:
+				value = Json::Value(reader.Double());
+				break;
+			case CborItem::True:
+				value = Json::Value(true);
+				break;
+			case CborItem::False:
+				value = Json::Value(false);
+				break;
+			case CborItem::Null:
+			case CborItem::End:
+				break;
+			}
+
+			Json::Value* added;
+			if (containers.empty())
+			{
+				root.swap(value);
+				added = &root;
+			}
+			else if (containers.back()->isArray())
+			{
+				added = &containers.back()->append(move(value));
+			}
+			else
+			{
+				added = &(*containers.back())[key];
+				added->swap(value);
+			}
+
+			if (item == CborItem::BeginObject || item == CborItem::BeginArray)
+			{
+				containers.push_back(added);
+			}
+			else if (containers.empty())
+			{
+				return root;
+			}
+		}
+	}
+}
@@ -0,0 +1,206 @@
+/*
+Copyright 2018 Microsoft
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH
+THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#pragma once
+
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "json/json.h"
+#include "JsonTokenizer.h"
+
+namespace Utils
+{
+	// CBOR (RFC 8949) is a binary form of the JSON data model: numbers are
+	// stored as integers or IEEE floats instead of text, and strings are
+	// stored by length, so they need no escaping and can be used in place.
+
+	enum class CborItem
+	{
+		BeginObject,
+		EndObject,
+		BeginArray,
+		EndArray,
+		Key,
+		String,
+		Unsigned,
+		Negative,
+		Double,
+		True,
+		False,
+		Null,
+		End,
+	};
+
+	class CborFormatError : public std::runtime_error
+	{
+	public:
+		CborFormatError(const std::string& message, size_t offset);
+
+		size_t Offset() const
+		{
+			return _offset;
+		}
+
+	private:
+		size_t _offset;
+	};
+
+	// A string in the buffer being read, or in the reader for a string that
+	// was sent in chunks. It is not terminated.
+	struct CborText
+	{
+		const char* data;
+		size_t size;
+
+		std::string ToString() const
+		{
+			return std::string(data, size);
+		}
+	};
+
+	// Writes CBOR one item at a time, so a document can be sent without
+	// building a Json::Value first. Whole values are written in the smallest
+	// form that keeps them exact: integers in 1 to 9 bytes and doubles as
+	// half, single or double floats. It does not check that the items it is
+	// given nest properly.
+	class CborWriter
+	{
+	public:
+		// The buffer must outlive the writer; give it a sink to stream.
+		explicit CborWriter(Json::WriteBuffer& out);
+
+		void WriteNull();
+		void WriteBool(bool value);
+		void WriteInt(int64_t value);
+		void WriteUInt(uint64_t value);
+		void WriteDouble(double value);
+		void WriteString(const char* data, size_t size);
+		void WriteString(const std::string& value)
+		{
+			WriteString(value.data(), value.size());
+		}
+
+		// A container of a known number of elements, or of members, each of
+		// which is a WriteString() for its name followed by its value.
+		void BeginArray(size_t count);
+		void BeginObject(size_t count);
+
+		// A container whose size is not known yet, which End() closes.
+		void BeginArray();
+		void BeginObject();
+		void End();
+
+		// The whole of 'value'. Comments are not kept.
+		void WriteValue(const Json::Value& value);
+
+	private:
+		CborWriter(const CborWriter&);            // prevent copy
+		CborWriter& operator=(const CborWriter&);  // prevent assignment
+
+		void WriteHead(uint8_t majorType, uint64_t argument);
+
+		Json::WriteBuffer& _out;
+	};
+
+	// Reads CBOR one item at a time, in the order JsonTokenizer reports
+	// the tokens of the same document. Strings are not copied: Text() points
+	// into the buffer. Tags are skipped, byte strings are read as strings and
+	// "undefined" as null; text is not checked for valid UTF-8. Nesting is
+	// tracked on the heap, and everything after the root item is ignored.
+	class CborReader
+	{
+	public:
+		static constexpr size_t MaxDepth = JsonTokenizer::MaxDepth;
+
+		// The buffer must outlive the reader.
+		CborReader(const char* begin, const char* end);
+
+		// Returns End after the root item. Throws CborFormatError for
+		// malformed input and for a map key that is not a string.
+		CborItem Next();
+
+		// Skips the rest of the item whose head was 'first'.
+		void SkipValue(CborItem first);
+
+		// The last Key or String.
+		CborText Text() const
+		{
+			return _text;
+		}
+
+		// The last Unsigned, or for the last Negative n, where its value is
+		// -1 - n. That fits an int64_t for n up to INT64_MAX.
+		uint64_t UInt() const
+		{
+			return _uint;
+		}
+
+		// The last Double.
+		double Double() const
+		{
+			return _double;
+		}
+
+		// Where the last item started; after End, where the root item ended.
+		size_t Offset() const
+		{
+			return static_cast<size_t>(_itemStart - _begin);
+		}
+
+		// Throws a CborFormatError at the last item.
+		[[noreturn]] void Fail(const std::string& message) const;
+
+	private:
+		CborReader(const CborReader&);            // prevent copy
+		CborReader& operator=(const CborReader&);  // prevent assignment
+
+		// An open array or map, with the items left in it: elements, or
+		// names and values.
+		struct Container
+		{
+			bool isObject;
+			bool isIndefinite;
+			uint64_t remaining;
+		};
+
+		CborItem ReadItem(bool isKey);
+		uint64_t ReadArgument(uint8_t additional);
+		void ReadString(uint8_t majorType, uint8_t additional);
+		const char* Take(uint64_t size);
+		void Push(bool isObject, uint8_t additional);
+
+		const char* _begin;
+		const char* _current;
+		const char* _end;
+		const char* _itemStart;
+		bool _done;
+		std::vector<Container> _containers;
+		CborText _text;
+		std::string _chunks;
+		uint64_t _uint;
+		double _double;
+	};
+
+	// The CBOR of 'value'.
+	std::string CborEncode(const Json::Value& value);
+
+	// The Json::Value of the CBOR item at the start of [begin, end). Numbers
+	// get the types Json::CharReaderBuilder's reader gives them. Throws
+	// CborFormatError for malformed input.
+	Json::Value CborDecode(const char* begin, const char* end);
+}
@@ -19,6 +19,17 @@ THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #define RegDebugLogFile L"DebugLogFile"
 #define RegConfigFile L"ConfigFile"
 #define DefaultConfigFile L"dmbridge.config.json"
+#define RegRpcStats L"RpcStats"
+#define RegTraceFile L"TraceFile"
+
+// User-defined service control asking DMBridge to publish its rpc metrics
+// under IoTDMRegistryRoot\RegRpcStats.
+#define ServiceControlPublishStats 128
+
+// User-defined service controls starting span tracing, and stopping it and
+// writing the collected spans to the file named by IoTDMRegistryRoot\RegTraceFile.
+#define ServiceControlStartTracing 129
+#define ServiceControlStopTracing 130
 
 #define ValueUnspecified L"<unspecified>"
 #define RegTrue L"True"
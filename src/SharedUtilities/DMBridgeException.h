@@ -14,21 +14,21 @@ THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 */
 #pragma once
 
-#include <exception>
+#include <stdexcept>
 #include "Logger.h"
 
-class DMBridgeExceptionWithErrorCode : public std::exception
+class DMBridgeExceptionWithErrorCode : public std::runtime_error
 {
 	long _errorCode;
 public:
 	DMBridgeExceptionWithErrorCode(long errorCode) :
-		std::exception(""), _errorCode(errorCode)
+		std::runtime_error(""), _errorCode(errorCode)
 	{
 		TRACEP("Exception error code: ", errorCode);
 	}
 
 	DMBridgeExceptionWithErrorCode(const char* message, long errorCode) :
-		std::exception(message), _errorCode(errorCode)
+		std::runtime_error(message), _errorCode(errorCode)
 	{
 		TRACEP("Exception error code: ", errorCode);
 	}
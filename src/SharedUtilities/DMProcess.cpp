@@ -21,6 +21,7 @@ THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "DMProcess.h"
 #include "AutoCloseHandle.h"
 #include "Logger.h"
+#include "Tracing.h"
 #include "DMBridgeException.h"
 
 static const int ERROR_PIPE_HAS_BEEN_ENDED = 109;
@@ -32,8 +33,23 @@ void Process::Launch(
     const std::wstring& commandString,
     unsigned long& returnCode,
     std::string& output)
+{
+    Launch(commandString, returnCode, [&output](const char* data, size_t size)
+    {
+        output.append(data, size);
+    });
+
+    TRACEP("Command output : ", output.c_str());
+}
+
+void Process::Launch(
+    const std::wstring& commandString,
+    unsigned long& returnCode,
+    const OutputHandler& onOutput)
 {
     TRACE(__FUNCTION__);
+    TRACE_SPAN(span, "process");
+    span.SetDetail(commandString);
 
     SECURITY_ATTRIBUTES securityAttributes;
     securityAttributes.nLength = sizeof(SECURITY_ATTRIBUTES);
@@ -112,11 +128,10 @@ void Process::Launch(
             if (bytesAvailable > 0)
             {
                 DWORD readByteCount = 0;
-                vector<char> readBuffer(bytesAvailable + 1);
-                if (ReadFile(stdOutReadHandle.Get(), readBuffer.data(), static_cast<unsigned int>(readBuffer.size()) - 1, &readByteCount, NULL) || readByteCount == 0)
+                vector<char> readBuffer(bytesAvailable);
+                if (ReadFile(stdOutReadHandle.Get(), readBuffer.data(), static_cast<unsigned int>(readBuffer.size()), &readByteCount, NULL) || readByteCount == 0)
                 {
-                    readBuffer[readByteCount] = '\0';
-                    output += readBuffer.data();
+                    onOutput(readBuffer.data(), readByteCount);
                 }
             }
         }
@@ -132,5 +147,4 @@ void Process::Launch(
     }
 
     TRACEP("Command return Code: ", returnCode);
-    TRACEP("Command output : ", output.c_str());
 }
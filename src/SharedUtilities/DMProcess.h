@@ -15,17 +15,29 @@ THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 #pragma once
 
+#include <functional>
 #include <string>
 #include <windows.h>
 
 class Process
 {
 public:
+    // Receives the child's output as it is read from the pipe.
+    typedef std::function<void(const char* data, size_t size)> OutputHandler;
+
     static void Launch(
         const std::wstring& commandString,
         unsigned long& returnCode,
         std::string& output);
 
+    // Hands the output to 'onOutput' piece by piece instead of gathering it,
+    // e.g. to parse it as it arrives. 'onOutput' must not throw; the child
+    // would be left running.
+    static void Launch(
+        const std::wstring& commandString,
+        unsigned long& returnCode,
+        const OutputHandler& onOutput);
+
     static bool IsProcessRunning(
         const std::wstring& processName);
 
@@ -0,0 +1,345 @@
+/*
+Copyright 2018 Microsoft
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH
+THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#include "stdafx.h"
+#include <cstring>
+#include <utility>
+#include "DMBridgeException.h"
+#include "JsonPath.h"
+
+using namespace std;
+
+namespace Utils
+{
+	// The array index a segment names: digits without a leading zero.
+	static bool ParseIndex(const string& name, Json::ArrayIndex& index)
+	{
+		if (name.empty() || name.size() > 10 || (name.size() > 1 && name[0] == '0'))
+		{
+			return false;
+		}
+		uint64_t value = 0;
+		for (char c : name)
+		{
+			if (c < '0' || c > '9')
+			{
+				return false;
+			}
+			value = value * 10 + static_cast<uint64_t>(c - '0');
+		}
+		if (value > Json::Value::maxUInt)
+		{
+			return false;
+		}
+		index = static_cast<Json::ArrayIndex>(value);
+		return true;
+	}
+
+	JsonPath::JsonPath(const string& pointer)
+	{
+		shared_ptr<Compiled> compiled = make_shared<Compiled>();
+		compiled->pointer = pointer;
+		compiled->hasWildcards = false;
+		if (!pointer.empty() && pointer[0] != '/')
+		{
+			throw DMBridgeExceptionWithErrorCode("JSON pointer does not start with '/'", ERROR_INVALID_PARAMETER);
+		}
+
+		// Every name is unescaped before any segment points into it.
+		for (size_t position = 0; position < pointer.size();)
+		{
+			size_t end = pointer.find('/', position + 1);
+			if (end == string::npos)
+			{
+				end = pointer.size();
+			}
+			string name;
+			for (size_t i = position + 1; i < end; ++i)
+			{
+				if (pointer[i] != '~')
+				{
+					name += pointer[i];
+				}
+				else if (i + 1 < end && (pointer[i + 1] == '0' || pointer[i + 1] == '1'))
+				{
+					name += pointer[++i] == '0' ? '~' : '/';
+				}
+				else
+				{
+					throw DMBridgeExceptionWithErrorCode("JSON pointer has '~' not followed by '0' or '1'", ERROR_INVALID_PARAMETER);
+				}
+			}
+			compiled->names.push_back(move(name));
+			position = end;
+		}
+
+		compiled->segments.reserve(compiled->names.size());
+		for (const string& name : compiled->names)
+		{
+			Segment segment = { Json::StaticKey(name.data(), name.data() + name.size()), 0, false, name == "*" };
+			segment.isIndex = ParseIndex(name, segment.index);
+			compiled->hasWildcards = compiled->hasWildcards || segment.isWildcard;
+			compiled->segments.push_back(segment);
+		}
+		_compiled = move(compiled);
+	}
+
+	const Json::Value* JsonPath::Find(const Json::Value& root) const
+	{
+		return FindFrom(root, 0);
+	}
+
+	Json::Value* JsonPath::Find(Json::Value& root) const
+	{
+		return const_cast<Json::Value*>(FindFrom(root, 0));
+	}
+
+	void JsonPath::FindAll(const Json::Value& root, vector<const Json::Value*>& matches) const
+	{
+		FindAllFrom(root, 0, matches);
+	}
+
+	bool JsonPath::Segment::MatchesMember(const string& name) const
+	{
+		return isWildcard || (key.length() == name.size() && memcmp(key.data(), name.data(), name.size()) == 0);
+	}
+
+	bool JsonPath::Segment::MatchesElement(Json::ArrayIndex element) const
+	{
+		return isWildcard || (isIndex && index == element);
+	}
+
+	// The member or element a segment other than a wildcard names.
+	const Json::Value* JsonPath::Child(const Json::Value& value, const Segment& segment)
+	{
+		if (value.isObject())
+		{
+			return value.find(segment.key);
+		}
+		if (value.isArray() && segment.isIndex && segment.index < value.size())
+		{
+			return &value[segment.index];
+		}
+		return nullptr;
+	}
+
+	// Only a wildcard recurses; named segments are followed in a loop.
+	const Json::Value* JsonPath::FindFrom(const Json::Value& value, size_t segment) const
+	{
+		const vector<Segment>& segments = _compiled->segments;
+		const Json::Value* current = &value;
+		for (; segment < segments.size(); ++segment)
+		{
+			const Segment& next = segments[segment];
+			if (next.isWildcard)
+			{
+				if (!current->isObject() && !current->isArray())
+				{
+					return nullptr;
+				}
+				for (Json::Value::const_iterator it = current->begin(); it != current->end(); ++it)
+				{
+					if (const Json::Value* found = FindFrom(*it, segment + 1))
+					{
+						return found;
+					}
+				}
+				return nullptr;
+			}
+			current = Child(*current, next);
+			if (current == nullptr)
+			{
+				return nullptr;
+			}
+		}
+		return current;
+	}
+
+	void JsonPath::FindAllFrom(const Json::Value& value, size_t segment, vector<const Json::Value*>& matches) const
+	{
+		const vector<Segment>& segments = _compiled->segments;
+		if (segment == segments.size())
+		{
+			matches.push_back(&value);
+			return;
+		}
+		if (!segments[segment].isWildcard)
+		{
+			const Json::Value* child = Child(value, segments[segment]);
+			if (child != nullptr)
+			{
+				FindAllFrom(*child, segment + 1, matches);
+			}
+		}
+		else if (value.isObject() || value.isArray())
+		{
+			for (Json::Value::const_iterator it = value.begin(); it != value.end(); ++it)
+			{
+				FindAllFrom(*it, segment + 1, matches);
+			}
+		}
+	}
+
+	JsonPathExtractor::JsonPathExtractor(const vector<JsonPath>& paths) :
+		_paths(paths),
+		_matches(paths.size()),
+		_skipping(0)
+	{
+		// Every path is a candidate for the root.
+		for (size_t path = 0; path < paths.size(); ++path)
+		{
+			_candidates.push_back(path);
+		}
+	}
+
+	void JsonPathExtractor::OnToken(JsonToken token, const string& text)
+	{
+		switch (token)
+		{
+		case JsonToken::Key:
+			if (_skipping == 0)
+			{
+				_key = text;
+				Forward(token, text);
+			}
+			break;
+		case JsonToken::EndObject:
+		case JsonToken::EndArray:
+			if (_skipping != 0)
+			{
+				if (--_skipping == 0)
+				{
+					EndValue();
+				}
+				break;
+			}
+			Forward(token, text);
+			_candidates.resize(_frames.back().candidates);
+			_frames.pop_back();
+			EndValue();
+			break;
+		case JsonToken::End:
+			break;
+		default:
+			if (_skipping != 0)
+			{
+				if (token == JsonToken::BeginObject || token == JsonToken::BeginArray)
+				{
+					++_skipping;
+				}
+				break;
+			}
+			BeginValue(token, text);
+			break;
+		}
+	}
+
+	void JsonPathExtractor::Extract(const char* begin, const char* end)
+	{
+		JsonTokenizer tokenizer(begin, end);
+		for (JsonToken token = tokenizer.Next(); token != JsonToken::End; token = tokenizer.Next())
+		{
+			OnToken(token, tokenizer.Text());
+			if (_skipping != 0)
+			{
+				tokenizer.SkipValue(token);
+				_skipping = 0;
+				EndValue();
+			}
+		}
+	}
+
+	const Json::Value* JsonPathExtractor::Find(size_t path) const
+	{
+		return _matches[path].empty() ? nullptr : &_matches[path].back();
+	}
+
+	// Starts a value: narrows the candidates of the container holding it to
+	// the paths that go on through it, and starts building it for the paths
+	// that end at it. Returns false, having started to skip it, for an object
+	// or array no path reaches into.
+	bool JsonPathExtractor::BeginValue(JsonToken token, const string& text)
+	{
+		size_t depth = _frames.size();
+		const Frame* container = _frames.empty() ? nullptr : &_frames.back();
+		size_t first = container == nullptr ? 0 : container->candidates;
+		size_t last = _candidates.size();
+		for (size_t i = first; i < last; ++i)
+		{
+			size_t path = _candidates[i];
+			const vector<JsonPath::Segment>& segments = _paths[path]._compiled->segments;
+			if (container != nullptr)
+			{
+				const JsonPath::Segment& segment = segments[depth - 1];
+				if (!(container->isObject ? segment.MatchesMember(_key) : segment.MatchesElement(container->index)))
+				{
+					continue;
+				}
+			}
+			if (segments.size() == depth)
+			{
+				Match match = { path, depth, unique_ptr<JsonValueBuilder>(new JsonValueBuilder()) };
+				_building.push_back(move(match));
+			}
+			else
+			{
+				_candidates.push_back(path);
+			}
+		}
+		Forward(token, text);
+
+		if (token != JsonToken::BeginObject && token != JsonToken::BeginArray)
+		{
+			_candidates.resize(last);
+			EndValue();
+			return true;
+		}
+		if (_candidates.size() == last && _building.empty())
+		{
+			_skipping = 1;
+			return false;
+		}
+		Frame frame = { token == JsonToken::BeginObject, 0, last };
+		_frames.push_back(frame);
+		return true;
+	}
+
+	// Ends the value at the depth of _frames: keeps what the paths that ended
+	// at it built, and moves on to the next element of an array.
+	void JsonPathExtractor::EndValue()
+	{
+		size_t depth = _frames.size();
+		while (!_building.empty() && _building.back().depth == depth)
+		{
+			Match& match = _building.back();
+			_matches[match.path].emplace_back();
+			_matches[match.path].back().swap(match.builder->Root());
+			_building.pop_back();
+		}
+		if (!_frames.empty() && !_frames.back().isObject)
+		{
+			++_frames.back().index;
+		}
+	}
+
+	void JsonPathExtractor::Forward(JsonToken token, const string& text)
+	{
+		for (Match& match : _building)
+		{
+			match.builder->OnToken(token, text);
+		}
+	}
+}
@@ -0,0 +1,148 @@
+/*
+Copyright 2018 Microsoft
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH
+THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+#include "json/json.h"
+#include "JsonPushParser.h"
+#include "JsonTokenizer.h"
+
+namespace Utils
+{
+	// A JSON Pointer (RFC 6901), compiled once so that looking it up does
+	// not parse it or hash its member names again. A segment that is just
+	// "*" matches every member of an object or element of an array; a member
+	// actually named "*" cannot be addressed. A segment of digits addresses
+	// an element of an array, or the member of that name in an object.
+	// Copies share the compiled path.
+	class JsonPath
+	{
+	public:
+		// 'pointer' is e.g. "/attestation/tpm/endorsementKey", or "" for the
+		// whole document. Throws DMBridgeExceptionWithErrorCode if it is not
+		// a JSON Pointer.
+		explicit JsonPath(const std::string& pointer);
+
+		// The value at the path, or nullptr if there is none. With wildcards,
+		// the first in the order Json::Value iterates: elements by index and
+		// members by name. Neither copies nor throws.
+		const Json::Value* Find(const Json::Value& root) const;
+		Json::Value* Find(Json::Value& root) const;
+
+		// Appends every value the path matches, in that order.
+		void FindAll(const Json::Value& root, std::vector<const Json::Value*>& matches) const;
+
+		const std::string& Pointer() const
+		{
+			return _compiled->pointer;
+		}
+
+		bool HasWildcards() const
+		{
+			return _compiled->hasWildcards;
+		}
+
+	private:
+		friend class JsonPathExtractor;
+
+		struct Segment
+		{
+			Json::StaticKey key;
+			Json::ArrayIndex index;
+			bool isIndex;
+			bool isWildcard;
+
+			bool MatchesMember(const std::string& name) const;
+			bool MatchesElement(Json::ArrayIndex element) const;
+		};
+
+		struct Compiled
+		{
+			std::string pointer;
+			std::vector<std::string> names;
+			std::vector<Segment> segments;
+			bool hasWildcards;
+		};
+
+		static const Json::Value* Child(const Json::Value& value, const Segment& segment);
+		const Json::Value* FindFrom(const Json::Value& value, size_t segment) const;
+		void FindAllFrom(const Json::Value& value, size_t segment, std::vector<const Json::Value*>& matches) const;
+
+		std::shared_ptr<const Compiled> _compiled;
+	};
+
+	// Keeps only the values at some paths of one document as it is read, and
+	// builds no Json::Value for the rest. Give it the tokens of a
+	// JsonPushParser, or a whole buffer through Extract(). Where a document
+	// repeats a member name, values are matched under every occurrence.
+	class JsonPathExtractor : public IJsonHandler
+	{
+	public:
+		explicit JsonPathExtractor(const std::vector<JsonPath>& paths);
+
+		void OnToken(JsonToken token, const std::string& text) override;
+
+		// Reads the document in [begin, end), skipping the values no path
+		// can match without reporting their tokens. Throws JsonSyntaxError
+		// for malformed input.
+		void Extract(const char* begin, const char* end);
+
+		// The last value paths[path] matched, or nullptr; as Find() on the
+		// document for a path without wildcards.
+		const Json::Value* Find(size_t path) const;
+
+		// Every value paths[path] matched, in document order.
+		const std::vector<Json::Value>& Matches(size_t path) const
+		{
+			return _matches[path];
+		}
+
+	private:
+		JsonPathExtractor(const JsonPathExtractor&);            // prevent copy
+		JsonPathExtractor& operator=(const JsonPathExtractor&);  // prevent assignment
+
+		// An object or array that paths continue into.
+		struct Frame
+		{
+			bool isObject;
+			Json::ArrayIndex index;  // of the next element
+			size_t candidates;       // where its paths start in _candidates
+		};
+
+		// A value a path matched, being built from its tokens.
+		struct Match
+		{
+			size_t path;
+			size_t depth;
+			std::unique_ptr<JsonValueBuilder> builder;
+		};
+
+		bool BeginValue(JsonToken token, const std::string& text);
+		void EndValue();
+		void Forward(JsonToken token, const std::string& text);
+
+		std::vector<JsonPath> _paths;
+		std::vector<std::vector<Json::Value>> _matches;
+		std::vector<Frame> _frames;
+		std::vector<size_t> _candidates;
+		std::vector<Match> _building;
+		std::string _key;
+		size_t _skipping;
+	};
+}
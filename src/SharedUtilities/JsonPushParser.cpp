@@ -0,0 +1,396 @@
+/*
+Copyright 2018 Microsoft
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH
+THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#include "stdafx.h"
+#include <algorithm>
+#include <clocale>
+#include <cstdlib>
+#include "JsonPushParser.h"
+
+using namespace std;
+
+namespace Utils
+{
+	static const string NoText;
+
+	JsonPushParser::JsonPushParser(IJsonHandler& handler) :
+		_handler(handler),
+		_scanner(JsonSyntax::Lenient),
+		_state(State::Root),
+		_pending(JsonToken::End)
+	{}
+
+	void JsonPushParser::Feed(const char* data, size_t size)
+	{
+		_scanner.SetPiece(data, data + size, false);
+		Parse();
+	}
+
+	void JsonPushParser::Finish()
+	{
+		if (_state == State::Done)
+		{
+			return;
+		}
+
+		// Ends a number the last piece ended in, or fails on anything else
+		// left open.
+		_scanner.SetPiece(nullptr, nullptr, true);
+		Parse();
+		if (_state != State::Done)
+		{
+			_scanner.FailHere(Expected());
+		}
+	}
+
+	// Reads tokens until the piece is used up or the root value is complete.
+	void JsonPushParser::Parse()
+	{
+		while (_state != State::Done)
+		{
+			if (_scanner.IsPending())
+			{
+				if (!_scanner.Continue())
+				{
+					return;
+				}
+				if (_pending != JsonToken::End)
+				{
+					EndToken();
+				}
+				continue;
+			}
+
+			_scanner.SkipWhitespace();
+			if (_scanner.AtEnd())
+			{
+				return;
+			}
+			ReadToken();
+		}
+	}
+
+	// Starts reading the token at the scanner.
+	void JsonPushParser::ReadToken()
+	{
+		_scanner.StartToken();
+		char c = _scanner.Peek();
+		switch (_state)
+		{
+		case State::Done:
+			return;
+
+		case State::Root:
+		case State::ObjectValue:
+		case State::ArrayValue:
+			BeginValue();
+			return;
+
+		case State::ObjectFirst:
+			if (c == '}')
+			{
+				_scanner.Advance();
+				EndContainer();
+				_handler.OnToken(JsonToken::EndObject, NoText);
+				return;
+			}
+			// fall through
+		case State::ObjectKey:
+			if (c != '"')
+			{
+				_scanner.FailHere(Expected());
+			}
+			BeginToken(JsonToken::Key, _scanner.ReadString());
+			return;
+
+		case State::ObjectColon:
+			if (c != ':')
+			{
+				_scanner.FailHere(Expected());
+			}
+			_scanner.Advance();
+			_state = State::ObjectValue;
+			return;
+
+		case State::ObjectNext:
+			if (c == ',')
+			{
+				_scanner.Advance();
+				_state = State::ObjectKey;
+				return;
+			}
+			if (c == '}')
+			{
+				_scanner.Advance();
+				EndContainer();
+				_handler.OnToken(JsonToken::EndObject, NoText);
+				return;
+			}
+			_scanner.FailHere(Expected());
+
+		case State::ArrayFirst:
+			if (c == ']')
+			{
+				_scanner.Advance();
+				EndContainer();
+				_handler.OnToken(JsonToken::EndArray, NoText);
+				return;
+			}
+			BeginValue();
+			return;
+
+		case State::ArrayNext:
+			if (c == ',')
+			{
+				_scanner.Advance();
+				_state = State::ArrayValue;
+				return;
+			}
+			if (c == ']')
+			{
+				_scanner.Advance();
+				EndContainer();
+				_handler.OnToken(JsonToken::EndArray, NoText);
+				return;
+			}
+			_scanner.FailHere(Expected());
+		}
+	}
+
+	void JsonPushParser::BeginValue()
+	{
+		switch (_scanner.Peek())
+		{
+		case '{':
+			Push('{');
+			_handler.OnToken(JsonToken::BeginObject, NoText);
+			return;
+		case '[':
+			Push('[');
+			_handler.OnToken(JsonToken::BeginArray, NoText);
+			return;
+		case '"':
+			BeginToken(JsonToken::String, _scanner.ReadString());
+			return;
+		case 't':
+			BeginToken(JsonToken::True, _scanner.ReadLiteral("true"));
+			return;
+		case 'f':
+			BeginToken(JsonToken::False, _scanner.ReadLiteral("false"));
+			return;
+		case 'n':
+			BeginToken(JsonToken::Null, _scanner.ReadLiteral("null"));
+			return;
+		default:
+			if (_scanner.Peek() != '-' && (_scanner.Peek() < '0' || _scanner.Peek() > '9'))
+			{
+				_scanner.FailHere(Expected());
+			}
+			BeginToken(JsonToken::Number, _scanner.ReadNumber());
+			return;
+		}
+	}
+
+	// 'token' is reported once the scanner has all of it, which may only be
+	// in a later piece.
+	void JsonPushParser::BeginToken(JsonToken token, bool isComplete)
+	{
+		_pending = token;
+		if (isComplete)
+		{
+			EndToken();
+		}
+	}
+
+	void JsonPushParser::EndToken()
+	{
+		JsonToken token = _pending;
+		_pending = JsonToken::End;
+		switch (token)
+		{
+		case JsonToken::Key:
+			_state = State::ObjectColon;
+			_handler.OnToken(token, _scanner.Text());
+			return;
+		case JsonToken::String:
+		case JsonToken::Number:
+			EndValue();
+			_handler.OnToken(token, _scanner.Text());
+			return;
+		default:
+			EndValue();
+			_handler.OnToken(token, NoText);
+			return;
+		}
+	}
+
+	void JsonPushParser::Push(char container)
+	{
+		if (_containers.size() >= MaxDepth)
+		{
+			_scanner.Fail("Exceeded the nesting limit");
+		}
+		_scanner.Advance();
+		_containers.push_back(container);
+		_state = container == '{' ? State::ObjectFirst : State::ArrayFirst;
+	}
+
+	void JsonPushParser::EndContainer()
+	{
+		_containers.pop_back();
+		EndValue();
+	}
+
+	// Moves on to what can follow a value in the innermost open container.
+	void JsonPushParser::EndValue()
+	{
+		if (_containers.empty())
+		{
+			_state = State::Done;
+		}
+		else
+		{
+			_state = _containers.back() == '{' ? State::ObjectNext : State::ArrayNext;
+		}
+	}
+
+	// What the parser needs next, for errors about anything else.
+	const char* JsonPushParser::Expected() const
+	{
+		switch (_state)
+		{
+		case State::ObjectFirst:
+		case State::ObjectKey:
+			return "Expected a member name";
+		case State::ObjectColon:
+			return "Expected ':' after a member name";
+		case State::ObjectNext:
+			return "Expected ',' or '}' after an object member";
+		case State::ArrayNext:
+			return "Expected ',' or ']' after an array element";
+		default:
+			return "Expected a value";
+		}
+	}
+
+	JsonValueBuilder::JsonValueBuilder()
+	{}
+
+	void JsonValueBuilder::OnToken(JsonToken token, const string& text)
+	{
+		switch (token)
+		{
+		case JsonToken::BeginObject:
+			_containers.push_back(&Add(Json::Value(Json::objectValue)));
+			break;
+		case JsonToken::BeginArray:
+			_containers.push_back(&Add(Json::Value(Json::arrayValue)));
+			break;
+		case JsonToken::EndObject:
+		case JsonToken::EndArray:
+			_containers.pop_back();
+			break;
+		case JsonToken::Key:
+			_key = text;
+			break;
+		case JsonToken::String:
+			Add(Json::Value(text));
+			break;
+		case JsonToken::Number:
+			Add(DecodeNumber(text));
+			break;
+		case JsonToken::True:
+			Add(Json::Value(true));
+			break;
+		case JsonToken::False:
+			Add(Json::Value(false));
+			break;
+		case JsonToken::Null:
+			Add(Json::Value());
+			break;
+		case JsonToken::End:
+			break;
+		}
+	}
+
+	// Places a value in the innermost open container, as the last member
+	// named, replacing an earlier member of that name as the reader does.
+	Json::Value& JsonValueBuilder::Add(Json::Value&& value)
+	{
+		if (_containers.empty())
+		{
+			_root.swap(value);
+			return _root;
+		}
+
+		Json::Value& container = *_containers.back();
+		if (container.isArray())
+		{
+			return container.append(move(value));
+		}
+		Json::Value& member = container[_key];
+		member.swap(value);
+		return member;
+	}
+
+	// The same decoding as Json::OurReader::decodeNumber: an integer that
+	// fits is an Int, or a UInt when it is positive and above Json::Value::
+	// maxInt; anything else is a double.
+	Json::Value JsonValueBuilder::DecodeNumber(const string& text)
+	{
+		bool isNegative = text[0] == '-';
+		Json::Value::LargestUInt maxValue = isNegative
+			? Json::Value::LargestUInt(Json::Value::maxLargestInt) + 1
+			: Json::Value::maxLargestUInt;
+		Json::Value::LargestUInt value = 0;
+		size_t i = isNegative ? 1 : 0;
+		for (; i < text.size(); ++i)
+		{
+			unsigned int digit = static_cast<unsigned int>(text[i] - '0');
+			if (digit > 9 || value > (maxValue - digit) / 10)
+			{
+				break;
+			}
+			value = value * 10 + digit;
+		}
+
+		if (i == text.size())
+		{
+			if (isNegative && value == maxValue)
+			{
+				return Json::Value(Json::Value::minLargestInt);
+			}
+			if (isNegative)
+			{
+				return Json::Value(-Json::Value::LargestInt(value));
+			}
+			if (value <= Json::Value::LargestUInt(Json::Value::maxInt))
+			{
+				return Json::Value(Json::Value::LargestInt(value));
+			}
+			return Json::Value(value);
+		}
+
+		// strtod reads the decimal point of the current C locale.
+		string number = text;
+		char decimalPoint = *localeconv()->decimal_point;
+		if (decimalPoint != '.')
+		{
+			replace(number.begin(), number.end(), '.', decimalPoint);
+		}
+		return Json::Value(strtod(number.c_str(), nullptr));
+	}
+}
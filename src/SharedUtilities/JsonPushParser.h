@@ -0,0 +1,135 @@
+/*
+Copyright 2018 Microsoft
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH
+THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "json/json.h"
+#include "JsonTokenizer.h"
+
+namespace Utils
+{
+	// Receives the tokens of a document from a JsonPushParser, in order.
+	class IJsonHandler
+	{
+	public:
+		virtual ~IJsonHandler() {}
+
+		// 'text' is the decoded UTF-8 text of a Key or String token, the text
+		// of a Number token and empty otherwise. It is only valid during the
+		// call. End is not reported.
+		virtual void OnToken(JsonToken token, const std::string& text) = 0;
+	};
+
+	// Parses a document that arrives in pieces, e.g. as it is read from a
+	// file or a pipe, without first gathering it into one buffer. A piece may
+	// end anywhere, even inside a token; only the token being read is kept
+	// between pieces. It accepts what JsonTokenizer accepts, and everything
+	// after the root value is ignored.
+	class JsonPushParser
+	{
+	public:
+		static constexpr size_t MaxDepth = JsonTokenizer::MaxDepth;
+
+		// The handler must outlive the parser.
+		explicit JsonPushParser(IJsonHandler& handler);
+
+		// Parses the next piece of the document, reporting every token it
+		// completes. Throws JsonSyntaxError for malformed input, after which
+		// the parser must not be used again.
+		void Feed(const char* data, size_t size);
+
+		// Ends the document: reports a number the last piece ended in, and
+		// throws JsonSyntaxError if the root value is incomplete.
+		void Finish();
+
+		// Whether the root value is complete; later input is ignored.
+		bool IsDone() const
+		{
+			return _state == State::Done;
+		}
+
+		// Where the last token started, counting from 1.
+		size_t Line() const
+		{
+			return _scanner.TokenLine();
+		}
+
+		size_t Column() const
+		{
+			return _scanner.TokenColumn();
+		}
+
+	private:
+		JsonPushParser(const JsonPushParser&);            // prevent copy
+		JsonPushParser& operator=(const JsonPushParser&);  // prevent assignment
+
+		enum class State
+		{
+			Root,
+			Done,
+			ObjectFirst,
+			ObjectKey,
+			ObjectColon,
+			ObjectValue,
+			ObjectNext,
+			ArrayFirst,
+			ArrayValue,
+			ArrayNext,
+		};
+
+		void Parse();
+		void ReadToken();
+		void BeginValue();
+		void BeginToken(JsonToken token, bool isComplete);
+		void EndToken();
+		void Push(char container);
+		void EndValue();
+		void EndContainer();
+		const char* Expected() const;
+
+		IJsonHandler& _handler;
+		JsonScanner _scanner;
+		State _state;
+		JsonToken _pending; // read in part, or End
+		std::vector<char> _containers;
+	};
+
+	// Builds the Json::Value of the document a JsonPushParser reports, with
+	// the same types and values Json::CharReaderBuilder's reader gives it.
+	class JsonValueBuilder : public IJsonHandler
+	{
+	public:
+		JsonValueBuilder();
+
+		void OnToken(JsonToken token, const std::string& text) override;
+
+		// The document, once the parser is done with it.
+		Json::Value& Root()
+		{
+			return _root;
+		}
+
+	private:
+		Json::Value& Add(Json::Value&& value);
+		static Json::Value DecodeNumber(const std::string& text);
+
+		Json::Value _root;
+		std::vector<Json::Value*> _containers;
+		std::string _key;
+	};
+}
@@ -0,0 +1,586 @@
+/*
+Copyright 2018 Microsoft
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH
+THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "stdafx.h"
+#include "JsonScanner.h"
+
+using namespace std;
+
+namespace Utils
+{
+	JsonSyntaxError::JsonSyntaxError(const string& message, size_t line, size_t column, size_t offset) :
+		runtime_error("Line " + to_string(line) + ", Column " + to_string(column) + ": " + message),
+		_message(message),
+		_line(line),
+		_column(column),
+		_offset(offset)
+	{}
+
+	JsonScanner::JsonScanner(JsonSyntax syntax) :
+		_syntax(syntax),
+		_current(nullptr),
+		_end(nullptr),
+		_pieceBegin(nullptr),
+		_pieceOffset(0),
+		_isLast(false),
+		_line(1),
+		_lineOffset(0),
+		_tokenLine(1),
+		_tokenColumn(1),
+		_tokenOffset(0),
+		_lexeme(Lexeme::None),
+		_literal(nullptr),
+		_matched(0),
+		_hexDigits(0),
+		_codePoint(0),
+		_highSurrogate(0)
+	{}
+
+	void JsonScanner::SetPiece(const char* begin, const char* end, bool isLast)
+	{
+		_pieceOffset += static_cast<size_t>(_end - _pieceBegin);
+		_pieceBegin = begin;
+		_current = begin;
+		_end = end;
+		_isLast = isLast;
+	}
+
+	void JsonScanner::SkipCharacter()
+	{
+		if (*_current++ == '\n')
+		{
+			NewLine();
+		}
+	}
+
+	// The rest of SkipWhitespace(), from a line break or comment on.
+	void JsonScanner::SkipLinesAndComments()
+	{
+		while (_current != _end)
+		{
+			switch (*_current)
+			{
+			case '\n':
+				++_current;
+				NewLine();
+				break;
+			case ' ':
+			case '\t':
+			case '\r':
+				++_current;
+				break;
+			case '/':
+				if (_syntax == JsonSyntax::Strict)
+				{
+					FailHere("Comments are not allowed");
+				}
+				++_current;
+				_lexeme = Lexeme::CommentStart;
+				if (!ContinueComment())
+				{
+					return;
+				}
+				break;
+			default:
+				return;
+			}
+		}
+	}
+
+	bool JsonScanner::ReadString()
+	{
+		// Most strings have no escapes and end inside the piece.
+		const char* run = ++_current;
+		const char* p = run;
+		while (p != _end && *p != '"' && *p != '\\' && *p != '\n')
+		{
+			++p;
+		}
+		if (p != _end && *p == '"')
+		{
+			_text.assign(run, p);
+			_current = p + 1;
+			return true;
+		}
+
+		_text.clear();
+		_lexeme = Lexeme::String;
+		return ContinueString();
+	}
+
+	bool JsonScanner::ReadNumber()
+	{
+		const char* start = _current;
+		if (*_current == '-')
+		{
+			++_current;
+		}
+
+		_text.clear();
+		_lexeme = Lexeme::NumberSign;
+		return ScanNumber(start);
+	}
+
+	bool JsonScanner::ReadLiteral(const char* literal)
+	{
+		size_t length = char_traits<char>::length(literal);
+		if (static_cast<size_t>(_end - _current) >= length)
+		{
+			if (char_traits<char>::compare(_current, literal, length) != 0)
+			{
+				Fail("Expected a value");
+			}
+			_current += length;
+			return true;
+		}
+
+		// Split across pieces, or cut short.
+		_literal = literal;
+		_matched = 0;
+		_lexeme = Lexeme::Literal;
+		return ContinueLiteral();
+	}
+
+	bool JsonScanner::Continue()
+	{
+		switch (_lexeme)
+		{
+		case Lexeme::None:
+			return true;
+		case Lexeme::String:
+		case Lexeme::Escape:
+		case Lexeme::Hex:
+		case Lexeme::LowSurrogateBackslash:
+		case Lexeme::LowSurrogateU:
+			return ContinueString();
+		case Lexeme::NumberSign:
+		case Lexeme::NumberInteger:
+		case Lexeme::NumberPoint:
+		case Lexeme::NumberFraction:
+		case Lexeme::NumberExponentMark:
+		case Lexeme::NumberExponentSign:
+		case Lexeme::NumberExponent:
+			return ScanNumber(_current);
+		case Lexeme::Literal:
+			return ContinueLiteral();
+		default:
+			return ContinueComment();
+		}
+	}
+
+	void JsonScanner::SkipRestOfString()
+	{
+		while (_current != _end && *_current != '"')
+		{
+			if (*_current == '\\' && _end - _current >= 2)
+			{
+				++_current;
+			}
+			SkipCharacter();
+		}
+		if (_current != _end)
+		{
+			++_current;
+		}
+		_lexeme = Lexeme::None;
+	}
+
+	void JsonScanner::Reset()
+	{
+		_lexeme = Lexeme::None;
+		_highSurrogate = 0;
+	}
+
+	void JsonScanner::Fail(const string& message) const
+	{
+		throw JsonSyntaxError(message, _tokenLine, _tokenColumn, _tokenOffset);
+	}
+
+	void JsonScanner::FailHere(const string& message) const
+	{
+		throw JsonSyntaxError(message, _line, Offset() - _lineOffset + 1, Offset());
+	}
+
+	// Runs of plain text are appended whole; each escape moves the lexeme on
+	// until the string is back to plain text.
+	bool JsonScanner::ContinueString()
+	{
+		for (;;)
+		{
+			switch (_lexeme)
+			{
+			case Lexeme::String:
+			{
+				const char* run = _current;
+				while (_current != _end && *_current != '"' && *_current != '\\')
+				{
+					if (*_current++ == '\n')
+					{
+						NewLine();
+					}
+				}
+				_text.append(run, _current);
+
+				if (_current == _end)
+				{
+					if (_isLast)
+					{
+						Fail("Missing '\"' at the end of a string");
+					}
+					return false;
+				}
+				if (*_current++ == '"')
+				{
+					_lexeme = Lexeme::None;
+					return true;
+				}
+				_lexeme = Lexeme::Escape;
+				break;
+			}
+
+			case Lexeme::Escape:
+				if (_current == _end)
+				{
+					if (_isLast)
+					{
+						Fail("Missing '\"' at the end of a string");
+					}
+					return false;
+				}
+				ReadEscape();
+				break;
+
+			case Lexeme::Hex:
+				if (!ContinueHex())
+				{
+					return false;
+				}
+				break;
+
+			default:
+				if (_current == _end)
+				{
+					if (_isLast)
+					{
+						FailHere("Expected a low surrogate after a high surrogate");
+					}
+					return false;
+				}
+				if (*_current != (_lexeme == Lexeme::LowSurrogateBackslash ? '\\' : 'u'))
+				{
+					FailHere("Expected a low surrogate after a high surrogate");
+				}
+				++_current;
+				if (_lexeme == Lexeme::LowSurrogateBackslash)
+				{
+					_lexeme = Lexeme::LowSurrogateU;
+				}
+				else
+				{
+					_lexeme = Lexeme::Hex;
+					_hexDigits = 0;
+					_codePoint = 0;
+				}
+				break;
+			}
+		}
+	}
+
+	// The character after a backslash.
+	void JsonScanner::ReadEscape()
+	{
+		_lexeme = Lexeme::String;
+		switch (*_current)
+		{
+		case '"': _text += '"'; break;
+		case '\\': _text += '\\'; break;
+		case '/': _text += '/'; break;
+		case 'b': _text += '\b'; break;
+		case 'f': _text += '\f'; break;
+		case 'n': _text += '\n'; break;
+		case 'r': _text += '\r'; break;
+		case 't': _text += '\t'; break;
+		case 'u':
+			_lexeme = Lexeme::Hex;
+			_hexDigits = 0;
+			_codePoint = 0;
+			break;
+		default:
+			FailHere("Invalid escape sequence in a string");
+		}
+		++_current;
+	}
+
+	bool JsonScanner::ContinueHex()
+	{
+		for (; _current != _end && _hexDigits < 4; ++_current, ++_hexDigits)
+		{
+			char c = *_current;
+			_codePoint <<= 4;
+			if (c >= '0' && c <= '9')
+			{
+				_codePoint += c - '0';
+			}
+			else if (c >= 'a' && c <= 'f')
+			{
+				_codePoint += c - 'a' + 10;
+			}
+			else if (c >= 'A' && c <= 'F')
+			{
+				_codePoint += c - 'A' + 10;
+			}
+			else
+			{
+				FailHere("Expected four hex digits after \\u");
+			}
+		}
+		if (_hexDigits < 4)
+		{
+			if (_isLast)
+			{
+				FailHere("Expected four hex digits after \\u");
+			}
+			return false;
+		}
+
+		if (_highSurrogate != 0)
+		{
+			if (_codePoint < 0xDC00 || _codePoint > 0xDFFF)
+			{
+				FailHere("Expected a low surrogate after a high surrogate");
+			}
+			_codePoint = 0x10000 + ((_highSurrogate - 0xD800) << 10) + (_codePoint - 0xDC00);
+			_highSurrogate = 0;
+		}
+		else if (_codePoint >= 0xD800 && _codePoint <= 0xDBFF)
+		{
+			_highSurrogate = _codePoint;
+			_lexeme = Lexeme::LowSurrogateBackslash;
+			return true;
+		}
+		AppendUtf8(_codePoint);
+		_lexeme = Lexeme::String;
+		return true;
+	}
+
+	void JsonScanner::AppendUtf8(uint32_t codePoint)
+	{
+		if (codePoint < 0x80)
+		{
+			_text += static_cast<char>(codePoint);
+		}
+		else if (codePoint < 0x800)
+		{
+			_text += static_cast<char>(0xC0 | (codePoint >> 6));
+			_text += static_cast<char>(0x80 | (codePoint & 0x3F));
+		}
+		else if (codePoint < 0x10000)
+		{
+			_text += static_cast<char>(0xE0 | (codePoint >> 12));
+			_text += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+			_text += static_cast<char>(0x80 | (codePoint & 0x3F));
+		}
+		else
+		{
+			_text += static_cast<char>(0xF0 | (codePoint >> 18));
+			_text += static_cast<char>(0x80 | ((codePoint >> 12) & 0x3F));
+			_text += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+			_text += static_cast<char>(0x80 | (codePoint & 0x3F));
+		}
+	}
+
+	// Each lexeme names what the number has read so far; the number ends at
+	// the first character that cannot continue it. 'run' is where the text
+	// not yet in Text() starts.
+	bool JsonScanner::ScanNumber(const char* run)
+	{
+		const char* p = _current;
+		Lexeme lexeme = _lexeme;
+		for (; p != _end; ++p)
+		{
+			char c = *p;
+			bool isDigit = c >= '0' && c <= '9';
+			switch (lexeme)
+			{
+			case Lexeme::NumberSign:
+				if (!isDigit)
+				{
+					_current = p;
+					FailHere("Expected a digit in a number");
+				}
+				lexeme = Lexeme::NumberInteger;
+				continue;
+			case Lexeme::NumberInteger:
+				if (isDigit)
+				{
+					continue;
+				}
+				if (c == '.')
+				{
+					lexeme = Lexeme::NumberPoint;
+					continue;
+				}
+				if (c == 'e' || c == 'E')
+				{
+					lexeme = Lexeme::NumberExponentMark;
+					continue;
+				}
+				break;
+			case Lexeme::NumberPoint:
+				if (!isDigit)
+				{
+					_current = p;
+					FailHere("Expected a digit in a number");
+				}
+				lexeme = Lexeme::NumberFraction;
+				continue;
+			case Lexeme::NumberFraction:
+				if (isDigit)
+				{
+					continue;
+				}
+				if (c == 'e' || c == 'E')
+				{
+					lexeme = Lexeme::NumberExponentMark;
+					continue;
+				}
+				break;
+			case Lexeme::NumberExponentMark:
+				if (c == '+' || c == '-')
+				{
+					lexeme = Lexeme::NumberExponentSign;
+					continue;
+				}
+				// fall through
+			case Lexeme::NumberExponentSign:
+				if (!isDigit)
+				{
+					_current = p;
+					FailHere("Expected a digit in a number");
+				}
+				lexeme = Lexeme::NumberExponent;
+				continue;
+			default:
+				if (isDigit)
+				{
+					continue;
+				}
+				break;
+			}
+			break;
+		}
+		_current = p;
+		_text.append(run, p);
+
+		_lexeme = lexeme;
+		if (p == _end && !_isLast)
+		{
+			return false;
+		}
+		if (lexeme != Lexeme::NumberInteger && lexeme != Lexeme::NumberFraction && lexeme != Lexeme::NumberExponent)
+		{
+			FailHere("Expected a digit in a number");
+		}
+		_lexeme = Lexeme::None;
+		return true;
+	}
+
+	bool JsonScanner::ContinueLiteral()
+	{
+		for (; _literal[_matched] != 0; ++_current, ++_matched)
+		{
+			if (_current == _end)
+			{
+				if (_isLast)
+				{
+					Fail("Expected a value");
+				}
+				return false;
+			}
+			if (*_current != _literal[_matched])
+			{
+				Fail("Expected a value");
+			}
+		}
+		_lexeme = Lexeme::None;
+		return true;
+	}
+
+	bool JsonScanner::ContinueComment()
+	{
+		if (_lexeme == Lexeme::CommentStart)
+		{
+			if (_current == _end)
+			{
+				if (_isLast)
+				{
+					FailHere("Expected a comment after '/'");
+				}
+				return false;
+			}
+			if (*_current != '/' && *_current != '*')
+			{
+				FailHere("Expected a comment after '/'");
+			}
+			_lexeme = *_current++ == '/' ? Lexeme::LineComment : Lexeme::BlockComment;
+		}
+
+		while (_current != _end)
+		{
+			char c = *_current;
+			if (_lexeme == Lexeme::LineComment)
+			{
+				// The line break is left to SkipWhitespace(), which counts it.
+				if (c == '\n' || c == '\r')
+				{
+					_lexeme = Lexeme::None;
+					return true;
+				}
+				++_current;
+				continue;
+			}
+
+			++_current;
+			if (_lexeme == Lexeme::BlockCommentStar && c == '/')
+			{
+				_lexeme = Lexeme::None;
+				return true;
+			}
+			_lexeme = c == '*' ? Lexeme::BlockCommentStar : Lexeme::BlockComment;
+			if (c == '\n')
+			{
+				NewLine();
+			}
+		}
+
+		if (!_isLast)
+		{
+			return false;
+		}
+		if (_lexeme == Lexeme::LineComment)
+		{
+			_lexeme = Lexeme::None;
+			return true;
+		}
+		FailHere("Missing '*/' at the end of a comment");
+	}
+
+	// Called just after a '\n' has been read.
+	void JsonScanner::NewLine()
+	{
+		++_line;
+		_lineOffset = Offset();
+	}
+}
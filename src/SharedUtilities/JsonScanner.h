@@ -0,0 +1,245 @@
+/*
+Copyright 2018 Microsoft
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH
+THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+
+namespace Utils
+{
+	// What a JsonTokenizer accepts. Lenient is what Json::CharReaderBuilder
+	// accepts by default, except that numbers must be well formed: the
+	// reader also takes a lone '-' as 0 and "1.", "1e" or "1e+" as 1.
+	// Strict is what its strictMode() accepts, except that the root may be
+	// any value: no comments, nothing after the root value, and no name
+	// twice in one object. Neither allows a trailing comma.
+	enum class JsonSyntax
+	{
+		Lenient,
+		Strict,
+	};
+
+	class JsonSyntaxError : public std::runtime_error
+	{
+	public:
+		JsonSyntaxError(const std::string& message, size_t line, size_t column, size_t offset);
+
+		size_t Line() const
+		{
+			return _line;
+		}
+
+		size_t Column() const
+		{
+			return _column;
+		}
+
+		// In bytes, from the start of the document.
+		size_t Offset() const
+		{
+			return _offset;
+		}
+
+		// What is wrong, without where.
+		const std::string& Message() const
+		{
+			return _message;
+		}
+
+	private:
+		std::string _message;
+		size_t _line;
+		size_t _column;
+		size_t _offset;
+	};
+
+	// The lexical half of JsonTokenizer and JsonPushParser: skips whitespace
+	// and comments, reads strings, numbers and literals, and keeps track of
+	// where each token starts. The text may come in pieces that end
+	// anywhere, even inside a token or comment, which is then carried on
+	// with the next piece; the grammar is left to its callers.
+	class JsonScanner
+	{
+	public:
+		explicit JsonScanner(JsonSyntax syntax);
+
+		// Reads 'begin' to 'end' next. 'isLast' if the document ends there:
+		// a token or comment still open at the end is then ended, or is an
+		// error.
+		void SetPiece(const char* begin, const char* end, bool isLast);
+
+		// Whether the piece is used up.
+		bool AtEnd() const
+		{
+			return _current == _end;
+		}
+
+		// The next character of the piece; only when not AtEnd().
+		char Peek() const
+		{
+			return *_current;
+		}
+
+		// Moves past Peek(), which must not be a line break.
+		void Advance()
+		{
+			++_current;
+		}
+
+		// Moves past Peek(), whatever it is.
+		void SkipCharacter();
+
+		// Skips whitespace and comments. Comments are an error in strict
+		// mode.
+		void SkipWhitespace()
+		{
+			while (_current != _end && (*_current == ' ' || *_current == '\t' || *_current == '\r'))
+			{
+				++_current;
+			}
+			if (_current != _end && (*_current == '\n' || *_current == '/'))
+			{
+				SkipLinesAndComments();
+			}
+		}
+
+		// Takes the next token to start at Peek().
+		void StartToken()
+		{
+			_tokenOffset = Offset();
+			_tokenLine = _line;
+			_tokenColumn = _tokenOffset - _lineOffset + 1;
+		}
+
+		// Each reads the token that starts at Peek() into Text(): a string
+		// decoded to UTF-8, a number as it is written, or the literal given.
+		// Returns whether the token is complete; if the piece ended inside
+		// it, Continue() carries on with it.
+		bool ReadString();
+		bool ReadNumber();
+		bool ReadLiteral(const char* literal);
+
+		// Whether the last piece ended inside a token or comment.
+		bool IsPending() const
+		{
+			return _lexeme != Lexeme::None;
+		}
+
+		// Carries on with the token or comment the last piece ended inside
+		// of. Returns whether it is now complete.
+		bool Continue();
+
+		// Whether an error was thrown from inside a string.
+		bool InString() const
+		{
+			return _lexeme >= Lexeme::String && _lexeme <= Lexeme::LowSurrogateU;
+		}
+
+		// Skips to just past the next unescaped '"', without decoding.
+		void SkipRestOfString();
+
+		// Forgets the token or comment an error was thrown from.
+		void Reset();
+
+		const std::string& Text() const
+		{
+			return _text;
+		}
+
+		// Where the last token started, counting from 1.
+		size_t TokenLine() const
+		{
+			return _tokenLine;
+		}
+
+		size_t TokenColumn() const
+		{
+			return _tokenColumn;
+		}
+
+		// In bytes, from the start of the document.
+		size_t TokenOffset() const
+		{
+			return _tokenOffset;
+		}
+
+		// Throws a JsonSyntaxError at the last token.
+		[[noreturn]] void Fail(const std::string& message) const;
+
+		// Throws a JsonSyntaxError at Peek().
+		[[noreturn]] void FailHere(const std::string& message) const;
+
+	private:
+		// The token, or comment, being read.
+		enum class Lexeme
+		{
+			None,
+			String,
+			Escape,
+			Hex,
+			LowSurrogateBackslash,
+			LowSurrogateU,
+			NumberSign,
+			NumberInteger,
+			NumberPoint,
+			NumberFraction,
+			NumberExponentMark,
+			NumberExponentSign,
+			NumberExponent,
+			Literal,
+			CommentStart,
+			LineComment,
+			BlockComment,
+			BlockCommentStar,
+		};
+
+		void SkipLinesAndComments();
+		bool ContinueString();
+		bool ContinueHex();
+		bool ScanNumber(const char* run);
+		bool ContinueLiteral();
+		bool ContinueComment();
+		void ReadEscape();
+		void AppendUtf8(uint32_t codePoint);
+		void NewLine();
+
+		// How many bytes of the document have been read.
+		size_t Offset() const
+		{
+			return _pieceOffset + static_cast<size_t>(_current - _pieceBegin);
+		}
+
+		JsonSyntax _syntax;
+		const char* _current;
+		const char* _end;
+		const char* _pieceBegin;
+		size_t _pieceOffset;
+		bool _isLast;
+		size_t _line;
+		size_t _lineOffset;
+		size_t _tokenLine;
+		size_t _tokenColumn;
+		size_t _tokenOffset;
+		Lexeme _lexeme;
+		const char* _literal;
+		size_t _matched;
+		uint32_t _hexDigits;
+		uint32_t _codePoint;
+		uint32_t _highSurrogate;
+		std::string _text;
+	};
+}
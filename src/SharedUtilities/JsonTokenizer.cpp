@@ -0,0 +1,424 @@
+/*
+Copyright 2018 Microsoft
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH
+THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "stdafx.h"
+#include <algorithm>
+#include "JsonTokenizer.h"
+
+using namespace std;
+
+namespace Utils
+{
+	string JsonDiagnostic::ToString() const
+	{
+		return "Line " + to_string(line) + ", Column " + to_string(column) + ", Offset " + to_string(offset) + ": " + message;
+	}
+
+	JsonTokenizer::JsonTokenizer(const char* begin, const char* end, JsonSyntax syntax) :
+		_scanner(syntax),
+		_syntax(syntax),
+		_state(State::Root)
+	{
+		_scanner.SetPiece(begin, end, true);
+	}
+
+	JsonToken JsonTokenizer::Next()
+	{
+		_scanner.SkipWhitespace();
+		_scanner.StartToken();
+
+		switch (_state)
+		{
+		case State::Done:
+			// Like Json::CharReaderBuilder's default failIfExtra = false.
+			if (_syntax == JsonSyntax::Strict && !_scanner.AtEnd())
+			{
+				_scanner.FailHere("Expected nothing after the root value");
+			}
+			return JsonToken::End;
+
+		case State::Root:
+		case State::ObjectValue:
+		case State::ArrayValue:
+			return ReadValue();
+
+		case State::ObjectFirst:
+			if (!_scanner.AtEnd() && _scanner.Peek() == '}')
+			{
+				CheckNames();
+				_scanner.Advance();
+				EndContainer();
+				return JsonToken::EndObject;
+			}
+			return ReadKey();
+
+		case State::ObjectKey:
+			return ReadKey();
+
+		case State::ObjectNext:
+			if (!_scanner.AtEnd() && _scanner.Peek() == ',')
+			{
+				_scanner.Advance();
+				_scanner.SkipWhitespace();
+				_scanner.StartToken();
+				return ReadKey();
+			}
+			if (!_scanner.AtEnd() && _scanner.Peek() == '}')
+			{
+				CheckNames();
+				_scanner.Advance();
+				EndContainer();
+				return JsonToken::EndObject;
+			}
+			_scanner.FailHere("Expected ',' or '}' after an object member");
+
+		case State::ArrayFirst:
+			if (!_scanner.AtEnd() && _scanner.Peek() == ']')
+			{
+				_scanner.Advance();
+				EndContainer();
+				return JsonToken::EndArray;
+			}
+			return ReadValue();
+
+		case State::ArrayNext:
+			if (!_scanner.AtEnd() && _scanner.Peek() == ',')
+			{
+				_scanner.Advance();
+				_scanner.SkipWhitespace();
+				_scanner.StartToken();
+				return ReadValue();
+			}
+			if (!_scanner.AtEnd() && _scanner.Peek() == ']')
+			{
+				_scanner.Advance();
+				EndContainer();
+				return JsonToken::EndArray;
+			}
+			_scanner.FailHere("Expected ',' or ']' after an array element");
+		}
+		_scanner.FailHere("Invalid tokenizer state");
+	}
+
+	void JsonTokenizer::SkipValue(JsonToken first)
+	{
+		if (first != JsonToken::BeginObject && first != JsonToken::BeginArray)
+		{
+			return;
+		}
+
+		size_t depth = 1;
+		while (depth > 0)
+		{
+			switch (Next())
+			{
+			case JsonToken::BeginObject:
+			case JsonToken::BeginArray:
+				++depth;
+				break;
+			case JsonToken::EndObject:
+			case JsonToken::EndArray:
+				--depth;
+				break;
+			default:
+				break;
+			}
+		}
+	}
+
+	void JsonTokenizer::Recover()
+	{
+		// The rest of a string the error was in, so that its closing quote
+		// is not taken for an opening one.
+		if (_scanner.InString())
+		{
+			_scanner.SkipRestOfString();
+		}
+		_scanner.Reset();
+
+		// Containers opened after the error are skipped whole.
+		size_t skipped = 0;
+		while (!_scanner.AtEnd())
+		{
+			switch (_scanner.Peek())
+			{
+			case '"':
+				_scanner.Advance();
+				_scanner.SkipRestOfString();
+				continue;
+			case '/':
+				if (_syntax == JsonSyntax::Lenient)
+				{
+					// A malformed comment is skipped as far as the scanner
+					// got with it.
+					try
+					{
+						_scanner.SkipWhitespace();
+					}
+					catch (const JsonSyntaxError&)
+					{
+						_scanner.Reset();
+					}
+					continue;
+				}
+				break;
+			case '{':
+			case '[':
+				++skipped;
+				break;
+			case ',':
+				if (skipped == 0 && !_containers.empty())
+				{
+					EndValue();
+					return;
+				}
+				break;
+			case '}':
+			case ']':
+			{
+				if (skipped > 0)
+				{
+					--skipped;
+					break;
+				}
+				char open = _scanner.Peek() == '}' ? '{' : '[';
+				if (find(_containers.begin(), _containers.end(), open) != _containers.end())
+				{
+					// Closes the containers it skips, and leaves the
+					// bracket for Next() to end its own.
+					while (_containers.back() != open)
+					{
+						EndContainer();
+					}
+					EndValue();
+					return;
+				}
+				break;
+			}
+			default:
+				break;
+			}
+			_scanner.SkipCharacter();
+		}
+
+		// Whatever is still open can never be closed.
+		while (!_containers.empty())
+		{
+			EndContainer();
+		}
+		_state = State::Done;
+	}
+
+	void JsonTokenizer::Fail(const string& message) const
+	{
+		_scanner.Fail(message);
+	}
+
+	JsonToken JsonTokenizer::ReadValue()
+	{
+		if (_scanner.AtEnd())
+		{
+			_scanner.FailHere("Expected a value");
+		}
+
+		switch (_scanner.Peek())
+		{
+		case '{':
+			Push('{');
+			return JsonToken::BeginObject;
+		case '[':
+			Push('[');
+			return JsonToken::BeginArray;
+		case '"':
+			_scanner.ReadString();
+			EndValue();
+			return JsonToken::String;
+		case 't':
+			return ReadLiteral("true", JsonToken::True);
+		case 'f':
+			return ReadLiteral("false", JsonToken::False);
+		case 'n':
+			return ReadLiteral("null", JsonToken::Null);
+		default:
+			if (_scanner.Peek() == '-' || (_scanner.Peek() >= '0' && _scanner.Peek() <= '9'))
+			{
+				_scanner.ReadNumber();
+				EndValue();
+				return JsonToken::Number;
+			}
+			_scanner.FailHere("Expected a value");
+		}
+	}
+
+	JsonToken JsonTokenizer::ReadKey()
+	{
+		if (_scanner.AtEnd() || _scanner.Peek() != '"')
+		{
+			_scanner.FailHere("Expected a member name");
+		}
+		_scanner.ReadString();
+		if (_syntax == JsonSyntax::Strict)
+		{
+			AddName();
+		}
+
+		_scanner.SkipWhitespace();
+		if (_scanner.AtEnd() || _scanner.Peek() != ':')
+		{
+			_scanner.FailHere("Expected ':' after a member name");
+		}
+		_scanner.Advance();
+		_state = State::ObjectValue;
+		return JsonToken::Key;
+	}
+
+	JsonToken JsonTokenizer::ReadLiteral(const char* literal, JsonToken token)
+	{
+		_scanner.ReadLiteral(literal);
+		EndValue();
+		return token;
+	}
+
+	void JsonTokenizer::Push(char container)
+	{
+		if (_containers.size() >= MaxDepth)
+		{
+			// Leaves the bracket for Recover() to skip its container whole.
+			_scanner.Fail("Exceeded the nesting limit");
+		}
+		_scanner.Advance();
+		_containers.push_back(container);
+		if (container == '{' && _syntax == JsonSyntax::Strict)
+		{
+			_objectNames.push_back(_names.size());
+		}
+		_state = container == '{' ? State::ObjectFirst : State::ArrayFirst;
+	}
+
+	void JsonTokenizer::EndContainer()
+	{
+		if (_containers.back() == '{' && _syntax == JsonSyntax::Strict)
+		{
+			size_t first = _objectNames.back();
+			_objectNames.pop_back();
+			_nameText.resize(first == _names.size() ? _nameText.size() : _names[first].begin);
+			_names.resize(first);
+		}
+		_containers.pop_back();
+		EndValue();
+	}
+
+	void JsonTokenizer::AddName()
+	{
+		Name name = { _nameText.size(), Text().size(), Line(), Column(), Offset() };
+		_nameText += Text();
+		_names.push_back(name);
+	}
+
+	// Throws at the first repeated name in the innermost object, which is
+	// then forgotten, so that the next call finds the next one.
+	void JsonTokenizer::CheckNames()
+	{
+		if (_syntax != JsonSyntax::Strict)
+		{
+			return;
+		}
+
+		size_t first = _objectNames.back();
+		if (_names.size() - first < 2)
+		{
+			return;
+		}
+
+		// Sorted by name, then by where it is, so a repeat follows the
+		// name it repeats.
+		_order.clear();
+		for (size_t i = first; i < _names.size(); ++i)
+		{
+			_order.push_back(i);
+		}
+		auto compare = [this](size_t a, size_t b)
+		{
+			return _nameText.compare(_names[a].begin, _names[a].length, _nameText, _names[b].begin, _names[b].length);
+		};
+		sort(_order.begin(), _order.end(), [&compare](size_t a, size_t b)
+		{
+			int order = compare(a, b);
+			return order != 0 ? order < 0 : a < b;
+		});
+
+		size_t repeat = _names.size();
+		for (size_t i = 1; i < _order.size(); ++i)
+		{
+			if (_order[i] < repeat && compare(_order[i - 1], _order[i]) == 0)
+			{
+				repeat = _order[i];
+			}
+		}
+		if (repeat == _names.size())
+		{
+			return;
+		}
+
+		Name name = _names[repeat];
+		_names.erase(_names.begin() + repeat);
+		throw JsonSyntaxError("Duplicate member name '" + _nameText.substr(name.begin, name.length) + "'", name.line, name.column, name.offset);
+	}
+
+	// Moves on to what can follow a value in the innermost open container.
+	void JsonTokenizer::EndValue()
+	{
+		if (_containers.empty())
+		{
+			_state = State::Done;
+		}
+		else
+		{
+			_state = _containers.back() == '{' ? State::ObjectNext : State::ArrayNext;
+		}
+	}
+
+	vector<JsonDiagnostic> ValidateJson(const char* begin, const char* end, JsonSyntax syntax, size_t maxErrors)
+	{
+		JsonTokenizer tokenizer(begin, end, syntax);
+		vector<JsonDiagnostic> diagnostics;
+		for (;;)
+		{
+			try
+			{
+				if (tokenizer.Next() == JsonToken::End)
+				{
+					break;
+				}
+			}
+			catch (const JsonSyntaxError& e)
+			{
+				diagnostics.push_back({ e.Message(), e.Line(), e.Column(), e.Offset() });
+				if (diagnostics.size() >= maxErrors)
+				{
+					break;
+				}
+				tokenizer.Recover();
+			}
+		}
+
+		// Repeated names are found when their object ends.
+		stable_sort(diagnostics.begin(), diagnostics.end(), [](const JsonDiagnostic& a, const JsonDiagnostic& b)
+		{
+			return a.offset < b.offset;
+		});
+		return diagnostics;
+	}
+}
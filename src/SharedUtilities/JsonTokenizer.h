@@ -0,0 +1,157 @@
+/*
+Copyright 2018 Microsoft
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH
+THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include "JsonScanner.h"
+
+namespace Utils
+{
+	enum class JsonToken
+	{
+		BeginObject,
+		EndObject,
+		BeginArray,
+		EndArray,
+		Key,
+		String,
+		Number,
+		True,
+		False,
+		Null,
+		End,
+	};
+
+	// A syntax error found by ValidateJson().
+	struct JsonDiagnostic
+	{
+		std::string message;
+		size_t line;
+		size_t column;
+		size_t offset;
+
+		// "Line {line}, Column {column}, Offset {offset}: {message}"
+		std::string ToString() const;
+	};
+
+	// Reads a JSON document one token at a time, without building a
+	// Json::Value, so callers can keep only the values they need. By default
+	// it accepts what Json::CharReaderBuilder accepts by default, less the
+	// malformed numbers JsonSyntax::Lenient lists: comments are skipped and
+	// anything after the root value is ignored. Nesting is
+	// tracked on the heap, so deep documents do not use up the stack.
+	class JsonTokenizer
+	{
+	public:
+		static constexpr size_t MaxDepth = 1000;
+
+		// The buffer must outlive the tokenizer.
+		JsonTokenizer(const char* begin, const char* end, JsonSyntax syntax = JsonSyntax::Lenient);
+
+		// Returns End after the root value. Throws JsonSyntaxError for
+		// malformed input; a name repeated in an object is reported when the
+		// object ends, at the repeat.
+		JsonToken Next();
+
+		// After Next() has thrown, skips to the next ',' or closing bracket
+		// of an open container, so that Next() can carry on from there. At
+		// the end of the input the document is ended.
+		void Recover();
+
+		// Skips the rest of the value whose first token was 'first'.
+		void SkipValue(JsonToken first);
+
+		// The decoded UTF-8 text of the last Key or String token, or the
+		// text of the last Number token.
+		const std::string& Text() const
+		{
+			return _scanner.Text();
+		}
+
+		// Where the last token started, counting from 1.
+		size_t Line() const
+		{
+			return _scanner.TokenLine();
+		}
+
+		size_t Column() const
+		{
+			return _scanner.TokenColumn();
+		}
+
+		// In bytes, from the start of the document.
+		size_t Offset() const
+		{
+			return _scanner.TokenOffset();
+		}
+
+		// Throws a JsonSyntaxError at the last token.
+		[[noreturn]] void Fail(const std::string& message) const;
+
+	private:
+		JsonTokenizer(const JsonTokenizer&);            // prevent copy
+		JsonTokenizer& operator=(const JsonTokenizer&);  // prevent assignment
+
+		enum class State
+		{
+			Root,
+			Done,
+			ObjectFirst,
+			ObjectKey,
+			ObjectValue,
+			ObjectNext,
+			ArrayFirst,
+			ArrayValue,
+			ArrayNext,
+		};
+
+		JsonToken ReadValue();
+		JsonToken ReadKey();
+		JsonToken ReadLiteral(const char* literal, JsonToken token);
+		void Push(char container);
+		void EndValue();
+		void EndContainer();
+		void AddName();
+		void CheckNames();
+
+		// A name read in an open object, in strict mode; its text is at
+		// 'begin' in _nameText.
+		struct Name
+		{
+			size_t begin;
+			size_t length;
+			size_t line;
+			size_t column;
+			size_t offset;
+		};
+
+		JsonScanner _scanner;
+		JsonSyntax _syntax;
+		State _state;
+		std::vector<char> _containers;
+		std::vector<Name> _names;
+		std::vector<size_t> _objectNames; // the first name of each open object
+		std::vector<size_t> _order;       // reused by CheckNames()
+		std::string _nameText;
+	};
+
+	// Reads the whole document, without building it, and returns every
+	// syntax error in it in order; none if it is well formed. After an error
+	// it carries on as JsonTokenizer::Recover() does, so that one mistake is
+	// mostly reported once. Stops after 'maxErrors'.
+	std::vector<JsonDiagnostic> ValidateJson(const char* begin, const char* end, JsonSyntax syntax = JsonSyntax::Lenient, size_t maxErrors = 100);
+}
@@ -75,7 +75,7 @@ void Logger::Log(Utils::ETWLogger::LoggingLevel level, const wchar_t* msg)
 	{
 		lock_guard<mutex> guard(_mutex);
 
-		wofstream logFile(_logFileName.c_str(), ofstream::out | ofstream::app);
+		wofstream logFile(Utils::FileStreamName(_logFileName), ofstream::out | ofstream::app);
 		if (logFile)
 		{
 			logFile << messageWithTime.c_str();
@@ -0,0 +1,93 @@
+/*
+Copyright 2018 Microsoft
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH
+THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#include "stdafx.h"
+#include <limits>
+#include <utility>
+#include "AutoCloseHandle.h"
+#include "DMBridgeException.h"
+#include "MappedFile.h"
+
+using namespace std;
+
+namespace Utils
+{
+	MappedFile::MappedFile(const wstring& fileName) :
+		_data(""),
+		_size(0),
+		_mapped(false)
+	{
+		HANDLE fileHandle = CreateFile(fileName.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+		if (fileHandle == INVALID_HANDLE_VALUE)
+		{
+			throw DMBridgeExceptionWithErrorCode("Failed to open file", GetLastError());
+		}
+		AutoCloseHandle file(move(fileHandle));
+
+		LARGE_INTEGER size;
+		if (!GetFileSizeEx(file.Get(), &size))
+		{
+			throw DMBridgeExceptionWithErrorCode("Failed to get the file size", GetLastError());
+		}
+		if (static_cast<uint64_t>(size.QuadPart) > numeric_limits<size_t>::max())
+		{
+			throw DMBridgeExceptionWithErrorCode("File is too large to map", ERROR_NOT_ENOUGH_MEMORY);
+		}
+		if (size.QuadPart == 0)
+		{
+			return;
+		}
+		if (static_cast<uint64_t>(size.QuadPart) < MapThreshold)
+		{
+			_buffer.resize(static_cast<size_t>(size.QuadPart));
+			DWORD read = 0;
+			if (!ReadFile(file.Get(), _buffer.data(), static_cast<DWORD>(_buffer.size()), &read, NULL))
+			{
+				throw DMBridgeExceptionWithErrorCode("Failed to read file", GetLastError());
+			}
+
+			// Less if the file was truncated since its size was taken.
+			_data = _buffer.data();
+			_size = read;
+			return;
+		}
+
+		// The view keeps the file mapped after both handles are closed.
+		AutoCloseHandle mapping(CreateFileMapping(file.Get(), NULL, PAGE_READONLY, 0, 0, NULL));
+		if (mapping.Get() == NULL)
+		{
+			throw DMBridgeExceptionWithErrorCode("Failed to map file", GetLastError());
+		}
+
+		const void* view = MapViewOfFile(mapping.Get(), FILE_MAP_READ, 0, 0, 0);
+		if (view == NULL)
+		{
+			throw DMBridgeExceptionWithErrorCode("Failed to map a view of file", GetLastError());
+		}
+
+		_data = static_cast<const char*>(view);
+		_size = static_cast<size_t>(size.QuadPart);
+		_mapped = true;
+	}
+
+	MappedFile::~MappedFile()
+	{
+		if (_mapped)
+		{
+			UnmapViewOfFile(_data);
+		}
+	}
+}
@@ -0,0 +1,59 @@
+/*
+Copyright 2018 Microsoft
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH
+THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+namespace Utils
+{
+	// A file mapped read-only into memory, so it can be parsed in place
+	// instead of being copied into a buffer first. The pages are shared with
+	// the file cache and only read in as they are touched. A file smaller
+	// than MapThreshold is read with one read instead, as setting up the
+	// mapping costs more than the copy it saves.
+	class MappedFile
+	{
+	public:
+		static constexpr size_t MapThreshold = 64 * 1024;
+
+		// Throws DMBridgeExceptionWithErrorCode if the file cannot be opened,
+		// read or mapped.
+		explicit MappedFile(const std::wstring& fileName);
+		~MappedFile();
+
+		// Never null; an empty file reads as "".
+		const char* Data() const
+		{
+			return _data;
+		}
+
+		size_t Size() const
+		{
+			return _size;
+		}
+
+	private:
+		MappedFile(const MappedFile&);            // prevent copy
+		MappedFile& operator=(const MappedFile&);  // prevent assignment
+
+		const char* _data;
+		size_t _size;
+		bool _mapped;
+		std::vector<char> _buffer;
+	};
+}
@@ -0,0 +1,330 @@
+/*
+Copyright 2018 Microsoft
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH
+THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "stdafx.h"
+#include <fstream>
+#include "RegistryStore.h"
+#include "RegistryUtils.h"
+#include "DMBridgeException.h"
+#include "Logger.h"
+
+using namespace std;
+
+namespace Utils
+{
+	Win32RegistryStore::Win32RegistryStore() :
+		_stopEvent(NULL)
+	{}
+
+	Win32RegistryStore::~Win32RegistryStore()
+	{
+		if (_stopEvent == NULL)
+		{
+			return;
+		}
+
+		SetEvent(_stopEvent);
+		for (unique_ptr<KeyWatch>& watch : _watches)
+		{
+			watch->thread.Join();
+			RegCloseKey(watch->key);
+			CloseHandle(watch->changeEvent);
+		}
+		CloseHandle(_stopEvent);
+	}
+
+	void Win32RegistryStore::WriteValue(const wstring& subKey, const wstring& propName, const wstring& propValue)
+	{
+		WriteRegistryValue(subKey, propName, propValue);
+	}
+
+	void Win32RegistryStore::WriteValue(const wstring& subKey, const wstring& propName, unsigned long propValue)
+	{
+		WriteRegistryValue(subKey, propName, propValue);
+	}
+
+	void Win32RegistryStore::WriteValues(const vector<RegistryValueWrite>& values)
+	{
+		WriteRegistryValues(values);
+	}
+
+	LSTATUS Win32RegistryStore::TryReadValue(const wstring& subKey, const wstring& propName, wstring& propValue) const
+	{
+		return TryReadRegistryValue(subKey, propName, propValue);
+	}
+
+	LSTATUS Win32RegistryStore::TryReadValue(const wstring& subKey, const wstring& propName, unsigned long& propValue) const
+	{
+		return TryReadRegistryValue(subKey, propName, propValue);
+	}
+
+	void Win32RegistryStore::WatchKey(const wstring& subKey, const function<void()>& onChange)
+	{
+		TRACEP(L"Watching registry key: ", subKey.c_str());
+		lock_guard<mutex> guard(_watchesMutex);
+
+		if (_stopEvent == NULL)
+		{
+			_stopEvent = CreateEvent(NULL, TRUE /*manual reset*/, FALSE, NULL);
+			if (_stopEvent == NULL)
+			{
+				throw DMBridgeExceptionWithErrorCode("Failed to create registry watch stop event.", GetLastError());
+			}
+		}
+
+		unique_ptr<KeyWatch> watch(new KeyWatch());
+		LSTATUS status = RegCreateKeyEx(HKEY_LOCAL_MACHINE, subKey.c_str(), 0, NULL, 0, KEY_NOTIFY, NULL, &watch->key, NULL);
+		if (status != ERROR_SUCCESS)
+		{
+			throw DMBridgeExceptionWithErrorCode("Failed to open registry key to watch.", status);
+		}
+
+		watch->changeEvent = CreateEvent(NULL, FALSE /*auto reset*/, FALSE, NULL);
+		if (watch->changeEvent == NULL)
+		{
+			DWORD lastError = GetLastError();
+			RegCloseKey(watch->key);
+			throw DMBridgeExceptionWithErrorCode("Failed to create registry watch event.", lastError);
+		}
+
+		// Do not return before the first notification is registered, or a
+		// change made right after WatchKey() returns could be missed.
+		promise<LSTATUS> registered;
+		future<LSTATUS> registeredStatus = registered.get_future();
+		watch->thread = thread(WatchThread, watch->key, watch->changeEvent, _stopEvent, onChange, move(registered));
+		status = registeredStatus.get();
+		if (status != ERROR_SUCCESS)
+		{
+			watch->thread.Join();
+			RegCloseKey(watch->key);
+			CloseHandle(watch->changeEvent);
+			throw DMBridgeExceptionWithErrorCode("Failed to watch registry key.", status);
+		}
+
+		_watches.push_back(move(watch));
+	}
+
+	void Win32RegistryStore::WatchThread(HKEY key, HANDLE changeEvent, HANDLE stopEvent, function<void()> onChange, promise<LSTATUS> registered)
+	{
+		// Asynchronous notifications end with the thread that asked for them,
+		// so this thread makes every request.
+		LSTATUS status = RegNotifyChangeKeyValue(key, FALSE, REG_NOTIFY_CHANGE_LAST_SET, changeEvent, TRUE);
+		registered.set_value(status);
+
+		const HANDLE events[] = { changeEvent, stopEvent };
+		while (status == ERROR_SUCCESS)
+		{
+			if (WaitForMultipleObjects(ARRAYSIZE(events), events, FALSE, INFINITE) != WAIT_OBJECT_0)
+			{
+				return;
+			}
+
+			// Notifications are one-shot; ask again before handling this one
+			// so a change made meanwhile is not missed.
+			status = RegNotifyChangeKeyValue(key, FALSE, REG_NOTIFY_CHANGE_LAST_SET, changeEvent, TRUE);
+
+			try
+			{
+				onChange();
+			}
+			catch (...)
+			{
+				TRACE("Registry change handler failed.");
+			}
+		}
+		TRACEP("Stopped watching registry key. Error: ", status);
+	}
+
+	void MemoryRegistryStore::Store(const ValueMap& values)
+	{
+		{
+			lock_guard<mutex> guard(_mutex);
+
+			// Only keep the new values once OnWrite() has accepted them.
+			ValueMap newValues = _values;
+			for (const auto& value : values)
+			{
+				newValues[value.first] = value.second;
+			}
+			OnWrite(newValues);
+			_values.swap(newValues);
+		}
+
+		vector<function<void()>> callbacks;
+		{
+			lock_guard<mutex> guard(_watchesMutex);
+			for (const auto& watch : _watches)
+			{
+				for (const auto& value : values)
+				{
+					if (_wcsicmp(watch.first.c_str(), value.first.first.c_str()) == 0)
+					{
+						callbacks.push_back(watch.second);
+						break;
+					}
+				}
+			}
+		}
+		for (const function<void()>& callback : callbacks)
+		{
+			callback();
+		}
+	}
+
+	void MemoryRegistryStore::WatchKey(const wstring& subKey, const function<void()>& onChange)
+	{
+		lock_guard<mutex> guard(_watchesMutex);
+		_watches.emplace_back(subKey, onChange);
+	}
+
+	void MemoryRegistryStore::WriteValue(const wstring& subKey, const wstring& propName, const wstring& propValue)
+	{
+		ValueMap values;
+		values[make_pair(subKey, propName)] = RegistryValue{ REG_SZ, propValue, 0 };
+		Store(values);
+	}
+
+	void MemoryRegistryStore::WriteValue(const wstring& subKey, const wstring& propName, unsigned long propValue)
+	{
+		ValueMap values;
+		values[make_pair(subKey, propName)] = RegistryValue{ REG_DWORD, wstring(), propValue };
+		Store(values);
+	}
+
+	void MemoryRegistryStore::WriteValues(const vector<RegistryValueWrite>& values)
+	{
+		ValueMap storedValues;
+		for (const RegistryValueWrite& value : values)
+		{
+			storedValues[make_pair(value.subKey, value.propName)] = RegistryValue{ REG_SZ, value.propValue, 0 };
+		}
+		Store(storedValues);
+	}
+
+	LSTATUS MemoryRegistryStore::TryReadValue(const wstring& subKey, const wstring& propName, wstring& propValue) const
+	{
+		lock_guard<mutex> guard(_mutex);
+		auto it = _values.find(make_pair(subKey, propName));
+		if (it == _values.end())
+		{
+			return ERROR_FILE_NOT_FOUND;
+		}
+		if (it->second.type != REG_SZ)
+		{
+			return ERROR_UNSUPPORTED_TYPE;
+		}
+		propValue = it->second.stringValue;
+		return ERROR_SUCCESS;
+	}
+
+	LSTATUS MemoryRegistryStore::TryReadValue(const wstring& subKey, const wstring& propName, unsigned long& propValue) const
+	{
+		lock_guard<mutex> guard(_mutex);
+		auto it = _values.find(make_pair(subKey, propName));
+		if (it == _values.end())
+		{
+			return ERROR_FILE_NOT_FOUND;
+		}
+		if (it->second.type != REG_DWORD)
+		{
+			return ERROR_UNSUPPORTED_TYPE;
+		}
+		propValue = it->second.dwordValue;
+		return ERROR_SUCCESS;
+	}
+
+	// The file holds one object per key, e.g.
+	// { "Software\\Microsoft\\IoTDMBridge": { "ConfigFile": "c:\\dmbridge.json", "Level": 1 } }
+	FileRegistryStore::FileRegistryStore(const wstring& fileName) :
+		_fileName(fileName)
+	{
+		TRACEP(L"Loading registry store: ", fileName);
+
+		ifstream file(FileStreamName(fileName), ifstream::binary);
+		if (!file.good())
+		{
+			// Nothing has been written yet.
+			return;
+		}
+
+		Json::CharReaderBuilder builder;
+		Json::Value root;
+		string errors;
+		if (!Json::parseFromStream(builder, file, &root, &errors) || !root.isObject())
+		{
+			throw DMBridgeExceptionWithErrorCode("Failed to parse registry store file.", ERROR_INVALID_DATA);
+		}
+
+		for (const string& subKey : root.getMemberNames())
+		{
+			const Json::Value& key = root[subKey];
+			if (!key.isObject())
+			{
+				throw DMBridgeExceptionWithErrorCode("Invalid key in registry store file.", ERROR_INVALID_DATA);
+			}
+
+			for (const string& propName : key.getMemberNames())
+			{
+				const Json::Value& value = key[propName];
+				pair<wstring, wstring> name(MultibyteToWide(subKey.c_str()), MultibyteToWide(propName.c_str()));
+				if (value.isString())
+				{
+					_values[name] = RegistryValue{ REG_SZ, MultibyteToWide(value.asCString()), 0 };
+				}
+				else if (value.isUInt())
+				{
+					_values[name] = RegistryValue{ REG_DWORD, wstring(), value.asUInt() };
+				}
+				else
+				{
+					throw DMBridgeExceptionWithErrorCode("Invalid value in registry store file.", ERROR_INVALID_DATA);
+				}
+			}
+		}
+	}
+
+	void FileRegistryStore::OnWrite(const ValueMap& values)
+	{
+		Json::Value root(Json::objectValue);
+		for (const auto& entry : values)
+		{
+			Json::Value& value = root[WideToMultibyte(entry.first.first.c_str())][WideToMultibyte(entry.first.second.c_str())];
+			if (entry.second.type == REG_SZ)
+			{
+				value = WideToMultibyte(entry.second.stringValue.c_str());
+			}
+			else
+			{
+				value = Json::UInt(entry.second.dwordValue);
+			}
+		}
+
+		// Replace the file in one step so a crash never leaves it half written.
+		wstring tempFileName = _fileName + L".tmp";
+		{
+			ofstream file(FileStreamName(tempFileName), ofstream::binary | ofstream::trunc);
+			file << root;
+			if (!file.good())
+			{
+				throw DMBridgeExceptionWithErrorCode("Failed to write registry store file.", ERROR_WRITE_FAULT);
+			}
+		}
+
+		if (!MoveFileEx(tempFileName.c_str(), _fileName.c_str(), MOVEFILE_REPLACE_EXISTING))
+		{
+			throw DMBridgeExceptionWithErrorCode("Failed to replace registry store file.", GetLastError());
+		}
+	}
+}
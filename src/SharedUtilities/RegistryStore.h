@@ -0,0 +1,151 @@
+/*
+Copyright 2018 Microsoft
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH
+THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <functional>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+#include <windows.h>
+#include "JoiningThread.h"
+#include "RegistryUtils.h"
+#include "StringUtils.h"
+
+namespace Utils
+{
+	// Storage for the HKEY_LOCAL_MACHINE values the bridge reads and writes.
+	// Writes throw DMBridgeExceptionWithErrorCode on failure; reads return the
+	// Win32 error, ERROR_FILE_NOT_FOUND for a missing value.
+	class IRegistryStore
+	{
+	public:
+		virtual ~IRegistryStore() {}
+
+		virtual void WriteValue(const std::wstring& subKey, const std::wstring& propName, const std::wstring& propValue) = 0;
+		virtual void WriteValue(const std::wstring& subKey, const std::wstring& propName, unsigned long propValue) = 0;
+
+		// Writes every value or none.
+		virtual void WriteValues(const std::vector<RegistryValueWrite>& values) = 0;
+
+		virtual LSTATUS TryReadValue(const std::wstring& subKey, const std::wstring& propName, std::wstring& propValue) const = 0;
+		virtual LSTATUS TryReadValue(const std::wstring& subKey, const std::wstring& propName, unsigned long& propValue) const = 0;
+
+		// Calls onChange() after values of subKey change, including through
+		// this store, for as long as the store exists. Several changes may be
+		// reported by one call.
+		virtual void WatchKey(const std::wstring& subKey, const std::function<void()>& onChange) = 0;
+	};
+
+	// The system registry, through the RegistryUtils functions.
+	class Win32RegistryStore : public IRegistryStore
+	{
+	public:
+		Win32RegistryStore();
+		~Win32RegistryStore();
+
+		void WriteValue(const std::wstring& subKey, const std::wstring& propName, const std::wstring& propValue) override;
+		void WriteValue(const std::wstring& subKey, const std::wstring& propName, unsigned long propValue) override;
+		void WriteValues(const std::vector<RegistryValueWrite>& values) override;
+
+		LSTATUS TryReadValue(const std::wstring& subKey, const std::wstring& propName, std::wstring& propValue) const override;
+		LSTATUS TryReadValue(const std::wstring& subKey, const std::wstring& propName, unsigned long& propValue) const override;
+
+		// Each watched key gets a thread waiting on RegNotifyChangeKeyValue();
+		// onChange() runs on that thread.
+		void WatchKey(const std::wstring& subKey, const std::function<void()>& onChange) override;
+
+	private:
+		Win32RegistryStore(const Win32RegistryStore&);            // prevent copy
+		Win32RegistryStore& operator=(const Win32RegistryStore&);  // prevent assignment
+
+		struct KeyWatch
+		{
+			HKEY key;
+			HANDLE changeEvent;
+			JoiningThread thread;
+		};
+
+		static void WatchThread(HKEY key, HANDLE changeEvent, HANDLE stopEvent, std::function<void()> onChange, std::promise<LSTATUS> registered);
+
+		std::mutex _watchesMutex;
+		HANDLE _stopEvent;
+		std::vector<std::unique_ptr<KeyWatch>> _watches;
+	};
+
+	// Values held in memory only; key and value names are case-insensitive,
+	// as in the registry.
+	class MemoryRegistryStore : public IRegistryStore
+	{
+	public:
+		void WriteValue(const std::wstring& subKey, const std::wstring& propName, const std::wstring& propValue) override;
+		void WriteValue(const std::wstring& subKey, const std::wstring& propName, unsigned long propValue) override;
+		void WriteValues(const std::vector<RegistryValueWrite>& values) override;
+
+		LSTATUS TryReadValue(const std::wstring& subKey, const std::wstring& propName, std::wstring& propValue) const override;
+		LSTATUS TryReadValue(const std::wstring& subKey, const std::wstring& propName, unsigned long& propValue) const override;
+
+		// onChange() runs on the writing thread once the write is stored.
+		void WatchKey(const std::wstring& subKey, const std::function<void()>& onChange) override;
+
+	protected:
+		struct RegistryValue
+		{
+			DWORD type;
+			std::wstring stringValue;
+			unsigned long dwordValue;
+		};
+
+		struct NameLess
+		{
+			bool operator() (const std::pair<std::wstring, std::wstring>& n1, const std::pair<std::wstring, std::wstring>& n2) const
+			{
+				CaseInsensitiveLess less;
+				return less(n1.first, n2.first) || (!less(n2.first, n1.first) && less(n1.second, n2.second));
+			}
+		};
+
+		typedef std::map<std::pair<std::wstring, std::wstring>, RegistryValue, NameLess> ValueMap;
+
+		// Called with the lock held on every write, with the values as they
+		// will be once the write succeeds; throwing rejects the write.
+		virtual void OnWrite(const ValueMap&) {}
+
+		void Store(const ValueMap& values);
+
+		mutable std::mutex _mutex;
+		ValueMap _values;
+
+		std::mutex _watchesMutex;
+		std::vector<std::pair<std::wstring, std::function<void()>>> _watches;
+	};
+
+	// A MemoryRegistryStore that loads from, and saves every write to, a JSON file.
+	class FileRegistryStore : public MemoryRegistryStore
+	{
+	public:
+		FileRegistryStore(const std::wstring& fileName);
+
+	protected:
+		void OnWrite(const ValueMap& values) override;
+
+	private:
+		std::wstring _fileName;
+	};
+}
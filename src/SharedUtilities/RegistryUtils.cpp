@@ -14,74 +14,300 @@ THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 */
 
 #include "stdafx.h"
+#include <map>
+#include <unordered_map>
+#include <memory>
 #include "RegistryUtils.h"
 #include "DMBridgeException.h"
 #include "Logger.h"
+#include "Tracing.h"
 
 using namespace std;
 
+// Most values the bridge reads fit in this many characters and take a single
+// RegGetValue call; longer ones are read again into a buffer of the size
+// reported by the first call.
+constexpr size_t StackBufferChars = 128;
+
+namespace
+{
+	typedef shared_ptr<HKEY__> SharedKey;
+
+	// HKEY_LOCAL_MACHINE sub keys kept open between calls, so reading or
+	// writing a value takes one registry call instead of an open, the call
+	// and a close. Keys are opened with only the access they are used for:
+	// KEY_QUERY_VALUE for reads, KEY_SET_VALUE for writes and both for batched
+	// writes. A key is closed once it is evicted and the last call using it
+	// has returned.
+	class RegistryKeyCache
+	{
+	public:
+		static RegistryKeyCache& Instance()
+		{
+			static RegistryKeyCache instance;
+			return instance;
+		}
+
+		LSTATUS Open(const wstring& subKey, REGSAM access, SharedKey& key)
+		{
+			lock_guard<mutex> lock(_mutex);
+			KeyMap& keys = KeysFor(access);
+
+			auto it = keys.find(subKey);
+			if (it != keys.end())
+			{
+				key = it->second;
+				return ERROR_SUCCESS;
+			}
+
+			HKEY hKey = NULL;
+			LSTATUS status;
+			if ((access & KEY_SET_VALUE) != 0)
+			{
+				status = RegCreateKeyEx(
+					HKEY_LOCAL_MACHINE,
+					subKey.c_str(),
+					0,      // reserved
+					NULL,   // user-defined class type of this key.
+					0,      // default; non-volatile
+					access,
+					NULL,   // inherit security descriptor from parent.
+					&hKey,
+					NULL    // disposition [optional, out]
+				);
+			}
+			else
+			{
+				// Missing keys are not cached, so a key created later is found.
+				status = RegOpenKeyEx(HKEY_LOCAL_MACHINE, subKey.c_str(), 0, access, &hKey);
+			}
+			if (status != ERROR_SUCCESS)
+			{
+				return status;
+			}
+
+			key = SharedKey(hKey, RegCloseKey);
+			keys[subKey] = key;
+			return ERROR_SUCCESS;
+		}
+
+		// Drops 'key' unless another caller has already replaced it.
+		void Evict(const wstring& subKey, REGSAM access, const SharedKey& key)
+		{
+			lock_guard<mutex> lock(_mutex);
+			KeyMap& keys = KeysFor(access);
+
+			auto it = keys.find(subKey);
+			if (it != keys.end() && it->second == key)
+			{
+				keys.erase(it);
+			}
+		}
+
+		void Clear()
+		{
+			lock_guard<mutex> lock(_mutex);
+			_keys.clear();
+		}
+
+	private:
+		// Keyed by the exact spelling of the sub key: callers pass the same
+		// constants every time, and a differently cased spelling only costs
+		// a second handle to the same key.
+		typedef unordered_map<wstring, SharedKey> KeyMap;
+
+		KeyMap& KeysFor(REGSAM access)
+		{
+			return _keys[access];
+		}
+
+		mutex _mutex;
+		map<REGSAM, KeyMap> _keys;
+	};
+
+	// Runs 'call' on the cached key. A key deleted since it was opened fails
+	// with ERROR_KEY_DELETED; it is then reopened, and created again for
+	// writes, and the call is retried once.
+	template<class Call>
+	LSTATUS WithCachedKey(const wstring& subKey, REGSAM access, Call call)
+	{
+		RegistryKeyCache& cache = RegistryKeyCache::Instance();
+		for (int attempt = 0; ; ++attempt)
+		{
+			SharedKey key;
+			LSTATUS status = cache.Open(subKey, access, key);
+			if (status != ERROR_SUCCESS)
+			{
+				return status;
+			}
+
+			status = call(key.get());
+			if (status != ERROR_KEY_DELETED || attempt > 0)
+			{
+				return status;
+			}
+			cache.Evict(subKey, access, key);
+		}
+	}
+
+	constexpr REGSAM BatchAccess = KEY_QUERY_VALUE | KEY_SET_VALUE;
+
+	// A value as it was before a batched write replaced it.
+	struct SavedValue
+	{
+		HKEY hKey;
+		const wstring* propName;
+		bool existed;
+		DWORD type;
+		vector<BYTE> data;
+	};
+
+	LSTATUS SaveValue(HKEY hKey, const wstring& propName, SavedValue& saved)
+	{
+		saved.hKey = hKey;
+		saved.propName = &propName;
+		saved.existed = false;
+
+		BYTE buffer[StackBufferChars * sizeof(wchar_t)];
+		DWORD dataSize = sizeof(buffer);
+		LSTATUS status = RegGetValue(hKey, NULL, propName.c_str(), RRF_RT_ANY | RRF_NOEXPAND, &saved.type, buffer, &dataSize);
+		if (status == ERROR_SUCCESS)
+		{
+			saved.data.assign(buffer, buffer + dataSize);
+		}
+		while (status == ERROR_MORE_DATA)
+		{
+			saved.data.resize(dataSize);
+			status = RegGetValue(hKey, NULL, propName.c_str(), RRF_RT_ANY | RRF_NOEXPAND, &saved.type, saved.data.data(), &dataSize);
+			saved.data.resize(dataSize);
+		}
+
+		if (status == ERROR_FILE_NOT_FOUND)
+		{
+			return ERROR_SUCCESS;
+		}
+		saved.existed = status == ERROR_SUCCESS;
+		return status;
+	}
+
+	void RestoreValue(const SavedValue& saved)
+	{
+		LSTATUS status = saved.existed ?
+			RegSetValueEx(saved.hKey, saved.propName->c_str(), 0, saved.type, saved.data.data(), static_cast<DWORD>(saved.data.size())) :
+			RegDeleteValue(saved.hKey, saved.propName->c_str());
+		if (status != ERROR_SUCCESS)
+		{
+			TRACEP(L"Error: Could not roll back registry value: ", saved.propName->c_str());
+		}
+	}
+
+	// Opens every key once, then writes the values in order, saving each
+	// value first. On failure, the values already written are put back in
+	// reverse order and the first error is returned.
+	LSTATUS WriteValuesOnce(const vector<Utils::RegistryValueWrite>& values, vector<SharedKey>& keys)
+	{
+		RegistryKeyCache& cache = RegistryKeyCache::Instance();
+		keys.clear();
+		keys.reserve(values.size());
+		for (const Utils::RegistryValueWrite& value : values)
+		{
+			SharedKey key;
+			LSTATUS status = cache.Open(value.subKey, BatchAccess, key);
+			if (status != ERROR_SUCCESS)
+			{
+				return status;
+			}
+			keys.push_back(key);
+		}
+
+		vector<SavedValue> written;
+		written.reserve(values.size());
+		LSTATUS status = ERROR_SUCCESS;
+		for (size_t i = 0; i < values.size() && status == ERROR_SUCCESS; ++i)
+		{
+			const Utils::RegistryValueWrite& value = values[i];
+			SavedValue saved;
+			status = SaveValue(keys[i].get(), value.propName, saved);
+			if (status == ERROR_SUCCESS)
+			{
+				status = RegSetValueEx(keys[i].get(), value.propName.c_str(), 0, REG_SZ, reinterpret_cast<const BYTE*>(value.propValue.c_str()), (static_cast<unsigned int>(value.propValue.size()) + 1) * sizeof(value.propValue[0]));
+			}
+			if (status == ERROR_SUCCESS)
+			{
+				written.push_back(move(saved));
+			}
+		}
+
+		if (status != ERROR_SUCCESS)
+		{
+			for (auto it = written.rbegin(); it != written.rend(); ++it)
+			{
+				RestoreValue(*it);
+			}
+		}
+		return status;
+	}
+}
+
 namespace Utils
 {
 	void WriteRegistryValue(const wstring& subKey, const wstring& propName, const wstring& propValue)
 	{
-		LSTATUS status;
-		HKEY hKey = NULL;
-		status = RegCreateKeyEx(
-			HKEY_LOCAL_MACHINE,
-			subKey.c_str(),
-			0,      // reserved
-			NULL,   // user-defined class type of this key.
-			0,      // default; non-volatile
-			KEY_ALL_ACCESS,
-			NULL,   // inherit security descriptor from parent.
-			&hKey,
-			NULL    // disposition [optional, out]
-		);
-		if (status != ERROR_SUCCESS) {
-			throw DMBridgeExceptionWithErrorCode(status);
-		}
+		TRACE_SPAN(span, "registry");
+		span.SetDetail(subKey, L"\\", propName);
 
-		status = RegSetValueEx(hKey, propName.c_str(), 0, REG_SZ, reinterpret_cast<const BYTE*>(propValue.c_str()), (static_cast<unsigned int>(propValue.size()) + 1) * sizeof(propValue[0]));
+		LSTATUS status = WithCachedKey(subKey, KEY_SET_VALUE, [&](HKEY hKey)
+		{
+			return RegSetValueEx(hKey, propName.c_str(), 0, REG_SZ, reinterpret_cast<const BYTE*>(propValue.c_str()), (static_cast<unsigned int>(propValue.size()) + 1) * sizeof(propValue[0]));
+		});
 		if (status != ERROR_SUCCESS) {
-			RegCloseKey(hKey);
 			throw DMBridgeExceptionWithErrorCode(status);
 		}
-
-		RegCloseKey(hKey);
 	}
 
 	void WriteRegistryValue(const wstring& subKey, const wstring& propName, unsigned long propValue)
 	{
-		LSTATUS status;
-		HKEY hKey = NULL;
-		status = RegCreateKeyEx(
-			HKEY_LOCAL_MACHINE,
-			subKey.c_str(),
-			0,      // reserved
-			NULL,   // user-defined class type of this key.
-			0,      // default; non-volatile
-			KEY_ALL_ACCESS,
-			NULL,   // inherit security descriptor from parent.
-			&hKey,
-			NULL    // disposition [optional, out]
-		);
+		TRACE_SPAN(span, "registry");
+		span.SetDetail(subKey, L"\\", propName);
+
+		LSTATUS status = WithCachedKey(subKey, KEY_SET_VALUE, [&](HKEY hKey)
+		{
+			return RegSetValueEx(hKey, propName.c_str(), 0, REG_DWORD, reinterpret_cast<const BYTE*>(&propValue), sizeof(propValue));
+		});
 		if (status != ERROR_SUCCESS) {
 			throw DMBridgeExceptionWithErrorCode(status);
 		}
+	}
+
+	void WriteRegistryValues(const vector<RegistryValueWrite>& values)
+	{
+		TRACE_SPAN(span, "registry");
+		span.SetDetail(values.size(), L" values");
 
-		status = RegSetValueEx(hKey, propName.c_str(), 0, REG_DWORD, reinterpret_cast<BYTE*>(&propValue), sizeof(propValue));
+		RegistryKeyCache& cache = RegistryKeyCache::Instance();
+		vector<SharedKey> keys;
+		LSTATUS status = WriteValuesOnce(values, keys);
+		if (status == ERROR_KEY_DELETED)
+		{
+			// Nothing was left written; reopen every key and try again.
+			for (size_t i = 0; i < keys.size(); ++i)
+			{
+				cache.Evict(values[i].subKey, BatchAccess, keys[i]);
+			}
+			status = WriteValuesOnce(values, keys);
+		}
 		if (status != ERROR_SUCCESS) {
-			RegCloseKey(hKey);
 			throw DMBridgeExceptionWithErrorCode(status);
 		}
-
-		RegCloseKey(hKey);
 	}
 
 	bool RegistryKeyExists(const wstring& subKey)
 	{
+		TRACE_SPAN(span, "registry");
+		span.SetDetail(subKey);
+
 		HKEY keyHandle = NULL;
-		LONG result = RegOpenKey(HKEY_LOCAL_MACHINE, subKey.c_str(), &keyHandle);
+		LONG result = RegOpenKeyEx(HKEY_LOCAL_MACHINE, subKey.c_str(), 0, KEY_QUERY_VALUE, &keyHandle);
 		if (result == ERROR_SUCCESS)
 		{
 			RegCloseKey(keyHandle);
@@ -92,46 +318,52 @@ namespace Utils
 
 	LSTATUS TryReadRegistryValue(const wstring& subKey, const wstring& propName, wstring& propValue)
 	{
-		DWORD dataSize = 0;
-		LSTATUS status;
-		status = RegGetValue(HKEY_LOCAL_MACHINE, subKey.c_str(), propName.c_str(), RRF_RT_REG_SZ, NULL, NULL, &dataSize);
-		if (status != ERROR_SUCCESS)
-		{
-			return status;
-		}
+		TRACE_SPAN(span, "registry");
+		span.SetDetail(subKey, L"\\", propName);
 
-		vector<char> data(dataSize);
-		status = RegGetValue(HKEY_LOCAL_MACHINE, subKey.c_str(), propName.c_str(), RRF_RT_REG_SZ, NULL, data.data(), &dataSize);
-		if (status != ERROR_SUCCESS)
+		return WithCachedKey(subKey, KEY_QUERY_VALUE, [&](HKEY hKey)
 		{
-			return status;
-		}
-
-		propValue = reinterpret_cast<const wchar_t*>(data.data());
+			wchar_t buffer[StackBufferChars];
+			DWORD dataSize = sizeof(buffer);
+			LSTATUS status = RegGetValue(hKey, NULL, propName.c_str(), RRF_RT_REG_SZ, NULL, buffer, &dataSize);
+			if (status == ERROR_SUCCESS)
+			{
+				propValue = buffer;
+				return status;
+			}
 
-		return ERROR_SUCCESS;
+			// The value can grow between calls, so keep going until it fits.
+			vector<wchar_t> data;
+			while (status == ERROR_MORE_DATA)
+			{
+				data.resize(dataSize / sizeof(wchar_t) + 1);
+				dataSize = static_cast<DWORD>(data.size() * sizeof(wchar_t));
+				status = RegGetValue(hKey, NULL, propName.c_str(), RRF_RT_REG_SZ, NULL, data.data(), &dataSize);
+			}
+			if (status == ERROR_SUCCESS)
+			{
+				propValue = data.data();
+			}
+			return status;
+		});
 	}
 
 	LSTATUS TryReadRegistryValue(const wstring& subKey, const wstring& propName, unsigned long& propValue)
 	{
-		DWORD dataSize = 0;
-		LSTATUS status;
-		status = RegGetValue(HKEY_LOCAL_MACHINE, subKey.c_str(), propName.c_str(), RRF_RT_REG_DWORD, NULL, NULL, &dataSize);
-		if (status != ERROR_SUCCESS)
-		{
-			return status;
-		}
+		TRACE_SPAN(span, "registry");
+		span.SetDetail(subKey, L"\\", propName);
 
-		vector<char> data(dataSize);
-		status = RegGetValue(HKEY_LOCAL_MACHINE, subKey.c_str(), propName.c_str(), RRF_RT_REG_DWORD, NULL, data.data(), &dataSize);
-		if (status != ERROR_SUCCESS)
+		return WithCachedKey(subKey, KEY_QUERY_VALUE, [&](HKEY hKey)
 		{
+			DWORD data = 0;
+			DWORD dataSize = sizeof(data);
+			LSTATUS status = RegGetValue(hKey, NULL, propName.c_str(), RRF_RT_REG_DWORD, NULL, &data, &dataSize);
+			if (status == ERROR_SUCCESS)
+			{
+				propValue = data;
+			}
 			return status;
-		}
-
-		propValue = *(reinterpret_cast<const unsigned long*>(data.data()));
-
-		return ERROR_SUCCESS;
+		});
 	}
 
 	wstring ReadRegistryValue(const wstring& subKey, const wstring& propName)
@@ -155,4 +387,9 @@ namespace Utils
 		}
 		return propValue;
 	}
+
+	void CloseRegistryKeys()
+	{
+		RegistryKeyCache::Instance().Clear();
+	}
 }
@@ -17,6 +17,7 @@ THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 #include <windows.h>
 #include <string>
+#include <vector>
 
 namespace Utils
 {
@@ -24,9 +25,25 @@ namespace Utils
 	void WriteRegistryValue(const std::wstring& subKey, const std::wstring& propName, const std::wstring& propValue);
 	void WriteRegistryValue(const std::wstring& subKey, const std::wstring& propName, unsigned long propValue);
 
+	// A string value written by WriteRegistryValues().
+	struct RegistryValueWrite
+	{
+		std::wstring subKey;
+		std::wstring propName;
+		std::wstring propValue;
+	};
+
+	// Writes every value or none: if a write fails, the values already
+	// written are restored and the error is thrown.
+	void WriteRegistryValues(const std::vector<RegistryValueWrite>& values);
+
 	LSTATUS TryReadRegistryValue(const std::wstring& subKey, const std::wstring& propName, std::wstring& propValue);
 	LSTATUS TryReadRegistryValue(const std::wstring& subKey, const std::wstring& propName, unsigned long& propValue);
 
 	std::wstring ReadRegistryValue(const std::wstring& subKey, const std::wstring& propName);
 	std::wstring ReadRegistryValue(const std::wstring& subKey, const std::wstring& propName, const std::wstring& propDefaultValue);
+
+	// Reads and writes keep the keys they use open. Closes them; keys still in
+	// use by a concurrent call are closed once that call returns.
+	void CloseRegistryKeys();
 }
@@ -0,0 +1,232 @@
+/*
+Copyright 2018 Microsoft
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH
+THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "stdafx.h"
+#include "RpcMetrics.h"
+
+using namespace std;
+
+namespace Utils
+{
+	namespace LatencyBuckets
+	{
+		static unsigned int HighestBit(uint64_t value)
+		{
+			unsigned int bit = 0;
+			if (value >> 32) { value >>= 32; bit += 32; }
+			if (value >> 16) { value >>= 16; bit += 16; }
+			if (value >> 8) { value >>= 8; bit += 8; }
+			if (value >> 4) { value >>= 4; bit += 4; }
+			if (value >> 2) { value >>= 2; bit += 2; }
+			if (value >> 1) { bit += 1; }
+			return bit;
+		}
+
+		size_t IndexOf(uint64_t nanoseconds)
+		{
+			if (nanoseconds > MaxValue)
+			{
+				nanoseconds = MaxValue;
+			}
+			if (nanoseconds < SubBucketCount)
+			{
+				return static_cast<size_t>(nanoseconds);
+			}
+
+			unsigned int shift = HighestBit(nanoseconds) - SubBucketBits;
+			size_t subBucket = static_cast<size_t>(nanoseconds >> shift) - SubBucketCount;
+			return SubBucketCount + shift * SubBucketCount + subBucket;
+		}
+
+		uint64_t LowerBound(size_t index)
+		{
+			if (index < SubBucketCount)
+			{
+				return index;
+			}
+
+			size_t shift = (index - SubBucketCount) / SubBucketCount;
+			size_t subBucket = (index - SubBucketCount) % SubBucketCount;
+			return static_cast<uint64_t>(SubBucketCount + subBucket) << shift;
+		}
+
+		uint64_t UpperBound(size_t index)
+		{
+			if (index < SubBucketCount)
+			{
+				return index;
+			}
+
+			size_t shift = (index - SubBucketCount) / SubBucketCount;
+			return LowerBound(index) + (uint64_t(1) << shift) - 1;
+		}
+	}
+
+	uint64_t RpcMethodSnapshot::MeanNanoseconds() const
+	{
+		uint64_t count = Count();
+		return count == 0 ? 0 : totalNanoseconds / count;
+	}
+
+	uint64_t RpcMethodSnapshot::PercentileNanoseconds(double percentile) const
+	{
+		uint64_t count = Count();
+		if (count == 0)
+		{
+			return 0;
+		}
+
+		uint64_t target = static_cast<uint64_t>(percentile / 100.0 * count + 0.5);
+		if (target == 0)
+		{
+			target = 1;
+		}
+
+		uint64_t seen = 0;
+		for (size_t i = 0; i < buckets.size(); ++i)
+		{
+			seen += buckets[i];
+			if (seen >= target)
+			{
+				uint64_t upperBound = LatencyBuckets::UpperBound(i);
+				return upperBound < maxNanoseconds ? upperBound : maxNanoseconds;
+			}
+		}
+		return maxNanoseconds;
+	}
+
+	Json::Value RpcMethodSnapshot::ToJson() const
+	{
+		Json::Value method(Json::objectValue);
+		method["name"] = name;
+		method["success"] = Json::UInt64(successCount);
+		method["error"] = Json::UInt64(errorCount);
+		method["meanNs"] = Json::UInt64(MeanNanoseconds());
+		method["p50Ns"] = Json::UInt64(PercentileNanoseconds(50.0));
+		method["p90Ns"] = Json::UInt64(PercentileNanoseconds(90.0));
+		method["p99Ns"] = Json::UInt64(PercentileNanoseconds(99.0));
+		method["maxNs"] = Json::UInt64(maxNanoseconds);
+		return method;
+	}
+
+	void RpcMethodMetrics::Interval::Reset()
+	{
+		for (atomic<uint64_t>& bucket : buckets)
+		{
+			bucket.store(0, memory_order_relaxed);
+		}
+		successCount.store(0, memory_order_relaxed);
+		errorCount.store(0, memory_order_relaxed);
+		totalNanoseconds.store(0, memory_order_relaxed);
+		maxNanoseconds.store(0, memory_order_relaxed);
+	}
+
+	RpcMethodMetrics::RpcMethodMetrics(const string& name) :
+		_name(name)
+	{
+		_intervals[0].Reset();
+		_intervals[1].Reset();
+		_totals.name = name;
+		_totals.buckets.resize(LatencyBuckets::Count);
+	}
+
+	void RpcMethodMetrics::Record(uint64_t nanoseconds, bool success)
+	{
+		int64_t epoch = _phaser.WriterEnter();
+		Interval& interval = _intervals[WriterReaderPhaser::ActiveIndex(epoch)];
+
+		interval.buckets[LatencyBuckets::IndexOf(nanoseconds)].fetch_add(1, memory_order_relaxed);
+		(success ? interval.successCount : interval.errorCount).fetch_add(1, memory_order_relaxed);
+		interval.totalNanoseconds.fetch_add(nanoseconds, memory_order_relaxed);
+
+		uint64_t currentMax = interval.maxNanoseconds.load(memory_order_relaxed);
+		while (nanoseconds > currentMax &&
+			!interval.maxNanoseconds.compare_exchange_weak(currentMax, nanoseconds, memory_order_relaxed))
+		{
+		}
+
+		_phaser.WriterExit(epoch);
+	}
+
+	void RpcMethodMetrics::Harvest(Interval& interval)
+	{
+		for (size_t i = 0; i < LatencyBuckets::Count; ++i)
+		{
+			_totals.buckets[i] += interval.buckets[i].load(memory_order_relaxed);
+		}
+		_totals.successCount += interval.successCount.load(memory_order_relaxed);
+		_totals.errorCount += interval.errorCount.load(memory_order_relaxed);
+		_totals.totalNanoseconds += interval.totalNanoseconds.load(memory_order_relaxed);
+
+		uint64_t intervalMax = interval.maxNanoseconds.load(memory_order_relaxed);
+		if (intervalMax > _totals.maxNanoseconds)
+		{
+			_totals.maxNanoseconds = intervalMax;
+		}
+
+		interval.Reset();
+	}
+
+	RpcMethodSnapshot RpcMethodMetrics::Snapshot()
+	{
+		lock_guard<mutex> lock(_phaser.ReaderLock());
+		Harvest(_intervals[_phaser.FlipPhase()]);
+		return _totals;
+	}
+
+	RpcMetrics& RpcMetrics::Instance()
+	{
+		static RpcMetrics instance;
+		return instance;
+	}
+
+	RpcMethodMetrics& RpcMetrics::GetMethod(const string& name)
+	{
+		lock_guard<mutex> lock(_methodsMutex);
+		for (RpcMethodMetrics& method : _methods)
+		{
+			if (method.Name() == name)
+			{
+				return method;
+			}
+		}
+		_methods.emplace_back(name);
+		return _methods.back();
+	}
+
+	vector<RpcMethodSnapshot> RpcMetrics::Snapshot()
+	{
+		lock_guard<mutex> lock(_methodsMutex);
+		vector<RpcMethodSnapshot> snapshots;
+		for (RpcMethodMetrics& method : _methods)
+		{
+			snapshots.push_back(method.Snapshot());
+		}
+		return snapshots;
+	}
+
+	Json::Value RpcMetrics::SnapshotJson()
+	{
+		Json::Value methods(Json::arrayValue);
+		for (const RpcMethodSnapshot& snapshot : Snapshot())
+		{
+			methods.append(snapshot.ToJson());
+		}
+
+		Json::Value root(Json::objectValue);
+		root["methods"] = methods;
+		return root;
+	}
+}
@@ -0,0 +1,166 @@
+/*
+Copyright 2018 Microsoft
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH
+THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "json/json.h"
+#include "WriterReaderPhaser.h"
+
+namespace Utils
+{
+	// HdrHistogram-style log-linear bucketing of nanosecond latencies.
+	// Values below 16ns map to their own bucket; above that, every power of two
+	// is split into 16 linear sub-buckets, which bounds the error to 1/16.
+	namespace LatencyBuckets
+	{
+		constexpr unsigned int SubBucketBits = 4;
+		constexpr unsigned int SubBucketCount = 1 << SubBucketBits;
+		constexpr unsigned int MaxMagnitude = 40; // ~18 minutes
+		constexpr uint64_t MaxValue = (uint64_t(1) << MaxMagnitude) - 1;
+		constexpr size_t Count = SubBucketCount + (MaxMagnitude - SubBucketBits) * SubBucketCount;
+
+		size_t IndexOf(uint64_t nanoseconds);
+		uint64_t LowerBound(size_t index);
+		uint64_t UpperBound(size_t index);
+	}
+
+	struct RpcMethodSnapshot
+	{
+		std::string name;
+		uint64_t successCount = 0;
+		uint64_t errorCount = 0;
+		uint64_t totalNanoseconds = 0;
+		uint64_t maxNanoseconds = 0;
+		std::vector<uint64_t> buckets;
+
+		uint64_t Count() const
+		{
+			return successCount + errorCount;
+		}
+
+		uint64_t MeanNanoseconds() const;
+		uint64_t PercentileNanoseconds(double percentile) const;
+		Json::Value ToJson() const;
+	};
+
+	class RpcMethodMetrics
+	{
+	public:
+		RpcMethodMetrics(const std::string& name);
+
+		void Record(uint64_t nanoseconds, bool success);
+		RpcMethodSnapshot Snapshot();
+
+		const std::string& Name() const
+		{
+			return _name;
+		}
+
+	private:
+		RpcMethodMetrics(const RpcMethodMetrics&);            // prevent copy
+		RpcMethodMetrics& operator=(const RpcMethodMetrics&);  // prevent assignment
+
+		struct Interval
+		{
+			std::atomic<uint64_t> buckets[LatencyBuckets::Count];
+			std::atomic<uint64_t> successCount;
+			std::atomic<uint64_t> errorCount;
+			std::atomic<uint64_t> totalNanoseconds;
+			std::atomic<uint64_t> maxNanoseconds;
+
+			void Reset();
+		};
+
+		void Harvest(Interval& interval);
+
+		std::string _name;
+		WriterReaderPhaser _phaser;
+		Interval _intervals[2];
+
+		// Accumulated from drained intervals; only touched under the reader lock.
+		RpcMethodSnapshot _totals;
+	};
+
+	class RpcMetrics
+	{
+	public:
+		static RpcMetrics& Instance();
+
+		// The returned reference stays valid for the lifetime of the process,
+		// so callers are expected to look it up once and keep it.
+		RpcMethodMetrics& GetMethod(const std::string& name);
+
+		std::vector<RpcMethodSnapshot> Snapshot();
+		Json::Value SnapshotJson();
+
+	private:
+		std::mutex _methodsMutex;
+		std::list<RpcMethodMetrics> _methods;
+	};
+
+	// Times a single RPC call. Complete() records the call as succeeded or
+	// failed based on its HRESULT; a scope that is left without Complete(),
+	// e.g. by an exception, is recorded as failed.
+	class RpcMetricsScope
+	{
+	public:
+		RpcMetricsScope(RpcMethodMetrics& method) :
+			_method(method),
+			_start(std::chrono::steady_clock::now()),
+			_completed(false)
+		{}
+
+		long Complete(long hresult)
+		{
+			Record(hresult >= 0 /*SUCCEEDED*/);
+			return hresult;
+		}
+
+		~RpcMetricsScope()
+		{
+			if (!_completed)
+			{
+				Record(false);
+			}
+		}
+
+	private:
+		RpcMetricsScope(const RpcMetricsScope&);            // prevent copy
+		RpcMetricsScope& operator=(const RpcMetricsScope&);  // prevent assignment
+
+		void Record(bool success)
+		{
+			_completed = true;
+			auto elapsed = std::chrono::steady_clock::now() - _start;
+			_method.Record(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()), success);
+		}
+
+		RpcMethodMetrics& _method;
+		std::chrono::steady_clock::time_point _start;
+		bool _completed;
+	};
+}
+
+// Declares 'scope', timing the enclosing RPC method for the rest of the block.
+#define RPC_METRICS_SCOPE(scope) \
+	static Utils::RpcMethodMetrics& scope##Method = Utils::RpcMetrics::Instance().GetMethod(__FUNCTION__); \
+	Utils::RpcMetricsScope scope(scope##Method)
@@ -18,6 +18,7 @@ THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include <vector>
 #include "ServiceManager.h"
 #include "Logger.h"
+#include "Tracing.h"
 #include "AutoCloseHandle.h"
 #include "DMBridgeException.h"
 
@@ -28,6 +29,8 @@ constexpr int SERVICE_WAIT_CYCLE_MS = 1000;
 DWORD ServiceManager::GetStatus(const wstring& serviceName)
 {
 	TRACE(__FUNCTION__);
+	TRACE_SPAN(span, "scm");
+	span.SetDetail(serviceName);
 
 	TRACEP(L"Checking the running state of service: ", serviceName.c_str());
 
@@ -69,6 +72,8 @@ void ServiceManager::WaitStatus(const wstring& serviceName, DWORD status, unsign
 DWORD ServiceManager::GetStartType(const wstring& serviceName)
 {
 	TRACE(__FUNCTION__);
+	TRACE_SPAN(span, "scm");
+	span.SetDetail(serviceName);
 
 	TRACEP(L"Checking the enabled state of service: ", serviceName.c_str());
 
@@ -103,6 +108,8 @@ DWORD ServiceManager::GetStartType(const wstring& serviceName)
 void ServiceManager::StartStop(const wstring& serviceName, bool start)
 {
 	TRACE(__FUNCTION__);
+	TRACE_SPAN(span, "scm");
+	span.SetDetail(serviceName);
 
 	TRACEP(L"Starting service: ", serviceName.c_str());
 
@@ -166,9 +173,38 @@ void ServiceManager::Stop(const wstring& serviceName)
 	StartStop(serviceName, false /*stop*/);
 }
 
+void ServiceManager::SendControl(const wstring& serviceName, DWORD control)
+{
+	TRACE(__FUNCTION__);
+	TRACE_SPAN(span, "scm");
+	span.SetDetail(serviceName);
+
+	TRACEP(L"Sending control to service: ", serviceName.c_str());
+
+	Utils::AutoCloseServiceHandle serviceManagerHandle = OpenSCManager(NULL /*local machine*/, SERVICES_ACTIVE_DATABASE, SC_MANAGER_CONNECT);
+	if (serviceManagerHandle.Get() == NULL)
+	{
+		throw DMBridgeExceptionWithErrorCode("OpenSCManager() failed.", GetLastError());
+	}
+
+	Utils::AutoCloseServiceHandle serviceHandle = OpenService(serviceManagerHandle.Get() /*scm manager*/, serviceName.c_str(), SERVICE_USER_DEFINED_CONTROL);
+	if (serviceHandle.Get() == NULL)
+	{
+		throw DMBridgeExceptionWithErrorCode("OpenService() failed.", GetLastError());
+	}
+
+	SERVICE_STATUS serviceStatus;
+	if (!ControlService(serviceHandle.Get(), control, &serviceStatus))
+	{
+		throw DMBridgeExceptionWithErrorCode("ControlService() failed.", GetLastError());
+	}
+}
+
 void ServiceManager::SetStartType(const wstring& serviceName, DWORD startType)
 {
 	TRACE(__FUNCTION__);
+	TRACE_SPAN(span, "scm");
+	span.SetDetail(serviceName);
 
 	TRACEP(L"Enabling auto startup for service: ", serviceName.c_str());
 
@@ -28,6 +28,9 @@ public:
 	static void SetStartType(const std::wstring& serviceName, DWORD startType);
 
 	static void WaitStatus(const std::wstring& serviceName, DWORD status, unsigned int maxWaitInSeconds);
+
+	// Sends a user-defined control code (128-255) to a running service.
+	static void SendControl(const std::wstring& serviceName, DWORD control);
 private:
 	static void StartStop(const std::wstring& serviceName, bool start);
 };
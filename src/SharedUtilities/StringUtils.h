@@ -31,6 +31,19 @@ namespace Utils
 	std::string WideToMultibyte(const wchar_t* s);
 	std::wstring MultibyteToWide(const char* s);
 
+	// File streams accept wide names on Windows only; elsewhere file names are UTF-8.
+#ifdef _WIN32
+	inline const wchar_t* FileStreamName(const std::wstring& fileName)
+	{
+		return fileName.c_str();
+	}
+#else
+	inline std::string FileStreamName(const std::wstring& fileName)
+	{
+		return WideToMultibyte(fileName.c_str());
+	}
+#endif
+
 	bool Contains(const std::wstring& container, const std::wstring& contained);
 
 	template<class T>
@@ -39,7 +52,7 @@ namespace Utils
 		std::basic_stringstream<T> ss;
 		ss.str(s);
 		std::basic_string<T> item;
-		while (getline<T>(ss, item, delim))
+		while (std::getline<T>(ss, item, delim))
 		{
 			tokens.push_back(item);
 		}
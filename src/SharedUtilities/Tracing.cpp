@@ -0,0 +1,193 @@
+/*
+Copyright 2018 Microsoft
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH
+THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "stdafx.h"
+#include <cstdio>
+#include "Tracing.h"
+
+using namespace std;
+using namespace std::chrono;
+
+static void WriteJsonString(ostream& stream, const char* value)
+{
+	stream << '"';
+	for (const char* c = value; *c != '\0'; ++c)
+	{
+		switch (*c)
+		{
+		case '"': stream << "\\\""; break;
+		case '\\': stream << "\\\\"; break;
+		default:
+			if (static_cast<unsigned char>(*c) < 0x20)
+			{
+				char escaped[8];
+				snprintf(escaped, sizeof(escaped), "\\u%04x", *c);
+				stream << escaped;
+			}
+			else
+			{
+				stream << *c;
+			}
+		}
+	}
+	stream << '"';
+}
+
+// Chrome expects microseconds; keep the nanoseconds as three decimals.
+static void WriteMicroseconds(ostream& stream, uint64_t nanoseconds)
+{
+	char formatted[32];
+	snprintf(formatted, sizeof(formatted), "%llu.%03u", static_cast<unsigned long long>(nanoseconds / 1000), static_cast<unsigned int>(nanoseconds % 1000));
+	stream << formatted;
+}
+
+namespace Utils
+{
+	Tracer& Tracer::Instance()
+	{
+		static Tracer instance;
+		return instance;
+	}
+
+	Tracer::Tracer() :
+		_enabled(false),
+		_dropped(0),
+		_epoch(steady_clock::now()),
+		_nextThreadId(1)
+	{}
+
+	void Tracer::Start()
+	{
+		lock_guard<mutex> lock(_buffersMutex);
+		for (shared_ptr<ThreadBuffer>& buffer : _buffers)
+		{
+			lock_guard<mutex> bufferLock(buffer->lock);
+			buffer->events.clear();
+		}
+		_dropped.store(0);
+		_enabled.store(true);
+	}
+
+	void Tracer::Stop()
+	{
+		_enabled.store(false);
+	}
+
+	uint64_t Tracer::Now() const
+	{
+		return static_cast<uint64_t>(duration_cast<nanoseconds>(steady_clock::now() - _epoch).count());
+	}
+
+	Tracer::ThreadBuffer& Tracer::LocalBuffer()
+	{
+		// The tracer keeps a reference too, so events of threads that have
+		// exited can still be exported.
+		thread_local shared_ptr<ThreadBuffer> localBuffer;
+		if (!localBuffer)
+		{
+			localBuffer = make_shared<ThreadBuffer>();
+
+			lock_guard<mutex> lock(_buffersMutex);
+			localBuffer->threadId = _nextThreadId++;
+			_buffers.push_back(localBuffer);
+		}
+		return *localBuffer;
+	}
+
+	void Tracer::Record(TraceEvent&& event)
+	{
+		ThreadBuffer& buffer = LocalBuffer();
+
+		lock_guard<mutex> lock(buffer.lock);
+		if (buffer.events.size() >= MaxEventsPerThread)
+		{
+			_dropped.fetch_add(1, memory_order_relaxed);
+			return;
+		}
+		buffer.events.push_back(move(event));
+	}
+
+	Json::Value Tracer::ExportChromeTrace()
+	{
+		Json::Value traceEvents(Json::arrayValue);
+
+		lock_guard<mutex> lock(_buffersMutex);
+		for (shared_ptr<ThreadBuffer>& buffer : _buffers)
+		{
+			lock_guard<mutex> bufferLock(buffer->lock);
+			for (const TraceEvent& event : buffer->events)
+			{
+				// Complete ("X") events; timestamps are in microseconds.
+				Json::Value traceEvent(Json::objectValue);
+				traceEvent["name"] = event.name;
+				traceEvent["cat"] = event.category;
+				traceEvent["ph"] = "X";
+				traceEvent["ts"] = event.startNanoseconds / 1000.0;
+				traceEvent["dur"] = event.durationNanoseconds / 1000.0;
+				traceEvent["pid"] = 1;
+				traceEvent["tid"] = buffer->threadId;
+				if (!event.detail.empty())
+				{
+					traceEvent["args"]["detail"] = event.detail;
+				}
+				traceEvents.append(traceEvent);
+			}
+		}
+
+		Json::Value root(Json::objectValue);
+		root["traceEvents"] = traceEvents;
+		root["displayTimeUnit"] = "ns";
+		root["otherData"]["droppedEvents"] = Json::UInt64(DroppedCount());
+		return root;
+	}
+
+	// Streams the same document ExportChromeTrace() builds, without
+	// materializing a Json::Value per event.
+	void Tracer::WriteChromeTrace(ostream& stream)
+	{
+		stream << "{\"traceEvents\":[";
+
+		bool first = true;
+		{
+			lock_guard<mutex> lock(_buffersMutex);
+			for (shared_ptr<ThreadBuffer>& buffer : _buffers)
+			{
+				lock_guard<mutex> bufferLock(buffer->lock);
+				for (const TraceEvent& event : buffer->events)
+				{
+					stream << (first ? "{\"name\":" : ",{\"name\":");
+					first = false;
+					WriteJsonString(stream, event.name);
+					stream << ",\"cat\":";
+					WriteJsonString(stream, event.category);
+					stream << ",\"ph\":\"X\",\"ts\":";
+					WriteMicroseconds(stream, event.startNanoseconds);
+					stream << ",\"dur\":";
+					WriteMicroseconds(stream, event.durationNanoseconds);
+					stream << ",\"pid\":1,\"tid\":" << buffer->threadId;
+					if (!event.detail.empty())
+					{
+						stream << ",\"args\":{\"detail\":";
+						WriteJsonString(stream, event.detail.c_str());
+						stream << "}";
+					}
+					stream << "}";
+				}
+			}
+		}
+
+		stream << "],\"displayTimeUnit\":\"ns\",\"otherData\":{\"droppedEvents\":" << DroppedCount() << "}}";
+	}
+}
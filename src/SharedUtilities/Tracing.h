@@ -0,0 +1,153 @@
+/*
+Copyright 2018 Microsoft
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH
+THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "json/json.h"
+#include "StringUtils.h"
+
+namespace Utils
+{
+	struct TraceEvent
+	{
+		const char* category;
+		const char* name;
+		uint64_t startNanoseconds;
+		uint64_t durationNanoseconds;
+		std::string detail;
+	};
+
+	// Collects completed spans into per-thread buffers while enabled, and
+	// exports them in the Chrome trace-event format (chrome://tracing or
+	// https://ui.perfetto.dev). Disabled by default; enabling it at runtime
+	// only costs one relaxed atomic load per span until then.
+	class Tracer
+	{
+	public:
+		static constexpr size_t MaxEventsPerThread = 64 * 1024;
+
+		static Tracer& Instance();
+
+		bool IsEnabled() const
+		{
+			return _enabled.load(std::memory_order_relaxed);
+		}
+
+		// Discards previously collected events and starts collecting.
+		void Start();
+		void Stop();
+
+		// Nanoseconds since the tracer was created.
+		uint64_t Now() const;
+
+		void Record(TraceEvent&& event);
+
+		// Events recorded after the buffer of their thread filled up.
+		uint64_t DroppedCount() const
+		{
+			return _dropped.load(std::memory_order_relaxed);
+		}
+
+		Json::Value ExportChromeTrace();
+		void WriteChromeTrace(std::ostream& stream);
+
+	private:
+		Tracer();
+		Tracer(const Tracer&);            // prevent copy
+		Tracer& operator=(const Tracer&);  // prevent assignment
+
+		struct ThreadBuffer
+		{
+			// Only contended while exporting or clearing.
+			std::mutex lock;
+			std::vector<TraceEvent> events;
+			uint32_t threadId;
+		};
+
+		ThreadBuffer& LocalBuffer();
+
+		std::atomic<bool> _enabled;
+		std::atomic<uint64_t> _dropped;
+		std::chrono::steady_clock::time_point _epoch;
+
+		std::mutex _buffersMutex;
+		std::vector<std::shared_ptr<ThreadBuffer>> _buffers;
+		uint32_t _nextThreadId;
+	};
+
+	// Records the time between its construction and destruction as a span,
+	// if the tracer was enabled when it was constructed. 'category' and 'name'
+	// must outlive the trace, e.g. string literals or __FUNCTION__.
+	class TraceSpan
+	{
+	public:
+		TraceSpan(const char* category, const char* name) :
+			_active(Tracer::Instance().IsEnabled()),
+			_category(category),
+			_name(name),
+			_start(_active ? Tracer::Instance().Now() : 0)
+		{}
+
+		~TraceSpan()
+		{
+			if (_active)
+			{
+				Tracer& tracer = Tracer::Instance();
+				tracer.Record({ _category, _name, _start, tracer.Now() - _start, std::move(_detail) });
+			}
+		}
+
+		bool IsActive() const
+		{
+			return _active;
+		}
+
+		// Attaches a description, e.g. a registry path, to the span. The
+		// parts are only formatted when the span is recorded.
+		template<class... Parts>
+		void SetDetail(const Parts&... parts)
+		{
+			if (_active)
+			{
+				std::wostringstream detail;
+				int expand[] = { 0, ((detail << parts), 0)... };
+				(void)expand;
+				_detail = WideToMultibyte(detail.str().c_str());
+			}
+		}
+
+	private:
+		TraceSpan(const TraceSpan&);            // prevent copy
+		TraceSpan& operator=(const TraceSpan&);  // prevent assignment
+
+		bool _active;
+		const char* _category;
+		const char* _name;
+		uint64_t _start;
+		std::string _detail;
+	};
+}
+
+// Declares 'span', tracing the enclosing function for the rest of the block.
+#define TRACE_SPAN(span, category) Utils::TraceSpan span(category, __FUNCTION__)
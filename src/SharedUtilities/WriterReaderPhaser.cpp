@@ -0,0 +1,51 @@
+/*
+Copyright 2018 Microsoft
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH
+THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "stdafx.h"
+#include <thread>
+#include "WriterReaderPhaser.h"
+
+using namespace std;
+
+namespace Utils
+{
+	WriterReaderPhaser::WriterReaderPhaser() :
+		_startEpoch(0),
+		_evenEndEpoch(0),
+		_oddEndEpoch(INT64_MIN)
+	{}
+
+	size_t WriterReaderPhaser::FlipPhase()
+	{
+		bool nextPhaseIsEven = _startEpoch.load() < 0;
+
+		// Reset the end counter of the phase we are about to start before
+		// publishing it, so writers entering it are counted from a known value.
+		int64_t initialStartValue = nextPhaseIsEven ? 0 : INT64_MIN;
+		(nextPhaseIsEven ? _evenEndEpoch : _oddEndEpoch).store(initialStartValue);
+
+		int64_t startValueAtFlip = _startEpoch.exchange(initialStartValue);
+
+		// Every writer that entered the old phase has exited once its end
+		// counter catches up with the start counter we swapped out.
+		atomic<int64_t>& oldEndEpoch = nextPhaseIsEven ? _oddEndEpoch : _evenEndEpoch;
+		while (oldEndEpoch.load(memory_order_acquire) != startValueAtFlip)
+		{
+			this_thread::yield();
+		}
+
+		return nextPhaseIsEven ? 1 : 0;
+	}
+}
@@ -0,0 +1,63 @@
+/*
+Copyright 2018 Microsoft
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH
+THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+
+namespace Utils
+{
+	// Lets any number of writers record into the active half of a double buffer
+	// without locking, while a single reader swaps the halves and waits for the
+	// writers still in the old half to leave before reading it.
+	class WriterReaderPhaser
+	{
+	public:
+		WriterReaderPhaser();
+
+		int64_t WriterEnter()
+		{
+			return _startEpoch.fetch_add(1);
+		}
+
+		void WriterExit(int64_t epoch)
+		{
+			(epoch < 0 ? _oddEndEpoch : _evenEndEpoch).fetch_add(1, std::memory_order_release);
+		}
+
+		// Index of the half a writer that entered with 'epoch' records into.
+		static size_t ActiveIndex(int64_t epoch)
+		{
+			return epoch < 0 ? 1 : 0;
+		}
+
+		// Must be called with ReaderLock() held. Returns the index of the
+		// half that is no longer written to.
+		size_t FlipPhase();
+
+		std::mutex& ReaderLock()
+		{
+			return _readerLock;
+		}
+
+	private:
+		std::atomic<int64_t> _startEpoch;
+		std::atomic<int64_t> _evenEndEpoch;
+		std::atomic<int64_t> _oddEndEpoch;
+		std::mutex _readerLock;
+	};
+}
@@ -359,12 +359,14 @@ class Features;
 // value.h
 typedef unsigned int ArrayIndex;
 class StaticString;
+class StaticKey;
 class Path;
 class PathArgument;
 class Value;
 class ValueIteratorBase;
 class ValueIterator;
 class ValueConstIterator;
+class SharedValue;
 
 } // namespace Json
 
@@ -473,6 +475,11 @@ public:
 #include <string>
 #include <vector>
 
+#include <atomic>
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <new>
 #ifndef JSON_USE_CPPTL_SMALLMAP
 #include <map>
 #else
@@ -608,6 +615,112 @@ private:
   const char* c_str_;
 };
 
+/** \brief A member name with its hash computed once, for names looked up
+ * often or in many objects.
+ *
+ * Wide objects index their members by this hash, so a lookup with a StaticKey
+ * hashes nothing. The name is not copied and must outlive the StaticKey.
+ *
+ * Example of usage:
+ * \code
+ * static const Json::StaticKey code("code");
+ * int value = object[code].asInt();
+ * \endcode
+ */
+class JSON_API StaticKey {
+public:
+  explicit StaticKey(const char* key)
+      : key_(key), length_(static_cast<unsigned>(strlen(key))),
+        hash_(hash(key, length_)) {}
+  StaticKey(const char* begin, const char* end)
+      : key_(begin), length_(static_cast<unsigned>(end - begin)),
+        hash_(hash(begin, length_)) {}
+
+  const char* data() const { return key_; }
+  unsigned length() const { return length_; }
+  unsigned hash() const { return hash_; }
+
+  /// FNV-1a of the name; what the member index of an object is keyed by.
+  static unsigned hash(const char* key, unsigned length) {
+    unsigned value = 2166136261u;
+    for (unsigned i = 0; i < length; ++i) {
+      value ^= static_cast<unsigned char>(key[i]);
+      value *= 16777619u;
+    }
+    return value;
+  }
+
+private:
+  const char* key_;
+  unsigned length_;
+  unsigned hash_;
+};
+
+/** \brief Monotonic memory for a parsed document.
+ *
+ * allocate() hands out memory from large blocks and never frees any of it on
+ * its own; all blocks are released at once when the Arena is destroyed. A
+ * CharReader built with the "arena" setting places the document it parses in
+ * an Arena owned by the root Value. See CharReaderBuilder::settings_.
+ */
+class JSON_API Arena {
+public:
+  Arena();
+  ~Arena();
+
+  void* allocate(size_t size, size_t alignment);
+
+private:
+  Arena(Arena const&);            // prevent copy
+  Arena& operator=(Arena const&); // prevent assignment
+
+  struct Block;
+  Block* blocks_;
+  char* current_;
+  char* end_;
+  size_t nextBlockSize_;
+};
+
+/** \brief Allocator of the maps of Value: from an Arena when it has one, else
+ * from the heap. Copying a map copies it to the heap, so a copy of part of an
+ * arena document can outlive the document.
+ */
+template <typename T> class ArenaAllocator {
+public:
+  typedef T value_type;
+  template <typename U> struct rebind { typedef ArenaAllocator<U> other; };
+
+  ArenaAllocator() : arena_(0) {}
+  explicit ArenaAllocator(Arena* arena) : arena_(arena) {}
+  template <typename U>
+  ArenaAllocator(ArenaAllocator<U> const& other) : arena_(other.arena()) {}
+
+  T* allocate(size_t n) {
+    if (arena_)
+      return static_cast<T*>(arena_->allocate(n * sizeof(T), alignof(T)));
+    return static_cast<T*>(::operator new(n * sizeof(T)));
+  }
+  void deallocate(T* p, size_t) {
+    if (!arena_)
+      ::operator delete(p);
+  }
+  ArenaAllocator select_on_container_copy_construction() const {
+    return ArenaAllocator();
+  }
+
+  Arena* arena() const { return arena_; }
+
+  template <typename U> bool operator==(ArenaAllocator<U> const& other) const {
+    return arena_ == other.arena();
+  }
+  template <typename U> bool operator!=(ArenaAllocator<U> const& other) const {
+    return arena_ != other.arena();
+  }
+
+private:
+  Arena* arena_;
+};
+
 /** \brief Represents a <a HREF="http://www.json.org">JSON</a> value.
  *
  * This class is a discriminated union wrapper that can represents a:
@@ -641,9 +754,19 @@ private:
  * exception if a bound is exceeded to avoid security holes in your app,
  * but the Value API does *not* check bounds. That is the responsibility
  * of the caller.
+ *
+ * \note A document parsed with the "arena" setting lives in an #Arena owned
+ * by its root. Its values may be read, modified and copied out, but must not
+ * be moved or swapped out of the document unless the root goes with them.
+ * removeMember() and removeIndex() copy what they remove out of the arena.
+ *
+ * \note Copying a Value copies all of it, so that references into either one
+ * stay valid however the other is changed. To hand out a document that is no
+ * longer changed without copying it, use a #SharedValue.
  */
 class JSON_API Value {
   friend class ValueIteratorBase;
+  friend class OurReader;
 
 public:
   typedef std::vector<JSONCPP_STRING> Members;
@@ -691,7 +814,8 @@ public:
   static const UInt64 maxUInt64;
 #endif // defined(JSON_HAS_INT64)
 
-  /// Default precision for real value for string representation.
+  /// Default precision for real value for string representation; at this
+  /// precision, reals are written with the shortest round-trip digits.
   static const UInt defaultRealPrecision;
 
 // Workaround for bug in the NVIDIAs CUDA 9.1 nvcc compiler
@@ -705,7 +829,12 @@ private:
 #ifndef JSONCPP_DOC_EXCLUDE_IMPLEMENTATION
   class CZString {
   public:
-    enum DuplicationPolicy { noDuplication = 0, duplicate, duplicateOnCopy };
+    enum DuplicationPolicy {
+      noDuplication = 0,
+      duplicate,
+      duplicateOnCopy,
+      interned // a name in the KeyTable its object holds
+    };
     CZString(ArrayIndex index);
     CZString(char const* str, unsigned length, DuplicationPolicy allocate);
     CZString(CZString const& other);
@@ -726,9 +855,14 @@ private:
     char const* data() const;
     unsigned length() const;
     bool isStaticString() const;
+    /// StaticKey::hash() of the name; an interned name carries its own.
+    unsigned hash() const;
+
+    enum { inlineCapacity = 16 };
 
   private:
     void swap(CZString& other);
+    void copyInline(CZString const& other);
 
     struct StringStorage {
       unsigned policy_ : 2;
@@ -740,11 +874,57 @@ private:
       ArrayIndex index_;
       StringStorage storage_;
     };
+    // Keys shorter than inlineCapacity are copied here rather than to the
+    // heap, and cstr_ points at it. Interned keys are never copied.
+    char inline_[inlineCapacity];
   };
 
+  class MemberIndex;
+  class KeyTable;
+
 public:
 #ifndef JSON_USE_CPPTL_SMALLMAP
-  typedef std::map<CZString, Value> ObjectValues;
+  typedef std::map<CZString,
+                   Value,
+                   std::less<CZString>,
+                   ArenaAllocator<std::pair<const CZString, Value> > >
+      MemberMap;
+
+  /** \brief The members of an object, or the elements of an array.
+   *
+   * A wide object also gets an index of its members by StaticKey::hash(),
+   * once lookups that could not add a member have paid for building it. Any
+   * change to the members drops it. Building it from a const lookup is safe
+   * while other threads read the same object.
+   *
+   * Members with interned names hold the KeyTable the names are in.
+   */
+  class ObjectValues : public MemberMap {
+  public:
+    ObjectValues();
+    ObjectValues(key_compare const& compare, allocator_type const& allocator);
+    ObjectValues(ObjectValues const& other);
+    ~ObjectValues();
+
+    /// The member index, if it has been built.
+    MemberIndex const* index() const;
+    /// Counts a lookup of a member, and returns the member index if the
+    /// lookups so far pay for it.
+    MemberIndex const* indexForLookup() const;
+    /// Drops the member index; called on every change to the members.
+    void invalidateIndex();
+
+    /// Holds the table that the names of members about to be added are
+    /// interned in.
+    void holdKeys(KeyTable* keys);
+
+  private:
+    ObjectValues& operator=(ObjectValues const&); // prevent assignment
+
+    mutable std::atomic<MemberIndex*> index_;
+    mutable std::atomic<unsigned> lookups_;
+    KeyTable* keys_;
+  };
 #else
   typedef CppTL::SmallMap<CZString, Value> ObjectValues;
 #endif // ifndef JSON_USE_CPPTL_SMALLMAP
@@ -963,6 +1143,12 @@ Json::Value obj_value(Json::objectValue); // {}
    * \endcode
    */
   Value& operator[](const StaticString& key);
+  /// Access an object value by name, create a null member if it does not exist.
+  /// The name is copied into a member it creates.
+  Value& operator[](const StaticKey& key);
+  /// Access an object value by name, returns null if there is no member with
+  /// that name.
+  const Value& operator[](const StaticKey& key) const;
 #ifdef JSON_USE_CPPTL
   /// Access an object value by name, create a null member if it does not exist.
   Value& operator[](const CppTL::ConstString& key);
@@ -991,6 +1177,8 @@ Json::Value obj_value(Json::objectValue); // {}
   /// and operator[]const
   /// \note As stated elsewhere, behavior is undefined if (end-begin) >= 2^30
   Value const* find(char const* begin, char const* end) const;
+  /// As find(begin, end), without hashing the name.
+  Value const* find(StaticKey const& key) const;
   /// Most general and efficient version of object-mutators.
   /// \note As stated elsewhere, behavior is undefined if (end-begin) >= 2^30
   /// \return non-zero, but JSON_ASSERT if this is neither object nor nullValue.
@@ -1080,12 +1268,19 @@ Json::Value obj_value(Json::objectValue); // {}
 
 private:
   void initBasic(ValueType type, bool allocated = false);
+  void initString(char const* str, unsigned length);
+  bool stringPayload(unsigned* length, char const** str) const;
+  Arena* initArenaRoot(ValueType type);
+  void initArenaContainer(ValueType type, Arena* arena);
+  void initArenaString(char const* str, unsigned length, Arena* arena);
   void dupPayload(const Value& other);
   void releasePayload();
   void dupMeta(const Value& other);
 
   Value& resolveReference(const char* key);
   Value& resolveReference(const char* key, const char* end);
+  Value& resolveReference(CZString const& key, KeyTable* keys);
+  Value* findMember(CZString const& key, ObjectValues::iterator& hint);
 
   struct CommentInfo {
     CommentInfo();
@@ -1113,11 +1308,16 @@ private:
     char* string_; // actually ptr to unsigned, followed by str, unless
                    // !allocated_
     ObjectValues* map_;
+    char inline_[16]; // strings shorter than this, when inlined_
   } value_;
   ValueType type_ : 8;
   unsigned int allocated_ : 1; // Notes: if declared as bool, bitfield is
                                // useless. If not allocated_, string_ must be
                                // null-terminated.
+  unsigned int inlined_ : 1;
+  unsigned int inlineLength_ : 5;
+  unsigned int arena_ : 1;     // the payload was allocated from an Arena
+  unsigned int ownsArena_ : 1; // the root of an arena document
   CommentInfo* comments_;
 
   // [start, limit) byte offsets in the source JSON text from which this Value
@@ -1358,6 +1558,44 @@ public:
 
 inline void swap(Value& a, Value& b) { a.swap(b); }
 
+/** \brief A Value that is no longer changed, shared instead of copied.
+ *
+ * Copying a SharedValue takes a counted reference to one Value, in constant
+ * time, however large it is. Nothing can change that Value, so references
+ * into it stay valid for as long as any SharedValue to it is kept, and any
+ * number of threads may read and copy it at once. A member or element of it
+ * is shared the same way, and keeps the whole document.
+ *
+ * To change a document, copy it out into a Value.
+ * \code
+ * Json::SharedValue config(std::move(root));
+ * Json::SharedValue section = config.get("servicemanager");
+ * Json::Value changed = *section; // deep copy
+ * \endcode
+ */
+class JSON_API SharedValue {
+public:
+  /// A null value.
+  SharedValue();
+  /// Takes the value; pass an rvalue to move it in instead of copying it.
+  explicit SharedValue(Value value);
+
+  const Value& operator*() const { return *value_; }
+  const Value* operator->() const { return value_.get(); }
+
+  /// The member named 'key', or null if there is none.
+  SharedValue get(const char* key) const;
+  SharedValue get(const JSONCPP_STRING& key) const;
+  /// The element at 'index', or null if there is none.
+  SharedValue get(ArrayIndex index) const;
+
+private:
+  SharedValue(std::shared_ptr<const Value> const& document,
+              const Value* value);
+
+  std::shared_ptr<const Value> value_;
+};
+
 } // namespace Json
 
 #pragma pack(pop)
@@ -1721,6 +1959,22 @@ public:
     - `"allowSpecialFloats": false or true`
       - If true, special float values (NaNs and infinities) are allowed
         and their values are lossfree restorable.
+    - `"arena": false or true`
+      - If true, an object or array document is allocated from an #Arena
+        owned by the root, and freed all at once with it. For short-lived
+        documents that are read and dropped.
+    - `"iterative": false or true`
+      - If true, nested objects and arrays are read with an explicit stack
+        rather than by recursion, so the native stack used does not depend
+        on the depth of the document, and stackLimit can be raised safely
+        for reading. The document read is the same either way. Copying,
+        writing and destroying a Value still recurse.
+    - `"internKeys": false or true`
+      - If true, the CharReader stores each distinct member name once for
+        all the documents it parses, rather than once per member, and
+        members with the same name compare by address. For a reader that
+        parses many documents of one schema. The documents may outlive the
+        reader.
 
     You can examine 'settings_` yourself
     to see the defaults. You can also write and read them just like any
@@ -1843,6 +2097,51 @@ namespace Json {
 
 class Value;
 
+/** \brief Growable byte buffer that the built-in StreamWriter appends to.
+ *
+ * Without a sink, the buffer collects the whole document, and take() hands
+ * it over without a copy. With a sink, every chunkSize bytes are passed on
+ * as they build up, so a large document is never held in memory whole.
+ */
+class JSON_API WriteBuffer {
+public:
+  /// Receives the next chunk of output; returns false if writing it failed.
+  typedef bool (*Sink)(void* context, char const* data, size_t size);
+
+  enum { defaultChunkSize = 64 * 1024 };
+
+  WriteBuffer();
+  WriteBuffer(Sink sink, void* context, size_t chunkSize = defaultChunkSize);
+
+  void append(char c) {
+    if (size_ == data_.size())
+      reserve(1);
+    data_[size_++] = c;
+  }
+  void append(char const* data, size_t size);
+  void append(JSONCPP_STRING const& text) { append(text.data(), text.size()); }
+
+  /// Passes whatever is buffered on to the sink, if there is one.
+  /// \return false if this or any earlier chunk could not be written.
+  bool flush();
+
+  /// The collected output, leaving the buffer empty.
+  JSONCPP_STRING take();
+
+private:
+  WriteBuffer(WriteBuffer const&);    // no impl
+  void operator=(WriteBuffer const&); // no impl
+
+  void reserve(size_t size);
+
+  JSONCPP_STRING data_; // data_.size() is the capacity; size_ is in use
+  size_t size_;
+  Sink sink_;
+  void* context_;
+  size_t chunkSize_;
+  bool good_;
+};
+
 /**
 
 Usage:
@@ -1870,6 +2169,13 @@ public:
    */
   virtual int write(Value const& root, JSONCPP_OSTREAM* sout) = 0;
 
+  /** Append Value to buffer as configured in sub-class.
+      The default goes through write() and an ostringstream; the writer
+      StreamWriterBuilder makes appends to the buffer directly.
+      \return zero on success
+   */
+  virtual int writeToBuffer(Value const& root, WriteBuffer* buffer);
+
   /** \brief A simple abstract factory.
    */
   class JSON_API Factory {
@@ -1882,12 +2188,22 @@ public:
   }; // Factory
 };   // StreamWriter
 
-/** \brief Write into stringstream, then return string, for convenience.
+/** \brief Write into a WriteBuffer, then return string, for convenience.
  * A StreamWriter will be created from the factory, used, and then deleted.
  */
 JSONCPP_STRING JSON_API writeString(StreamWriter::Factory const& factory,
                                     Value const& root);
 
+/** \brief Write to a file descriptor, chunkSize bytes at a time.
+ * The file descriptor is neither closed nor synced.
+ * \return false if a write to fd failed.
+ */
+bool JSON_API writeToDescriptor(
+    StreamWriter::Factory const& factory,
+    Value const& root,
+    int fd,
+    size_t chunkSize = WriteBuffer::defaultChunkSize);
+
 /** \brief Build a StreamWriter implementation.
 
 Usage:
@@ -1925,6 +2241,8 @@ public:
     infinity as "-Infinity".
     - "precision": int
       - Number of precision digits for formatting of real values.
+        At 17 (default) or more significant digits, writes the shortest text
+        that reads back as the same value instead.
     - "precisionType": "significant"(default) or "decimal"
       - Type of precision for formatting of real values.
 
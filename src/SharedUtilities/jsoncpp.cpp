@@ -215,6 +215,84 @@ template <typename Iter> Iter fixZerosInTheEnd(Iter begin, Iter end) {
   return end;
 }
 
+/// Powers of ten that a double holds exactly.
+static const double exactPowersOf10[] = {
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+static const int maxExactPowerOf10 = 22;
+
+/** Parses a JSON number when its value needs a single correctly rounded
+ * multiplication or division, i.e. at most 19 significant digits making up
+ * an integer below 2^53, scaled by at most 10^22 (Clinger's fast path).
+ * Covers almost every number in practice without the C library, which is
+ * slow and reads the decimal point from the current locale.
+ * @return false if the text is not a plain JSON number or is outside the
+ *         fast path; value is then left untouched.
+ */
+static inline bool decodeExactDouble(const char* begin, const char* end,
+                                     double& value) {
+  const char* current = begin;
+  bool isNegative = current != end && *current == '-';
+  if (isNegative)
+    ++current;
+
+  LargestUInt mantissa = 0;
+  int significantDigits = 0;
+  int exponent = 0;
+  const char* digits = current;
+  for (; current != end && *current >= '0' && *current <= '9'; ++current) {
+    if (significantDigits == 19)
+      return false;
+    mantissa = mantissa * 10 + static_cast<unsigned>(*current - '0');
+    if (mantissa != 0)
+      ++significantDigits;
+  }
+  if (current == digits)
+    return false;
+
+  if (current != end && *current == '.') {
+    digits = ++current;
+    for (; current != end && *current >= '0' && *current <= '9'; ++current) {
+      if (significantDigits == 19)
+        return false;
+      mantissa = mantissa * 10 + static_cast<unsigned>(*current - '0');
+      if (mantissa != 0)
+        ++significantDigits;
+      --exponent;
+    }
+    if (current == digits)
+      return false;
+  }
+
+  if (current != end && (*current == 'e' || *current == 'E')) {
+    ++current;
+    bool isNegativeExponent = current != end && *current == '-';
+    if (current != end && (*current == '-' || *current == '+'))
+      ++current;
+    int written = 0;
+    digits = current;
+    for (; current != end && *current >= '0' && *current <= '9'; ++current) {
+      if (written < 10000)
+        written = written * 10 + (*current - '0');
+    }
+    if (current == digits)
+      return false;
+    exponent += isNegativeExponent ? -written : written;
+  }
+
+  if (current != end || mantissa > (LargestUInt(1) << 53) ||
+      exponent < -maxExactPowerOf10 || exponent > maxExactPowerOf10)
+    return false;
+
+  double result = static_cast<double>(mantissa);
+  if (exponent < 0)
+    result /= exactPowersOf10[-exponent];
+  else
+    result *= exactPowersOf10[exponent];
+  value = isNegative ? -result : result;
+  return true;
+}
+
 } // namespace Json
 
 #endif // LIB_JSONCPP_JSON_TOOL_H_INCLUDED
@@ -1122,6 +1200,334 @@ bool Reader::pushError(const Value& value,
 
 bool Reader::good() const { return !errors_.size(); }
 
+// Scanning for OurReader and the writers
+// ////////////////////////////////
+// skipWhitespace returns the first byte in [p, end) that is not JSON
+// whitespace; findStringSpecial the first that is a quote, a backslash or a
+// control character, i.e. the end of a run that a string copies verbatim.
+// findEscapeSpecial also stops at bytes from 0x80 up, which the writers turn
+// into \u escapes.
+// All look at 16 or 32 bytes at a time where the CPU allows, picked once at
+// run time, and fall back to a byte at a time for the tail and elsewhere.
+
+#if defined(_M_X64) || defined(__x86_64__) ||                                 \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+#define JSONCPP_SCAN_X86 1
+#endif
+
+struct Scanner {
+  char const* (*skipWhitespace)(char const* p, char const* end);
+  char const* (*findStringSpecial)(char const* p, char const* end);
+  char const* (*findEscapeSpecial)(char const* p, char const* end);
+};
+
+static inline bool isJsonWhitespace(char c) {
+  return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+static inline bool isStringSpecial(char c) {
+  return c == '"' || c == '\\' || static_cast<unsigned char>(c) < 0x20;
+}
+
+static char const* skipWhitespaceScalar(char const* p, char const* end) {
+  while (p != end && isJsonWhitespace(*p))
+    ++p;
+  return p;
+}
+
+static char const* findStringSpecialScalar(char const* p, char const* end) {
+  while (p != end && !isStringSpecial(*p))
+    ++p;
+  return p;
+}
+
+static inline bool isEscapeSpecial(char c) {
+  return c == '"' || c == '\\' || static_cast<unsigned char>(c) < 0x20 ||
+         static_cast<unsigned char>(c) >= 0x80;
+}
+
+static char const* findEscapeSpecialScalar(char const* p, char const* end) {
+  while (p != end && !isEscapeSpecial(*p))
+    ++p;
+  return p;
+}
+
+#if defined(JSONCPP_SCAN_X86)
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define JSONCPP_TARGET_AVX2
+static inline unsigned firstSetBit(unsigned mask) {
+  unsigned long index;
+  _BitScanForward(&index, mask);
+  return static_cast<unsigned>(index);
+}
+static bool cpuHasAvx2() {
+  int info[4];
+  __cpuid(info, 0);
+  if (info[0] < 7)
+    return false;
+  __cpuid(info, 1);
+  bool osxsave = (info[2] & (1 << 27)) != 0;
+  if (!osxsave || (_xgetbv(0) & 6) != 6) // the OS saves the YMM registers
+    return false;
+  __cpuidex(info, 7, 0);
+  return (info[1] & (1 << 5)) != 0;
+}
+#else
+#include <immintrin.h>
+#define JSONCPP_TARGET_AVX2 __attribute__((target("avx2")))
+static inline unsigned firstSetBit(unsigned mask) {
+  return static_cast<unsigned>(__builtin_ctz(mask));
+}
+static bool cpuHasAvx2() { return __builtin_cpu_supports("avx2") != 0; }
+#endif
+
+static char const* skipWhitespaceSse2(char const* p, char const* end) {
+  const __m128i space = _mm_set1_epi8(' ');
+  const __m128i tab = _mm_set1_epi8('\t');
+  const __m128i cr = _mm_set1_epi8('\r');
+  const __m128i lf = _mm_set1_epi8('\n');
+  for (; end - p >= 16; p += 16) {
+    __m128i chunk = _mm_loadu_si128(reinterpret_cast<__m128i const*>(p));
+    __m128i whitespace = _mm_or_si128(
+        _mm_or_si128(_mm_cmpeq_epi8(chunk, space), _mm_cmpeq_epi8(chunk, tab)),
+        _mm_or_si128(_mm_cmpeq_epi8(chunk, cr), _mm_cmpeq_epi8(chunk, lf)));
+    unsigned mask = ~static_cast<unsigned>(_mm_movemask_epi8(whitespace)) & 0xFFFF;
+    if (mask)
+      return p + firstSetBit(mask);
+  }
+  return skipWhitespaceScalar(p, end);
+}
+
+static char const* findStringSpecialSse2(char const* p, char const* end) {
+  const __m128i quote = _mm_set1_epi8('"');
+  const __m128i backslash = _mm_set1_epi8('\\');
+  const __m128i control = _mm_set1_epi8(0x1F);
+  for (; end - p >= 16; p += 16) {
+    __m128i chunk = _mm_loadu_si128(reinterpret_cast<__m128i const*>(p));
+    __m128i special = _mm_or_si128(
+        _mm_or_si128(_mm_cmpeq_epi8(chunk, quote),
+                     _mm_cmpeq_epi8(chunk, backslash)),
+        _mm_cmpeq_epi8(_mm_max_epu8(chunk, control), control));
+    unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(special));
+    if (mask)
+      return p + firstSetBit(mask);
+  }
+  return findStringSpecialScalar(p, end);
+}
+
+static char const* findEscapeSpecialSse2(char const* p, char const* end) {
+  const __m128i quote = _mm_set1_epi8('"');
+  const __m128i backslash = _mm_set1_epi8('\\');
+  const __m128i space = _mm_set1_epi8(0x20);
+  for (; end - p >= 16; p += 16) {
+    __m128i chunk = _mm_loadu_si128(reinterpret_cast<__m128i const*>(p));
+    // As signed bytes, 0x80 and up are negative and so also below ' '.
+    __m128i special = _mm_or_si128(
+        _mm_or_si128(_mm_cmpeq_epi8(chunk, quote),
+                     _mm_cmpeq_epi8(chunk, backslash)),
+        _mm_cmplt_epi8(chunk, space));
+    unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(special));
+    if (mask)
+      return p + firstSetBit(mask);
+  }
+  return findEscapeSpecialScalar(p, end);
+}
+
+JSONCPP_TARGET_AVX2
+static char const* skipWhitespaceAvx2(char const* p, char const* end) {
+  const __m256i space = _mm256_set1_epi8(' ');
+  const __m256i tab = _mm256_set1_epi8('\t');
+  const __m256i cr = _mm256_set1_epi8('\r');
+  const __m256i lf = _mm256_set1_epi8('\n');
+  for (; end - p >= 32; p += 32) {
+    __m256i chunk = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(p));
+    __m256i whitespace = _mm256_or_si256(
+        _mm256_or_si256(_mm256_cmpeq_epi8(chunk, space),
+                        _mm256_cmpeq_epi8(chunk, tab)),
+        _mm256_or_si256(_mm256_cmpeq_epi8(chunk, cr),
+                        _mm256_cmpeq_epi8(chunk, lf)));
+    unsigned mask = ~static_cast<unsigned>(_mm256_movemask_epi8(whitespace));
+    if (mask)
+      return p + firstSetBit(mask);
+  }
+  return skipWhitespaceSse2(p, end);
+}
+
+JSONCPP_TARGET_AVX2
+static char const* findStringSpecialAvx2(char const* p, char const* end) {
+  const __m256i quote = _mm256_set1_epi8('"');
+  const __m256i backslash = _mm256_set1_epi8('\\');
+  const __m256i control = _mm256_set1_epi8(0x1F);
+  for (; end - p >= 32; p += 32) {
+    __m256i chunk = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(p));
+    __m256i special = _mm256_or_si256(
+        _mm256_or_si256(_mm256_cmpeq_epi8(chunk, quote),
+                        _mm256_cmpeq_epi8(chunk, backslash)),
+        _mm256_cmpeq_epi8(_mm256_max_epu8(chunk, control), control));
+    unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8(special));
+    if (mask)
+      return p + firstSetBit(mask);
+  }
+  return findStringSpecialSse2(p, end);
+}
+
+JSONCPP_TARGET_AVX2
+static char const* findEscapeSpecialAvx2(char const* p, char const* end) {
+  const __m256i quote = _mm256_set1_epi8('"');
+  const __m256i backslash = _mm256_set1_epi8('\\');
+  const __m256i space = _mm256_set1_epi8(0x20);
+  for (; end - p >= 32; p += 32) {
+    __m256i chunk = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(p));
+    __m256i special = _mm256_or_si256(
+        _mm256_or_si256(_mm256_cmpeq_epi8(chunk, quote),
+                        _mm256_cmpeq_epi8(chunk, backslash)),
+        _mm256_cmpgt_epi8(space, chunk));
+    unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8(special));
+    if (mask)
+      return p + firstSetBit(mask);
+  }
+  return findEscapeSpecialSse2(p, end);
+}
+#endif // if defined(JSONCPP_SCAN_X86)
+
+static Scanner selectScanner() {
+#if defined(JSONCPP_SCAN_X86)
+  if (cpuHasAvx2()) {
+    Scanner avx2 = {skipWhitespaceAvx2, findStringSpecialAvx2,
+                    findEscapeSpecialAvx2};
+    return avx2;
+  }
+  Scanner sse2 = {skipWhitespaceSse2, findStringSpecialSse2,
+                  findEscapeSpecialSse2};
+  return sse2;
+#else
+  Scanner scalar = {skipWhitespaceScalar, findStringSpecialScalar,
+                    findEscapeSpecialScalar};
+  return scalar;
+#endif
+}
+
+static Scanner const& scanner() {
+  static Scanner const selected = selectScanner();
+  return selected;
+}
+
+// Implementation of class Value::KeyTable
+// ////////////////////////////////
+
+// A member name interned by a KeyTable. The name and a terminating zero
+// follow it, and the keys with that name point at them.
+struct InternedKey {
+  unsigned hash_; // StaticKey::hash() of the name
+  unsigned length_;
+  void const* table_; // the KeyTable that interned it, and frees it
+};
+
+static InternedKey const* internedKey(char const* name) {
+  return reinterpret_cast<InternedKey const*>(name) - 1;
+}
+
+// The member names read by a CharReader built with "internKeys": each
+// distinct name is stored once for all the documents it parses. The table
+// is counted: the reader and every object with interned names hold a
+// reference, so the documents may outlive the reader, and the names need no
+// count of their own. Only the reader adds names, one parse at a time.
+class Value::KeyTable {
+public:
+  // Longer names are left to their documents; they are rare, and differ
+  // from each other within the first few bytes anyway.
+  static const unsigned maxLength = 256;
+  // So are names past this many, so that a reader fed names that never
+  // repeat does not keep them all.
+  static const size_t maxNames = 4096;
+
+  KeyTable();
+
+  void retain();
+  void release();
+
+  // The interned copy of the name, or 0 if it is not interned.
+  char const* intern(char const* name, unsigned length);
+
+  // Two different names interned by one table are never equal.
+  static bool together(char const* name, char const* other) {
+    return internedKey(name)->table_ == internedKey(other)->table_;
+  }
+
+private:
+  ~KeyTable();
+  KeyTable(KeyTable const&);            // prevent copy
+  KeyTable& operator=(KeyTable const&); // prevent assignment
+
+  void grow();
+
+  std::atomic<unsigned> references_;
+  size_t size_;
+  // Open addressing, at most half full.
+  std::vector<InternedKey*> slots_;
+};
+
+Value::KeyTable::KeyTable() : references_(1), size_(0), slots_(64) {}
+
+Value::KeyTable::~KeyTable() {
+  for (size_t slot = 0; slot < slots_.size(); ++slot)
+    ::operator delete(slots_[slot]);
+}
+
+void Value::KeyTable::retain() {
+  references_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void Value::KeyTable::release() {
+  if (references_.fetch_sub(1, std::memory_order_acq_rel) == 1)
+    delete this;
+}
+
+char const* Value::KeyTable::intern(char const* name, unsigned length) {
+  if (length > maxLength)
+    return 0;
+  unsigned hash = StaticKey::hash(name, length);
+  size_t mask = slots_.size() - 1;
+  size_t slot = hash & mask;
+  for (; slots_[slot]; slot = (slot + 1) & mask) {
+    InternedKey const* key = slots_[slot];
+    char const* keyName = reinterpret_cast<char const*>(key + 1);
+    if (key->hash_ == hash && key->length_ == length &&
+        memcmp(keyName, name, length) == 0)
+      return keyName;
+  }
+  if (size_ == maxNames)
+    return 0;
+
+  InternedKey* key = static_cast<InternedKey*>(
+      ::operator new(sizeof(InternedKey) + length + 1));
+  key->hash_ = hash;
+  key->length_ = length;
+  key->table_ = this;
+  char* keyName = reinterpret_cast<char*>(key + 1);
+  memcpy(keyName, name, length);
+  keyName[length] = 0;
+  slots_[slot] = key;
+  if (++size_ * 2 > slots_.size())
+    grow();
+  return keyName;
+}
+
+void Value::KeyTable::grow() {
+  std::vector<InternedKey*> slots(slots_.size() * 2);
+  size_t mask = slots.size() - 1;
+  for (size_t i = 0; i < slots_.size(); ++i) {
+    if (!slots_[i])
+      continue;
+    size_t slot = slots_[i]->hash_ & mask;
+    while (slots[slot])
+      slot = (slot + 1) & mask;
+    slots[slot] = slots_[i];
+  }
+  slots_.swap(slots);
+}
+
 // exact copy of Features
 class OurFeatures {
 public:
@@ -1134,6 +1540,9 @@ public:
   bool failIfExtra_;
   bool rejectDupKeys_;
   bool allowSpecialFloats_;
+  bool arena_;
+  bool iterative_;
+  bool internKeys_;
   int stackLimit_;
 }; // OurFeatures
 
@@ -1157,6 +1566,7 @@ public:
   };
 
   OurReader(OurFeatures const& features);
+  ~OurReader();
   bool parse(const char* beginDoc,
              const char* endDoc,
              Value& root,
@@ -1221,6 +1631,15 @@ private:
   bool readValue();
   bool readObject(Token& token);
   bool readArray(Token& token);
+  void beginValue(Token& token);
+  bool readScalar(Token& token);
+  void endContainer();
+  bool readValueIterative();
+  bool openValue(bool& successful);
+  bool openChild(bool& successful);
+  bool closeChild(bool ok, bool& successful);
+  void initContainer(ValueType type);
+  Value& resolveMember(JSONCPP_STRING const& name);
   bool decodeNumber(Token& token);
   bool decodeNumber(Token& token, Value& decoded);
   bool decodeString(Token& token);
@@ -1255,6 +1674,17 @@ private:
 
   typedef std::stack<Value*> Nodes;
   Nodes nodes_;
+
+  // An object or array being read by readValueIterative(); what readObject()
+  // and readArray() keep in locals.
+  struct Frame {
+    bool object_;
+    bool nameEmpty_;   // the name of the last member read was empty
+    ArrayIndex index_; // of the next element
+  };
+  typedef std::vector<Frame> Frames;
+  Frames frames_;
+  JSONCPP_STRING memberName_;
   Errors errors_;
   JSONCPP_STRING document_;
   Location begin_;
@@ -1263,6 +1693,9 @@ private:
   Location lastValueEnd_;
   Value* lastValue_;
   JSONCPP_STRING commentsBefore_;
+  JSONCPP_STRING decodedString_; // reused by every string value
+  Arena* arena_; // of the root, once it is read, in arena mode
+  Value::KeyTable* keys_; // of every document read, with internKeys
 
   OurFeatures const features_;
   bool collectComments_;
@@ -1280,7 +1713,13 @@ bool OurReader::containsNewLine(OurReader::Location begin,
 
 OurReader::OurReader(OurFeatures const& features)
     : errors_(), document_(), begin_(), end_(), current_(), lastValueEnd_(),
-      lastValue_(), commentsBefore_(), features_(features), collectComments_() {
+      lastValue_(), commentsBefore_(),
+      keys_(features.internKeys_ ? new Value::KeyTable() : 0),
+      features_(features), collectComments_() {}
+
+OurReader::~OurReader() {
+  if (keys_)
+    keys_->release();
 }
 
 bool OurReader::parse(const char* beginDoc,
@@ -1299,11 +1738,13 @@ bool OurReader::parse(const char* beginDoc,
   lastValue_ = 0;
   commentsBefore_.clear();
   errors_.clear();
+  arena_ = 0;
   while (!nodes_.empty())
     nodes_.pop();
   nodes_.push(&root);
+  frames_.clear();
 
-  bool successful = readValue();
+  bool successful = features_.iterative_ ? readValueIterative() : readValue();
   Token token;
   skipCommentTokens(token);
   if (features_.failIfExtra_) {
@@ -1332,27 +1773,38 @@ bool OurReader::parse(const char* beginDoc,
 }
 
 bool OurReader::readValue() {
+  Token token;
+  beginValue(token);
+  bool successful;
+  switch (token.type_) {
+  case tokenObjectBegin:
+    successful = readObject(token);
+    break;
+  case tokenArrayBegin:
+    successful = readArray(token);
+    break;
+  default:
+    return readScalar(token);
+  }
+  endContainer();
+  return successful;
+}
+
+void OurReader::beginValue(Token& token) {
   //  To preserve the old behaviour we cast size_t to int.
   if (static_cast<int>(nodes_.size()) > features_.stackLimit_)
     throwRuntimeError("Exceeded stackLimit in readValue().");
-  Token token;
   skipCommentTokens(token);
-  bool successful = true;
 
   if (collectComments_ && !commentsBefore_.empty()) {
     currentValue().setComment(commentsBefore_, commentBefore);
     commentsBefore_.clear();
   }
+}
 
+bool OurReader::readScalar(Token& token) {
+  bool successful = true;
   switch (token.type_) {
-  case tokenObjectBegin:
-    successful = readObject(token);
-    currentValue().setOffsetLimit(current_ - begin_);
-    break;
-  case tokenArrayBegin:
-    successful = readArray(token);
-    currentValue().setOffsetLimit(current_ - begin_);
-    break;
   case tokenNumber:
     successful = decodeNumber(token);
     break;
@@ -1422,6 +1874,175 @@ bool OurReader::readValue() {
   return successful;
 }
 
+void OurReader::endContainer() {
+  currentValue().setOffsetLimit(current_ - begin_);
+  if (collectComments_) {
+    lastValueEnd_ = current_;
+    lastValue_ = &currentValue();
+  }
+}
+
+// readValue() with the recursion through readObject() and readArray() kept in
+// frames_ instead, so the native stack does not grow with the depth of the
+// document. It reads the same values, reports the same errors and recovers
+// from them the same way. nodes_ is pushed and popped as by readValue(), so
+// stackLimit bounds the depth the same way.
+bool OurReader::readValueIterative() {
+  bool successful;
+  // Whether the container on top of frames_ is to read its next member.
+  bool reading = openValue(successful);
+  for (;;) {
+    if (reading) {
+      if (openChild(successful)) {
+        reading = openValue(successful);
+        continue;
+      }
+      frames_.pop_back();
+      endContainer();
+    }
+    // The value at nodes_.top() is read; back to the container holding it.
+    if (frames_.empty())
+      return successful;
+    nodes_.pop();
+    reading = closeChild(successful, successful);
+    if (!reading) {
+      frames_.pop_back();
+      endContainer();
+    }
+  }
+}
+
+// The start of readValue(), and of readObject() or readArray(). Returns true
+// if it opened an object or array, false if it read the whole value.
+bool OurReader::openValue(bool& successful) {
+  Token token;
+  beginValue(token);
+  if (token.type_ != tokenObjectBegin && token.type_ != tokenArrayBegin) {
+    successful = readScalar(token);
+    return false;
+  }
+  Frame frame;
+  frame.object_ = token.type_ == tokenObjectBegin;
+  frame.nameEmpty_ = true;
+  frame.index_ = 0;
+  frames_.push_back(frame);
+  initContainer(frame.object_ ? objectValue : arrayValue);
+  currentValue().setOffsetStart(token.start_ - begin_);
+  return true;
+}
+
+// The head of the loop in readObject() or readArray(). Returns true if it
+// pushed the next member onto nodes_, false if the container has ended.
+bool OurReader::openChild(bool& successful) {
+  Frame& frame = frames_.back();
+  if (!frame.object_) {
+    if (frame.index_ == 0) {
+      skipSpaces();
+      if (current_ != end_ && *current_ == ']') // empty array
+      {
+        Token endArray;
+        readToken(endArray);
+        successful = true;
+        return false;
+      }
+    }
+    Value& value = currentValue()[frame.index_++];
+    nodes_.push(&value);
+    return true;
+  }
+
+  Token tokenName;
+  bool initialTokenOk = readToken(tokenName);
+  while (tokenName.type_ == tokenComment && initialTokenOk)
+    initialTokenOk = readToken(tokenName);
+  if (initialTokenOk && tokenName.type_ == tokenObjectEnd &&
+      frame.nameEmpty_) { // empty object
+    successful = true;
+    return false;
+  }
+  memberName_.clear();
+  if (initialTokenOk && tokenName.type_ == tokenString) {
+    if (!decodeString(tokenName, memberName_)) {
+      successful = recoverFromError(tokenObjectEnd);
+      return false;
+    }
+  } else if (initialTokenOk && tokenName.type_ == tokenNumber &&
+             features_.allowNumericKeys_) {
+    Value numberName;
+    if (!decodeNumber(tokenName, numberName)) {
+      successful = recoverFromError(tokenObjectEnd);
+      return false;
+    }
+    memberName_ = numberName.asString();
+  } else {
+    successful = addErrorAndRecover("Missing '}' or object member name",
+                                    tokenName, tokenObjectEnd);
+    return false;
+  }
+  frame.nameEmpty_ = memberName_.empty();
+
+  Token colon;
+  if (!readToken(colon) || colon.type_ != tokenMemberSeparator) {
+    successful = addErrorAndRecover("Missing ':' after object member name",
+                                    colon, tokenObjectEnd);
+    return false;
+  }
+  if (memberName_.length() >= (1U << 30))
+    throwRuntimeError("keylength >= 2^30");
+  if (features_.rejectDupKeys_ && currentValue().isMember(memberName_)) {
+    JSONCPP_STRING msg = "Duplicate key: '" + memberName_ + "'";
+    successful = addErrorAndRecover(msg, tokenName, tokenObjectEnd);
+    return false;
+  }
+  nodes_.push(&resolveMember(memberName_));
+  return true;
+}
+
+// The rest of the loop in readObject() or readArray(), once a member has been
+// read with the result ok. Returns true if another member follows, false if
+// the container has ended.
+bool OurReader::closeChild(bool ok, bool& successful) {
+  if (!frames_.back().object_) {
+    if (!ok) { // error already set
+      successful = recoverFromError(tokenArrayEnd);
+      return false;
+    }
+    Token currentToken;
+    // Accept Comment after last item in the array.
+    ok = readToken(currentToken);
+    while (currentToken.type_ == tokenComment && ok) {
+      ok = readToken(currentToken);
+    }
+    bool badTokenType = (currentToken.type_ != tokenArraySeparator &&
+                         currentToken.type_ != tokenArrayEnd);
+    if (!ok || badTokenType) {
+      successful = addErrorAndRecover("Missing ',' or ']' in array declaration",
+                                      currentToken, tokenArrayEnd);
+      return false;
+    }
+    successful = true;
+    return currentToken.type_ != tokenArrayEnd;
+  }
+
+  if (!ok) { // error already set
+    successful = recoverFromError(tokenObjectEnd);
+    return false;
+  }
+  Token comma;
+  if (!readToken(comma) ||
+      (comma.type_ != tokenObjectEnd && comma.type_ != tokenArraySeparator &&
+       comma.type_ != tokenComment)) {
+    successful = addErrorAndRecover("Missing ',' or '}' in object declaration",
+                                    comma, tokenObjectEnd);
+    return false;
+  }
+  bool finalizeTokenOk = true;
+  while (comma.type_ == tokenComment && finalizeTokenOk)
+    finalizeTokenOk = readToken(comma);
+  successful = true;
+  return comma.type_ != tokenObjectEnd;
+}
+
 void OurReader::skipCommentTokens(Token& token) {
   if (features_.allowComments_) {
     do {
@@ -1533,13 +2154,12 @@ bool OurReader::readToken(Token& token) {
 }
 
 void OurReader::skipSpaces() {
-  while (current_ != end_) {
-    Char c = *current_;
-    if (c == ' ' || c == '\t' || c == '\r' || c == '\n')
-      ++current_;
-    else
-      break;
-  }
+  // Most tokens are not preceded by whitespace, or by a single space.
+  if (current_ == end_ || !isJsonWhitespace(*current_))
+    return;
+  ++current_;
+  if (current_ != end_ && isJsonWhitespace(*current_))
+    current_ = scanner().skipWhitespace(current_ + 1, end_);
 }
 
 bool OurReader::match(Location pattern, int patternLength) {
@@ -1661,15 +2281,17 @@ bool OurReader::readNumber(bool checkInf) {
   return true;
 }
 bool OurReader::readString() {
-  Char c = 0;
-  while (current_ != end_) {
-    c = getNextChar();
-    if (c == '\\')
-      getNextChar();
-    else if (c == '"')
-      break;
+  // Control characters are let through as they always were.
+  for (;;) {
+    current_ = scanner().findStringSpecial(current_, end_);
+    if (current_ == end_)
+      return false;
+    Char c = *current_++;
+    if (c == '"')
+      return true;
+    if (c == '\\' && current_ != end_)
+      ++current_;
   }
-  return c == '"';
 }
 
 bool OurReader::readStringSingleQuote() {
@@ -1687,8 +2309,7 @@ bool OurReader::readStringSingleQuote() {
 bool OurReader::readObject(Token& token) {
   Token tokenName;
   JSONCPP_STRING name;
-  Value init(objectValue);
-  currentValue().swapPayload(init);
+  initContainer(objectValue);
   currentValue().setOffsetStart(token.start_ - begin_);
   while (readToken(tokenName)) {
     bool initialTokenOk = true;
@@ -1722,8 +2343,7 @@ bool OurReader::readObject(Token& token) {
       JSONCPP_STRING msg = "Duplicate key: '" + name + "'";
       return addErrorAndRecover(msg, tokenName, tokenObjectEnd);
     }
-    Value& value = currentValue()[name];
-    nodes_.push(&value);
+    nodes_.push(&resolveMember(name));
     bool ok = readValue();
     nodes_.pop();
     if (!ok) // error already set
@@ -1746,9 +2366,33 @@ bool OurReader::readObject(Token& token) {
                             tokenObjectEnd);
 }
 
+// The member 'name' of the current object, named from the key table if the
+// reader interns names.
+Value& OurReader::resolveMember(JSONCPP_STRING const& name) {
+  unsigned length = static_cast<unsigned>(name.length());
+  if (keys_) {
+    if (char const* interned = keys_->intern(name.data(), length)) {
+      Value::CZString key(interned, length, Value::CZString::interned);
+      return currentValue().resolveReference(key, keys_);
+    }
+  }
+  return currentValue().resolveReference(name.data(), name.data() + length);
+}
+
+void OurReader::initContainer(ValueType type) {
+  if (!features_.arena_) {
+    Value init(type);
+    currentValue().swapPayload(init);
+  } else if (!arena_) {
+    // The first container read is the root.
+    arena_ = currentValue().initArenaRoot(type);
+  } else {
+    currentValue().initArenaContainer(type, arena_);
+  }
+}
+
 bool OurReader::readArray(Token& token) {
-  Value init(arrayValue);
-  currentValue().swapPayload(init);
+  initContainer(arrayValue);
   currentValue().setOffsetStart(token.start_ - begin_);
   skipSpaces();
   if (current_ != end_ && *current_ == ']') // empty array
@@ -1805,7 +2449,7 @@ bool OurReader::decodeNumber(Token& token, Value& decoded) {
   // TODO: Help the compiler do the div and mod at compile time or get rid of
   // them.
   Value::LargestUInt maxIntegerValue =
-      isNegative ? Value::LargestUInt(-Value::minLargestInt)
+      isNegative ? Value::LargestUInt(Value::maxLargestInt) + 1
                  : Value::maxLargestUInt;
   Value::LargestUInt threshold = maxIntegerValue / 10;
   Value::LargestUInt value = 0;
@@ -1826,7 +2470,9 @@ bool OurReader::decodeNumber(Token& token, Value& decoded) {
     }
     value = value * 10 + digit;
   }
-  if (isNegative)
+  if (isNegative && value == maxIntegerValue)
+    decoded = Value::minLargestInt;
+  else if (isNegative)
     decoded = -Value::LargestInt(value);
   else if (value <= Value::LargestUInt(Value::maxInt))
     decoded = Value::LargestInt(value);
@@ -1847,6 +2493,11 @@ bool OurReader::decodeDouble(Token& token) {
 
 bool OurReader::decodeDouble(Token& token, Value& decoded) {
   double value = 0;
+  if (decodeExactDouble(token.start_, token.end_, value)) {
+    decoded = value;
+    return true;
+  }
+
   const int bufferSize = 32;
   int count;
   ptrdiff_t const length = token.end_ - token.start_;
@@ -1884,11 +2535,17 @@ bool OurReader::decodeDouble(Token& token, Value& decoded) {
 }
 
 bool OurReader::decodeString(Token& token) {
-  JSONCPP_STRING decoded_string;
-  if (!decodeString(token, decoded_string))
+  decodedString_.clear();
+  if (!decodeString(token, decodedString_))
     return false;
-  Value decoded(decoded_string);
-  currentValue().swapPayload(decoded);
+  if (arena_) {
+    currentValue().initArenaString(decodedString_.data(),
+                                   static_cast<unsigned>(decodedString_.size()),
+                                   arena_);
+  } else {
+    Value decoded(decodedString_);
+    currentValue().swapPayload(decoded);
+  }
   currentValue().setOffsetStart(token.start_ - begin_);
   currentValue().setOffsetLimit(token.end_ - begin_);
   return true;
@@ -1899,6 +2556,11 @@ bool OurReader::decodeString(Token& token, JSONCPP_STRING& decoded) {
   Location current = token.start_ + 1; // skip '"'
   Location end = token.end_ - 1;       // do not include '"'
   while (current != end) {
+    Location special = scanner().findStringSpecial(current, end);
+    decoded.append(current, special);
+    current = special;
+    if (current == end)
+      break;
     Char c = *current++;
     if (c == '"')
       break;
@@ -1941,7 +2603,7 @@ bool OurReader::decodeString(Token& token, JSONCPP_STRING& decoded) {
         return addError("Bad escape sequence in string", token, current);
       }
     } else {
-      decoded += c;
+      decoded += c; // a control character, kept as it always was
     }
   }
   return true;
@@ -2171,6 +2833,9 @@ CharReader* CharReaderBuilder::newCharReader() const {
   features.failIfExtra_ = settings_["failIfExtra"].asBool();
   features.rejectDupKeys_ = settings_["rejectDupKeys"].asBool();
   features.allowSpecialFloats_ = settings_["allowSpecialFloats"].asBool();
+  features.arena_ = settings_["arena"].asBool();
+  features.iterative_ = settings_["iterative"].asBool();
+  features.internKeys_ = settings_["internKeys"].asBool();
   return new OurCharReader(collectComments, features);
 }
 static void getValidReaderKeys(std::set<JSONCPP_STRING>* valid_keys) {
@@ -2185,6 +2850,9 @@ static void getValidReaderKeys(std::set<JSONCPP_STRING>* valid_keys) {
   valid_keys->insert("failIfExtra");
   valid_keys->insert("rejectDupKeys");
   valid_keys->insert("allowSpecialFloats");
+  valid_keys->insert("arena");
+  valid_keys->insert("iterative");
+  valid_keys->insert("internKeys");
 }
 bool CharReaderBuilder::validate(Json::Value* invalid) const {
   Json::Value my_invalid;
@@ -2233,6 +2901,9 @@ void CharReaderBuilder::setDefaults(Json::Value* settings) {
   (*settings)["failIfExtra"] = false;
   (*settings)["rejectDupKeys"] = false;
   (*settings)["allowSpecialFloats"] = false;
+  (*settings)["arena"] = false;
+  (*settings)["iterative"] = false;
+  (*settings)["internKeys"] = false;
   //! [CharReaderBuilderDefaults]
 }
 
@@ -2479,6 +3150,7 @@ ValueIterator& ValueIterator::operator=(const SelfType& other) {
 #endif
 #include <algorithm> // min()
 #include <cstddef>   // size_t
+#include <new>       // nothrow
 
 // Disable warning C4702 : unreachable code
 #if defined(_MSC_VER) && _MSC_VER >= 1800 // VC++ 12.0 and above
@@ -2568,7 +3240,8 @@ static inline char* duplicateStringValue(const char* value, size_t length) {
   if (length >= static_cast<size_t>(Value::maxInt))
     length = Value::maxInt - 1;
 
-  char* newString = static_cast<char*>(malloc(length + 1));
+  char* newString =
+      static_cast<char*>(::operator new(length + 1, std::nothrow));
   if (newString == NULL) {
     throwRuntimeError("in Json::Value::duplicateStringValue(): "
                       "Failed to allocate string value buffer");
@@ -2589,7 +3262,8 @@ static inline char* duplicateAndPrefixStringValue(const char* value,
                       "in Json::Value::duplicateAndPrefixStringValue(): "
                       "length too big for prefixing");
   unsigned actualLength = length + static_cast<unsigned>(sizeof(unsigned)) + 1U;
-  char* newString = static_cast<char*>(malloc(actualLength));
+  char* newString =
+      static_cast<char*>(::operator new(actualLength, std::nothrow));
   if (newString == 0) {
     throwRuntimeError("in Json::Value::duplicateAndPrefixStringValue(): "
                       "Failed to allocate string value buffer");
@@ -2622,17 +3296,21 @@ static inline void releasePrefixedStringValue(char* value) {
   decodePrefixedString(true, value, &length, &valueDecoded);
   size_t const size = sizeof(unsigned) + length + 1U;
   memset(value, 0, size);
-  free(value);
+  ::operator delete(value);
 }
 static inline void releaseStringValue(char* value, unsigned length) {
   // length==0 => we allocated the strings memory
   size_t size = (length == 0) ? strlen(value) : length;
   memset(value, 0, size);
-  free(value);
+  ::operator delete(value);
 }
 #else  // !JSONCPP_USING_SECURE_MEMORY
-static inline void releasePrefixedStringValue(char* value) { free(value); }
-static inline void releaseStringValue(char* value, unsigned) { free(value); }
+static inline void releasePrefixedStringValue(char* value) {
+  ::operator delete(value);
+}
+static inline void releaseStringValue(char* value, unsigned) {
+  ::operator delete(value);
+}
 #endif // JSONCPP_USING_SECURE_MEMORY
 
 } // namespace Json
@@ -2694,48 +3372,249 @@ void Value::CommentInfo::setComment(const char* text, size_t len) {
 // //////////////////////////////////////////////////////////////////
 // //////////////////////////////////////////////////////////////////
 // //////////////////////////////////////////////////////////////////
-// class Value::CZString
+// class Arena
 // //////////////////////////////////////////////////////////////////
 // //////////////////////////////////////////////////////////////////
 // //////////////////////////////////////////////////////////////////
 
-// Notes: policy_ indicates if the string was allocated when
-// a string is stored.
-
-Value::CZString::CZString(ArrayIndex index) : cstr_(0), index_(index) {}
+struct Arena::Block {
+  Block* next_;
+};
 
-Value::CZString::CZString(char const* str,
-                          unsigned length,
-                          DuplicationPolicy allocate)
-    : cstr_(str) {
-  // allocate != duplicate
-  storage_.policy_ = allocate & 0x3;
-  storage_.length_ = length & 0x3FFFFFFF;
+static const size_t arenaFirstBlockSize = 4096;
+static const size_t arenaMaxBlockSize = 65536;
+
+Arena::Arena()
+    : blocks_(0), current_(0), end_(0), nextBlockSize_(arenaFirstBlockSize) {}
+
+Arena::~Arena() {
+  while (blocks_) {
+    Block* next = blocks_->next_;
+    ::operator delete(blocks_);
+    blocks_ = next;
+  }
+}
+
+void* Arena::allocate(size_t size, size_t alignment) {
+  size_t padding =
+      (alignment - reinterpret_cast<size_t>(current_) % alignment) % alignment;
+  if (current_ != 0 && padding + size <= static_cast<size_t>(end_ - current_)) {
+    char* allocated = current_ + padding;
+    current_ = allocated + size;
+    return allocated;
+  }
+
+  // Blocks double in size up to arenaMaxBlockSize. A request for more than a
+  // quarter of a block gets a block of its own, so that it does not waste
+  // what is left of the current one.
+  size_t blockSize = size + alignment;
+  bool dedicated = blockSize > nextBlockSize_ / 4;
+  if (!dedicated)
+    blockSize = nextBlockSize_;
+  Block* block = static_cast<Block*>(::operator new(sizeof(Block) + blockSize));
+  char* start = reinterpret_cast<char*>(block + 1);
+  char* allocated =
+      start + (alignment - reinterpret_cast<size_t>(start) % alignment) %
+                  alignment;
+  if (dedicated && blocks_ != 0) {
+    block->next_ = blocks_->next_;
+    blocks_->next_ = block;
+  } else {
+    block->next_ = blocks_;
+    blocks_ = block;
+    current_ = allocated + size;
+    end_ = start + blockSize;
+    if (nextBlockSize_ < arenaMaxBlockSize)
+      nextBlockSize_ *= 2;
+  }
+  return allocated;
 }
 
+// An open-addressing table of the members of a wide object, by
+// StaticKey::hash() of their names. It points at the map's nodes, which stay
+// put until they are erased, and erasing a member drops the index.
+class Value::MemberIndex {
+public:
+  // Objects narrower than this are searched as fast through the map.
+  static const size_t minMembers = 16;
+  // Building the index costs about as much as this many map lookups per
+  // member, so it is built once the lookups reach size() / lookupsPerMember.
+  static const size_t lookupsPerMember = 16;
+
+  explicit MemberIndex(MemberMap const& members) : mask_(1) {
+    // At most half full, so probe sequences stay short.
+    while (mask_ + 1 < members.size() * 2)
+      mask_ = mask_ * 2 + 1;
+    slots_.resize(mask_ + 1);
+    for (MemberMap::const_iterator it = members.begin(); it != members.end();
+         ++it) {
+      unsigned hash = it->first.hash();
+      size_t slot = hash & mask_;
+      while (slots_[slot].member)
+        slot = (slot + 1) & mask_;
+      slots_[slot].hash = hash;
+      slots_[slot].member = &*it;
+    }
+  }
+
+  Value const* find(char const* key, unsigned length, unsigned hash) const {
+    for (size_t slot = hash & mask_; slots_[slot].member;
+         slot = (slot + 1) & mask_) {
+      Slot const& candidate = slots_[slot];
+      if (candidate.hash == hash &&
+          candidate.member->first.length() == length &&
+          memcmp(candidate.member->first.data(), key, length) == 0)
+        return &candidate.member->second;
+    }
+    return 0;
+  }
+
+private:
+  struct Slot {
+    Slot() : hash(0), member(0) {}
+    unsigned hash;
+    MemberMap::value_type const* member;
+  };
+
+  size_t mask_;
+  std::vector<Slot> slots_;
+};
+
+Value::ObjectValues::ObjectValues() : index_(0), lookups_(0), keys_(0) {}
+
+Value::ObjectValues::ObjectValues(key_compare const& compare,
+                                  allocator_type const& allocator)
+    : MemberMap(compare, allocator), index_(0), lookups_(0), keys_(0) {}
+
+// The index is not copied; the copy builds its own if it is looked up enough.
+Value::ObjectValues::ObjectValues(ObjectValues const& other)
+    : MemberMap(other), index_(0), lookups_(0), keys_(other.keys_) {
+  if (keys_)
+    keys_->retain();
+}
+
+// The keys have no destructor to run, so the table may go first.
+Value::ObjectValues::~ObjectValues() {
+  delete index_.load();
+  if (keys_)
+    keys_->release();
+}
+
+// A reader adds members to an object it has just made, so their names are
+// all from the one table.
+void Value::ObjectValues::holdKeys(KeyTable* keys) {
+  if (keys_ == keys)
+    return;
+  JSON_ASSERT(keys_ == 0);
+  keys_ = keys;
+  keys_->retain();
+}
+
+Value::MemberIndex const* Value::ObjectValues::index() const {
+  return index_.load(std::memory_order_acquire);
+}
+
+Value::MemberIndex const* Value::ObjectValues::indexForLookup() const {
+  if (size() < MemberIndex::minMembers)
+    return 0;
+  MemberIndex* index = index_.load(std::memory_order_acquire);
+  if (index)
+    return index;
+  size_t lookups = lookups_.fetch_add(1, std::memory_order_relaxed) + 1;
+  if (lookups * MemberIndex::lookupsPerMember < size())
+    return 0;
+
+  // Readers racing to build it keep whichever index was published first.
+  MemberIndex* built = new MemberIndex(*this);
+  if (!index_.compare_exchange_strong(index, built,
+                                      std::memory_order_acq_rel)) {
+    delete built;
+    return index;
+  }
+  return built;
+}
+
+void Value::ObjectValues::invalidateIndex() {
+  if (index_.load(std::memory_order_relaxed)) {
+    delete index_.exchange(0, std::memory_order_relaxed);
+  }
+  lookups_.store(0, std::memory_order_relaxed);
+}
+
+namespace {
+struct ArenaHolder {
+  Arena arena_;
+};
+} // namespace
+
+// The payload of the root of an arena document. The Arena is a base before
+// the map, so it is constructed before and destroyed after everything the map
+// allocated from it.
+class ArenaRoot : private ArenaHolder, public Value::ObjectValues {
+public:
+  ArenaRoot()
+      : Value::ObjectValues(Value::ObjectValues::key_compare(),
+                            Value::ObjectValues::allocator_type(&arena_)) {}
+
+  Arena* arena() { return &arena_; }
+};
+
+// //////////////////////////////////////////////////////////////////
+// //////////////////////////////////////////////////////////////////
+// //////////////////////////////////////////////////////////////////
+// class Value::CZString
+// //////////////////////////////////////////////////////////////////
+// //////////////////////////////////////////////////////////////////
+// //////////////////////////////////////////////////////////////////
+
+// Notes: policy_ indicates if the string was allocated when
+// a string is stored.
+
+Value::CZString::CZString(ArrayIndex index) : cstr_(0), index_(index) {}
+
+Value::CZString::CZString(char const* str,
+                          unsigned length,
+                          DuplicationPolicy allocate)
+    : cstr_(str) {
+  // allocate != duplicate
+  storage_.policy_ = allocate & 0x3;
+  storage_.length_ = length & 0x3FFFFFFF;
+}
+
+// Copying a key that is neither static nor interned duplicates it: into
+// inline_ when it is short, which is what almost every object member name
+// is, else to the heap.
 Value::CZString::CZString(const CZString& other) {
-  cstr_ = (other.storage_.policy_ != noDuplication && other.cstr_ != 0
-               ? duplicateStringValue(other.cstr_, other.storage_.length_)
-               : other.cstr_);
-  storage_.policy_ =
-      static_cast<unsigned>(
-          other.cstr_
-              ? (static_cast<DuplicationPolicy>(other.storage_.policy_) ==
-                         noDuplication
-                     ? noDuplication
-                     : duplicate)
-              : static_cast<DuplicationPolicy>(other.storage_.policy_)) &
-      3U;
-  storage_.length_ = other.storage_.length_;
+  if (other.cstr_ == 0 || other.storage_.policy_ == noDuplication ||
+      other.storage_.policy_ == interned) {
+    cstr_ = other.cstr_;
+    index_ = other.index_;
+  } else if (other.storage_.length_ < sizeof(inline_)) {
+    copyInline(other);
+  } else {
+    cstr_ = duplicateStringValue(other.cstr_, other.storage_.length_);
+    storage_.policy_ = duplicate;
+    storage_.length_ = other.storage_.length_;
+  }
 }
 
 #if JSON_HAS_RVALUE_REFERENCES
 Value::CZString::CZString(CZString&& other)
     : cstr_(other.cstr_), index_(other.index_) {
+  if (cstr_ == other.inline_)
+    copyInline(other);
   other.cstr_ = nullptr;
 }
 #endif
 
+void Value::CZString::copyInline(CZString const& other) {
+  memcpy(inline_, other.cstr_, other.storage_.length_);
+  inline_[other.storage_.length_] = 0;
+  cstr_ = inline_;
+  storage_.policy_ = duplicateOnCopy;
+  storage_.length_ = other.storage_.length_;
+}
+
 Value::CZString::~CZString() {
   if (cstr_ && storage_.policy_ == duplicate) {
     releaseStringValue(const_cast<char*>(cstr_),
@@ -2749,19 +3628,21 @@ Value::CZString::~CZString() {
 void Value::CZString::swap(CZString& other) {
   std::swap(cstr_, other.cstr_);
   std::swap(index_, other.index_);
+  std::swap(inline_, other.inline_);
+  if (cstr_ == other.inline_)
+    cstr_ = inline_;
+  if (other.cstr_ == inline_)
+    other.cstr_ = other.inline_;
 }
 
 Value::CZString& Value::CZString::operator=(const CZString& other) {
-  cstr_ = other.cstr_;
-  index_ = other.index_;
+  CZString(other).swap(*this);
   return *this;
 }
 
 #if JSON_HAS_RVALUE_REFERENCES
 Value::CZString& Value::CZString::operator=(CZString&& other) {
-  cstr_ = other.cstr_;
-  index_ = other.index_;
-  other.cstr_ = nullptr;
+  swap(other);
   return *this;
 }
 #endif
@@ -2773,6 +3654,8 @@ bool Value::CZString::operator<(const CZString& other) const {
   // Assume both are strings.
   unsigned this_len = this->storage_.length_;
   unsigned other_len = other.storage_.length_;
+  if (cstr_ == other.cstr_ && this_len == other_len)
+    return false; // the same name
   unsigned min_len = std::min<unsigned>(this_len, other_len);
   JSON_ASSERT(this->cstr_ && other.cstr_);
   int comp = memcmp(this->cstr_, other.cstr_, min_len);
@@ -2792,6 +3675,11 @@ bool Value::CZString::operator==(const CZString& other) const {
   unsigned other_len = other.storage_.length_;
   if (this_len != other_len)
     return false;
+  if (cstr_ == other.cstr_)
+    return true;
+  if (storage_.policy_ == interned && other.storage_.policy_ == interned &&
+      KeyTable::together(cstr_, other.cstr_))
+    return false;
   JSON_ASSERT(this->cstr_ && other.cstr_);
   int comp = memcmp(this->cstr_, other.cstr_, this_len);
   return comp == 0;
@@ -2806,6 +3694,12 @@ bool Value::CZString::isStaticString() const {
   return storage_.policy_ == noDuplication;
 }
 
+unsigned Value::CZString::hash() const {
+  if (storage_.policy_ == interned)
+    return internedKey(cstr_)->hash_;
+  return StaticKey::hash(cstr_, storage_.length_);
+}
+
 // //////////////////////////////////////////////////////////////////
 // //////////////////////////////////////////////////////////////////
 // //////////////////////////////////////////////////////////////////
@@ -2873,22 +3767,19 @@ Value::Value(double value) {
 }
 
 Value::Value(const char* value) {
-  initBasic(stringValue, true);
+  initBasic(stringValue);
   JSON_ASSERT_MESSAGE(value != NULL, "Null Value Passed to Value Constructor");
-  value_.string_ = duplicateAndPrefixStringValue(
-      value, static_cast<unsigned>(strlen(value)));
+  initString(value, static_cast<unsigned>(strlen(value)));
 }
 
 Value::Value(const char* begin, const char* end) {
-  initBasic(stringValue, true);
-  value_.string_ =
-      duplicateAndPrefixStringValue(begin, static_cast<unsigned>(end - begin));
+  initBasic(stringValue);
+  initString(begin, static_cast<unsigned>(end - begin));
 }
 
 Value::Value(const JSONCPP_STRING& value) {
-  initBasic(stringValue, true);
-  value_.string_ = duplicateAndPrefixStringValue(
-      value.data(), static_cast<unsigned>(value.length()));
+  initBasic(stringValue);
+  initString(value.data(), static_cast<unsigned>(value.length()));
 }
 
 Value::Value(const StaticString& value) {
@@ -2898,9 +3789,8 @@ Value::Value(const StaticString& value) {
 
 #ifdef JSON_USE_CPPTL
 Value::Value(const CppTL::ConstString& value) {
-  initBasic(stringValue, true);
-  value_.string_ = duplicateAndPrefixStringValue(
-      value, static_cast<unsigned>(value.length()));
+  initBasic(stringValue);
+  initString(value, static_cast<unsigned>(value.length()));
 }
 #endif
 
@@ -2943,6 +3833,18 @@ void Value::swapPayload(Value& other) {
   int temp2 = allocated_;
   allocated_ = other.allocated_;
   other.allocated_ = temp2 & 0x1;
+  int temp3 = inlined_;
+  inlined_ = other.inlined_;
+  other.inlined_ = temp3 & 0x1;
+  int temp4 = inlineLength_;
+  inlineLength_ = other.inlineLength_;
+  other.inlineLength_ = temp4 & 0x1F;
+  int temp5 = arena_;
+  arena_ = other.arena_;
+  other.arena_ = temp5 & 0x1;
+  int temp6 = ownsArena_;
+  ownsArena_ = other.ownsArena_;
+  other.ownsArena_ = temp6 & 0x1;
 }
 
 void Value::copyPayload(const Value& other) {
@@ -2989,20 +3891,14 @@ bool Value::operator<(const Value& other) const {
   case booleanValue:
     return value_.bool_ < other.value_.bool_;
   case stringValue: {
-    if ((value_.string_ == 0) || (other.value_.string_ == 0)) {
-      if (other.value_.string_)
-        return true;
-      else
-        return false;
-    }
     unsigned this_len;
     unsigned other_len;
     char const* this_str;
     char const* other_str;
-    decodePrefixedString(this->allocated_, this->value_.string_, &this_len,
-                         &this_str);
-    decodePrefixedString(other.allocated_, other.value_.string_, &other_len,
-                         &other_str);
+    bool this_has = stringPayload(&this_len, &this_str);
+    bool other_has = other.stringPayload(&other_len, &other_str);
+    if (!this_has || !other_has)
+      return other_has;
     unsigned min_len = std::min<unsigned>(this_len, other_len);
     JSON_ASSERT(this_str && other_str);
     int comp = memcmp(this_str, other_str, min_len);
@@ -3051,17 +3947,14 @@ bool Value::operator==(const Value& other) const {
   case booleanValue:
     return value_.bool_ == other.value_.bool_;
   case stringValue: {
-    if ((value_.string_ == 0) || (other.value_.string_ == 0)) {
-      return (value_.string_ == other.value_.string_);
-    }
     unsigned this_len;
     unsigned other_len;
     char const* this_str;
     char const* other_str;
-    decodePrefixedString(this->allocated_, this->value_.string_, &this_len,
-                         &this_str);
-    decodePrefixedString(other.allocated_, other.value_.string_, &other_len,
-                         &other_str);
+    bool this_has = stringPayload(&this_len, &this_str);
+    bool other_has = other.stringPayload(&other_len, &other_str);
+    if (!this_has || !other_has)
+      return this_has == other_has;
     if (this_len != other_len)
       return false;
     JSON_ASSERT(this_str && other_str);
@@ -3070,8 +3963,9 @@ bool Value::operator==(const Value& other) const {
   }
   case arrayValue:
   case objectValue:
-    return value_.map_->size() == other.value_.map_->size() &&
-           (*value_.map_) == (*other.value_.map_);
+    return value_.map_ == other.value_.map_ ||
+           (value_.map_->size() == other.value_.map_->size() &&
+            (*value_.map_) == (*other.value_.map_));
   default:
     JSON_ASSERT_UNREACHABLE;
   }
@@ -3083,12 +3977,10 @@ bool Value::operator!=(const Value& other) const { return !(*this == other); }
 const char* Value::asCString() const {
   JSON_ASSERT_MESSAGE(type_ == stringValue,
                       "in Json::Value::asCString(): requires stringValue");
-  if (value_.string_ == 0)
-    return 0;
   unsigned this_len;
   char const* this_str;
-  decodePrefixedString(this->allocated_, this->value_.string_, &this_len,
-                       &this_str);
+  if (!stringPayload(&this_len, &this_str))
+    return 0;
   return this_str;
 }
 
@@ -3096,12 +3988,10 @@ const char* Value::asCString() const {
 unsigned Value::getCStringLength() const {
   JSON_ASSERT_MESSAGE(type_ == stringValue,
                       "in Json::Value::asCString(): requires stringValue");
-  if (value_.string_ == 0)
-    return 0;
   unsigned this_len;
   char const* this_str;
-  decodePrefixedString(this->allocated_, this->value_.string_, &this_len,
-                       &this_str);
+  if (!stringPayload(&this_len, &this_str))
+    return 0;
   return this_len;
 }
 #endif
@@ -3109,10 +3999,9 @@ unsigned Value::getCStringLength() const {
 bool Value::getString(char const** begin, char const** end) const {
   if (type_ != stringValue)
     return false;
-  if (value_.string_ == 0)
-    return false;
   unsigned length;
-  decodePrefixedString(this->allocated_, this->value_.string_, &length, begin);
+  if (!stringPayload(&length, begin))
+    return false;
   *end = *begin + length;
   return true;
 }
@@ -3122,12 +4011,10 @@ JSONCPP_STRING Value::asString() const {
   case nullValue:
     return "";
   case stringValue: {
-    if (value_.string_ == 0)
-      return "";
     unsigned this_len;
     char const* this_str;
-    decodePrefixedString(this->allocated_, this->value_.string_, &this_len,
-                         &this_str);
+    if (!stringPayload(&this_len, &this_str))
+      return "";
     return JSONCPP_STRING(this_str, this_len);
   }
   case booleanValue:
@@ -3147,7 +4034,7 @@ JSONCPP_STRING Value::asString() const {
 CppTL::ConstString Value::asConstString() const {
   unsigned len;
   char const* str;
-  decodePrefixedString(allocated_, value_.string_, &len, &str);
+  stringPayload(&len, &str);
   return CppTL::ConstString(str, len);
 }
 #endif
@@ -3397,6 +4284,7 @@ void Value::clear() {
   case arrayValue:
   case objectValue:
     value_.map_->clear();
+    value_.map_->invalidateIndex();
     break;
   default:
     break;
@@ -3432,8 +4320,12 @@ Value& Value::operator[](ArrayIndex index) {
   if (it != value_.map_->end() && (*it).first == key)
     return (*it).second;
 
+#if JSON_HAS_RVALUE_REFERENCES
+  it = value_.map_->emplace_hint(it, key, Value());
+#else
   ObjectValues::value_type defaultValue(key, nullSingleton());
   it = value_.map_->insert(it, defaultValue);
+#endif
   return (*it).second;
 }
 
@@ -3467,14 +4359,90 @@ const Value& Value::operator[](int index) const {
 void Value::initBasic(ValueType type, bool allocated) {
   type_ = type;
   allocated_ = allocated;
+  inlined_ = false;
+  inlineLength_ = 0;
+  arena_ = false;
+  ownsArena_ = false;
   comments_ = 0;
   start_ = 0;
   limit_ = 0;
 }
 
+// Short strings are kept in value_ itself, so most strings in a parsed
+// document cost no allocation of their own.
+void Value::initString(char const* str, unsigned length) {
+  if (length < sizeof(value_.inline_)) {
+    memcpy(value_.inline_, str, length);
+    value_.inline_[length] = 0;
+    inlined_ = true;
+    inlineLength_ = length;
+  } else {
+    value_.string_ = duplicateAndPrefixStringValue(str, length);
+    allocated_ = true;
+  }
+}
+
+bool Value::stringPayload(unsigned* length, char const** str) const {
+  if (inlined_) {
+    *length = inlineLength_;
+    *str = value_.inline_;
+    return true;
+  }
+  if (value_.string_ == 0)
+    return false;
+  decodePrefixedString(allocated_, value_.string_, length, str);
+  return true;
+}
+
+Arena* Value::initArenaRoot(ValueType type) {
+  ArenaRoot* root = new ArenaRoot();
+  Value payload;
+  payload.type_ = type;
+  payload.value_.map_ = root;
+  payload.ownsArena_ = true;
+  swapPayload(payload);
+  return root->arena();
+}
+
+void Value::initArenaContainer(ValueType type, Arena* arena) {
+  void* memory = arena->allocate(sizeof(ObjectValues), alignof(ObjectValues));
+  Value payload;
+  payload.value_.map_ = new (memory) ObjectValues(
+      ObjectValues::key_compare(), ObjectValues::allocator_type(arena));
+  payload.type_ = type;
+  payload.arena_ = true;
+  swapPayload(payload);
+}
+
+void Value::initArenaString(char const* str, unsigned length, Arena* arena) {
+  Value payload;
+  payload.type_ = stringValue;
+  if (length < sizeof(value_.inline_)) {
+    payload.initString(str, length);
+  } else {
+    JSON_ASSERT_MESSAGE(length <= static_cast<unsigned>(Value::maxInt) -
+                                      sizeof(unsigned) - 1U,
+                        "in Json::Value::initArenaString(): "
+                        "length too big for prefixing");
+    char* prefixed = static_cast<char*>(
+        arena->allocate(sizeof(unsigned) + length + 1U, alignof(unsigned)));
+    *reinterpret_cast<unsigned*>(prefixed) = length;
+    memcpy(prefixed + sizeof(unsigned), str, length);
+    prefixed[sizeof(unsigned) + length] = 0;
+    payload.value_.string_ = prefixed;
+    payload.allocated_ = true;
+    payload.arena_ = true;
+  }
+  swapPayload(payload);
+}
+
 void Value::dupPayload(const Value& other) {
   type_ = other.type_;
   allocated_ = false;
+  inlined_ = other.inlined_;
+  inlineLength_ = other.inlineLength_;
+  arena_ = false;
+  ownsArena_ = false;
   switch (type_) {
   case nullValue:
   case intValue:
@@ -3484,7 +4452,9 @@ void Value::dupPayload(const Value& other) {
     value_ = other.value_;
     break;
   case stringValue:
-    if (other.value_.string_ && other.allocated_) {
+    if (other.inlined_) {
+      value_ = other.value_;
+    } else if (other.value_.string_ && other.allocated_) {
       unsigned len;
       char const* str;
       decodePrefixedString(other.allocated_, other.value_.string_, &len, &str);
@@ -3512,12 +4482,17 @@ void Value::releasePayload() {
   case booleanValue:
     break;
   case stringValue:
-    if (allocated_)
+    if (allocated_ && !arena_)
       releasePrefixedStringValue(value_.string_);
     break;
   case arrayValue:
   case objectValue:
-    delete value_.map_;
+    if (ownsArena_)
+      delete static_cast<ArenaRoot*>(value_.map_);
+    else if (arena_)
+      value_.map_->~ObjectValues();
+    else
+      delete value_.map_;
     break;
   default:
     JSON_ASSERT_UNREACHABLE;
@@ -3551,12 +4526,18 @@ Value& Value::resolveReference(const char* key) {
     *this = Value(objectValue);
   CZString actualKey(key, static_cast<unsigned>(strlen(key)),
                      CZString::noDuplication); // NOTE!
-  ObjectValues::iterator it = value_.map_->lower_bound(actualKey);
-  if (it != value_.map_->end() && (*it).first == actualKey)
-    return (*it).second;
+  ObjectValues::iterator it;
+  if (Value* found = findMember(actualKey, it))
+    return *found;
 
+#if JSON_HAS_RVALUE_REFERENCES
+  // Constructs the member in place: the key is copied once, into the node.
+  it = value_.map_->emplace_hint(it, actualKey, Value());
+#else
   ObjectValues::value_type defaultValue(actualKey, nullSingleton());
   it = value_.map_->insert(it, defaultValue);
+#endif
+  value_.map_->invalidateIndex();
   Value& value = (*it).second;
   return value;
 }
@@ -3570,16 +4551,74 @@ Value& Value::resolveReference(char const* key, char const* end) {
     *this = Value(objectValue);
   CZString actualKey(key, static_cast<unsigned>(end - key),
                      CZString::duplicateOnCopy);
-  ObjectValues::iterator it = value_.map_->lower_bound(actualKey);
-  if (it != value_.map_->end() && (*it).first == actualKey)
-    return (*it).second;
+  ObjectValues::iterator it;
+  if (Value* found = findMember(actualKey, it))
+    return *found;
 
+#if JSON_HAS_RVALUE_REFERENCES
+  // Constructs the member in place: the key is copied once, into the node.
+  // A key too long for CZString to inline is copied into the arena of an
+  // arena document, where it is never freed but copied on copy.
+  Arena* arena = value_.map_->get_allocator().arena();
+  if (arena != 0 && actualKey.length() >= CZString::inlineCapacity) {
+    char* copy = static_cast<char*>(arena->allocate(actualKey.length() + 1, 1));
+    memcpy(copy, key, actualKey.length());
+    copy[actualKey.length()] = 0;
+    it = value_.map_->emplace_hint(
+        it, CZString(copy, actualKey.length(), CZString::duplicateOnCopy),
+        Value());
+  } else {
+    it = value_.map_->emplace_hint(it, actualKey, Value());
+  }
+#else
   ObjectValues::value_type defaultValue(actualKey, nullSingleton());
   it = value_.map_->insert(it, defaultValue);
+#endif
+  value_.map_->invalidateIndex();
+  Value& value = (*it).second;
+  return value;
+}
+
+// @param key is interned in 'keys', which the members then hold on to.
+Value& Value::resolveReference(CZString const& key, KeyTable* keys) {
+  JSON_ASSERT_MESSAGE(
+      type_ == nullValue || type_ == objectValue,
+      "in Json::Value::resolveReference(key, keys): requires objectValue");
+  if (type_ == nullValue)
+    *this = Value(objectValue);
+  value_.map_->holdKeys(keys);
+  ObjectValues::iterator it;
+  if (Value* found = findMember(key, it))
+    return *found;
+
+#if JSON_HAS_RVALUE_REFERENCES
+  it = value_.map_->emplace_hint(it, key, Value());
+#else
+  ObjectValues::value_type defaultValue(key, nullSingleton());
+  it = value_.map_->insert(it, defaultValue);
+#endif
+  value_.map_->invalidateIndex();
   Value& value = (*it).second;
   return value;
 }
 
+// The member named 'key' of this object, or null and where to insert it.
+// Only a lookup that finds the member counts toward building the member
+// index, so filling an object never builds it.
+Value* Value::findMember(CZString const& key, ObjectValues::iterator& hint) {
+  ObjectValues& members = *value_.map_;
+  if (MemberIndex const* index = members.index()) {
+    Value const* found = index->find(key.data(), key.length(), key.hash());
+    if (found)
+      return const_cast<Value*>(found);
+  }
+  hint = members.lower_bound(key);
+  if (hint == members.end() || !((*hint).first == key))
+    return 0;
+  members.indexForLookup();
+  return &(*hint).second;
+}
+
 Value Value::get(ArrayIndex index, const Value& defaultValue) const {
   const Value* value = &((*this)[index]);
   return value == &nullSingleton() ? defaultValue : *value;
@@ -3593,8 +4632,24 @@ Value const* Value::find(char const* begin, char const* end) const {
                       "objectValue or nullValue");
   if (type_ == nullValue)
     return NULL;
-  CZString actualKey(begin, static_cast<unsigned>(end - begin),
-                     CZString::noDuplication);
+  unsigned length = static_cast<unsigned>(end - begin);
+  if (MemberIndex const* index = value_.map_->indexForLookup())
+    return index->find(begin, length, StaticKey::hash(begin, length));
+  CZString actualKey(begin, length, CZString::noDuplication);
+  ObjectValues::const_iterator it = value_.map_->find(actualKey);
+  if (it == value_.map_->end())
+    return NULL;
+  return &(*it).second;
+}
+Value const* Value::find(StaticKey const& key) const {
+  JSON_ASSERT_MESSAGE(type_ == nullValue || type_ == objectValue,
+                      "in Json::Value::find(key): requires "
+                      "objectValue or nullValue");
+  if (type_ == nullValue)
+    return NULL;
+  if (MemberIndex const* index = value_.map_->indexForLookup())
+    return index->find(key.data(), key.length(), key.hash());
+  CZString actualKey(key.data(), key.length(), CZString::noDuplication);
   ObjectValues::const_iterator it = value_.map_->find(actualKey);
   if (it == value_.map_->end())
     return NULL;
@@ -3625,6 +4680,17 @@ Value& Value::operator[](const StaticString& key) {
   return resolveReference(key.c_str());
 }
 
+Value& Value::operator[](const StaticKey& key) {
+  return resolveReference(key.data(), key.data() + key.length());
+}
+
+Value const& Value::operator[](StaticKey const& key) const {
+  Value const* found = find(key);
+  if (!found)
+    return nullSingleton();
+  return *found;
+}
+
 #ifdef JSON_USE_CPPTL
 Value& Value::operator[](const CppTL::ConstString& key) {
   return resolveReference(key.c_str(), key.end_c_str());
@@ -3667,13 +4733,20 @@ bool Value::removeMember(const char* begin, const char* end, Value* removed) {
   ObjectValues::iterator it = value_.map_->find(actualKey);
   if (it == value_.map_->end())
     return false;
-  if (removed)
+  if (removed) {
 #if JSON_HAS_RVALUE_REFERENCES
-    *removed = std::move(it->second);
+    // A payload in the arena of an arena document is copied, since it goes
+    // when the root does.
+    if (it->second.arena_)
+      *removed = it->second;
+    else
+      *removed = std::move(it->second);
 #else
     *removed = it->second;
 #endif
+  }
   value_.map_->erase(it);
+  value_.map_->invalidateIndex();
   return true;
 }
 bool Value::removeMember(const char* key, Value* removed) {
@@ -3690,6 +4763,7 @@ void Value::removeMember(const char* key) {
 
   CZString actualKey(key, unsigned(strlen(key)), CZString::noDuplication);
   value_.map_->erase(actualKey);
+  value_.map_->invalidateIndex();
 }
 void Value::removeMember(const JSONCPP_STRING& key) {
   removeMember(key.c_str());
@@ -4009,6 +5083,42 @@ Value::iterator Value::end() {
   return iterator();
 }
 
+// class SharedValue
+// //////////////////////////////////////////////////////////////////
+
+// Points at the null singleton without owning anything.
+SharedValue::SharedValue()
+    : value_(std::shared_ptr<const Value>(), &Value::nullSingleton()) {}
+
+SharedValue::SharedValue(Value value)
+    : value_(std::make_shared<Value>(std::move(value))) {}
+
+// Shares ownership of the whole document, but points at 'value' in it.
+SharedValue::SharedValue(std::shared_ptr<const Value> const& document,
+                         const Value* value)
+    : value_(document, value) {}
+
+SharedValue SharedValue::get(const char* key) const {
+  const Value& member = (*value_)[key];
+  if (&member == &Value::nullSingleton())
+    return SharedValue();
+  return SharedValue(value_, &member);
+}
+
+SharedValue SharedValue::get(const JSONCPP_STRING& key) const {
+  const Value& member = (*value_)[key];
+  if (&member == &Value::nullSingleton())
+    return SharedValue();
+  return SharedValue(value_, &member);
+}
+
+SharedValue SharedValue::get(ArrayIndex index) const {
+  const Value& element = (*value_)[index];
+  if (&element == &Value::nullSingleton())
+    return SharedValue();
+  return SharedValue(value_, &element);
+}
+
 // class PathArgument
 // //////////////////////////////////////////////////////////////////
 
@@ -4179,6 +5289,8 @@ Value& Path::make(Value& root) const {
 #include <json/writer.h>
 #endif // if !defined(JSON_IS_AMALGAMATION)
 #include <cassert>
+#include <cerrno>
+#include <cstdlib>
 #include <cstring>
 #include <iomanip>
 #include <memory>
@@ -4248,6 +5360,12 @@ Value& Path::make(Value& root) const {
 #endif
 #endif
 
+#if defined(_MSC_VER)
+#include <io.h> // _write
+#else
+#include <unistd.h> // write
+#endif
+
 #if defined(_MSC_VER) && _MSC_VER >= 1400 // VC++ 8.0
 // Disable warning about strdup being deprecated.
 #pragma warning(disable : 4996)
@@ -4261,8 +5379,8 @@ typedef std::unique_ptr<StreamWriter> StreamWriterPtr;
 typedef std::auto_ptr<StreamWriter> StreamWriterPtr;
 #endif
 
-JSONCPP_STRING valueToString(LargestInt value) {
-  UIntToStringBuffer buffer;
+/// Writes value to the end of buffer, returning where the text starts.
+static char* largestIntToString(LargestInt value, UIntToStringBuffer& buffer) {
   char* current = buffer + sizeof(buffer);
   if (value == Value::minLargestInt) {
     uintToString(LargestUInt(Value::maxLargestInt) + 1, current);
@@ -4277,6 +5395,11 @@ JSONCPP_STRING valueToString(LargestInt value) {
   return current;
 }
 
+JSONCPP_STRING valueToString(LargestInt value) {
+  UIntToStringBuffer buffer;
+  return largestIntToString(value, buffer);
+}
+
 JSONCPP_STRING valueToString(LargestUInt value) {
   UIntToStringBuffer buffer;
   char* current = buffer + sizeof(buffer);
@@ -4298,6 +5421,369 @@ JSONCPP_STRING valueToString(UInt value) {
 #endif // # if defined(JSON_HAS_INT64)
 
 namespace {
+// Shortest round-trip formatting of doubles with Florian Loitsch's Grisu2
+// ("Printing Floating-Point Numbers Quickly and Accurately with Integers",
+// PLDI 2010), as also used by RapidJSON. The digits always read back as the
+// same double. Grisu2 alone misses the shortest digits for a small fraction
+// of values, by one digit; those are found by checking the shorter
+// candidates with strtod().
+
+static const UInt64 doubleFractionMask = 0x000FFFFFFFFFFFFFULL;
+static const UInt64 doubleHiddenBit = 0x0010000000000000ULL;
+static const int doubleExponentBias = 0x3FF + 52;
+
+/// A floating point number with a 64-bit significand: f * 2^e.
+struct DiyFp {
+  DiyFp() : f(0), e(0) {}
+  DiyFp(UInt64 significand, int exponent) : f(significand), e(exponent) {}
+
+  explicit DiyFp(double value) {
+    UInt64 bits;
+    memcpy(&bits, &value, sizeof(bits));
+    int biasedExponent = static_cast<int>((bits >> 52) & 0x7FF);
+    f = bits & doubleFractionMask;
+    if (biasedExponent != 0) {
+      f += doubleHiddenBit;
+      e = biasedExponent - doubleExponentBias;
+    } else {
+      e = 1 - doubleExponentBias;
+    }
+  }
+
+  DiyFp operator-(const DiyFp& other) const { return DiyFp(f - other.f, e); }
+
+  /// The upper 64 bits of the 128-bit product, rounded.
+  DiyFp operator*(const DiyFp& other) const {
+    const UInt64 mask32 = 0xFFFFFFFFULL;
+    UInt64 a = f >> 32, b = f & mask32;
+    UInt64 c = other.f >> 32, d = other.f & mask32;
+    UInt64 ac = a * c, bc = b * c, ad = a * d, bd = b * d;
+    UInt64 middle = (bd >> 32) + (ad & mask32) + (bc & mask32);
+    middle += UInt64(1) << 31;
+    return DiyFp(ac + (ad >> 32) + (bc >> 32) + (middle >> 32),
+                 e + other.e + 64);
+  }
+
+  DiyFp normalize() const {
+    DiyFp result(*this);
+    while (!(result.f & (UInt64(1) << 63))) {
+      result.f <<= 1;
+      --result.e;
+    }
+    return result;
+  }
+
+  /// The points halfway to the neighbouring doubles, sharing the exponent
+  /// of the normalized upper one.
+  void boundaries(DiyFp* lower, DiyFp* upper) const {
+    *upper = DiyFp((f << 1) + 1, e - 1).normalize();
+    *lower = f == doubleHiddenBit ? DiyFp((f << 2) - 1, e - 2)
+                                  : DiyFp((f << 1) - 1, e - 1);
+    lower->f <<= lower->e - upper->e;
+    lower->e = upper->e;
+  }
+
+  UInt64 f;
+  int e;
+};
+
+/// The cached power of ten that brings a number with binary exponent e into
+/// the range DigitGen works in; decimalExponent receives minus its power.
+static DiyFp cachedPowerOf10(int e, int* decimalExponent) {
+  // 10^-348, 10^-340, ..., 10^340, rounded to 64 bits.
+  static const UInt64 significands[] = {
+    0xfa8fd5a0081c0288ULL, 0xbaaee17fa23ebf76ULL, 0x8b16fb203055ac76ULL,
+    0xcf42894a5dce35eaULL, 0x9a6bb0aa55653b2dULL, 0xe61acf033d1a45dfULL,
+    0xab70fe17c79ac6caULL, 0xff77b1fcbebcdc4fULL, 0xbe5691ef416bd60cULL,
+    0x8dd01fad907ffc3cULL, 0xd3515c2831559a83ULL, 0x9d71ac8fada6c9b5ULL,
+    0xea9c227723ee8bcbULL, 0xaecc49914078536dULL, 0x823c12795db6ce57ULL,
+    0xc21094364dfb5637ULL, 0x9096ea6f3848984fULL, 0xd77485cb25823ac7ULL,
+    0xa086cfcd97bf97f4ULL, 0xef340a98172aace5ULL, 0xb23867fb2a35b28eULL,
+    0x84c8d4dfd2c63f3bULL, 0xc5dd44271ad3cdbaULL, 0x936b9fcebb25c996ULL,
+    0xdbac6c247d62a584ULL, 0xa3ab66580d5fdaf6ULL, 0xf3e2f893dec3f126ULL,
+    0xb5b5ada8aaff80b8ULL, 0x87625f056c7c4a8bULL, 0xc9bcff6034c13053ULL,
+    0x964e858c91ba2655ULL, 0xdff9772470297ebdULL, 0xa6dfbd9fb8e5b88fULL,
+    0xf8a95fcf88747d94ULL, 0xb94470938fa89bcfULL, 0x8a08f0f8bf0f156bULL,
+    0xcdb02555653131b6ULL, 0x993fe2c6d07b7facULL, 0xe45c10c42a2b3b06ULL,
+    0xaa242499697392d3ULL, 0xfd87b5f28300ca0eULL, 0xbce5086492111aebULL,
+    0x8cbccc096f5088ccULL, 0xd1b71758e219652cULL, 0x9c40000000000000ULL,
+    0xe8d4a51000000000ULL, 0xad78ebc5ac620000ULL, 0x813f3978f8940984ULL,
+    0xc097ce7bc90715b3ULL, 0x8f7e32ce7bea5c70ULL, 0xd5d238a4abe98068ULL,
+    0x9f4f2726179a2245ULL, 0xed63a231d4c4fb27ULL, 0xb0de65388cc8ada8ULL,
+    0x83c7088e1aab65dbULL, 0xc45d1df942711d9aULL, 0x924d692ca61be758ULL,
+    0xda01ee641a708deaULL, 0xa26da3999aef774aULL, 0xf209787bb47d6b85ULL,
+    0xb454e4a179dd1877ULL, 0x865b86925b9bc5c2ULL, 0xc83553c5c8965d3dULL,
+    0x952ab45cfa97a0b3ULL, 0xde469fbd99a05fe3ULL, 0xa59bc234db398c25ULL,
+    0xf6c69a72a3989f5cULL, 0xb7dcbf5354e9beceULL, 0x88fcf317f22241e2ULL,
+    0xcc20ce9bd35c78a5ULL, 0x98165af37b2153dfULL, 0xe2a0b5dc971f303aULL,
+    0xa8d9d1535ce3b396ULL, 0xfb9b7cd9a4a7443cULL, 0xbb764c4ca7a44410ULL,
+    0x8bab8eefb6409c1aULL, 0xd01fef10a657842cULL, 0x9b10a4e5e9913129ULL,
+    0xe7109bfba19c0c9dULL, 0xac2820d9623bf429ULL, 0x80444b5e7aa7cf85ULL,
+    0xbf21e44003acdd2dULL, 0x8e679c2f5e44ff8fULL, 0xd433179d9c8cb841ULL,
+    0x9e19db92b4e31ba9ULL, 0xeb96bf6ebadf77d9ULL, 0xaf87023b9bf0ee6bULL,
+  };
+  static const short exponents[] = {
+    -1220, -1193, -1166, -1140, -1113, -1087, -1060, -1034, -1007, -980, -954,
+    -927, -901, -874, -847, -821, -794, -768, -741, -715, -688, -661, -635,
+    -608, -582, -555, -529, -502, -475, -449, -422, -396, -369, -343, -316,
+    -289, -263, -236, -210, -183, -157, -130, -103, -77, -50, -24, 3, 30, 56,
+    83, 109, 136, 162, 189, 216, 242, 269, 295, 322, 348, 375, 402, 428, 455,
+    481, 508, 534, 561, 588, 614, 641, 667, 694, 720, 747, 774, 800, 827, 853,
+    880, 907, 933, 960, 986, 1013, 1039, 1066,
+  };
+  double dk = (-61 - e) * 0.30102999566398114 + 347;
+  int k = static_cast<int>(dk);
+  if (dk - k > 0.0)
+    ++k;
+  unsigned int index = static_cast<unsigned int>((k >> 3) + 1);
+  *decimalExponent = -(-348 + static_cast<int>(index << 3));
+  return DiyFp(significands[index], exponents[index]);
+}
+
+static const UInt64 powersOf10[] = {1ULL,
+                                    10ULL,
+                                    100ULL,
+                                    1000ULL,
+                                    10000ULL,
+                                    100000ULL,
+                                    1000000ULL,
+                                    10000000ULL,
+                                    100000000ULL,
+                                    1000000000ULL,
+                                    10000000000ULL,
+                                    100000000000ULL,
+                                    1000000000000ULL,
+                                    10000000000000ULL,
+                                    100000000000000ULL,
+                                    1000000000000000ULL,
+                                    10000000000000000ULL,
+                                    100000000000000000ULL,
+                                    1000000000000000000ULL,
+                                    10000000000000000000ULL};
+
+static int decimalDigitCount(UInt value) {
+  int count = 1;
+  while (count < 9 && value >= powersOf10[count])
+    ++count;
+  return count;
+}
+
+/// Moves the last digit down while that brings it closer to the exact value
+/// and keeps it inside the rounding interval.
+static void grisuRound(char* buffer, int length, UInt64 delta, UInt64 rest,
+                       UInt64 tenKappa, UInt64 distance) {
+  while (rest < distance && delta - rest >= tenKappa &&
+         (rest + tenKappa < distance ||
+          distance - rest > rest + tenKappa - distance)) {
+    --buffer[length - 1];
+    rest += tenKappa;
+  }
+}
+
+static void grisuDigits(const DiyFp& w, const DiyFp& upper, UInt64 delta,
+                        char* buffer, int* length, int* decimalExponent) {
+  const DiyFp one(UInt64(1) << -upper.e, upper.e);
+  const UInt64 distance = (upper - w).f;
+  UInt integral = static_cast<UInt>(upper.f >> -one.e);
+  UInt64 fraction = upper.f & (one.f - 1);
+  int kappa = decimalDigitCount(integral);
+  *length = 0;
+
+  while (kappa > 0) {
+    UInt64 divisor = powersOf10[kappa - 1];
+    UInt digit = static_cast<UInt>(integral / divisor);
+    integral = static_cast<UInt>(integral % divisor);
+    if (digit || *length)
+      buffer[(*length)++] = static_cast<char>('0' + digit);
+    --kappa;
+    UInt64 rest = (static_cast<UInt64>(integral) << -one.e) + fraction;
+    if (rest <= delta) {
+      *decimalExponent += kappa;
+      grisuRound(buffer, *length, delta, rest, powersOf10[kappa] << -one.e,
+                 distance);
+      return;
+    }
+  }
+
+  for (;;) {
+    fraction *= 10;
+    delta *= 10;
+    char digit = static_cast<char>(fraction >> -one.e);
+    if (digit || *length)
+      buffer[(*length)++] = static_cast<char>('0' + digit);
+    fraction &= one.f - 1;
+    --kappa;
+    if (fraction < delta) {
+      *decimalExponent += kappa;
+      int index = -kappa;
+      grisuRound(buffer, *length, delta, fraction, one.f,
+                 distance * (index < 20 ? powersOf10[index] : 0));
+      return;
+    }
+  }
+}
+
+/// Whether digits * 10^decimalExponent reads back as value. The text has no
+/// decimal point, so strtod() reads it the same in every locale.
+static bool readsBackAs(double value, const char* digits, int length,
+                        int decimalExponent) {
+  char text[32];
+  memcpy(text, digits, static_cast<size_t>(length));
+  snprintf(text + length, sizeof(text) - static_cast<size_t>(length), "e%d",
+           decimalExponent);
+  return strtod(text, NULL) == value;
+}
+
+/// Replaces digits * 10^decimalExponent with the fewest digits, but no fewer
+/// than minLength, that still read back as value. Every number of a given
+/// length that reads back lies between the digits cut to that length and
+/// the digits rounded up to it, so only those two are tried, the nearer one
+/// first.
+static void grisuShorten(double value, char* buffer, int* length,
+                         int* decimalExponent, int minLength) {
+  for (int shorter = minLength; shorter < *length; ++shorter) {
+    char candidates[2][24];
+    int lengths[2] = {shorter, shorter};
+    int exponents[2];
+    exponents[0] = exponents[1] = *decimalExponent + *length - shorter;
+    memcpy(candidates[0], buffer, static_cast<size_t>(shorter));
+    memcpy(candidates[1], buffer, static_cast<size_t>(shorter));
+
+    int index = shorter - 1;
+    while (index >= 0 && candidates[1][index] == '9')
+      candidates[1][index--] = '0';
+    if (index >= 0) {
+      ++candidates[1][index];
+    } else {
+      candidates[1][0] = '1';
+      ++exponents[1];
+    }
+
+    for (int i = 0; i < 2; ++i) {
+      while (lengths[i] > 1 && candidates[i][lengths[i] - 1] == '0') {
+        --lengths[i];
+        ++exponents[i];
+      }
+    }
+
+    const int nearer = buffer[shorter] < '5' ? 0 : 1;
+    for (int tried = 0; tried < 2; ++tried) {
+      const int i = nearer ^ tried;
+      if (readsBackAs(value, candidates[i], lengths[i], exponents[i])) {
+        memcpy(buffer, candidates[i], static_cast<size_t>(lengths[i]));
+        *length = lengths[i];
+        *decimalExponent = exponents[i];
+        return;
+      }
+    }
+  }
+}
+
+/// Writes the digits of a positive, finite value to buffer (at most 18
+/// characters) such that value == digits * 10^decimalExponent.
+static void grisu2(double value, char* buffer, int* length,
+                   int* decimalExponent) {
+  const DiyFp v(value);
+  DiyFp lower, upper;
+  v.boundaries(&lower, &upper);
+  int cachedExponent;
+  const DiyFp cached = cachedPowerOf10(upper.e, &cachedExponent);
+  const DiyFp w = v.normalize() * cached;
+  upper = upper * cached;
+  lower = lower * cached;
+
+  // Each product may be one unit off, so the digits come from the interval
+  // narrowed by a unit at each end, where every number reads back as value.
+  *decimalExponent = cachedExponent;
+  grisuDigits(w, DiyFp(upper.f - 1, upper.e), upper.f - lower.f - 2, buffer,
+              length, decimalExponent);
+
+  // A shorter number may still lie in the units left out. The interval
+  // widened by a unit at each end holds every number that could read back,
+  // so the digits generated from it are never longer than the shortest.
+  char wide[24];
+  int wideLength;
+  int wideExponent = cachedExponent;
+  grisuDigits(w, DiyFp(upper.f + 1, upper.e), upper.f - lower.f + 2, wide,
+              &wideLength, &wideExponent);
+  if (wideLength < *length)
+    grisuShorten(value, buffer, length, decimalExponent, wideLength);
+}
+
+enum { shortestBufferSize = 32 };
+
+/// Formats a finite value the way "%.17g" would lay it out, but with the
+/// shortest digits that read back as the same value and always a '.' as the
+/// decimal point. Returns the length written to text, which must have room
+/// for shortestBufferSize characters; the text is not NUL-terminated.
+size_t valueToShortestChars(double value, char* text) {
+  char* out = text;
+  if (value == 0) {
+    if (1 / value < 0)
+      *out++ = '-';
+    memcpy(out, "0.0", 3);
+    return static_cast<size_t>(out + 3 - text);
+  }
+
+  char digits[24];
+  int length = 0;
+  int decimalExponent = 0;
+  bool isNegative = value < 0;
+  grisu2(isNegative ? -value : value, digits, &length, &decimalExponent);
+
+  // The value is 0.digits * 10^point.
+  int point = length + decimalExponent;
+  if (isNegative)
+    *out++ = '-';
+  if (point > -4 && point <= 17) {
+    if (point <= 0) {
+      *out++ = '0';
+      *out++ = '.';
+      for (int i = point; i < 0; ++i)
+        *out++ = '0';
+      memcpy(out, digits, static_cast<size_t>(length));
+      out += length;
+    } else if (point >= length) {
+      memcpy(out, digits, static_cast<size_t>(length));
+      out += length;
+      for (int i = length; i < point; ++i)
+        *out++ = '0';
+      *out++ = '.';
+      *out++ = '0';
+    } else {
+      memcpy(out, digits, static_cast<size_t>(point));
+      out += point;
+      *out++ = '.';
+      memcpy(out, digits + point, static_cast<size_t>(length - point));
+      out += length - point;
+    }
+  } else {
+    *out++ = digits[0];
+    if (length > 1) {
+      *out++ = '.';
+      memcpy(out, digits + 1, static_cast<size_t>(length - 1));
+      out += length - 1;
+    }
+    int exponent = point - 1;
+    *out++ = 'e';
+    *out++ = exponent < 0 ? '-' : '+';
+    if (exponent < 0)
+      exponent = -exponent;
+    if (exponent >= 100)
+      *out++ = static_cast<char>('0' + exponent / 100);
+    *out++ = static_cast<char>('0' + exponent / 10 % 10);
+    *out++ = static_cast<char>('0' + exponent % 10);
+  }
+  return static_cast<size_t>(out - text);
+}
+
+/// Whether valueToString() writes a finite double with the shortest digits.
+inline bool isShortestPrecision(unsigned int precision,
+                                PrecisionType precisionType) {
+  return precisionType == PrecisionType::significantDigits &&
+         precision >= Value::defaultRealPrecision;
+}
+
 JSONCPP_STRING valueToString(double value,
                              bool useSpecialFloats,
                              unsigned int precision,
@@ -4312,6 +5798,13 @@ JSONCPP_STRING valueToString(double value,
                [isnan(value) ? 0 : (value < 0) ? 1 : 2];
   }
 
+  // At full precision, write the shortest text that reads back as the same
+  // double rather than all seventeen digits.
+  if (isShortestPrecision(precision, precisionType)) {
+    char text[shortestBufferSize];
+    return JSONCPP_STRING(text, valueToShortestChars(value, text));
+  }
+
   JSONCPP_STRING buffer(size_t(36), '\0');
   while (true) {
     int len = snprintf(
@@ -4352,18 +5845,6 @@ JSONCPP_STRING valueToString(double value,
 
 JSONCPP_STRING valueToString(bool value) { return value ? "true" : "false"; }
 
-static bool isAnyCharRequiredQuoting(char const* s, size_t n) {
-  assert(s || !n);
-
-  char const* const end = s + n;
-  for (char const* cur = s; cur < end; ++cur) {
-    if (*cur == '\\' || *cur == '\"' || *cur < ' ' ||
-        static_cast<unsigned char>(*cur) < 0x80)
-      return true;
-  }
-  return false;
-}
-
 static unsigned int utf8ToCodepoint(const char*& s, const char* e) {
   const unsigned int REPLACEMENT_CHARACTER = 0xFFFD;
 
@@ -4443,42 +5924,42 @@ static JSONCPP_STRING toHex16Bit(unsigned int x) {
   return result;
 }
 
-static JSONCPP_STRING valueToQuotedStringN(const char* value, unsigned length) {
-  if (value == NULL)
-    return "";
-
-  if (!isAnyCharRequiredQuoting(value, length))
-    return JSONCPP_STRING("\"") + value + "\"";
-  // We have to walk value and escape any special characters.
-  // Appending to JSONCPP_STRING is not efficient, but this should be rare.
-  // (Note: forward slashes are *not* rare, but I am not escaping them.)
-  JSONCPP_STRING::size_type maxsize = length * 2 + 3; // allescaped+quotes+NULL
-  JSONCPP_STRING result;
-  result.reserve(maxsize); // to avoid lots of mallocs
-  result += "\"";
+// Copies the runs that need no escaping in one go; the scanner finds where
+// each run ends.
+static void writeQuotedString(WriteBuffer& out,
+                              const char* value,
+                              unsigned length) {
+  char const* (*const findEscapeSpecial)(char const*, char const*) =
+      scanner().findEscapeSpecial;
+  out.append('"');
   char const* end = value + length;
-  for (const char* c = value; c != end; ++c) {
+  for (const char* c = value;; ++c) {
+    char const* special = findEscapeSpecial(c, end);
+    out.append(c, static_cast<size_t>(special - c));
+    if (special == end)
+      break;
+    c = special;
     switch (*c) {
     case '\"':
-      result += "\\\"";
+      out.append("\\\"", 2);
       break;
     case '\\':
-      result += "\\\\";
+      out.append("\\\\", 2);
       break;
     case '\b':
-      result += "\\b";
+      out.append("\\b", 2);
       break;
     case '\f':
-      result += "\\f";
+      out.append("\\f", 2);
       break;
     case '\n':
-      result += "\\n";
+      out.append("\\n", 2);
       break;
     case '\r':
-      result += "\\r";
+      out.append("\\r", 2);
       break;
     case '\t':
-      result += "\\t";
+      out.append("\\t", 2);
       break;
     // case '/':
     // Even though \/ is considered a legal escape in JSON, a bare
@@ -4493,29 +5974,123 @@ static JSONCPP_STRING valueToQuotedStringN(const char* value, unsigned length) {
       // don't escape non-control characters
       // (short escape sequence are applied above)
       if (cp < 0x80 && cp >= 0x20)
-        result += static_cast<char>(cp);
+        out.append(static_cast<char>(cp));
       else if (cp < 0x10000) { // codepoint is in Basic Multilingual Plane
-        result += "\\u";
-        result += toHex16Bit(cp);
+        out.append("\\u", 2);
+        out.append(toHex16Bit(cp));
       } else { // codepoint is not in Basic Multilingual Plane
                // convert to surrogate pair first
         cp -= 0x10000;
-        result += "\\u";
-        result += toHex16Bit((cp >> 10) + 0xD800);
-        result += "\\u";
-        result += toHex16Bit((cp & 0x3FF) + 0xDC00);
+        out.append("\\u", 2);
+        out.append(toHex16Bit((cp >> 10) + 0xD800));
+        out.append("\\u", 2);
+        out.append(toHex16Bit((cp & 0x3FF) + 0xDC00));
       }
     } break;
     }
   }
-  result += "\"";
-  return result;
+  out.append('"');
+}
+
+static JSONCPP_STRING valueToQuotedStringN(const char* value, unsigned length) {
+  if (value == NULL)
+    return "";
+
+  WriteBuffer out;
+  writeQuotedString(out, value, length);
+  return out.take();
 }
 
 JSONCPP_STRING valueToQuotedString(const char* value) {
   return valueToQuotedStringN(value, static_cast<unsigned int>(strlen(value)));
 }
 
+// Class WriteBuffer
+// //////////////////////////////////////////////////////////////////
+
+WriteBuffer::WriteBuffer()
+    : size_(0), sink_(NULL), context_(NULL), chunkSize_(0), good_(true) {}
+
+WriteBuffer::WriteBuffer(Sink sink, void* context, size_t chunkSize)
+    : size_(0), sink_(sink), context_(context),
+      chunkSize_(chunkSize != 0 ? chunkSize : size_t(defaultChunkSize)),
+      good_(true) {
+  data_.resize(chunkSize_);
+}
+
+void WriteBuffer::append(char const* data, size_t size) {
+  if (size > data_.size() - size_) {
+    reserve(size);
+    if (sink_ && size > data_.size()) {
+      // Too large to buffer; pass it on as it is.
+      if (good_)
+        good_ = sink_(context_, data, size);
+      return;
+    }
+  }
+  if (size != 0)
+    memcpy(&data_[size_], data, size);
+  size_ += size;
+}
+
+void WriteBuffer::reserve(size_t size) {
+  // With a sink the buffer stays at one chunk.
+  if (sink_) {
+    flush();
+    return;
+  }
+  size_t capacity = data_.size() < 256 ? 256 : data_.size() * 2;
+  while (capacity - size_ < size)
+    capacity *= 2;
+  data_.resize(capacity);
+}
+
+bool WriteBuffer::flush() {
+  if (sink_ && size_ != 0) {
+    if (good_)
+      good_ = sink_(context_, data_.data(), size_);
+    size_ = 0;
+  }
+  return good_;
+}
+
+JSONCPP_STRING WriteBuffer::take() {
+  data_.resize(size_);
+  size_ = 0;
+  JSONCPP_STRING result;
+  result.swap(data_);
+  if (sink_)
+    data_.resize(chunkSize_);
+  return result;
+}
+
+static bool writeToStream(void* context, char const* data, size_t size) {
+  JSONCPP_OSTREAM& sout = *static_cast<JSONCPP_OSTREAM*>(context);
+  sout.write(data, static_cast<std::streamsize>(size));
+  return !sout.fail();
+}
+
+static bool writeToFileDescriptor(void* context, char const* data,
+                                  size_t size) {
+  int fd = *static_cast<int*>(context);
+  while (size != 0) {
+#if defined(_MSC_VER)
+    const size_t maxWrite = 0x40000000;
+    int written = _write(fd, data,
+                         static_cast<unsigned>(size < maxWrite ? size : maxWrite));
+#else
+    ssize_t written = ::write(fd, data, size);
+    if (written < 0 && errno == EINTR)
+      continue;
+#endif
+    if (written <= 0)
+      return false;
+    data += written;
+    size -= static_cast<size_t>(written);
+  }
+  return true;
+}
+
 // Class Writer
 // //////////////////////////////////////////////////////////////////
 Writer::~Writer() {}
@@ -5053,13 +6628,16 @@ struct BuiltStyledStreamWriter : public StreamWriter {
                           unsigned int precision,
                           PrecisionType precisionType);
   int write(Value const& root, JSONCPP_OSTREAM* sout) JSONCPP_OVERRIDE;
+  int writeToBuffer(Value const& root, WriteBuffer* buffer) JSONCPP_OVERRIDE;
 
 private:
   void writeValue(Value const& value);
   void writeArrayValue(Value const& value);
   bool isMultilineArray(Value const& value);
+  void pushValue(char const* value, size_t length);
   void pushValue(JSONCPP_STRING const& value);
   void writeIndent();
+  void writeWithIndent(char value);
   void writeWithIndent(JSONCPP_STRING const& value);
   void indent();
   void unindent();
@@ -5069,8 +6647,12 @@ private:
 
   typedef std::vector<JSONCPP_STRING> ChildValues;
 
+  WriteBuffer* out_;
   ChildValues childValues_;
-  JSONCPP_STRING indentString_;
+  // A newline followed by the indentation repeated for as deep as the
+  // document has gone so far; writeIndent() writes a prefix of it.
+  JSONCPP_STRING indentTable_;
+  unsigned int depth_;
   unsigned int rightMargin_;
   JSONCPP_STRING indentation_;
   CommentStyle::Enum cs_;
@@ -5092,24 +6674,37 @@ BuiltStyledStreamWriter::BuiltStyledStreamWriter(
     bool useSpecialFloats,
     unsigned int precision,
     PrecisionType precisionType)
-    : rightMargin_(74), indentation_(indentation), cs_(cs),
-      colonSymbol_(colonSymbol), nullSymbol_(nullSymbol),
-      endingLineFeedSymbol_(endingLineFeedSymbol), addChildValues_(false),
-      indented_(false), useSpecialFloats_(useSpecialFloats),
-      precision_(precision), precisionType_(precisionType) {}
+    : out_(NULL), indentTable_("\n"), depth_(0), rightMargin_(74),
+      indentation_(indentation), cs_(cs), colonSymbol_(colonSymbol),
+      nullSymbol_(nullSymbol), endingLineFeedSymbol_(endingLineFeedSymbol),
+      addChildValues_(false), indented_(false),
+      useSpecialFloats_(useSpecialFloats), precision_(precision),
+      precisionType_(precisionType) {
+  for (int level = 0; level < 8; ++level)
+    indentTable_ += indentation_;
+}
 int BuiltStyledStreamWriter::write(Value const& root, JSONCPP_OSTREAM* sout) {
+  WriteBuffer buffer(writeToStream, sout);
   sout_ = sout;
+  int result = writeToBuffer(root, &buffer);
+  buffer.flush();
+  sout_ = NULL;
+  return result;
+}
+int BuiltStyledStreamWriter::writeToBuffer(Value const& root,
+                                           WriteBuffer* buffer) {
+  out_ = buffer;
   addChildValues_ = false;
   indented_ = true;
-  indentString_.clear();
+  depth_ = 0;
   writeCommentBeforeValue(root);
   if (!indented_)
     writeIndent();
   indented_ = true;
   writeValue(root);
   writeCommentAfterValueOnSameLine(root);
-  *sout_ << endingLineFeedSymbol_;
-  sout_ = NULL;
+  out_->append(endingLineFeedSymbol_);
+  out_ = NULL;
   return 0;
 }
 void BuiltStyledStreamWriter::writeValue(Value const& value) {
@@ -5117,58 +6712,80 @@ void BuiltStyledStreamWriter::writeValue(Value const& value) {
   case nullValue:
     pushValue(nullSymbol_);
     break;
-  case intValue:
-    pushValue(valueToString(value.asLargestInt()));
+  case intValue: {
+    UIntToStringBuffer buffer;
+    char const* text = largestIntToString(value.asLargestInt(), buffer);
+    pushValue(text, static_cast<size_t>(buffer + sizeof(buffer) - 1 - text));
     break;
-  case uintValue:
-    pushValue(valueToString(value.asLargestUInt()));
+  }
+  case uintValue: {
+    UIntToStringBuffer buffer;
+    char* text = buffer + sizeof(buffer);
+    uintToString(value.asLargestUInt(), text);
+    pushValue(text, static_cast<size_t>(buffer + sizeof(buffer) - 1 - text));
     break;
-  case realValue:
-    pushValue(valueToString(value.asDouble(), useSpecialFloats_, precision_,
-                            precisionType_));
+  }
+  case realValue: {
+    double real = value.asDouble();
+    if (isfinite(real) && isShortestPrecision(precision_, precisionType_)) {
+      char text[shortestBufferSize];
+      pushValue(text, valueToShortestChars(real, text));
+    } else {
+      pushValue(valueToString(real, useSpecialFloats_, precision_,
+                              precisionType_));
+    }
     break;
+  }
   case stringValue: {
     // Is NULL is possible for value.string_? No.
     char const* str;
     char const* end;
     bool ok = value.getString(&str, &end);
-    if (ok)
-      pushValue(valueToQuotedStringN(str, static_cast<unsigned>(end - str)));
+    if (!ok)
+      pushValue("", 0);
+    else if (addChildValues_)
+      childValues_.push_back(
+          valueToQuotedStringN(str, static_cast<unsigned>(end - str)));
     else
-      pushValue("");
+      writeQuotedString(*out_, str, static_cast<unsigned>(end - str));
     break;
   }
   case booleanValue:
-    pushValue(valueToString(value.asBool()));
+    if (value.asBool())
+      pushValue("true", 4);
+    else
+      pushValue("false", 5);
     break;
   case arrayValue:
     writeArrayValue(value);
     break;
   case objectValue: {
-    Value::Members members(value.getMemberNames());
-    if (members.empty())
-      pushValue("{}");
+    Value::const_iterator it = value.begin();
+    if (it == value.end())
+      pushValue("{}", 2);
     else {
-      writeWithIndent("{");
+      writeWithIndent('{');
       indent();
-      Value::Members::iterator it = members.begin();
       for (;;) {
-        JSONCPP_STRING const& name = *it;
-        Value const& childValue = value[name];
+        char const* nameEnd;
+        char const* name = it.memberName(&nameEnd);
+        Value const& childValue = *it;
         writeCommentBeforeValue(childValue);
-        writeWithIndent(valueToQuotedStringN(
-            name.data(), static_cast<unsigned>(name.length())));
-        *sout_ << colonSymbol_;
+        if (!indented_)
+          writeIndent();
+        writeQuotedString(*out_, name, static_cast<unsigned>(nameEnd - name));
+        indented_ = false;
+        out_->append(colonSymbol_);
         writeValue(childValue);
-        if (++it == members.end()) {
+        if (++it == value.end()) {
           writeCommentAfterValueOnSameLine(childValue);
           break;
         }
-        *sout_ << ",";
+        out_->append(',');
         writeCommentAfterValueOnSameLine(childValue);
       }
       unindent();
-      writeWithIndent("}");
+      writeWithIndent('}');
     }
   } break;
   }
@@ -5177,11 +6794,11 @@ void BuiltStyledStreamWriter::writeValue(Value const& value) {
 void BuiltStyledStreamWriter::writeArrayValue(Value const& value) {
   unsigned size = value.size();
   if (size == 0)
-    pushValue("[]");
+    pushValue("[]", 2);
   else {
     bool isMultiLine = (cs_ == CommentStyle::All) || isMultilineArray(value);
     if (isMultiLine) {
-      writeWithIndent("[");
+      writeWithIndent('[');
       indent();
       bool hasChildValue = !childValues_.empty();
       unsigned index = 0;
@@ -5201,25 +6818,29 @@ void BuiltStyledStreamWriter::writeArrayValue(Value const& value) {
           writeCommentAfterValueOnSameLine(childValue);
           break;
         }
-        *sout_ << ",";
+        out_->append(',');
         writeCommentAfterValueOnSameLine(childValue);
       }
       unindent();
-      writeWithIndent("]");
+      writeWithIndent(']');
     } else // output on a single line
     {
       assert(childValues_.size() == size);
-      *sout_ << "[";
+      out_->append('[');
       if (!indentation_.empty())
-        *sout_ << " ";
+        out_->append(' ');
       for (unsigned index = 0; index < size; ++index) {
-        if (index > 0)
-          *sout_ << ((!indentation_.empty()) ? ", " : ",");
-        *sout_ << childValues_[index];
+        if (index > 0) {
+          if (!indentation_.empty())
+            out_->append(", ", 2);
+          else
+            out_->append(',');
+        }
+        out_->append(childValues_[index]);
       }
       if (!indentation_.empty())
-        *sout_ << " ";
-      *sout_ << "]";
+        out_->append(' ');
+      out_->append(']');
     }
   }
 }
@@ -5251,11 +6872,18 @@ bool BuiltStyledStreamWriter::isMultilineArray(Value const& value) {
   return isMultiLine;
 }
 
+void BuiltStyledStreamWriter::pushValue(char const* value, size_t length) {
+  if (addChildValues_)
+    childValues_.push_back(JSONCPP_STRING(value, length));
+  else
+    out_->append(value, length);
+}
+
 void BuiltStyledStreamWriter::pushValue(JSONCPP_STRING const& value) {
   if (addChildValues_)
     childValues_.push_back(value);
   else
-    *sout_ << value;
+    out_->append(value);
 }
 
 void BuiltStyledStreamWriter::writeIndent() {
@@ -5266,22 +6894,36 @@ void BuiltStyledStreamWriter::writeIndent() {
 
   if (!indentation_.empty()) {
     // In this case, drop newlines too.
-    *sout_ << '\n' << indentString_;
+    out_->append(indentTable_.data(), 1 + depth_ * indentation_.size());
   }
 }
 
+void BuiltStyledStreamWriter::writeWithIndent(char value) {
+  if (!indented_)
+    writeIndent();
+  out_->append(value);
+  indented_ = false;
+}
+
 void BuiltStyledStreamWriter::writeWithIndent(JSONCPP_STRING const& value) {
   if (!indented_)
     writeIndent();
-  *sout_ << value;
+  out_->append(value);
   indented_ = false;
 }
 
-void BuiltStyledStreamWriter::indent() { indentString_ += indentation_; }
+void BuiltStyledStreamWriter::indent() {
+  ++depth_;
+  size_t const length = 1 + depth_ * indentation_.size();
+  if (indentTable_.size() < length) {
+    JSONCPP_STRING const levels = indentTable_.substr(1);
+    indentTable_ += levels;
+  }
+}
 
 void BuiltStyledStreamWriter::unindent() {
-  assert(indentString_.size() >= indentation_.size());
-  indentString_.resize(indentString_.size() - indentation_.size());
+  assert(depth_ > 0);
+  --depth_;
 }
 
 void BuiltStyledStreamWriter::writeCommentBeforeValue(Value const& root) {
@@ -5295,10 +6937,10 @@ void BuiltStyledStreamWriter::writeCommentBeforeValue(Value const& root) {
   const JSONCPP_STRING& comment = root.getComment(commentBefore);
   JSONCPP_STRING::const_iterator iter = comment.begin();
   while (iter != comment.end()) {
-    *sout_ << *iter;
+    out_->append(*iter);
     if (*iter == '\n' && ((iter + 1) != comment.end() && *(iter + 1) == '/'))
       // writeIndent();  // would write extra newline
-      *sout_ << indentString_;
+      out_->append(indentTable_.data() + 1, depth_ * indentation_.size());
     ++iter;
   }
   indented_ = false;
@@ -5308,12 +6950,14 @@ void BuiltStyledStreamWriter::writeCommentAfterValueOnSameLine(
     Value const& root) {
   if (cs_ == CommentStyle::None)
     return;
-  if (root.hasComment(commentAfterOnSameLine))
-    *sout_ << " " + root.getComment(commentAfterOnSameLine);
+  if (root.hasComment(commentAfterOnSameLine)) {
+    out_->append(' ');
+    out_->append(root.getComment(commentAfterOnSameLine));
+  }
 
   if (root.hasComment(commentAfter)) {
     writeIndent();
-    *sout_ << root.getComment(commentAfter);
+    out_->append(root.getComment(commentAfter));
   }
 }
 
@@ -5329,6 +6973,12 @@ bool BuiltStyledStreamWriter::hasCommentForValue(const Value& value) {
 
 StreamWriter::StreamWriter() : sout_(NULL) {}
 StreamWriter::~StreamWriter() {}
+int StreamWriter::writeToBuffer(Value const& root, WriteBuffer* buffer) {
+  JSONCPP_OSTRINGSTREAM sout;
+  int result = write(root, &sout);
+  buffer->append(sout.str());
+  return result;
+}
 StreamWriter::Factory::~Factory() {}
 StreamWriterBuilder::StreamWriterBuilder() { setDefaults(&settings_); }
 StreamWriterBuilder::~StreamWriterBuilder() {}
@@ -5418,10 +7068,20 @@ void StreamWriterBuilder::setDefaults(Json::Value* settings) {
 
 JSONCPP_STRING writeString(StreamWriter::Factory const& factory,
                            Value const& root) {
-  JSONCPP_OSTRINGSTREAM sout;
+  WriteBuffer buffer;
   StreamWriterPtr const writer(factory.newStreamWriter());
-  writer->write(root, &sout);
-  return sout.str();
+  writer->writeToBuffer(root, &buffer);
+  return buffer.take();
+}
+
+bool writeToDescriptor(StreamWriter::Factory const& factory,
+                       Value const& root,
+                       int fd,
+                       size_t chunkSize) {
+  WriteBuffer buffer(writeToFileDescriptor, &fd, chunkSize);
+  StreamWriterPtr const writer(factory.newStreamWriter());
+  writer->writeToBuffer(root, &buffer);
+  return buffer.flush();
 }
 
 JSONCPP_OSTREAM& operator<<(JSONCPP_OSTREAM& sout, Value const& root) {
@@ -0,0 +1,84 @@
+/*
+Copyright 2018 Microsoft
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH
+THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace Benchmarks
+{
+	// Runs the measured operation 'iterations' times.
+	typedef std::function<void(uint64_t iterations)> BenchmarkFunction;
+
+	struct BenchmarkInfo
+	{
+		std::string name;
+		BenchmarkFunction function;
+	};
+
+	std::vector<BenchmarkInfo>& Registry();
+
+	// Splits the iterations across the hardware threads, as concurrent RPC
+	// calls would, and returns once every thread is done.
+	void RunOnAllThreads(uint64_t iterations, const BenchmarkFunction& run);
+
+	// Calls to operator new so far, on the calling thread and on the threads
+	// RunOnAllThreads started. Threads the code under test starts itself are
+	// not counted.
+	uint64_t AllocationCount();
+
+	// Leaves the time and allocations between the two calls out of the
+	// results, e.g. to measure only the teardown of something built per
+	// iteration. Only for benchmarks that run on the calling thread.
+	void PauseTiming();
+	void ResumeTiming();
+
+	// The size of the document each iteration reads or writes, shown with
+	// the results so that formats can be compared by size as well.
+	void ReportBytes(uint64_t bytes);
+
+	class Registration
+	{
+	public:
+		Registration(const char* name, BenchmarkFunction function)
+		{
+			Registry().push_back({ name, function });
+		}
+	};
+
+	// Keeps the optimizer from discarding a value the benchmark computed:
+	// the value has to be in memory, and may be read, at this point.
+	template<typename T>
+	void DoNotOptimize(const T& value)
+	{
+#ifdef _MSC_VER
+		static_cast<void>(*reinterpret_cast<const volatile char*>(&value));
+		_ReadWriteBarrier();
+#else
+		asm volatile("" : : "r"(&value) : "memory");
+#endif
+	}
+}
+
+#define BENCHMARK(name) \
+	static void name(uint64_t iterations); \
+	static Benchmarks::Registration name##Registration(#name, name); \
+	static void name(uint64_t iterations)
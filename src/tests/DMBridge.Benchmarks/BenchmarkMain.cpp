@@ -0,0 +1,355 @@
+/*
+Copyright 2018 Microsoft
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH
+THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "stdafx.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <thread>
+#include "Benchmark.h"
+#include "Fakes.h"
+#include "StringUtils.h"
+
+using namespace std;
+using namespace std::chrono;
+
+// The global operator new is replaced to count allocations for the new/op
+// column. Counts are kept per thread, so that counting does not contend
+// between the threads of a multi-threaded benchmark.
+static thread_local uint64_t threadAllocations = 0;
+static atomic<uint64_t> workerAllocations(0);
+
+// Each block starts with its size, so that operator delete can keep the
+// bytes in use up to date for the peak KB column. A block freed by another
+// thread than the one that allocated it is counted against the freeing one.
+static const size_t BlockHeaderSize = alignof(max_align_t);
+static thread_local int64_t threadLiveBytes = 0;
+static thread_local int64_t threadPeakBytes = 0;
+
+static steady_clock::time_point pauseStart;
+static uint64_t pauseStartAllocations = 0;
+static int64_t pauseStartPeakBytes = 0;
+static nanoseconds pausedTime(0);
+static uint64_t pausedAllocations = 0;
+static uint64_t reportedBytes = 0;
+
+static void* Allocate(size_t size) noexcept
+{
+	++threadAllocations;
+	void* block = malloc(BlockHeaderSize + size);
+	if (block == nullptr)
+	{
+		return nullptr;
+	}
+
+	*static_cast<size_t*>(block) = size;
+	threadLiveBytes += static_cast<int64_t>(size);
+	threadPeakBytes = max(threadPeakBytes, threadLiveBytes);
+	return static_cast<char*>(block) + BlockHeaderSize;
+}
+
+static void Free(void* memory) noexcept
+{
+	if (memory == nullptr)
+	{
+		return;
+	}
+
+	void* block = static_cast<char*>(memory) - BlockHeaderSize;
+	threadLiveBytes -= static_cast<int64_t>(*static_cast<size_t*>(block));
+	free(block);
+}
+
+void* operator new(size_t size)
+{
+	void* memory = Allocate(size);
+	if (memory == nullptr)
+	{
+		throw bad_alloc();
+	}
+	return memory;
+}
+
+void* operator new(size_t size, const nothrow_t&) noexcept
+{
+	return Allocate(size);
+}
+
+void* operator new[](size_t size)
+{
+	return operator new(size);
+}
+
+void operator delete(void* memory) noexcept
+{
+	Free(memory);
+}
+
+void operator delete(void* memory, size_t) noexcept
+{
+	Free(memory);
+}
+
+void operator delete[](void* memory) noexcept
+{
+	Free(memory);
+}
+
+void operator delete[](void* memory, size_t) noexcept
+{
+	Free(memory);
+}
+
+namespace Benchmarks
+{
+	vector<BenchmarkInfo>& Registry()
+	{
+		static vector<BenchmarkInfo> registry;
+		return registry;
+	}
+
+	void RunOnAllThreads(uint64_t iterations, const BenchmarkFunction& run)
+	{
+		unsigned int threadCount = max(thread::hardware_concurrency(), 1u);
+		vector<thread> threads;
+		for (unsigned int t = 0; t < threadCount; ++t)
+		{
+			threads.emplace_back([&run, iterations, threadCount]()
+			{
+				uint64_t allocations = threadAllocations;
+				run(iterations / threadCount + 1);
+				workerAllocations += threadAllocations - allocations;
+			});
+		}
+		for (thread& t : threads)
+		{
+			t.join();
+		}
+	}
+
+	uint64_t AllocationCount()
+	{
+		return threadAllocations + workerAllocations.load();
+	}
+
+	void PauseTiming()
+	{
+		pauseStartAllocations = AllocationCount();
+		pauseStartPeakBytes = threadPeakBytes;
+		pauseStart = steady_clock::now();
+	}
+
+	// What setup keeps still counts towards the peak; what it only used
+	// while paused does not.
+	void ResumeTiming()
+	{
+		pausedTime += duration_cast<nanoseconds>(steady_clock::now() - pauseStart);
+		pausedAllocations += AllocationCount() - pauseStartAllocations;
+		threadPeakBytes = max(pauseStartPeakBytes, threadLiveBytes);
+	}
+
+	void ReportBytes(uint64_t bytes)
+	{
+		reportedBytes = bytes;
+	}
+}
+
+struct BenchmarkResult
+{
+	string name;
+	uint64_t iterations;
+	double nanosecondsPerIteration;
+
+	// Calls into the faked system APIs, per iteration.
+	double registryCallsPerIteration;
+	double scmCallsPerIteration;
+
+	double allocationsPerIteration;
+
+	// The most heap the calling thread had in use at once during the run,
+	// above what it had before.
+	double peakKilobytes;
+
+	// As the benchmark reported it, or 0.
+	uint64_t documentBytes;
+};
+
+// Doubles the iteration count until a run lasts at least minimumTime, so that
+// timer resolution and loop overhead are negligible.
+static BenchmarkResult Run(const Benchmarks::BenchmarkInfo& benchmark, nanoseconds minimumTime)
+{
+	uint64_t iterations = 1;
+	for (;;)
+	{
+		uint64_t registryCalls = Fakes::FakeRegistry::CallCount();
+		uint64_t scmCalls = Fakes::FakeServiceControlManager::CallCount();
+		uint64_t allocations = Benchmarks::AllocationCount();
+		int64_t liveBytes = threadLiveBytes;
+		threadPeakBytes = liveBytes;
+		pausedTime = nanoseconds(0);
+		pausedAllocations = 0;
+		reportedBytes = 0;
+
+		steady_clock::time_point start = steady_clock::now();
+		benchmark.function(iterations);
+		nanoseconds elapsed = duration_cast<nanoseconds>(steady_clock::now() - start) - pausedTime;
+		allocations += pausedAllocations;
+
+		if (elapsed >= minimumTime || iterations >= (uint64_t(1) << 40))
+		{
+			double count = static_cast<double>(iterations);
+			return { benchmark.name, iterations,
+				elapsed.count() / count,
+				(Fakes::FakeRegistry::CallCount() - registryCalls) / count,
+				(Fakes::FakeServiceControlManager::CallCount() - scmCalls) / count,
+				(Benchmarks::AllocationCount() - allocations) / count,
+				(threadPeakBytes - liveBytes) / 1024.0,
+				reportedBytes };
+		}
+		iterations *= 2;
+	}
+}
+
+static void WriteJson(const vector<BenchmarkResult>& results, const string& fileName)
+{
+	Json::Value benchmarks(Json::arrayValue);
+	for (const BenchmarkResult& result : results)
+	{
+		Json::Value benchmark(Json::objectValue);
+		benchmark["name"] = result.name;
+		benchmark["iterations"] = Json::UInt64(result.iterations);
+		benchmark["nsPerOp"] = result.nanosecondsPerIteration;
+		benchmark["registryCallsPerOp"] = result.registryCallsPerIteration;
+		benchmark["scmCallsPerOp"] = result.scmCallsPerIteration;
+		benchmark["allocationsPerOp"] = result.allocationsPerIteration;
+		benchmark["peakKilobytes"] = result.peakKilobytes;
+		if (result.documentBytes != 0)
+		{
+			benchmark["documentBytes"] = Json::UInt64(result.documentBytes);
+		}
+		benchmarks.append(benchmark);
+	}
+
+	Json::Value root(Json::objectValue);
+	root["benchmarks"] = benchmarks;
+
+	ofstream file(fileName);
+	file << root;
+}
+
+// The bridge's logger has already claimed the console for wide output, which
+// narrow writes cannot be mixed with, so the report is written to wcout too.
+static void PrintRow(const string& name, const string& iterations, const string& nanoseconds, const string& registryCalls, const string& scmCalls, const string& allocations, const string& peak, const string& bytes)
+{
+	bool silenced = wcout.bad();
+	wcout.clear();
+	wcout << left << setw(48) << Utils::MultibyteToWide(name.c_str()) << right
+		<< L' ' << setw(14) << Utils::MultibyteToWide(iterations.c_str())
+		<< L' ' << setw(14) << Utils::MultibyteToWide(nanoseconds.c_str())
+		<< L' ' << setw(8) << Utils::MultibyteToWide(registryCalls.c_str())
+		<< L' ' << setw(8) << Utils::MultibyteToWide(scmCalls.c_str())
+		<< L' ' << setw(10) << Utils::MultibyteToWide(allocations.c_str())
+		<< L' ' << setw(10) << Utils::MultibyteToWide(peak.c_str())
+		<< L' ' << setw(10) << Utils::MultibyteToWide(bytes.c_str()) << endl;
+	if (silenced)
+	{
+		wcout.setstate(ios::badbit);
+	}
+}
+
+static string Format(double value, int precision)
+{
+	ostringstream formatted;
+	formatted << fixed << setprecision(precision) << value;
+	return formatted.str();
+}
+
+static void PrintUsage()
+{
+	wcout << L"Usage: DMBridge.Benchmarks [--quick] [--filter {substring}] [--json {file}] [--verbose]" << endl;
+	wcout << L" --quick    run every benchmark briefly, as a smoke test." << endl;
+	wcout << L" --filter   only run benchmarks whose name contains {substring}." << endl;
+	wcout << L" --json     also write the results to {file} as JSON." << endl;
+	wcout << L" --verbose  keep the bridge's console logging on." << endl;
+}
+
+int main(int argc, char* argv[])
+{
+	nanoseconds minimumTime = milliseconds(200);
+	string filter;
+	string jsonFileName;
+	bool verbose = false;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		if (strcmp(argv[i], "--quick") == 0)
+		{
+			minimumTime = milliseconds(1);
+		}
+		else if (strcmp(argv[i], "--filter") == 0 && i + 1 < argc)
+		{
+			filter = argv[++i];
+		}
+		else if (strcmp(argv[i], "--json") == 0 && i + 1 < argc)
+		{
+			jsonFileName = argv[++i];
+		}
+		else if (strcmp(argv[i], "--verbose") == 0)
+		{
+			verbose = true;
+		}
+		else
+		{
+			PrintUsage();
+			return 1;
+		}
+	}
+
+	// The bridge logs every call to the console; that would swamp the results.
+	if (!verbose)
+	{
+		wcout.setstate(ios::badbit);
+	}
+
+	vector<BenchmarkResult> results;
+	PrintRow("Benchmark", "Iterations", "ns/op", "reg/op", "scm/op", "new/op", "peak KB", "bytes");
+	for (const Benchmarks::BenchmarkInfo& benchmark : Benchmarks::Registry())
+	{
+		if (!filter.empty() && benchmark.name.find(filter) == string::npos)
+		{
+			continue;
+		}
+
+		BenchmarkResult result = Run(benchmark, minimumTime);
+		PrintRow(result.name, to_string(result.iterations), Format(result.nanosecondsPerIteration, 2),
+			Format(result.registryCallsPerIteration, 2), Format(result.scmCallsPerIteration, 2),
+			Format(result.allocationsPerIteration, 2), Format(result.peakKilobytes, 1),
+			result.documentBytes != 0 ? to_string(result.documentBytes) : "-");
+		results.push_back(result);
+	}
+
+	if (!jsonFileName.empty())
+	{
+		WriteJson(results, jsonFileName);
+	}
+	return 0;
+}
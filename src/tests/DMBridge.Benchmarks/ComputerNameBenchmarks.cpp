@@ -0,0 +1,132 @@
+/*
+Copyright 2018 Microsoft
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH
+THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "stdafx.h"
+#include "Benchmark.h"
+#include "ComputerName.h"
+#include "Fakes.h"
+#include "RegistryStore.h"
+
+using namespace std;
+
+static void Setup()
+{
+	static once_flag once;
+	call_once(once, []()
+	{
+		Fakes::FakeSystem::SetComputerName(L"MINWINPC");
+		Fakes::FakeRegistry::SetValue(L"system\\currentcontrolset\\control\\computername\\computername", L"ComputerName", wstring(L"MINWINPC"));
+	});
+}
+
+// Serves the names from the watched cache for as long as it is in scope, then
+// restores the uncached reads the other benchmarks measure.
+class CachedNames
+{
+public:
+	CachedNames()
+	{
+		ComputerName::ApplyRegistryStore(make_shared<Utils::Win32RegistryStore>());
+		ComputerName::StartWatching();
+	}
+
+	~CachedNames()
+	{
+		ComputerName::ApplyRegistryStore(make_shared<Utils::Win32RegistryStore>());
+	}
+};
+
+static void IsRenamePending(uint64_t iterations)
+{
+	for (uint64_t i = 0; i < iterations; ++i)
+	{
+		BOOL isPending = FALSE;
+		Benchmarks::DoNotOptimize(ComputerName::IsRenamePending(&isPending));
+	}
+}
+
+BENCHMARK(ComputerName_Get)
+{
+	Setup();
+	for (uint64_t i = 0; i < iterations; ++i)
+	{
+		long size = 0;
+		wchar_t* name = nullptr;
+		Benchmarks::DoNotOptimize(ComputerName::Get(size, name));
+		midl_user_free(name);
+	}
+}
+
+// Name validation plus the registry writes of a rename.
+BENCHMARK(ComputerName_Set)
+{
+	Setup();
+	for (uint64_t i = 0; i < iterations; ++i)
+	{
+		Benchmarks::DoNotOptimize(ComputerName::Set(L"MINWINPC"));
+	}
+}
+
+BENCHMARK(ComputerName_Set_InvalidName)
+{
+	Setup();
+	for (uint64_t i = 0; i < iterations; ++i)
+	{
+		Benchmarks::DoNotOptimize(ComputerName::Set(L"not a valid name"));
+	}
+}
+
+BENCHMARK(ComputerName_IsRenamePending)
+{
+	Setup();
+	for (uint64_t i = 0; i < iterations; ++i)
+	{
+		BOOL isPending = FALSE;
+		Benchmarks::DoNotOptimize(ComputerName::IsRenamePending(&isPending));
+	}
+}
+
+BENCHMARK(ComputerName_Get_Cached)
+{
+	Setup();
+	CachedNames cached;
+	for (uint64_t i = 0; i < iterations; ++i)
+	{
+		long size = 0;
+		wchar_t* name = nullptr;
+		Benchmarks::DoNotOptimize(ComputerName::Get(size, name));
+		midl_user_free(name);
+	}
+}
+
+BENCHMARK(ComputerName_IsRenamePending_Cached)
+{
+	Setup();
+	CachedNames cached;
+	IsRenamePending(iterations);
+}
+
+BENCHMARK(ComputerName_IsRenamePending_AllThreads)
+{
+	Setup();
+	Benchmarks::RunOnAllThreads(iterations, IsRenamePending);
+}
+
+BENCHMARK(ComputerName_IsRenamePending_AllThreads_Cached)
+{
+	Setup();
+	CachedNames cached;
+	Benchmarks::RunOnAllThreads(iterations, IsRenamePending);
+}
@@ -0,0 +1,205 @@
+/*
+Copyright 2018 Microsoft
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH
+THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "stdafx.h"
+#include <filesystem>
+#include "Benchmark.h"
+#include "ConfigCache.h"
+#include "ConfigUtils.h"
+#include "Constants.h"
+#include "DMBridgeConfig.h"
+#include "Fakes.h"
+#include "NTServiceConfig.h"
+#include "SampleData.h"
+#include "StringUtils.h"
+
+using namespace std;
+
+static const wstring& ConfigFile()
+{
+	static const wstring file = []()
+	{
+		filesystem::path path = filesystem::temp_directory_path() / "dmbridge.benchmark.config.json";
+		ofstream(path) << Samples::ConfigText();
+		return Utils::MultibyteToWide(path.string().c_str());
+	}();
+	return file;
+}
+
+// A multi-megabyte config, to show what loading costs grow with.
+static const wstring& LargeConfigFile()
+{
+	static const wstring file = []()
+	{
+		filesystem::path path = filesystem::temp_directory_path() / "dmbridge.benchmark.largeconfig.json";
+		ofstream(path) << Samples::LargeConfigText(50000);
+		return Utils::MultibyteToWide(path.string().c_str());
+	}();
+	return file;
+}
+
+BENCHMARK(Config_ParseJSONFile)
+{
+	const wstring& file = ConfigFile();
+	for (uint64_t i = 0; i < iterations; ++i)
+	{
+		Benchmarks::DoNotOptimize(ConfigUtils::ParseJSONFile(file));
+	}
+}
+
+BENCHMARK(Config_ParseJSONFile_Large)
+{
+	const wstring& file = LargeConfigFile();
+	for (uint64_t i = 0; i < iterations; ++i)
+	{
+		Benchmarks::DoNotOptimize(ConfigUtils::ParseJSONFile(file));
+	}
+}
+
+// Looks the file up in the registry before parsing it, as the service does.
+BENCHMARK(Config_LoadConfigFile)
+{
+	Fakes::FakeRegistry::SetValue(IoTDMRegistryRoot, RegConfigFile, ConfigFile());
+	for (uint64_t i = 0; i < iterations; ++i)
+	{
+		Benchmarks::DoNotOptimize(ConfigUtils::LoadConfigFile());
+	}
+}
+
+BENCHMARK(Config_NTServiceConfig)
+{
+	const ConfigUtils::CompiledConfig compiled = ConfigUtils::CompileConfig(Samples::ConfigText());
+	for (uint64_t i = 0; i < iterations; ++i)
+	{
+		NTServiceConfig config(compiled);
+		Benchmarks::DoNotOptimize(config);
+	}
+}
+
+BENCHMARK(Config_DMBridgeConfig)
+{
+	const ConfigUtils::CompiledConfig compiled = ConfigUtils::CompileConfig(Samples::ConfigText());
+	for (uint64_t i = 0; i < iterations; ++i)
+	{
+		DMBridgeConfig config(compiled);
+		Benchmarks::DoNotOptimize(config);
+	}
+}
+
+// What compiling a config cost when it went through a Json::Value: parse the
+// whole document, then look up and convert the two lists.
+static ConfigUtils::CompiledConfig CompileFromDom(const string& text)
+{
+	Json::CharReaderBuilder builder;
+	unique_ptr<Json::CharReader> reader(builder.newCharReader());
+	Json::Value root;
+	string errors;
+	reader->parse(text.data(), text.data() + text.size(), &root, &errors);
+
+	ConfigUtils::CompiledConfig config;
+	for (const Json::Value& api : root["api"])
+	{
+		config.apiList.push_back(Utils::MultibyteToWide(api.asString().c_str()));
+	}
+	for (const Json::Value& service : root["servicemanager"]["whitelist"])
+	{
+		config.whitelist.push_back(Utils::MultibyteToWide(service.asString().c_str()));
+	}
+	return config;
+}
+
+BENCHMARK(Config_Compile_Dom)
+{
+	const string text = Samples::ConfigText();
+	for (uint64_t i = 0; i < iterations; ++i)
+	{
+		Benchmarks::DoNotOptimize(CompileFromDom(text));
+	}
+}
+
+BENCHMARK(Config_Compile_Binder)
+{
+	const string text = Samples::ConfigText();
+	for (uint64_t i = 0; i < iterations; ++i)
+	{
+		Benchmarks::DoNotOptimize(ConfigUtils::CompileConfig(text));
+	}
+}
+
+BENCHMARK(Config_CompileLarge_Dom)
+{
+	static const string text = Samples::LargeConfigText(10000);
+	for (uint64_t i = 0; i < iterations; ++i)
+	{
+		Benchmarks::DoNotOptimize(CompileFromDom(text));
+	}
+}
+
+BENCHMARK(Config_CompileLarge_Binder)
+{
+	static const string text = Samples::LargeConfigText(10000);
+	for (uint64_t i = 0; i < iterations; ++i)
+	{
+		Benchmarks::DoNotOptimize(ConfigUtils::CompileConfig(text));
+	}
+}
+
+// The config work of a service start without a cache: read and compile the
+// file. Building DMBridgeConfig and NTServiceConfig from the result costs the
+// same either way.
+BENCHMARK(Config_Startup_Uncached)
+{
+	const wstring& file = ConfigFile();
+	for (uint64_t i = 0; i < iterations; ++i)
+	{
+		Benchmarks::DoNotOptimize(ConfigUtils::CompileConfigFile(file));
+	}
+}
+
+BENCHMARK(Config_Startup_Uncached_Large)
+{
+	const wstring& file = LargeConfigFile();
+	for (uint64_t i = 0; i < iterations; ++i)
+	{
+		Benchmarks::DoNotOptimize(ConfigUtils::CompileConfigFile(file));
+	}
+}
+
+// A start after the file was rewritten with the same content, e.g. by a
+// deployment: the cache is out of date, but the file's content hash is not.
+BENCHMARK(Config_Startup_Touched_Large)
+{
+	const wstring& file = LargeConfigFile();
+	filesystem::path path = Utils::WideToMultibyte(file.c_str());
+	ConfigCache::Load(file);
+	for (uint64_t i = 0; i < iterations; ++i)
+	{
+		Benchmarks::PauseTiming();
+		filesystem::last_write_time(path, filesystem::last_write_time(path) + chrono::seconds(1));
+		Benchmarks::ResumeTiming();
+		Benchmarks::DoNotOptimize(ConfigCache::Load(file));
+	}
+}
+
+// The same start with the compiled cache already written by an earlier start.
+BENCHMARK(Config_Startup_Cached)
+{
+	const wstring& file = ConfigFile();
+	ConfigCache::Load(file);
+	for (uint64_t i = 0; i < iterations; ++i)
+	{
+		Benchmarks::DoNotOptimize(ConfigCache::Load(file));
+	}
+}
@@ -0,0 +1,746 @@
+/*
+Copyright 2018 Microsoft
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH
+THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "stdafx.h"
+#include <filesystem>
+#include "Benchmark.h"
+#include "Cbor.h"
+#include "JsonPath.h"
+#include "JsonPushParser.h"
+#include "SampleData.h"
+
+using namespace std;
+
+static Json::Value Parse(const string& text, bool arena = false, bool iterative = false)
+{
+	Json::CharReaderBuilder builder;
+	builder["arena"] = arena;
+	builder["iterative"] = iterative;
+	unique_ptr<Json::CharReader> reader(builder.newCharReader());
+	Json::Value root;
+	string errors;
+	reader->parse(text.data(), text.data() + text.size(), &root, &errors);
+	return root;
+}
+
+BENCHMARK(Json_Parse_Config)
+{
+	const string text = Samples::ConfigText();
+	Benchmarks::ReportBytes(text.size());
+	for (uint64_t i = 0; i < iterations; ++i)
+	{
+		Benchmarks::DoNotOptimize(Parse(text));
+	}
+}
+
+BENCHMARK(Json_Parse_Config_Arena)
+{
+	const string text = Samples::ConfigText();
+	for (uint64_t i = 0; i < iterations; ++i)
+	{
+		Benchmarks::DoNotOptimize(Parse(text, true));
+	}
+}
+
+BENCHMARK(Json_Parse_LimpetOutput)
+{
+	const string text = Samples::LimpetEnrollmentInfo;
+	for (uint64_t i = 0; i < iterations; ++i)
+	{
+		Benchmarks::DoNotOptimize(Parse(text));
+	}
+}
+
+BENCHMARK(Json_Parse_LimpetOutput_Arena)
+{
+	const string text = Samples::LimpetEnrollmentInfo;
+	for (uint64_t i = 0; i < iterations; ++i)
+	{
+		Benchmarks::DoNotOptimize(Parse(text, true));
+	}
+}
+
+BENCHMARK(Json_Parse_LargeConfig)
+{
+	const string text = Samples::LargeConfigText(1000);
+	Benchmarks::ReportBytes(text.size());
+	for (uint64_t i = 0; i < iterations; ++i)
+	{
+		Benchmarks::DoNotOptimize(Parse(text));
+	}
+}
+
+BENCHMARK(Json_Parse_LargeConfig_Arena)
+{
+	const string text = Samples::LargeConfigText(1000);
+	for (uint64_t i = 0; i < iterations; ++i)
+	{
+		Benchmarks::DoNotOptimize(Parse(text, true));
+	}
+}
+
+BENCHMARK(Json_Parse_LargeConfig_Iterative)
+{
+	const string text = Samples::LargeConfigText(1000);
+	for (uint64_t i = 0; i < iterations; ++i)
+	{
+		Benchmarks::DoNotOptimize(Parse(text, false, true));
+	}
+}
+
+// Nested as deep as the default stackLimit allows.
+BENCHMARK(Json_Parse_Nested)
+{
+	const string text = Samples::NestedText(900, 20);
+	for (uint64_t i = 0; i < iterations; ++i)
+	{
+		Benchmarks::DoNotOptimize(Parse(text));
+	}
+}
+
+BENCHMARK(Json_Parse_Nested_Iterative)
+{
+	const string text = Samples::NestedText(900, 20);
+	for (uint64_t i = 0; i < iterations; ++i)
+	{
+		Benchmarks::DoNotOptimize(Parse(text, false, true));
+	}
+}
+
+BENCHMARK(Json_Parse_LargeArray)
+{
+	const string text = Samples::LargeArrayText(10000);
+	for (uint64_t i = 0; i < iterations; ++i)
+	{
+		Benchmarks::DoNotOptimize(Parse(text));
+	}
+}
+
+// Parses every iteration with the same reader, so that an interning one
+// reads each name once.
+static void ParseWithOneReader(uint64_t iterations, const string& text, bool internKeys)
+{
+	Json::CharReaderBuilder builder;
+	builder["internKeys"] = internKeys;
+	unique_ptr<Json::CharReader> reader(builder.newCharReader());
+	for (uint64_t i = 0; i < iterations; ++i)
+	{
+		Json::Value root;
+		string errors;
+		reader->parse(text.data(), text.data() + text.size(), &root, &errors);
+		Benchmarks::DoNotOptimize(root);
+	}
+}
+
+BENCHMARK(Json_Parse_LargeArray_InternKeys)
+{
+	ParseWithOneReader(iterations, Samples::LargeArrayText(10000), true);
+}
+
+BENCHMARK(Json_Parse_EnrollmentRecords)
+{
+	ParseWithOneReader(iterations, Samples::EnrollmentRecordsText(1000), false);
+}
+
+BENCHMARK(Json_Parse_EnrollmentRecords_InternKeys)
+{
+	ParseWithOneReader(iterations, Samples::EnrollmentRecordsText(1000), true);
+}
+
+// Compares two documents with the same content, as a handler does to tell
+// whether what it was sent has changed.
+static void Compare(uint64_t iterations, const string& text, bool internKeys)
+{
+	Json::CharReaderBuilder builder;
+	builder["internKeys"] = internKeys;
+	unique_ptr<Json::CharReader> reader(builder.newCharReader());
+	Json::Value first;
+	Json::Value second;
+	string errors;
+	reader->parse(text.data(), text.data() + text.size(), &first, &errors);
+	reader->parse(text.data(), text.data() + text.size(), &second, &errors);
+	for (uint64_t i = 0; i < iterations; ++i)
+	{
+		Benchmarks::DoNotOptimize(first == second);
+	}
+}
+
+BENCHMARK(Json_Compare_EnrollmentRecords)
+{
+	Compare(iterations, Samples::EnrollmentRecordsText(1000), false);
+}
+
+BENCHMARK(Json_Compare_EnrollmentRecords_InternKeys)
+{
+	Compare(iterations, Samples::EnrollmentRecordsText(1000), true);
+}
+
+BENCHMARK(Json_Parse_StringHeavy)
+{
+	const string text = Samples::StringHeavyText(1000);
+	for (uint64_t i = 0; i < iterations; ++i)
+	{
+		Benchmarks::DoNotOptimize(Parse(text));
+	}
+}
+
+BENCHMARK(Json_Parse_Numbers)
+{
+	const string text = Samples::NumbersText(10000);
+	Benchmarks::ReportBytes(text.size());
+	for (uint64_t i = 0; i < iterations; ++i)
+	{
+		Benchmarks::DoNotOptimize(Parse(text));
+	}
+}
+
+// The same documents as CBOR, against the text benchmarks above.
+static void ParseCbor(uint64_t iterations, const string& text)
+{
+	Benchmarks::PauseTiming();
+	const string bytes = Utils::CborEncode(Parse(text));
+	Benchmarks::ResumeTiming();
+	Benchmarks::ReportBytes(bytes.size());
+	for (uint64_t i = 0; i < iterations; ++i)
+	{
+		Benchmarks::DoNotOptimize(Utils::CborDecode(bytes.data(), bytes.data() + bytes.size()));
+	}
+}
+
+BENCHMARK(Json_Parse_Config_Cbor)
+{
+	ParseCbor(iterations, Samples::ConfigText());
+}
+
+BENCHMARK(Json_Parse_LargeConfig_Cbor)
+{
+	ParseCbor(iterations, Samples::LargeConfigText(1000));
+}
+
+BENCHMARK(Json_Parse_Numbers_Cbor)
+{
+	ParseCbor(iterations, Samples::NumbersText(10000));
+}
+
+// Reading every token without building a Json::Value, as a caller that
+// keeps only some values would.
+BENCHMARK(Json_Tokenize_LargeConfig)
+{
+	const string text = Samples::LargeConfigText(1000);
+	Benchmarks::ReportBytes(text.size());
+	for (uint64_t i = 0; i < iterations; ++i)
+	{
+		Utils::JsonTokenizer tokenizer(text.data(), text.data() + text.size());
+		size_t length = 0;
+		for (Utils::JsonToken token = tokenizer.Next(); token != Utils::JsonToken::End; token = tokenizer.Next())
+		{
+			length += tokenizer.Text().size();
+		}
+		Benchmarks::DoNotOptimize(length);
+	}
+}
+
+BENCHMARK(Json_Validate_LargeConfig)
+{
+	const string text = Samples::LargeConfigText(1000);
+	Benchmarks::ReportBytes(text.size());
+	for (uint64_t i = 0; i < iterations; ++i)
+	{
+		Benchmarks::DoNotOptimize(Utils::ValidateJson(text.data(), text.data() + text.size()));
+	}
+}
+
+BENCHMARK(Json_Validate_LargeConfig_Strict)
+{
+	const string text = Samples::LargeConfigText(1000);
+	Benchmarks::ReportBytes(text.size());
+	for (uint64_t i = 0; i < iterations; ++i)
+	{
+		Benchmarks::DoNotOptimize(Utils::ValidateJson(text.data(), text.data() + text.size(), Utils::JsonSyntax::Strict));
+	}
+}
+
+// A stray character every 4 KB, so most of the time goes to recovering.
+BENCHMARK(Json_Validate_LargeConfig_Damaged)
+{
+	string text = Samples::LargeConfigText(1000);
+	for (size_t at = 4096; at < text.size(); at += 4096)
+	{
+		text[at] = '#';
+	}
+	Benchmarks::ReportBytes(text.size());
+	for (uint64_t i = 0; i < iterations; ++i)
+	{
+		Benchmarks::DoNotOptimize(Utils::ValidateJson(text.data(), text.data() + text.size(), Utils::JsonSyntax::Lenient, SIZE_MAX));
+	}
+}
+
+BENCHMARK(Json_Tokenize_LargeConfig_Cbor)
+{
+	Benchmarks::PauseTiming();
+	const string bytes = Utils::CborEncode(Parse(Samples::LargeConfigText(1000)));
+	Benchmarks::ResumeTiming();
+	Benchmarks::ReportBytes(bytes.size());
+	for (uint64_t i = 0; i < iterations; ++i)
+	{
+		Utils::CborReader reader(bytes.data(), bytes.data() + bytes.size());
+		size_t length = 0;
+		for (Utils::CborItem item = reader.Next(); item != Utils::CborItem::End; item = reader.Next())
+		{
+			if (item == Utils::CborItem::Key || item == Utils::CborItem::String)
+			{
+				length += reader.Text().size;
+			}
+		}
+		Benchmarks::DoNotOptimize(length);
+	}
+}
+
+// A trace of about 2 MB on disk, for comparing the peak KB of reading a file
+// whole with that of parsing it as it is read.
+static const string& TraceFile()
+{
+	static const string file = []()
+	{
+		filesystem::path path = filesystem::temp_directory_path() / "dmbridge.benchmark.trace.json";
+		Json::StreamWriterBuilder builder;
+		ofstream(path, ios::binary) << Json::writeString(builder, Samples::TraceDocument(10000));
+		return path.string();
+	}();
+	return file;
+}
+
+static void ParseInPieces(const string& file, Utils::IJsonHandler& handler)
+{
+	ifstream stream(file, ios::binary);
+	Utils::JsonPushParser parser(handler);
+	char chunk[4096];
+	while (stream.read(chunk, sizeof(chunk)).gcount() > 0)
+	{
+		parser.Feed(chunk, static_cast<size_t>(stream.gcount()));
+	}
+	parser.Finish();
+}
+
+// parseFromStream gathers the whole file into a string before parsing it.
+BENCHMARK(Json_Parse_TraceFile_Stream)
+{
+	Benchmarks::PauseTiming();
+	const string& file = TraceFile();
+	Benchmarks::ResumeTiming();
+	Json::CharReaderBuilder builder;
+	for (uint64_t i = 0; i < iterations; ++i)
+	{
+		ifstream stream(file, ios::binary);
+		Json::Value root;
+		string errors;
+		Json::parseFromStream(builder, stream, &root, &errors);
+		Benchmarks::DoNotOptimize(root);
+	}
+}
+
+BENCHMARK(Json_Parse_TraceFile_Push)
+{
+	Benchmarks::PauseTiming();
+	const string& file = TraceFile();
+	Benchmarks::ResumeTiming();
+	for (uint64_t i = 0; i < iterations; ++i)
+	{
+		Utils::JsonValueBuilder builder;
+		ParseInPieces(file, builder);
+		Benchmarks::DoNotOptimize(builder.Root());
+	}
+}
+
+class TokenCounter : public Utils::IJsonHandler
+{
+public:
+	void OnToken(Utils::JsonToken, const string&) override
+	{
+		++count;
+	}
+
+	uint64_t count = 0;
+};
+
+// Without a Json::Value, as a caller picking a few values out would.
+BENCHMARK(Json_Parse_TraceFile_PushTokens)
+{
+	Benchmarks::PauseTiming();
+	const string& file = TraceFile();
+	Benchmarks::ResumeTiming();
+	for (uint64_t i = 0; i < iterations; ++i)
+	{
+		TokenCounter counter;
+		ParseInPieces(file, counter);
+		Benchmarks::DoNotOptimize(counter.count);
+	}
+}
+
+// Only the destruction of the parsed document is measured.
+static void Teardown(uint64_t iterations, bool arena)
+{
+	Benchmarks::PauseTiming();
+	const string text = Samples::LargeConfigText(1000);
+	Benchmarks::ResumeTiming();
+
+	for (uint64_t i = 0; i < iterations; ++i)
+	{
+		Benchmarks::PauseTiming();
+		Json::Value* root = new Json::Value(Parse(text, arena));
+		Benchmarks::ResumeTiming();
+		delete root;
+	}
+}
+
+BENCHMARK(Json_Teardown_LargeConfig)
+{
+	Teardown(iterations, false);
+}
+
+BENCHMARK(Json_Teardown_LargeConfig_Arena)
+{
+	Teardown(iterations, true);
+}
+
+// An object of 'count' members, parsed as the service would, and their names.
+static Json::Value WideObject(size_t count, vector<string>& names)
+{
+	Json::Value object(Json::objectValue);
+	for (size_t i = 0; i < count; ++i)
+	{
+		names.push_back("member" + to_string(i));
+		object[names.back()] = static_cast<Json::UInt64>(i);
+	}
+	return Parse(Json::writeString(Json::StreamWriterBuilder(), object));
+}
+
+// Looks up every member in turn, by name.
+static void Lookup(uint64_t iterations, size_t count)
+{
+	vector<string> names;
+	const Json::Value object = WideObject(count, names);
+	for (uint64_t i = 0; i < iterations; ++i)
+	{
+		Benchmarks::DoNotOptimize(object[names[i % count].c_str()]);
+	}
+}
+
+BENCHMARK(Json_Lookup_Members8)
+{
+	Lookup(iterations, 8);
+}
+
+BENCHMARK(Json_Lookup_Members64)
+{
+	Lookup(iterations, 64);
+}
+
+BENCHMARK(Json_Lookup_Members1000)
+{
+	Lookup(iterations, 1000);
+}
+
+BENCHMARK(Json_Lookup_Members1000_StaticKey)
+{
+	vector<string> names;
+	const Json::Value object = WideObject(1000, names);
+	vector<Json::StaticKey> keys;
+	for (const string& name : names)
+	{
+		keys.emplace_back(name.c_str());
+	}
+	for (uint64_t i = 0; i < iterations; ++i)
+	{
+		Benchmarks::DoNotOptimize(object[keys[i % keys.size()]]);
+	}
+}
+
+// Through the non-const operator[], which would add a missing member.
+BENCHMARK(Json_Lookup_Members1000_NonConst)
+{
+	vector<string> names;
+	Json::Value object = WideObject(1000, names);
+	for (uint64_t i = 0; i < iterations; ++i)
+	{
+		Benchmarks::DoNotOptimize(object[names[i % names.size()]]);
+	}
+}
+
+// The endorsement key and registration id, read from the output of limpet by
+// hand as Tpm.cpp used to, and through compiled paths.
+BENCHMARK(Json_Path_Manual_Limpet)
+{
+	const Json::Value root = Parse(Samples::LimpetEnrollmentInfo);
+	for (uint64_t i = 0; i < iterations; ++i)
+	{
+		if (root.isArray() && !root.empty())
+		{
+			const Json::Value& info = *root.begin();
+			if (info.isObject())
+			{
+				const Json::Value& attestation = info["attestation"];
+				if (attestation.isObject())
+				{
+					const Json::Value& tpm = attestation["tpm"];
+					if (tpm.isObject())
+					{
+						Benchmarks::DoNotOptimize(tpm["endorsementKey"]);
+					}
+				}
+				Benchmarks::DoNotOptimize(info["registrationId"]);
+			}
+		}
+	}
+}
+
+BENCHMARK(Json_Path_Find_Limpet)
+{
+	const Json::Value root = Parse(Samples::LimpetEnrollmentInfo);
+	const Utils::JsonPath ek("/0/attestation/tpm/endorsementKey");
+	const Utils::JsonPath regId("/0/registrationId");
+	for (uint64_t i = 0; i < iterations; ++i)
+	{
+		Benchmarks::DoNotOptimize(ek.Find(root));
+		Benchmarks::DoNotOptimize(regId.Find(root));
+	}
+}
+
+// From the text, against Json_Parse_LimpetOutput.
+BENCHMARK(Json_Path_Extract_Limpet)
+{
+	const string text = Samples::LimpetEnrollmentInfo;
+	const vector<Utils::JsonPath> paths = {
+		Utils::JsonPath("/0/attestation/tpm/endorsementKey"),
+		Utils::JsonPath("/0/registrationId"),
+	};
+	for (uint64_t i = 0; i < iterations; ++i)
+	{
+		Utils::JsonPathExtractor extractor(paths);
+		extractor.Extract(text.data(), text.data() + text.size());
+		Benchmarks::DoNotOptimize(extractor.Find(0));
+	}
+}
+
+// The whitelist alone, against Json_Parse_LargeConfig.
+BENCHMARK(Json_Path_Extract_LargeConfig)
+{
+	const string text = Samples::LargeConfigText(1000);
+	const vector<Utils::JsonPath> paths = { Utils::JsonPath("/servicemanager/whitelist") };
+	for (uint64_t i = 0; i < iterations; ++i)
+	{
+		Utils::JsonPathExtractor extractor(paths);
+		extractor.Extract(text.data(), text.data() + text.size());
+		Benchmarks::DoNotOptimize(extractor.Find(0));
+	}
+}
+
+BENCHMARK(Json_Path_Extract_LargeConfig_Wildcard)
+{
+	const string text = Samples::LargeConfigText(1000);
+	const vector<Utils::JsonPath> paths = { Utils::JsonPath("/extensions/*/name") };
+	for (uint64_t i = 0; i < iterations; ++i)
+	{
+		Utils::JsonPathExtractor extractor(paths);
+		extractor.Extract(text.data(), text.data() + text.size());
+		Benchmarks::DoNotOptimize(extractor.Matches(0).size());
+	}
+}
+
+BENCHMARK(Json_Path_FindAll_LargeConfig_Wildcard)
+{
+	const Json::Value root = Parse(Samples::LargeConfigText(1000));
+	const Utils::JsonPath path("/extensions/*/name");
+	vector<const Json::Value*> names;
+	for (uint64_t i = 0; i < iterations; ++i)
+	{
+		names.clear();
+		path.FindAll(root, names);
+		Benchmarks::DoNotOptimize(names.size());
+	}
+}
+
+BENCHMARK(Json_Copy_Config)
+{
+	const Json::Value root = Parse(Samples::ConfigText());
+	for (uint64_t i = 0; i < iterations; ++i)
+	{
+		Json::Value copy(root);
+		Benchmarks::DoNotOptimize(copy);
+	}
+}
+
+BENCHMARK(Json_Copy_LargeConfig)
+{
+	const Json::Value root = Parse(Samples::LargeConfigText(1000));
+	for (uint64_t i = 0; i < iterations; ++i)
+	{
+		Json::Value copy(root);
+		Benchmarks::DoNotOptimize(copy);
+	}
+}
+
+BENCHMARK(Json_Share_LargeConfig)
+{
+	const Json::SharedValue root(Parse(Samples::LargeConfigText(1000)));
+	for (uint64_t i = 0; i < iterations; ++i)
+	{
+		Json::SharedValue copy(root);
+		Benchmarks::DoNotOptimize(copy);
+	}
+}
+
+// Hands out one section of the document, as a handler gets its own.
+BENCHMARK(Json_Share_LargeConfig_Section)
+{
+	const Json::SharedValue root(Parse(Samples::LargeConfigText(1000)));
+	for (uint64_t i = 0; i < iterations; ++i)
+	{
+		Json::SharedValue section = root.get("servicemanager");
+		Benchmarks::DoNotOptimize(section);
+	}
+}
+
+BENCHMARK(Json_Share_LargeConfig_AllThreads)
+{
+	const Json::SharedValue root(Parse(Samples::LargeConfigText(1000)));
+	Benchmarks::RunOnAllThreads(iterations, [&root](uint64_t count)
+	{
+		for (uint64_t i = 0; i < count; ++i)
+		{
+			Json::SharedValue copy(root);
+			Benchmarks::DoNotOptimize(copy);
+		}
+	});
+}
+
+static void ReportWritten(const Json::StreamWriterBuilder& builder, const Json::Value& root)
+{
+	Benchmarks::PauseTiming();
+	Benchmarks::ReportBytes(Json::writeString(builder, root).size());
+	Benchmarks::ResumeTiming();
+}
+
+BENCHMARK(Json_Write_Config)
+{
+	const Json::Value root = Samples::Config();
+	Json::StreamWriterBuilder builder;
+	ReportWritten(builder, root);
+	for (uint64_t i = 0; i < iterations; ++i)
+	{
+		Benchmarks::DoNotOptimize(Json::writeString(builder, root));
+	}
+}
+
+BENCHMARK(Json_Write_Numbers)
+{
+	Benchmarks::PauseTiming();
+	const Json::Value root = Samples::Numbers(10000);
+	Benchmarks::ResumeTiming();
+	Json::StreamWriterBuilder builder;
+	ReportWritten(builder, root);
+	for (uint64_t i = 0; i < iterations; ++i)
+	{
+		Benchmarks::DoNotOptimize(Json::writeString(builder, root));
+	}
+}
+
+BENCHMARK(Json_Write_Numbers_Compact)
+{
+	Benchmarks::PauseTiming();
+	const Json::Value root = Samples::Numbers(10000);
+	Benchmarks::ResumeTiming();
+	Json::StreamWriterBuilder builder;
+	builder["indentation"] = "";
+	ReportWritten(builder, root);
+	for (uint64_t i = 0; i < iterations; ++i)
+	{
+		Benchmarks::DoNotOptimize(Json::writeString(builder, root));
+	}
+}
+
+BENCHMARK(Json_Write_Trace)
+{
+	Benchmarks::PauseTiming();
+	const Json::Value root = Samples::TraceDocument(10000);
+	Benchmarks::ResumeTiming();
+	Json::StreamWriterBuilder builder;
+	ReportWritten(builder, root);
+	for (uint64_t i = 0; i < iterations; ++i)
+	{
+		Benchmarks::DoNotOptimize(Json::writeString(builder, root));
+	}
+}
+
+BENCHMARK(Json_Write_Trace_Compact)
+{
+	Benchmarks::PauseTiming();
+	const Json::Value root = Samples::TraceDocument(10000);
+	Benchmarks::ResumeTiming();
+	Json::StreamWriterBuilder builder;
+	builder["indentation"] = "";
+	ReportWritten(builder, root);
+	for (uint64_t i = 0; i < iterations; ++i)
+	{
+		Benchmarks::DoNotOptimize(Json::writeString(builder, root));
+	}
+}
+
+BENCHMARK(Json_Write_Trace_Stream)
+{
+	Benchmarks::PauseTiming();
+	const Json::Value root = Samples::TraceDocument(10000);
+	Benchmarks::ResumeTiming();
+	Json::StreamWriterBuilder builder;
+	unique_ptr<Json::StreamWriter> writer(builder.newStreamWriter());
+	for (uint64_t i = 0; i < iterations; ++i)
+	{
+		ostringstream stream;
+		writer->write(root, &stream);
+		Benchmarks::DoNotOptimize(stream);
+	}
+}
+
+static void WriteCbor(uint64_t iterations, const Json::Value& root)
+{
+	Benchmarks::PauseTiming();
+	Benchmarks::ReportBytes(Utils::CborEncode(root).size());
+	Benchmarks::ResumeTiming();
+	for (uint64_t i = 0; i < iterations; ++i)
+	{
+		Benchmarks::DoNotOptimize(Utils::CborEncode(root));
+	}
+}
+
+BENCHMARK(Json_Write_Config_Cbor)
+{
+	WriteCbor(iterations, Samples::Config());
+}
+
+BENCHMARK(Json_Write_Numbers_Cbor)
+{
+	Benchmarks::PauseTiming();
+	const Json::Value root = Samples::Numbers(10000);
+	Benchmarks::ResumeTiming();
+	WriteCbor(iterations, root);
+}
+
+BENCHMARK(Json_Write_Trace_Cbor)
+{
+	Benchmarks::PauseTiming();
+	const Json::Value root = Samples::TraceDocument(10000);
+	Benchmarks::ResumeTiming();
+	WriteCbor(iterations, root);
+}
@@ -0,0 +1,45 @@
+/*
+Copyright 2018 Microsoft
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH
+THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "stdafx.h"
+#include "Benchmark.h"
+#include "Logger.h"
+
+// Every bridge call logs several lines; these run with the console stream
+// silenced, so they measure formatting rather than terminal output.
+BENCHMARK(Logger_Trace)
+{
+	for (uint64_t i = 0; i < iterations; ++i)
+	{
+		TRACE(L"Start request for service");
+	}
+}
+
+BENCHMARK(Logger_Trace_Multibyte)
+{
+	for (uint64_t i = 0; i < iterations; ++i)
+	{
+		TRACE("Start request for service");
+	}
+}
+
+BENCHMARK(Logger_TraceParam)
+{
+	const std::wstring serviceName = L"w32time";
+	for (uint64_t i = 0; i < iterations; ++i)
+	{
+		TRACEP(L"Start request for: ", serviceName);
+	}
+}
@@ -0,0 +1,75 @@
+/*
+Copyright 2018 Microsoft
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH
+THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "stdafx.h"
+#include "Benchmark.h"
+#include "ConfigUtils.h"
+#include "Fakes.h"
+#include "NTService.h"
+#include "SampleData.h"
+
+using namespace std;
+
+static void Setup()
+{
+	static once_flag once;
+	call_once(once, []()
+	{
+		unique_ptr<NTServiceConfig> config(new NTServiceConfig(ConfigUtils::CompileConfig(Samples::ConfigText())));
+		NTService::ApplyConfig(config);
+		Fakes::FakeServiceControlManager::AddService(L"w32time", SERVICE_RUNNING, SERVICE_AUTO_START);
+	});
+}
+
+// Name validation plus a service status query.
+BENCHMARK(NTService_Query)
+{
+	Setup();
+	for (uint64_t i = 0; i < iterations; ++i)
+	{
+		INT32 status = 0;
+		Benchmarks::DoNotOptimize(NTService::Query(L"w32time", &status));
+	}
+}
+
+BENCHMARK(NTService_Query_InvalidName)
+{
+	Setup();
+	for (uint64_t i = 0; i < iterations; ++i)
+	{
+		INT32 status = 0;
+		Benchmarks::DoNotOptimize(NTService::Query(L"w32time/../", &status));
+	}
+}
+
+// Validation, a whitelist hit and the status check that finds it running.
+BENCHMARK(NTService_Start_Whitelisted)
+{
+	Setup();
+	for (uint64_t i = 0; i < iterations; ++i)
+	{
+		Benchmarks::DoNotOptimize(NTService::Start(L"W32Time"));
+	}
+}
+
+// Rejected by the whitelist before the service control manager is involved.
+BENCHMARK(NTService_Start_NotWhitelisted)
+{
+	Setup();
+	for (uint64_t i = 0; i < iterations; ++i)
+	{
+		Benchmarks::DoNotOptimize(NTService::Start(L"dhcp"));
+	}
+}
@@ -0,0 +1,75 @@
+/*
+Copyright 2018 Microsoft
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH
+THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "stdafx.h"
+#include "Benchmark.h"
+#include "Fakes.h"
+#include "RegistryUtils.h"
+
+using namespace std;
+
+// The three values a rename writes.
+static const vector<Utils::RegistryValueWrite>& RenameValues()
+{
+	static const vector<Utils::RegistryValueWrite> values = {
+		{ L"system\\currentcontrolset\\control\\computername\\computername", L"ComputerName", L"MINWINPC" },
+		{ L"system\\currentcontrolset\\control\\computername\\activecomputername", L"ComputerName", L"MINWINPC" },
+		{ L"system\\currentcontrolset\\services\\tcpip\\parameters", L"NV HostName", L"MINWINPC" }
+	};
+	return values;
+}
+
+// One RegSetKeyValue per value, each opening and closing its key.
+BENCHMARK(Registry_RegSetKeyValue_RenameValues)
+{
+	for (uint64_t i = 0; i < iterations; ++i)
+	{
+		for (const Utils::RegistryValueWrite& value : RenameValues())
+		{
+			Benchmarks::DoNotOptimize(RegSetKeyValue(HKEY_LOCAL_MACHINE, value.subKey.c_str(), value.propName.c_str(), REG_SZ,
+				value.propValue.c_str(), static_cast<DWORD>((value.propValue.size() + 1) * sizeof(wchar_t))));
+		}
+	}
+}
+
+BENCHMARK(Registry_WriteRegistryValue_RenameValues)
+{
+	for (uint64_t i = 0; i < iterations; ++i)
+	{
+		for (const Utils::RegistryValueWrite& value : RenameValues())
+		{
+			Utils::WriteRegistryValue(value.subKey, value.propName, value.propValue);
+		}
+	}
+}
+
+// All-or-nothing; saves each value before writing it.
+BENCHMARK(Registry_WriteRegistryValues_RenameValues)
+{
+	for (uint64_t i = 0; i < iterations; ++i)
+	{
+		Utils::WriteRegistryValues(RenameValues());
+	}
+}
+
+BENCHMARK(Registry_TryReadRegistryValue_Dword)
+{
+	Fakes::FakeRegistry::SetValue(L"Software\\Microsoft\\IoTDMBridge", L"Level", 1ul);
+	for (uint64_t i = 0; i < iterations; ++i)
+	{
+		unsigned long value = 0;
+		Benchmarks::DoNotOptimize(Utils::TryReadRegistryValue(L"Software\\Microsoft\\IoTDMBridge", L"Level", value));
+	}
+}
@@ -0,0 +1,85 @@
+/*
+Copyright 2018 Microsoft
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH
+THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "stdafx.h"
+#include <chrono>
+#include <thread>
+#include "Benchmark.h"
+#include "RpcMetrics.h"
+
+using namespace std;
+
+BENCHMARK(SteadyClock_Now)
+{
+	for (uint64_t i = 0; i < iterations; ++i)
+	{
+		Benchmarks::DoNotOptimize(chrono::steady_clock::now());
+	}
+}
+
+BENCHMARK(RpcMetrics_Record)
+{
+	static Utils::RpcMethodMetrics method("RpcMetrics_Record");
+	for (uint64_t i = 0; i < iterations; ++i)
+	{
+		method.Record(i & 0xFFFFF, true);
+	}
+}
+
+BENCHMARK(RpcMetrics_Scope)
+{
+	for (uint64_t i = 0; i < iterations; ++i)
+	{
+		RPC_METRICS_SCOPE(metrics);
+		metrics.Complete(0);
+	}
+}
+
+// Four writers hammering the same method, as concurrent calls to one RPC would.
+BENCHMARK(RpcMetrics_Record_4Threads)
+{
+	constexpr int ThreadCount = 4;
+	static Utils::RpcMethodMetrics method("RpcMetrics_Record_4Threads");
+
+	vector<thread> writers;
+	for (int t = 0; t < ThreadCount; ++t)
+	{
+		writers.emplace_back([iterations]()
+		{
+			for (uint64_t i = 0; i < iterations / ThreadCount + 1; ++i)
+			{
+				method.Record(i & 0xFFFFF, (i & 7) != 0);
+			}
+		});
+	}
+	for (thread& writer : writers)
+	{
+		writer.join();
+	}
+}
+
+BENCHMARK(RpcMetrics_Snapshot)
+{
+	static Utils::RpcMethodMetrics method("RpcMetrics_Snapshot");
+	for (uint64_t i = 0; i < 1000; ++i)
+	{
+		method.Record(i * 1000, true);
+	}
+
+	for (uint64_t i = 0; i < iterations; ++i)
+	{
+		Benchmarks::DoNotOptimize(method.Snapshot().PercentileNanoseconds(99.0));
+	}
+}
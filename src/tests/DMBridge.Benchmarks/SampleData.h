@@ -0,0 +1,217 @@
+/*
+Copyright 2018 Microsoft
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH
+THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <cstdio>
+#include <string>
+#include "json/json.h"
+
+// Inputs shared by the benchmarks, sized like a provisioned device's.
+namespace Samples
+{
+	constexpr size_t WhitelistSize = 100;
+
+	// A full dmbridge.config.json with WhitelistSize whitelisted services,
+	// w32time among them.
+	inline Json::Value Config()
+	{
+		Json::Value root(Json::objectValue);
+		Json::Value& api = root["api"] = Json::Value(Json::arrayValue);
+		for (const char* name : { "computername", "servicemanager", "telemetry", "tpm", "shutdownmgmt", "uwpappmgmt", "metrics" })
+		{
+			api.append(name);
+		}
+
+		Json::Value& whitelist = root["servicemanager"]["whitelist"] = Json::Value(Json::arrayValue);
+		for (size_t i = 1; i < WhitelistSize; ++i)
+		{
+			whitelist.append("service" + std::to_string(i));
+		}
+		whitelist.append("w32time");
+		return root;
+	}
+
+	inline std::string ConfigText()
+	{
+		return Json::writeString(Json::StreamWriterBuilder(), Config());
+	}
+
+	// A config far larger than any device's: 'services' whitelisted services
+	// and a section of the same size that the bridge does not read.
+	inline std::string LargeConfigText(size_t services)
+	{
+		Json::Value root = Config();
+		Json::Value& whitelist = root["servicemanager"]["whitelist"];
+		Json::Value& unread = root["extensions"] = Json::Value(Json::arrayValue);
+		for (size_t i = WhitelistSize; i < services; ++i)
+		{
+			whitelist.append("service" + std::to_string(i));
+		}
+		for (size_t i = 0; i < services; ++i)
+		{
+			Json::Value& extension = unread.append(Json::Value(Json::objectValue));
+			extension["name"] = "extension" + std::to_string(i);
+			extension["enabled"] = i % 2 == 0;
+			extension["priority"] = static_cast<Json::UInt64>(i);
+		}
+		return Json::writeString(Json::StreamWriterBuilder(), root);
+	}
+
+	// What 'limpet.exe -azuredps -enrollmentinfo -json' prints.
+	constexpr char LimpetEnrollmentInfo[] =
+		"[{\"registrationId\":\"c4c2bb87a3b5d07ac2c0e3e8b16b5a58d1ae66d8f1c1d8bc5d8b37a8c7e1e0ab\","
+		"\"attestation\":{\"type\":\"tpm\",\"tpm\":{\"endorsementKey\":"
+		"\"AToAAQALAAMAsgAgg3GXZ0SEs/gakMyNRqXXJP1S124GUgtk8qHaGzMUaaoABgCAAEMAEAgAAAAAAAEAxsj2gUS"
+		"cTk1UjuioeTlfGYZrrimExB+bScH75adUMRIi2UOMxG1kw4y+9RW/IVoMl4e620VxZad0ARX2gUqVjYO7KPVt3dy"
+		"KhZS3dkcvfBisBhP1XH9B33VqHG9SHnbnQXdBUaCgKAfxome8UmBKfe+naTsE5fkvjb/do3/dD6l4sGBwFCnKRdln"
+		"4XpM03zLpoHFao8zOwt8l/uP3qUIxmCYv9A7m69Ms+5/pCkTu/rK4mRDsfhZ0QLfbzVI6zQFOKF/rwsfBtFeWlWtc"
+		"uJMKlXdD8TXWElTzgh7JS4qhFzreL0c1mI0GCj+Aws0usZh7dLIVPnlgZcBhgy1SSDQMQ==\"}}}]";
+
+	// An array of 'count' enrollment records as the provisioning service
+	// lists them: every record has the same member names, some of them too
+	// long to be stored inline.
+	inline std::string EnrollmentRecordsText(size_t count)
+	{
+		Json::Value root(Json::arrayValue);
+		for (size_t i = 0; i < count; ++i)
+		{
+			Json::Value& record = root.append(Json::Value(Json::objectValue));
+			record["registrationId"] = "device" + std::to_string(i);
+			record["deviceId"] = "device" + std::to_string(i);
+			record["etag"] = "\"0b00" + std::to_string(i) + "\"";
+			record["provisioningStatus"] = i % 8 == 0 ? "disabled" : "enabled";
+			record["createdDateTimeUtc"] = "2018-10-19T08:00:00.0000000Z";
+			record["lastUpdatedDateTimeUtc"] = "2018-11-01T08:00:00.0000000Z";
+			record["capabilities"]["iotEdge"] = false;
+			Json::Value& attestation = record["attestation"];
+			attestation["type"] = "tpm";
+			attestation["tpm"]["endorsementKey"] = "AToAAQALAAMAsgAgg3GXZ0SEs" + std::to_string(i);
+		}
+		return Json::writeString(Json::StreamWriterBuilder(), root);
+	}
+
+	// An array of 'count' small objects, indented with spaces as hand-edited
+	// files are.
+	inline std::string LargeArrayText(size_t count)
+	{
+		Json::Value root(Json::arrayValue);
+		for (size_t i = 0; i < count; ++i)
+		{
+			Json::Value& item = root.append(Json::Value(Json::objectValue));
+			item["id"] = static_cast<Json::UInt64>(i);
+			item["name"] = "item" + std::to_string(i);
+			item["enabled"] = i % 2 == 0;
+		}
+		Json::StreamWriterBuilder builder;
+		builder["indentation"] = "    ";
+		return Json::writeString(builder, root);
+	}
+
+	// An array of 'count' strings as long as the endorsement key in
+	// LimpetEnrollmentInfo, every fourth with escaped characters.
+	inline std::string StringHeavyText(size_t count)
+	{
+		const std::string key = std::string(LimpetEnrollmentInfo).substr(150, 300);
+		Json::Value root(Json::arrayValue);
+		for (size_t i = 0; i < count; ++i)
+		{
+			root.append(i % 4 == 0 ? key + "\n\t\"quoted\"" : key);
+		}
+		return Json::writeString(Json::StreamWriterBuilder(), root);
+	}
+
+	// An array of 'count' metric samples: an integer counter, a reading with
+	// two decimals and a ratio with all seventeen digits, so that both the
+	// short and the long number paths are exercised.
+	inline Json::Value Numbers(size_t count)
+	{
+		Json::Value root(Json::arrayValue);
+		for (size_t i = 0; i < count; ++i)
+		{
+			Json::Value& item = root.append(Json::Value(Json::objectValue));
+			item["sample"] = static_cast<Json::UInt64>(1539936000000 + i * 250);
+			item["reading"] = static_cast<double>(i % 5000) / 100.0 - 12.5;
+			item["ratio"] = 1.0 / static_cast<double>(i + 3);
+		}
+		return root;
+	}
+
+	// A Chrome trace of 'count' spans, as Tracer::ExportChromeTrace() builds
+	// it, every eighth span with a detail argument.
+	inline Json::Value TraceDocument(size_t count)
+	{
+		static const char* const names[] = {
+			"DMBridge::GetComputerName", "DMBridge::SetComputerName", "DMBridge::GetTelemetryLevel",
+			"ConfigUtils::ReadConfig", "TpmSupport::GetEndorsementKey"
+		};
+		Json::Value traceEvents(Json::arrayValue);
+		for (size_t i = 0; i < count; ++i)
+		{
+			Json::Value& event = traceEvents.append(Json::Value(Json::objectValue));
+			event["name"] = names[i % 5];
+			event["cat"] = i % 5 < 3 ? "rpc" : "io";
+			event["ph"] = "X";
+			event["ts"] = static_cast<double>(1539936000000 + i * 1375) / 1000.0;
+			event["dur"] = static_cast<double>(i % 977 + 12) / 1000.0;
+			event["pid"] = 1;
+			event["tid"] = static_cast<Json::UInt>(4000 + i % 8);
+			if (i % 8 == 0)
+			{
+				event["args"]["detail"] = "C:\\Windows\\System32\\limpet.exe \"-erk\" 0";
+			}
+		}
+		Json::Value root(Json::objectValue);
+		root["traceEvents"] = traceEvents;
+		root["displayTimeUnit"] = "ns";
+		root["otherData"]["droppedEvents"] = Json::UInt64(0);
+		return root;
+	}
+
+	// Numbers(count) as text, formatted with printf so that the text does not
+	// depend on how the writer formats doubles.
+	inline std::string NumbersText(size_t count)
+	{
+		std::string text = "[";
+		char item[128];
+		for (size_t i = 0; i < count; ++i)
+		{
+			snprintf(item, sizeof(item), "%s{\"sample\":%llu,\"reading\":%.2f,\"ratio\":%.17g}",
+				i == 0 ? "" : ",",
+				static_cast<unsigned long long>(1539936000000 + i * 250),
+				static_cast<double>(i % 5000) / 100.0 - 12.5,
+				1.0 / static_cast<double>(i + 3));
+			text += item;
+		}
+		return text + "]";
+	}
+
+	// An array of 'count' branches, each an object holding an array holding
+	// an object and so on, 'depth' levels deep.
+	inline std::string NestedText(size_t depth, size_t count)
+	{
+		std::string branch = "1";
+		for (size_t level = 0; level < depth; ++level)
+		{
+			branch = level % 2 == 0 ? "[0," + branch + "]" : "{\"n\":" + branch + "}";
+		}
+		std::string text = "[";
+		for (size_t i = 0; i < count; ++i)
+		{
+			text += (i == 0 ? "" : ",") + branch;
+		}
+		return text + "]";
+	}
+}
@@ -0,0 +1,56 @@
+/*
+Copyright 2018 Microsoft
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH
+THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "stdafx.h"
+#include "Benchmark.h"
+#include "StringUtils.h"
+
+using namespace std;
+
+BENCHMARK(StringUtils_WideToMultibyte)
+{
+	const wstring value = L"system\\currentcontrolset\\control\\computername\\computername";
+	for (uint64_t i = 0; i < iterations; ++i)
+	{
+		Benchmarks::DoNotOptimize(Utils::WideToMultibyte(value.c_str()));
+	}
+}
+
+BENCHMARK(StringUtils_MultibyteToWide)
+{
+	const string value = "system\\currentcontrolset\\control\\computername\\computername";
+	for (uint64_t i = 0; i < iterations; ++i)
+	{
+		Benchmarks::DoNotOptimize(Utils::MultibyteToWide(value.c_str()));
+	}
+}
+
+BENCHMARK(StringUtils_MultibyteToWide_NonAscii)
+{
+	const string value = u8"Geräte-Verwaltung デバイス管理";
+	for (uint64_t i = 0; i < iterations; ++i)
+	{
+		Benchmarks::DoNotOptimize(Utils::MultibyteToWide(value.c_str()));
+	}
+}
+
+BENCHMARK(StringUtils_Contains)
+{
+	const wstring container = L"Microsoft Windows IoT Core Device Management Bridge";
+	for (uint64_t i = 0; i < iterations; ++i)
+	{
+		Benchmarks::DoNotOptimize(Utils::Contains(container, L"bridge"));
+	}
+}
@@ -0,0 +1,92 @@
+/*
+Copyright 2018 Microsoft
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH
+THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "stdafx.h"
+#include "Benchmark.h"
+#include "Fakes.h"
+#include "RegistryStore.h"
+#include "TelemetryLevel.h"
+
+using namespace std;
+
+static void Setup()
+{
+	static once_flag once;
+	call_once(once, []()
+	{
+		Fakes::FakeRegistry::SetValue(L"Software\\Microsoft\\Windows\\CurrentVersion\\Policies\\DataCollection", L"AllowTelemetry", 1ul);
+	});
+}
+
+// Serves the level from the watched cache for as long as it is in scope, then
+// restores the uncached reads the other benchmarks measure.
+class CachedLevel
+{
+public:
+	CachedLevel()
+	{
+		TelemetryLevel::ApplyRegistryStore(make_shared<Utils::Win32RegistryStore>());
+		TelemetryLevel::StartWatching();
+	}
+
+	~CachedLevel()
+	{
+		TelemetryLevel::ApplyRegistryStore(make_shared<Utils::Win32RegistryStore>());
+	}
+};
+
+static void Get(uint64_t iterations)
+{
+	for (uint64_t i = 0; i < iterations; ++i)
+	{
+		INT32 level = 0;
+		Benchmarks::DoNotOptimize(TelemetryLevel::Get(&level));
+	}
+}
+
+BENCHMARK(TelemetryLevel_Get)
+{
+	Setup();
+	Get(iterations);
+}
+
+BENCHMARK(TelemetryLevel_Get_Cached)
+{
+	Setup();
+	CachedLevel cached;
+	Get(iterations);
+}
+
+BENCHMARK(TelemetryLevel_Get_AllThreads)
+{
+	Setup();
+	Benchmarks::RunOnAllThreads(iterations, Get);
+}
+
+BENCHMARK(TelemetryLevel_Get_AllThreads_Cached)
+{
+	Setup();
+	CachedLevel cached;
+	Benchmarks::RunOnAllThreads(iterations, Get);
+}
+
+BENCHMARK(TelemetryLevel_Set)
+{
+	Setup();
+	for (uint64_t i = 0; i < iterations; ++i)
+	{
+		Benchmarks::DoNotOptimize(TelemetryLevel::Set(1));
+	}
+}
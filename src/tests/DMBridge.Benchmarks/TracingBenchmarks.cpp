@@ -0,0 +1,75 @@
+/*
+Copyright 2018 Microsoft
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH
+THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "stdafx.h"
+#include "Benchmark.h"
+#include "Tracing.h"
+
+// The cost every instrumented function pays while tracing is off.
+BENCHMARK(Tracing_Span_Disabled)
+{
+	Utils::Tracer::Instance().Stop();
+	for (uint64_t i = 0; i < iterations; ++i)
+	{
+		TRACE_SPAN(span, "benchmark");
+		Benchmarks::DoNotOptimize(span);
+	}
+}
+
+BENCHMARK(Tracing_Span_Enabled)
+{
+	Utils::Tracer& tracer = Utils::Tracer::Instance();
+	for (uint64_t i = 0; i < iterations; ++i)
+	{
+		// Keep the per-thread buffer from filling up and dropping events.
+		if (i % Utils::Tracer::MaxEventsPerThread == 0)
+		{
+			tracer.Start();
+		}
+		TRACE_SPAN(span, "benchmark");
+	}
+	tracer.Stop();
+}
+
+static void RecordSpans(int count)
+{
+	Utils::Tracer& tracer = Utils::Tracer::Instance();
+	tracer.Start();
+	for (int i = 0; i < count; ++i)
+	{
+		TRACE_SPAN(span, "benchmark");
+	}
+	tracer.Stop();
+}
+
+BENCHMARK(Tracing_ExportChromeTrace_1000Spans)
+{
+	RecordSpans(1000);
+	for (uint64_t i = 0; i < iterations; ++i)
+	{
+		Benchmarks::DoNotOptimize(Utils::Tracer::Instance().ExportChromeTrace());
+	}
+}
+
+BENCHMARK(Tracing_WriteChromeTrace_1000Spans)
+{
+	RecordSpans(1000);
+	for (uint64_t i = 0; i < iterations; ++i)
+	{
+		std::ostringstream stream;
+		Utils::Tracer::Instance().WriteChromeTrace(stream);
+		Benchmarks::DoNotOptimize(stream);
+	}
+}
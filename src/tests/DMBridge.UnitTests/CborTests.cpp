@@ -0,0 +1,352 @@
+/*
+Copyright 2018 Microsoft
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH
+THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#include "stdafx.h"
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+#include "CppUnitTest.h"
+#include "Cbor.h"
+#include "JsonTokenizer.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace std;
+using namespace Utils;
+
+namespace
+{
+	Json::Value Parse(const string& text)
+	{
+		Json::CharReaderBuilder builder;
+		unique_ptr<Json::CharReader> reader(builder.newCharReader());
+		Json::Value root;
+		string errors;
+		Assert::IsTrue(reader->parse(text.data(), text.data() + text.size(), &root, &errors));
+		return root;
+	}
+
+	string ToHex(const string& bytes)
+	{
+		static const char digits[] = "0123456789abcdef";
+		string hex;
+		for (char c : bytes)
+		{
+			hex += digits[static_cast<uint8_t>(c) >> 4];
+			hex += digits[static_cast<uint8_t>(c) & 0xf];
+		}
+		return hex;
+	}
+
+	string FromHex(const string& hex)
+	{
+		string bytes;
+		for (size_t i = 0; i < hex.size(); i += 2)
+		{
+			bytes += static_cast<char>(stoi(hex.substr(i, 2), nullptr, 16));
+		}
+		return bytes;
+	}
+
+	JsonToken ToToken(CborItem item)
+	{
+		switch (item)
+		{
+		case CborItem::BeginObject: return JsonToken::BeginObject;
+		case CborItem::EndObject: return JsonToken::EndObject;
+		case CborItem::BeginArray: return JsonToken::BeginArray;
+		case CborItem::EndArray: return JsonToken::EndArray;
+		case CborItem::Key: return JsonToken::Key;
+		case CborItem::String: return JsonToken::String;
+		case CborItem::True: return JsonToken::True;
+		case CborItem::False: return JsonToken::False;
+		case CborItem::Null: return JsonToken::Null;
+		case CborItem::End: return JsonToken::End;
+		default: return JsonToken::Number;
+		}
+	}
+
+	Json::Value Decode(const string& bytes)
+	{
+		return CborDecode(bytes.data(), bytes.data() + bytes.size());
+	}
+
+	// Numbers at the edges of every type and encoded size, strings that
+	// need escaping in JSON, and nesting.
+	const char Document[] =
+		"{ \"ints\": [ 0, 23, 24, 255, 256, 65535, 65536, 4294967295, 4294967296, 2147483647, 2147483648,\n"
+		"    9223372036854775807, 9223372036854775808, 18446744073709551615,\n"
+		"    -1, -24, -25, -256, -257, -2147483648, -2147483649, -9223372036854775808 ],\n"
+		"  \"reals\": [ 0.0, -0.0, 1.5, 0.1, 65504.0, 65505.0, 100000.0, 1e300, -4.1, 5e-324, 6e-8, 1.401298464324817e-45 ],\n"
+		"  \"strings\": [ \"\", \"a\", \"\\u0000nul\", \"\\u00fc\\u6c34\\ud834\\udd1e\", \"quote \\\" and \\\\\" ],\n"
+		"  \"nested\": { \"a\": { \"b\": [ [], {}, [ null, true, false ] ] } },\n"
+		"  \"\": \"empty name\" }";
+}
+
+namespace DMBridgeUnitTests
+{
+	TEST_CLASS(CborTests)
+	{
+	public:
+		TEST_METHOD(Encode_Values_MatchesRfc8949Examples)
+		{
+			// Arrange
+			const pair<Json::Value, const char*> examples[] = {
+				{ Json::Value(0), "00" },
+				{ Json::Value(23), "17" },
+				{ Json::Value(24), "1818" },
+				{ Json::Value(1000), "1903e8" },
+				{ Json::Value(1000000), "1a000f4240" },
+				{ Json::Value(Json::Int64(1000000000000)), "1b000000e8d4a51000" },
+				{ Json::Value(Json::UInt64(18446744073709551615ull)), "1bffffffffffffffff" },
+				{ Json::Value(-1), "20" },
+				{ Json::Value(-1000), "3903e7" },
+				{ Json::Value(0.0), "f90000" },
+				{ Json::Value(-0.0), "f98000" },
+				{ Json::Value(1.0), "f93c00" },
+				{ Json::Value(1.1), "fb3ff199999999999a" },
+				{ Json::Value(1.5), "f93e00" },
+				{ Json::Value(65504.0), "f97bff" },
+				{ Json::Value(100000.0), "fa47c35000" },
+				{ Json::Value(3.4028234663852886e+38), "fa7f7fffff" },
+				{ Json::Value(1.0e+300), "fb7e37e43c8800759c" },
+				{ Json::Value(5.960464477539063e-8), "f90001" },
+				{ Json::Value(0.00006103515625), "f90400" },
+				{ Json::Value(-4.0), "f9c400" },
+				{ Json::Value(-4.1), "fbc010666666666666" },
+				{ Json::Value(numeric_limits<double>::infinity()), "f97c00" },
+				{ Json::Value(numeric_limits<double>::quiet_NaN()), "f97e00" },
+				{ Json::Value(-numeric_limits<double>::infinity()), "f9fc00" },
+				{ Json::Value(false), "f4" },
+				{ Json::Value(true), "f5" },
+				{ Json::Value(), "f6" },
+				{ Json::Value(""), "60" },
+				{ Json::Value("a"), "6161" },
+				{ Json::Value("IETF"), "6449455446" },
+				{ Json::Value(Json::arrayValue), "80" },
+				{ Parse("[1, 2, 3]"), "83010203" },
+				{ Json::Value(Json::objectValue), "a0" },
+				{ Parse("{\"a\": 1, \"b\": [2, 3]}"), "a26161016162820203" },
+			};
+
+			// Act & Assert
+			for (const auto& example : examples)
+			{
+				Assert::AreEqual(string(example.second), ToHex(CborEncode(example.first)));
+			}
+		}
+
+		TEST_METHOD(Decode_Rfc8949Examples_ReadsEveryForm)
+		{
+			// Arrange
+			const pair<const char*, const char*> examples[] = {
+				{ "9fff", "[]" },
+				{ "9f018202039f0405ffff", "[1, [2, 3], [4, 5]]" },
+				{ "83018202039f0405ff", "[1, [2, 3], [4, 5]]" },
+				{ "bf61610161629f0203ffff", "{\"a\": 1, \"b\": [2, 3]}" },
+				{ "bf6346756ef563416d7421ff", "{\"Fun\": true, \"Amt\": -2}" },
+				{ "7f657374726561646d696e67ff", "\"streaming\"" },
+				{ "a1434b65794556616c7565", "{\"Key\": \"Value\"}" },
+				{ "c11a514b67b0", "1363896240" },
+				{ "d74401020304", "\"\\u0001\\u0002\\u0003\\u0004\"" },
+				{ "f7", "null" },
+				{ "f90001", "5.960464477539063e-8" },
+				{ "fa47c35000", "100000.0" },
+				{ "1bffffffffffffffff", "18446744073709551615" },
+				{ "3b7fffffffffffffff", "-9223372036854775808" },
+				{ "3bffffffffffffffff", "-18446744073709551616" },
+				{ "01ff00", "1" },
+			};
+
+			// Act & Assert
+			for (const auto& example : examples)
+			{
+				Assert::IsTrue(Parse(example.second) == Decode(FromHex(example.first)));
+			}
+		}
+
+		TEST_METHOD(Decode_Encoded_MatchesReader)
+		{
+			// Arrange
+			const Json::Value expected = Parse(Document);
+
+			// Act
+			const Json::Value decoded = Decode(CborEncode(expected));
+
+			// Assert
+			Assert::IsTrue(expected == decoded);
+			Assert::IsTrue(decoded["ints"][13].isUInt64() && !decoded["ints"][13].isInt64());
+			Assert::IsTrue(decoded["reals"][0].isDouble());
+			Assert::IsTrue(signbit(decoded["reals"][1].asDouble()));
+		}
+
+		TEST_METHOD(Decode_EncodedDoubles_AreExact)
+		{
+			// Arrange
+			mt19937_64 random(47);
+
+			for (int i = 0; i < 100000; ++i)
+			{
+				// Doubles that fit a single or a half float, around the ends of
+				// their ranges, and double subnormals.
+				uint64_t bits = random();
+				switch (i % 4)
+				{
+				case 1:
+					bits &= 0x800fffffe0000000ull;
+					bits |= (1023 - 155 + random() % 290) << 52;
+					break;
+				case 2:
+					bits &= 0x800ffc0000000000ull;
+					bits |= (1023 - 30 + random() % 50) << 52;
+					break;
+				case 3:
+					bits &= 0x800fffffffffffffull;
+					break;
+				}
+				double value;
+				memcpy(&value, &bits, sizeof(value));
+				if (isnan(value))
+				{
+					continue;
+				}
+
+				// Act
+				const Json::Value decoded = Decode(CborEncode(Json::Value(value)));
+
+				// Assert
+				double actual = decoded.asDouble();
+				Assert::AreEqual(0, memcmp(&value, &actual, sizeof(value)));
+			}
+		}
+
+		TEST_METHOD(Next_Document_ReturnsTokensOfTheJson)
+		{
+			// Arrange; written back, the members are in the same order.
+			const Json::Value document = Parse(Document);
+			const string text = Json::writeString(Json::StreamWriterBuilder(), document);
+			const string bytes = CborEncode(document);
+			JsonTokenizer tokenizer(text.data(), text.data() + text.size());
+			CborReader reader(bytes.data(), bytes.data() + bytes.size());
+
+			// Act & Assert
+			for (;;)
+			{
+				CborItem item = reader.Next();
+				JsonToken token = tokenizer.Next();
+				Assert::AreEqual(static_cast<int>(token), static_cast<int>(ToToken(item)));
+				if (item == CborItem::Key || item == CborItem::String)
+				{
+					Assert::AreEqual(tokenizer.Text(), reader.Text().ToString());
+					// Not copied out of the buffer.
+					Assert::IsTrue(reader.Text().data >= bytes.data() && reader.Text().data <= bytes.data() + bytes.size());
+				}
+				if (item == CborItem::End)
+				{
+					break;
+				}
+			}
+			Assert::AreEqual(bytes.size(), reader.Offset());
+		}
+
+		TEST_METHOD(SkipValue_Container_ContinuesAfterIt)
+		{
+			// Arrange
+			const string bytes = FromHex("83" "a2616181f66162bf61629f01ffff" "9f8080ff" "07");
+			CborReader reader(bytes.data(), bytes.data() + bytes.size());
+			Assert::IsTrue(reader.Next() == CborItem::BeginArray);
+
+			// Act & Assert
+			reader.SkipValue(reader.Next());
+			reader.SkipValue(reader.Next());
+			Assert::IsTrue(reader.Next() == CborItem::Unsigned);
+			Assert::IsTrue(reader.UInt() == 7);
+			Assert::IsTrue(reader.Next() == CborItem::EndArray);
+			Assert::IsTrue(reader.Next() == CborItem::End);
+		}
+
+		TEST_METHOD(WriteValue_SinkAndIndefiniteContainers_StreamsDocument)
+		{
+			// Arrange
+			string received;
+			size_t chunks = 0;
+			auto sink = [](void* context, const char* data, size_t size)
+			{
+				auto output = static_cast<pair<string*, size_t*>*>(context);
+				output->first->append(data, size);
+				++*output->second;
+				return true;
+			};
+			pair<string*, size_t*> context(&received, &chunks);
+			Json::WriteBuffer out(sink, &context, 16);
+			CborWriter writer(out);
+			const Json::Value document = Parse(Document);
+
+			// Act
+			writer.BeginObject();
+			writer.WriteString("document");
+			writer.WriteValue(document);
+			writer.WriteString("series");
+			writer.BeginArray();
+			for (int i = -100; i < 100; ++i)
+			{
+				writer.WriteInt(i * 1000);
+			}
+			writer.End();
+			writer.End();
+			Assert::IsTrue(out.flush());
+
+			// Assert
+			const Json::Value decoded = Decode(received);
+			Assert::IsTrue(document == decoded["document"]);
+			Assert::AreEqual(200u, decoded["series"].size());
+			Assert::AreEqual(-100000, decoded["series"][0].asInt());
+			Assert::IsTrue(chunks > 1);
+		}
+
+		TEST_METHOD(Decode_Malformed_Throws)
+		{
+			// Arrange
+			const string encoded = CborEncode(Parse(Document));
+			vector<string> malformed = {
+				"", "ff", "1c", "5f01ff", "7f6161", "a10102", "a1f6f6", "bf6161ff", "9affffffff00", "f8ff", "c6",
+			};
+			for (size_t size = 0; size < encoded.size(); ++size)
+			{
+				malformed.push_back(ToHex(encoded.substr(0, size)));
+			}
+
+			// One array in another, to the nesting limit and one deeper.
+			string deepest;
+			for (size_t i = 0; i < CborReader::MaxDepth; ++i)
+			{
+				deepest += "81";
+			}
+			Decode(FromHex(deepest + "00"));
+			malformed.push_back(deepest + "8100");
+
+			// Act & Assert
+			for (const string& hex : malformed)
+			{
+				const string bytes = FromHex(hex);
+				Assert::ExpectException<CborFormatError>([&bytes]() { Decode(bytes); });
+			}
+		}
+	};
+}
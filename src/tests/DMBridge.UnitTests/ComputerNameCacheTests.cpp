@@ -0,0 +1,246 @@
+/*
+Copyright 2018 Microsoft
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH
+THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+// Runs ComputerName in-process against the fake name sources. Only built by
+// the portable CMake build, for the same reason as RegistryStoreInjectionTests.cpp.
+
+#include "stdafx.h"
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include "CppUnitTest.h"
+#include "ComputerName.h"
+#include "Fakes.h"
+#include "RegistryStore.h"
+#include "RegistryUtils.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace std;
+
+constexpr wchar_t CompNameKey[] = L"system\\currentcontrolset\\control\\computername\\computername";
+constexpr wchar_t CompNameValue[] = L"ComputerName";
+
+namespace
+{
+	bool IsRenamePending()
+	{
+		BOOL isPending = TRUE;
+		HRESULT hr = ComputerName::IsRenamePending(&isPending);
+		Assert::AreEqual(S_OK, hr);
+		return isPending != FALSE;
+	}
+
+	wstring GetName()
+	{
+		long size = 0;
+		wchar_t* name = nullptr;
+		HRESULT hr = ComputerName::Get(size, name);
+		Assert::AreEqual(S_OK, hr);
+		wstring result(name);
+		midl_user_free(name);
+		return result;
+	}
+}
+
+namespace DMBridgeUnitTests
+{
+	TEST_CLASS(ComputerNameCacheTests)
+	{
+	public:
+		TEST_METHOD_INITIALIZE(Setup)
+		{
+			Fakes::FakeSystem::SetComputerName(L"MINWINPC");
+		}
+		TEST_METHOD_CLEANUP(TearDown)
+		{
+			ComputerName::ApplyRegistryStore(make_shared<Utils::Win32RegistryStore>());
+			Fakes::FakeSystem::SetComputerName(L"MINWINPC");
+			Utils::CloseRegistryKeys();
+			Fakes::FakeRegistry::Reset();
+		}
+
+		TEST_METHOD(ComputerName_NotWatching_ReadsEveryCall)
+		{
+			// Arrange
+			auto store = make_shared<Fakes::FakeRegistryStore>();
+			store->WriteValue(CompNameKey, CompNameValue, L"MINWINPC");
+			ComputerName::ApplyRegistryStore(store);
+			uint64_t readsBefore = store->Reads();
+			uint64_t namesBefore = Fakes::FakeSystem::ComputerNameCallCount();
+
+			// Act
+			bool isPending = IsRenamePending();
+
+			// Assert
+			Assert::IsFalse(isPending);
+			Assert::AreEqual(uint64_t(1), store->Reads() - readsBefore);
+			Assert::AreEqual(uint64_t(1), Fakes::FakeSystem::ComputerNameCallCount() - namesBefore);
+		}
+
+		TEST_METHOD(ComputerName_Watching_ServesReadsFromCache)
+		{
+			// Arrange
+			auto store = make_shared<Fakes::FakeRegistryStore>();
+			store->WriteValue(CompNameKey, CompNameValue, L"NEWNAME");
+			ComputerName::ApplyRegistryStore(store);
+			ComputerName::StartWatching();
+			uint64_t readsBefore = store->Reads();
+			uint64_t namesBefore = Fakes::FakeSystem::ComputerNameCallCount();
+
+			// Act
+			bool isPending = false;
+			wstring name;
+			for (int i = 0; i < 100; ++i)
+			{
+				isPending = IsRenamePending();
+				name = GetName();
+			}
+
+			// Assert
+			Assert::IsTrue(isPending);
+			Assert::AreEqual(wstring(L"MINWINPC"), name);
+			Assert::AreEqual(uint64_t(0), store->Reads() - readsBefore);
+			Assert::AreEqual(uint64_t(0), Fakes::FakeSystem::ComputerNameCallCount() - namesBefore);
+		}
+
+		TEST_METHOD(ComputerName_Watching_PendingNameChanged_RefreshesCache)
+		{
+			// Arrange
+			auto store = make_shared<Fakes::FakeRegistryStore>();
+			store->WriteValue(CompNameKey, CompNameValue, L"MINWINPC");
+			ComputerName::ApplyRegistryStore(store);
+			ComputerName::StartWatching();
+			Assert::IsFalse(IsRenamePending());
+
+			// Act
+			store->WriteValue(CompNameKey, CompNameValue, L"NEWNAME");
+
+			// Assert
+			Assert::IsTrue(IsRenamePending());
+		}
+
+		TEST_METHOD(ComputerName_Watching_Set_RefreshesCacheWithoutNotification)
+		{
+			// Arrange
+			auto store = make_shared<Fakes::FakeRegistryStore>(Fakes::FakeRegistryStore::Notify::Never);
+			store->WriteValue(CompNameKey, CompNameValue, L"MINWINPC");
+			ComputerName::ApplyRegistryStore(store);
+			ComputerName::StartWatching();
+			Assert::IsFalse(IsRenamePending());
+
+			// Act
+			HRESULT hr = ComputerName::Set(L"NEWNAME");
+
+			// Assert
+			Assert::AreEqual(S_OK, hr);
+			Assert::IsTrue(IsRenamePending());
+		}
+
+		TEST_METHOD(ComputerName_Watching_ReadFailed_RetriesRead)
+		{
+			// Arrange
+			auto store = make_shared<Fakes::FakeRegistryStore>(Fakes::FakeRegistryStore::Notify::Never);
+			ComputerName::ApplyRegistryStore(store);
+			ComputerName::StartWatching();
+			BOOL isPending = FALSE;
+			Assert::AreEqual(HRESULT_FROM_WIN32(ERROR_FILE_NOT_FOUND), ComputerName::IsRenamePending(&isPending));
+			store->WriteValue(CompNameKey, CompNameValue, L"NEWNAME");
+
+			// Act
+			bool pending = IsRenamePending();
+
+			// Assert
+			Assert::IsTrue(pending);
+		}
+
+		TEST_METHOD(ComputerName_WatchingRegistry_PendingNameChanged_RefreshesCache)
+		{
+			// Arrange
+			Fakes::FakeRegistry::SetValue(CompNameKey, CompNameValue, L"MINWINPC");
+			ComputerName::StartWatching();
+			Assert::IsFalse(IsRenamePending());
+
+			// Act
+			Fakes::FakeRegistry::SetValue(CompNameKey, CompNameValue, L"NEWNAME");
+
+			// Assert
+			// The notification arrives on the watch thread.
+			auto deadline = chrono::steady_clock::now() + chrono::seconds(5);
+			while (!IsRenamePending() && chrono::steady_clock::now() < deadline)
+			{
+				this_thread::sleep_for(chrono::milliseconds(1));
+			}
+			Assert::IsTrue(IsRenamePending());
+		}
+
+		TEST_METHOD(ComputerName_ConcurrentReadsAndRenames_ReadersSeeWholeNames)
+		{
+			// Arrange
+			constexpr int ReaderCount = 4;
+			constexpr int RenameCount = 200;
+			auto store = make_shared<Fakes::FakeRegistryStore>();
+			store->WriteValue(CompNameKey, CompNameValue, L"MINWINPC");
+			ComputerName::ApplyRegistryStore(store);
+			ComputerName::StartWatching();
+			atomic<bool> done(false);
+			atomic<uint64_t> failures(0);
+			atomic<uint64_t> reads(0);
+
+			// Act
+			vector<thread> readers;
+			for (int t = 0; t < ReaderCount; ++t)
+			{
+				readers.emplace_back([&]()
+				{
+					while (!done)
+					{
+						BOOL isPending = FALSE;
+						long size = 0;
+						wchar_t* name = nullptr;
+						if (FAILED(ComputerName::IsRenamePending(&isPending)) ||
+							FAILED(ComputerName::Get(size, name)) ||
+							wcscmp(name, L"MINWINPC") != 0)
+						{
+							++failures;
+						}
+						midl_user_free(name);
+						++reads;
+					}
+				});
+			}
+
+			HRESULT setResult = S_OK;
+			for (int i = 0; i < RenameCount && SUCCEEDED(setResult); ++i)
+			{
+				setResult = ComputerName::Set(i % 2 == 0 ? L"NAMEA" : L"NAMEB");
+			}
+			while (reads < ReaderCount)
+			{
+				this_thread::yield();
+			}
+			done = true;
+			for (thread& reader : readers)
+			{
+				reader.join();
+			}
+
+			// Assert
+			Assert::AreEqual(S_OK, setResult);
+			Assert::AreEqual(uint64_t(0), failures.load());
+			Assert::IsTrue(IsRenamePending());
+		}
+	};
+}
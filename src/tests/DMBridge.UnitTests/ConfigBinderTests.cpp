@@ -0,0 +1,141 @@
+/*
+Copyright 2018 Microsoft
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH
+THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+// Compiles config text through ConfigUtils::CompileConfig and the
+// ConfigBinder behind it. Only built by the portable CMake build, for the
+// same reason as RegistryStoreInjectionTests.cpp.
+
+#include "stdafx.h"
+#include "CppUnitTest.h"
+#include "ConfigBinder.h"
+#include "ConfigUtils.h"
+#include "NTServiceConfig.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace std;
+
+namespace DMBridgeUnitTests
+{
+	TEST_CLASS(ConfigBinderTests)
+	{
+	public:
+		TEST_METHOD(CompileConfig_BindsListsAndSkipsOtherMembers)
+		{
+			// Arrange
+			string text =
+				"{ \"before\": { \"api\": [ \"nested\" ] },"
+				"  \"api\": [ \"computername\", \"tpm\" ],"
+				"  \"servicemanager\": { \"other\": [ 1, { \"whitelist\": [] } ], \"whitelist\": [ \"w32time\" ] },"
+				"  \"after\": [ \"api\" ] }";
+
+			// Act
+			ConfigUtils::CompiledConfig config = ConfigUtils::CompileConfig(text);
+
+			// Assert
+			Assert::IsTrue(config.hasApiList);
+			Assert::IsTrue(config.apiList == vector<wstring>{ L"computername", L"tpm" });
+			Assert::IsTrue(config.hasWhitelist);
+			Assert::IsTrue(config.whitelist == vector<wstring>{ L"w32time" });
+		}
+
+		TEST_METHOD(CompileConfig_MissingLists_AreNotSet)
+		{
+			// Act
+			ConfigUtils::CompiledConfig config = ConfigUtils::CompileConfig("{ \"servicemanager\": {} }");
+
+			// Assert
+			Assert::IsFalse(config.hasApiList);
+			Assert::IsFalse(config.hasWhitelist);
+		}
+
+		TEST_METHOD(CompileConfig_WrongTypes_AreNotSet)
+		{
+			// Act
+			ConfigUtils::CompiledConfig listNotArray = ConfigUtils::CompileConfig("{ \"api\": \"tpm\", \"servicemanager\": { \"whitelist\": {} } }");
+			ConfigUtils::CompiledConfig sectionNotObject = ConfigUtils::CompileConfig("{ \"servicemanager\": [ { \"whitelist\": [ \"a\" ] } ] }");
+
+			// Assert
+			Assert::IsFalse(listNotArray.hasApiList);
+			Assert::IsFalse(listNotArray.hasWhitelist);
+			Assert::IsFalse(sectionNotObject.hasWhitelist);
+		}
+
+		TEST_METHOD(CompileConfig_NonStringAndEmptyEntries_AreSkipped)
+		{
+			// Act
+			ConfigUtils::CompiledConfig config = ConfigUtils::CompileConfig("{ \"api\": [ 1, \"\", null, [ \"x\" ], \"tpm\", {} ] }");
+
+			// Assert
+			Assert::IsTrue(config.hasApiList);
+			Assert::IsTrue(config.apiList == vector<wstring>{ L"tpm" });
+		}
+
+		TEST_METHOD(CompileConfig_RepeatedMembers_LastWins)
+		{
+			// Act
+			ConfigUtils::CompiledConfig lists = ConfigUtils::CompileConfig("{ \"api\": [ \"a\" ], \"api\": [ \"b\" ] }");
+			ConfigUtils::CompiledConfig listThenWrongType = ConfigUtils::CompileConfig("{ \"api\": [ \"a\" ], \"api\": 5 }");
+			ConfigUtils::CompiledConfig sections = ConfigUtils::CompileConfig(
+				"{ \"servicemanager\": { \"whitelist\": [ \"a\" ] }, \"servicemanager\": { \"other\": 1 } }");
+
+			// Assert
+			Assert::IsTrue(lists.apiList == vector<wstring>{ L"b" });
+			Assert::IsFalse(listThenWrongType.hasApiList);
+			Assert::IsTrue(listThenWrongType.apiList.empty());
+			Assert::IsFalse(sections.hasWhitelist);
+		}
+
+		TEST_METHOD(CompileConfig_NotAnObject_Throws)
+		{
+			// Assert
+			Assert::ExpectException<Utils::JsonSyntaxError>([]() { ConfigUtils::CompileConfig("[ \"api\" ]"); });
+			Assert::ExpectException<Utils::JsonSyntaxError>([]() { ConfigUtils::CompileConfig(""); });
+		}
+
+		TEST_METHOD(CompileConfig_Malformed_ReportsPosition)
+		{
+			// Arrange
+			size_t line = 0;
+			size_t column = 0;
+
+			// Act
+			try
+			{
+				ConfigUtils::CompileConfig("{\n  \"api\": [\n    \"tpm\"\n    \"metrics\"\n  ]\n}");
+			}
+			catch (const Utils::JsonSyntaxError& e)
+			{
+				line = e.Line();
+				column = e.Column();
+			}
+
+			// Assert
+			Assert::AreEqual(size_t(4), line);
+			Assert::AreEqual(size_t(5), column);
+		}
+
+		TEST_METHOD(NTServiceConfig_FromCompiledConfig_UsesWhitelistOrDefaults)
+		{
+			// Act
+			NTServiceConfig configured(ConfigUtils::CompileConfig("{ \"servicemanager\": { \"whitelist\": [ \"dhcp\" ] } }"));
+			NTServiceConfig defaults(ConfigUtils::CompileConfig("{}"));
+
+			// Assert
+			Assert::IsTrue(configured.IsWhitelisted(L"DHCP"));
+			Assert::IsFalse(configured.IsWhitelisted(L"w32time"));
+			Assert::IsTrue(defaults.IsWhitelisted(L"w32time"));
+		}
+	};
+}
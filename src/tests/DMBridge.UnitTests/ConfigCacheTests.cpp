@@ -0,0 +1,302 @@
+/*
+Copyright 2018 Microsoft
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH
+THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+// Writes config files and their caches to the working directory. Only built
+// by the portable CMake build, for the same reason as
+// RegistryStoreInjectionTests.cpp.
+
+#include "stdafx.h"
+#include <fstream>
+#include <iterator>
+#include "CppUnitTest.h"
+#include "ConfigCache.h"
+#include "MappedFile.h"
+#include "StringUtils.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace std;
+
+constexpr wchar_t ConfigFileName[] = L"ConfigCacheTests.json";
+
+namespace
+{
+	void WriteFile(const wstring& fileName, const string& contents)
+	{
+		ofstream file(Utils::FileStreamName(fileName), ofstream::binary | ofstream::trunc);
+		file << contents;
+	}
+
+	string ReadFile(const wstring& fileName)
+	{
+		ifstream file(Utils::FileStreamName(fileName), ifstream::binary);
+		return string(istreambuf_iterator<char>(file), istreambuf_iterator<char>());
+	}
+
+	ConfigUtils::CompiledConfig SampleConfig()
+	{
+		ConfigUtils::CompiledConfig config;
+		config.hasApiList = true;
+		config.apiList = { L"ComputerName", L"NTService" };
+		config.hasWhitelist = true;
+		config.whitelist = { L"w32time", L"a", L"" };
+		return config;
+	}
+
+	const ConfigUtils::FileVersion Source = { 120, 131000000000000000ull };
+	const uint64_t SourceHash = 0x0123456789abcdefull;
+}
+
+namespace DMBridgeUnitTests
+{
+	TEST_CLASS(ConfigCacheTests)
+	{
+	public:
+		TEST_METHOD_CLEANUP(TearDown)
+		{
+			DeleteFile(ConfigFileName);
+			DeleteFile(ConfigCache::GetCacheFilePath(ConfigFileName).c_str());
+		}
+
+		TEST_METHOD(Deserialize_RoundTrips)
+		{
+			// Arrange
+			vector<char> data = ConfigCache::Serialize(SampleConfig(), Source, SourceHash);
+
+			// Act
+			ConfigUtils::CompiledConfig config;
+			bool deserialized = ConfigCache::TryDeserialize(data.data(), data.size(), Source, config);
+
+			// Assert
+			Assert::IsTrue(deserialized);
+			Assert::IsTrue(config.hasApiList);
+			Assert::IsTrue(config.apiList == SampleConfig().apiList);
+			Assert::IsTrue(config.hasWhitelist);
+			Assert::IsTrue(config.whitelist == SampleConfig().whitelist);
+		}
+
+		TEST_METHOD(Deserialize_UnsetLists_StayUnset)
+		{
+			// Arrange
+			vector<char> data = ConfigCache::Serialize(ConfigUtils::CompiledConfig(), Source, SourceHash);
+
+			// Act
+			ConfigUtils::CompiledConfig config = SampleConfig();
+			bool deserialized = ConfigCache::TryDeserialize(data.data(), data.size(), Source, config);
+
+			// Assert
+			Assert::IsTrue(deserialized);
+			Assert::IsFalse(config.hasApiList);
+			Assert::IsFalse(config.hasWhitelist);
+			Assert::IsTrue(config.apiList.empty());
+		}
+
+		TEST_METHOD(Deserialize_SourceChanged_Fails)
+		{
+			// Arrange
+			vector<char> data = ConfigCache::Serialize(SampleConfig(), Source, SourceHash);
+			ConfigUtils::FileVersion resized = { Source.size + 1, Source.lastWriteTime };
+			ConfigUtils::FileVersion touched = { Source.size, Source.lastWriteTime + 1 };
+
+			// Act
+			ConfigUtils::CompiledConfig config;
+			bool resizedDeserialized = ConfigCache::TryDeserialize(data.data(), data.size(), resized, config);
+			bool touchedDeserialized = ConfigCache::TryDeserialize(data.data(), data.size(), touched, config);
+
+			// Assert
+			Assert::IsFalse(resizedDeserialized);
+			Assert::IsFalse(touchedDeserialized);
+		}
+
+		TEST_METHOD(DeserializeContent_MatchesContentOnly)
+		{
+			// Arrange
+			vector<char> data = ConfigCache::Serialize(SampleConfig(), Source, SourceHash);
+
+			// Act
+			ConfigUtils::CompiledConfig config;
+			bool sameDeserialized = ConfigCache::TryDeserializeContent(data.data(), data.size(), SourceHash, config);
+			ConfigUtils::CompiledConfig otherConfig;
+			bool otherDeserialized = ConfigCache::TryDeserializeContent(data.data(), data.size(), SourceHash + 1, otherConfig);
+
+			// Assert
+			Assert::IsTrue(sameDeserialized);
+			Assert::IsTrue(config.whitelist == SampleConfig().whitelist);
+			Assert::IsFalse(otherDeserialized);
+		}
+
+		TEST_METHOD(ContentHash_IsXxh64)
+		{
+			// Arrange
+			string lanes(768, '\0');
+			for (size_t i = 0; i < lanes.size(); ++i)
+			{
+				lanes[i] = static_cast<char>(i);
+			}
+
+			// Assert, covering the tail loops alone and after the lanes.
+			Assert::AreEqual(uint64_t(0xef46db3751d8e999), ConfigUtils::ContentHash("", 0));
+			Assert::AreEqual(uint64_t(0x44bc2cf5ad770999), ConfigUtils::ContentHash("abc", 3));
+			Assert::AreEqual(uint64_t(0xa76190c3acf08a1c), ConfigUtils::ContentHash("0123456789abcdef0123456789abcdef0123456789", 42));
+			Assert::AreEqual(uint64_t(0x8e03c838c596036f), ConfigUtils::ContentHash(lanes.data(), lanes.size()));
+		}
+
+		TEST_METHOD(Deserialize_Corrupt_Fails)
+		{
+			// Arrange
+			vector<char> data = ConfigCache::Serialize(SampleConfig(), Source, SourceHash);
+			data.back() ^= 0x1;
+
+			// Act
+			ConfigUtils::CompiledConfig config;
+			bool deserialized = ConfigCache::TryDeserialize(data.data(), data.size(), Source, config);
+
+			// Assert
+			Assert::IsFalse(deserialized);
+		}
+
+		TEST_METHOD(Deserialize_Truncated_Fails)
+		{
+			// Arrange
+			vector<char> data = ConfigCache::Serialize(SampleConfig(), Source, SourceHash);
+
+			// Act
+			bool anyDeserialized = false;
+			for (size_t size = 0; size < data.size(); ++size)
+			{
+				ConfigUtils::CompiledConfig config;
+				anyDeserialized |= ConfigCache::TryDeserialize(data.data(), size, Source, config);
+			}
+
+			// Assert
+			Assert::IsFalse(anyDeserialized);
+		}
+
+		TEST_METHOD(Load_MissingFile_ReturnsDefaults)
+		{
+			// Act
+			ConfigUtils::CompiledConfig config = ConfigCache::Load(ConfigFileName);
+
+			// Assert
+			Assert::IsFalse(config.hasApiList);
+			Assert::IsFalse(config.hasWhitelist);
+			Assert::IsTrue(ReadFile(ConfigCache::GetCacheFilePath(ConfigFileName)).empty());
+		}
+
+		TEST_METHOD(Load_InvalidFile_ReturnsDefaultsWithoutCache)
+		{
+			// Arrange
+			WriteFile(ConfigFileName, "{ \"api\": [");
+
+			// Act
+			ConfigUtils::CompiledConfig config = ConfigCache::Load(ConfigFileName);
+
+			// Assert
+			Assert::IsFalse(config.hasApiList);
+			Assert::IsTrue(ReadFile(ConfigCache::GetCacheFilePath(ConfigFileName)).empty());
+		}
+
+		TEST_METHOD(Load_WritesCacheAndUsesIt)
+		{
+			// Arrange
+			WriteFile(ConfigFileName, "{ \"api\": [ \"ComputerName\" ] }");
+			ConfigCache::Load(ConfigFileName);
+			ConfigUtils::CompiledConfig cached = SampleConfig();
+			ConfigUtils::FileVersion source;
+			Assert::IsTrue(ConfigUtils::TryGetFileVersion(ConfigFileName, source));
+
+			// Replace the cache with one that only the cache could have produced.
+			vector<char> data = ConfigCache::Serialize(cached, source, 0);
+			WriteFile(ConfigCache::GetCacheFilePath(ConfigFileName), string(data.begin(), data.end()));
+
+			// Act
+			ConfigUtils::CompiledConfig config = ConfigCache::Load(ConfigFileName);
+
+			// Assert
+			Assert::IsTrue(config.apiList == cached.apiList);
+		}
+
+		TEST_METHOD(Load_FirstLoad_WritesCache)
+		{
+			// Arrange
+			WriteFile(ConfigFileName, "{ \"api\": [ \"ComputerName\" ], \"servicemanager\": { \"whitelist\": [ \"w32time\" ] } }");
+
+			// Act
+			ConfigUtils::CompiledConfig config = ConfigCache::Load(ConfigFileName);
+
+			// Assert
+			string data = ReadFile(ConfigCache::GetCacheFilePath(ConfigFileName));
+			ConfigUtils::FileVersion source;
+			Assert::IsTrue(ConfigUtils::TryGetFileVersion(ConfigFileName, source));
+			ConfigUtils::CompiledConfig cached;
+			Assert::IsTrue(ConfigCache::TryDeserialize(data.data(), data.size(), source, cached));
+			Assert::IsTrue(cached.apiList == vector<wstring>{ L"ComputerName" });
+			Assert::IsTrue(cached.whitelist == vector<wstring>{ L"w32time" });
+			Assert::IsTrue(config.whitelist == cached.whitelist);
+		}
+
+		TEST_METHOD(Load_SourceChanged_Recompiles)
+		{
+			// Arrange
+			WriteFile(ConfigFileName, "{ \"api\": [ \"ComputerName\" ] }");
+			ConfigCache::Load(ConfigFileName);
+			WriteFile(ConfigFileName, "{ \"api\": [ \"ComputerName\", \"NTService\" ] }");
+
+			// Act
+			ConfigUtils::CompiledConfig config = ConfigCache::Load(ConfigFileName);
+
+			// Assert
+			Assert::AreEqual(size_t(2), config.apiList.size());
+		}
+
+		TEST_METHOD(Load_FileLargerThanMapThreshold_Compiles)
+		{
+			// Arrange
+			string padding(Utils::MappedFile::MapThreshold, 'x');
+			WriteFile(ConfigFileName, "{ \"unread\": \"" + padding + "\", \"api\": [ \"ComputerName\" ] }");
+
+			// Act
+			ConfigUtils::CompiledConfig config = ConfigCache::Load(ConfigFileName);
+
+			// Assert
+			Assert::IsTrue(config.apiList == vector<wstring>{ L"ComputerName" });
+		}
+
+		TEST_METHOD(Load_SourceTouchedButUnchanged_UsesCacheAndRewritesIt)
+		{
+			// Arrange
+			string text = "{ \"api\": [ \"ComputerName\" ] }";
+			WriteFile(ConfigFileName, text);
+			ConfigUtils::FileVersion source;
+			Assert::IsTrue(ConfigUtils::TryGetFileVersion(ConfigFileName, source));
+			ConfigUtils::FileVersion touched = { source.size, source.lastWriteTime + 1 };
+
+			// A cache for an older write of the same content, holding a config
+			// that only the cache could have produced.
+			ConfigUtils::CompiledConfig cached = SampleConfig();
+			vector<char> data = ConfigCache::Serialize(cached, touched, ConfigUtils::ContentHash(text.data(), text.size()));
+			WriteFile(ConfigCache::GetCacheFilePath(ConfigFileName), string(data.begin(), data.end()));
+
+			// Act
+			ConfigUtils::CompiledConfig config = ConfigCache::Load(ConfigFileName);
+
+			// Assert
+			Assert::IsTrue(config.apiList == cached.apiList);
+			string rewritten = ReadFile(ConfigCache::GetCacheFilePath(ConfigFileName));
+			ConfigUtils::CompiledConfig rewrittenConfig;
+			Assert::IsTrue(ConfigCache::TryDeserialize(rewritten.data(), rewritten.size(), source, rewrittenConfig));
+			Assert::IsTrue(rewrittenConfig.apiList == cached.apiList);
+		}
+	};
+}
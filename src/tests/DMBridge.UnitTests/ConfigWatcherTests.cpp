@@ -0,0 +1,278 @@
+/*
+Copyright 2018 Microsoft
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH
+THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+// Runs ConfigWatcher and NTService in-process against config files written
+// by the tests. Only built by the portable CMake build, for the same reason
+// as RegistryStoreInjectionTests.cpp.
+
+#include "stdafx.h"
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <memory>
+#include <thread>
+#include "CppUnitTest.h"
+#include "ConfigWatcher.h"
+#include "Constants.h"
+#include "Fakes.h"
+#include "NTService.h"
+#include "NTServiceConfig.h"
+#include "RegistryStore.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace std;
+
+constexpr wchar_t ConfigFileName[] = L"ConfigWatcherTests.json";
+constexpr wchar_t OtherConfigFileName[] = L"ConfigWatcherTests.other.json";
+
+namespace
+{
+	void WriteConfig(const wchar_t* fileName, const string& contents)
+	{
+		ofstream file(Utils::FileStreamName(fileName), ofstream::binary | ofstream::trunc);
+		file << contents;
+	}
+
+	// Stands for a config file edited to 'version', in the API list that
+	// ConfigUtils::CompiledConfig keeps.
+	string VersionConfig(int version)
+	{
+		return "{ \"api\": [ \"v" + to_string(version) + "\" ] }";
+	}
+
+	int VersionOf(const ConfigUtils::CompiledConfig& config)
+	{
+		return config.apiList.size() == 1 ? stoi(config.apiList[0].substr(1)) : 0;
+	}
+
+	string WhitelistConfig(const string& services)
+	{
+		return "{ \"servicemanager\": { \"whitelist\": [ " + services + " ] } }";
+	}
+}
+
+namespace DMBridgeUnitTests
+{
+	TEST_CLASS(ConfigWatcherTests)
+	{
+	private:
+		shared_ptr<Utils::MemoryRegistryStore> _store;
+		vector<ConfigUtils::CompiledConfig> _applied;
+
+	public:
+		TEST_METHOD_INITIALIZE(Setup)
+		{
+			_store = make_shared<Utils::MemoryRegistryStore>();
+			_store->WriteValue(IoTDMRegistryRoot, RegConfigFile, ConfigFileName);
+			WriteConfig(ConfigFileName, VersionConfig(1));
+		}
+		TEST_METHOD_CLEANUP(TearDown)
+		{
+			DeleteFile(ConfigFileName);
+			DeleteFile(OtherConfigFileName);
+			Fakes::FakeServiceControlManager::Reset();
+		}
+
+		ConfigWatcher::ApplyFunction Recorder()
+		{
+			return [this](const ConfigUtils::CompiledConfig& config)
+			{
+				_applied.push_back(config);
+			};
+		}
+
+		TEST_METHOD(CheckForChanges_Unchanged_DoesNotApply)
+		{
+			// Arrange
+			ConfigWatcher watcher(_store, Recorder());
+
+			// Act
+			bool applied = watcher.CheckForChanges();
+
+			// Assert
+			Assert::IsFalse(applied);
+			Assert::AreEqual(size_t(0), _applied.size());
+		}
+
+		TEST_METHOD(CheckForChanges_FileChanged_AppliesOnce)
+		{
+			// Arrange
+			ConfigWatcher watcher(_store, Recorder());
+			WriteConfig(ConfigFileName, VersionConfig(22));
+
+			// Act
+			bool applied = watcher.CheckForChanges();
+			bool appliedAgain = watcher.CheckForChanges();
+
+			// Assert
+			Assert::IsTrue(applied);
+			Assert::IsFalse(appliedAgain);
+			Assert::AreEqual(size_t(1), _applied.size());
+			Assert::AreEqual(22, VersionOf(_applied[0]));
+		}
+
+		TEST_METHOD(CheckForChanges_PathChanged_AppliesNewFile)
+		{
+			// Arrange
+			ConfigWatcher watcher(_store, Recorder());
+			WriteConfig(OtherConfigFileName, VersionConfig(2));
+			_store->WriteValue(IoTDMRegistryRoot, RegConfigFile, OtherConfigFileName);
+
+			// Act
+			bool applied = watcher.CheckForChanges();
+
+			// Assert
+			Assert::IsTrue(applied);
+			Assert::AreEqual(2, VersionOf(_applied[0]));
+		}
+
+		TEST_METHOD(CheckForChanges_PathChangedToSameContent_DoesNotApply)
+		{
+			// Arrange
+			ConfigWatcher watcher(_store, Recorder());
+			WriteConfig(OtherConfigFileName, VersionConfig(1));
+			_store->WriteValue(IoTDMRegistryRoot, RegConfigFile, OtherConfigFileName);
+
+			// Act
+			bool applied = watcher.CheckForChanges();
+			WriteConfig(OtherConfigFileName, VersionConfig(2));
+			bool appliedChanged = watcher.CheckForChanges();
+
+			// Assert
+			Assert::IsFalse(applied);
+			Assert::IsTrue(appliedChanged);
+			Assert::AreEqual(size_t(1), _applied.size());
+			Assert::AreEqual(2, VersionOf(_applied[0]));
+		}
+
+		TEST_METHOD(CheckForChanges_InvalidFile_KeepsConfigUntilFixed)
+		{
+			// Arrange
+			ConfigWatcher watcher(_store, Recorder());
+			WriteConfig(ConfigFileName, "{ \"api\": ");
+
+			// Act
+			bool appliedInvalid = watcher.CheckForChanges();
+			WriteConfig(ConfigFileName, "[ \"not an object\" ]");
+			bool appliedNotObject = watcher.CheckForChanges();
+			WriteConfig(ConfigFileName, VersionConfig(333));
+			bool appliedFixed = watcher.CheckForChanges();
+
+			// Assert
+			Assert::IsFalse(appliedInvalid);
+			Assert::IsFalse(appliedNotObject);
+			Assert::IsTrue(appliedFixed);
+			Assert::AreEqual(size_t(1), _applied.size());
+			Assert::AreEqual(333, VersionOf(_applied[0]));
+		}
+
+		TEST_METHOD(CheckForChanges_FileDeleted_KeepsConfig)
+		{
+			// Arrange
+			ConfigWatcher watcher(_store, Recorder());
+			DeleteFile(ConfigFileName);
+
+			// Act
+			bool applied = watcher.CheckForChanges();
+
+			// Assert
+			Assert::IsFalse(applied);
+			Assert::AreEqual(size_t(0), _applied.size());
+		}
+
+		TEST_METHOD(Start_FileChanged_AppliesOnWatchThread)
+		{
+			// Arrange
+			atomic<int> version(0);
+			ConfigWatcher watcher(_store, [&version](const ConfigUtils::CompiledConfig& config)
+			{
+				version = VersionOf(config);
+			});
+			watcher.Start(1);
+
+			// Act
+			WriteConfig(ConfigFileName, VersionConfig(4444));
+
+			// Assert
+			auto deadline = chrono::steady_clock::now() + chrono::seconds(5);
+			while (version != 4444 && chrono::steady_clock::now() < deadline)
+			{
+				this_thread::sleep_for(chrono::milliseconds(1));
+			}
+			Assert::AreEqual(4444, version.load());
+		}
+
+		TEST_METHOD(NTService_WhitelistReloads_ConcurrentCallsSeeWholeConfigs)
+		{
+			// Arrange
+			constexpr int CallerCount = 4;
+			constexpr int ReloadCount = 200;
+			Fakes::FakeServiceControlManager::AddService(L"w32time", SERVICE_RUNNING, SERVICE_AUTO_START);
+			Fakes::FakeServiceControlManager::AddService(L"dhcp", SERVICE_RUNNING, SERVICE_AUTO_START);
+			unique_ptr<NTServiceConfig> initialConfig(new NTServiceConfig());
+			NTService::ApplyConfig(initialConfig);
+			ConfigWatcher watcher(_store, [](const ConfigUtils::CompiledConfig& compiled)
+			{
+				unique_ptr<NTServiceConfig> config(new NTServiceConfig(compiled));
+				NTService::ApplyConfig(config);
+			});
+			atomic<bool> done(false);
+			atomic<uint64_t> failures(0);
+			atomic<uint64_t> calls(0);
+
+			// Act
+			vector<thread> callers;
+			for (int t = 0; t < CallerCount; ++t)
+			{
+				callers.emplace_back([&]()
+				{
+					while (!done)
+					{
+						HRESULT alwaysListed = NTService::Start(L"w32time");
+						HRESULT sometimesListed = NTService::Start(L"dhcp");
+						if (alwaysListed != S_OK ||
+							(sometimesListed != S_OK && sometimesListed != HRESULT_FROM_WIN32(ERROR_ACCESS_DENIED)))
+						{
+							++failures;
+						}
+						++calls;
+					}
+				});
+			}
+
+			int reloads = 0;
+			for (int i = 0; i < ReloadCount; ++i)
+			{
+				// The two configs differ in size, so every write is seen as a change.
+				WriteConfig(ConfigFileName, WhitelistConfig(i % 2 == 0 ? "\"w32time\"" : "\"w32time\", \"dhcp\""));
+				reloads += watcher.CheckForChanges() ? 1 : 0;
+			}
+			while (calls < CallerCount)
+			{
+				this_thread::yield();
+			}
+			done = true;
+			for (thread& caller : callers)
+			{
+				caller.join();
+			}
+
+			// Assert
+			Assert::AreEqual(ReloadCount, reloads);
+			Assert::AreEqual(uint64_t(0), failures.load());
+			Assert::AreEqual(S_OK, NTService::Start(L"dhcp"));
+		}
+	};
+}
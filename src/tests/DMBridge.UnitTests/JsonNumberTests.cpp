@@ -0,0 +1,246 @@
+/*
+Copyright 2018 Microsoft
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH
+THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#include "stdafx.h"
+#include <algorithm>
+#include <cctype>
+#include <clocale>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <random>
+#include <string>
+#include "CppUnitTest.h"
+#include "json/json.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace std;
+
+namespace
+{
+	Json::Value Parse(const string& text)
+	{
+		Json::CharReaderBuilder builder;
+		unique_ptr<Json::CharReader> reader(builder.newCharReader());
+		Json::Value root;
+		string errors;
+		Assert::IsTrue(reader->parse(text.data(), text.data() + text.size(), &root, &errors));
+		return root;
+	}
+
+	uint64_t Bits(double value)
+	{
+		uint64_t bits;
+		memcpy(&bits, &value, sizeof(bits));
+		return bits;
+	}
+
+	// Writes value and reads it back, comparing bit patterns so that -0.0
+	// and 0.0 are told apart.
+	void AssertRoundTrips(double value)
+	{
+		const string text = Json::valueToString(value);
+		const Json::Value root = Parse("[" + text + "]");
+		const wstring message(text.begin(), text.end());
+		Assert::AreEqual(Bits(value), Bits(root[0].asDouble()), message.c_str());
+	}
+
+	// The number of significant digits in text written by valueToString().
+	int SignificantDigits(const string& text)
+	{
+		string digits;
+		for (char c : text.substr(0, text.find('e')))
+		{
+			if (isdigit(static_cast<unsigned char>(c)))
+			{
+				digits += c;
+			}
+		}
+		digits.erase(0, min(digits.find_first_not_of('0'), digits.size() - 1));
+		digits.erase(max(digits.find_last_not_of('0') + 1, size_t(1)));
+		return static_cast<int>(digits.size());
+	}
+
+	// The fewest significant digits that read back as value, found by trying
+	// every precision.
+	int FewestDigits(double value)
+	{
+		char text[32];
+		for (int digits = 1; digits < 17; ++digits)
+		{
+			snprintf(text, sizeof(text), "%.*e", digits - 1, value);
+			if (strtod(text, nullptr) == value)
+			{
+				return digits;
+			}
+		}
+		return 17;
+	}
+}
+
+namespace DMBridgeUnitTests
+{
+	TEST_CLASS(JsonNumberTests)
+	{
+	public:
+		TEST_METHOD(ValueToString_Double_WritesShortestText)
+		{
+			// Act & Assert
+			Assert::AreEqual(string("0.1"), Json::valueToString(0.1));
+			Assert::AreEqual(string("0.3"), Json::valueToString(0.3));
+			Assert::AreEqual(string("-2.25"), Json::valueToString(-2.25));
+			Assert::AreEqual(string("100.0"), Json::valueToString(100.0));
+			Assert::AreEqual(string("0.0001"), Json::valueToString(0.0001));
+			Assert::AreEqual(string("0.0"), Json::valueToString(0.0));
+			Assert::AreEqual(string("-0.0"), Json::valueToString(-0.0));
+			Assert::AreEqual(string("0.3333333333333333"), Json::valueToString(1.0 / 3.0));
+			Assert::AreEqual(string("1e+20"), Json::valueToString(1e20));
+			Assert::AreEqual(string("6.02e+23"), Json::valueToString(6.02e23));
+			Assert::AreEqual(string("1.5e-07"), Json::valueToString(1.5e-7));
+			Assert::AreEqual(string("1e+23"), Json::valueToString(1e23));
+			Assert::AreEqual(string("5e-324"), Json::valueToString(numeric_limits<double>::denorm_min()));
+		}
+
+		TEST_METHOD(ValueToString_LowerPrecision_KeepsPrintfFormatting)
+		{
+			// Act & Assert
+			Assert::AreEqual(string("0.33"), Json::valueToString(1.0 / 3.0, 2));
+			Assert::AreEqual(string("0.1"), Json::valueToString(0.1, 3, Json::PrecisionType::decimalPlaces));
+		}
+
+		TEST_METHOD(ValueToString_SpecialValues_RoundTrip)
+		{
+			// Act & Assert
+			AssertRoundTrips(0.0);
+			AssertRoundTrips(-0.0);
+			AssertRoundTrips(numeric_limits<double>::max());
+			AssertRoundTrips(numeric_limits<double>::min());
+			AssertRoundTrips(numeric_limits<double>::denorm_min());
+			AssertRoundTrips(numeric_limits<double>::epsilon());
+			AssertRoundTrips(9007199254740993.0);
+			AssertRoundTrips(1125899906842624.0);
+			AssertRoundTrips(0.1 + 0.2);
+		}
+
+		TEST_METHOD(ValueToString_RandomDoubles_RoundTrip)
+		{
+			// Arrange
+			mt19937_64 random(20181019);
+
+			for (int i = 0; i < 20000; ++i)
+			{
+				uint64_t bits = random();
+				double value;
+				memcpy(&value, &bits, sizeof(value));
+				if (!isfinite(value))
+				{
+					continue;
+				}
+
+				// Act & Assert
+				AssertRoundTrips(value);
+
+				// Short decimals take the fixed-point path.
+				AssertRoundTrips(static_cast<double>(static_cast<int64_t>(bits % 2000000) - 1000000) / 1000.0);
+			}
+		}
+
+		TEST_METHOD(ValueToString_RandomDoubles_WritesFewestDigits)
+		{
+			// Arrange
+			mt19937_64 random(20261019);
+
+			for (int i = 0; i < 20000; ++i)
+			{
+				uint64_t bits = random();
+				double value;
+				memcpy(&value, &bits, sizeof(value));
+				if (!isfinite(value))
+				{
+					continue;
+				}
+
+				// Act
+				const string text = Json::valueToString(value);
+
+				// Assert
+				const wstring message(text.begin(), text.end());
+				Assert::AreEqual(FewestDigits(value), SignificantDigits(text), message.c_str());
+			}
+		}
+
+		TEST_METHOD(Parse_Numbers_MatchStrtod)
+		{
+			// Arrange
+			const char* const texts[] = {
+				"0.1", "-0.0", "1e22", "1e23", "123456.789e-3", "9007199254740993.5", "1.7976931348623157e308",
+				"4.9e-324", "2.2250738585072011e-308", "0.000001", "1234567890123456789.0", "12345678901234567890e-5",
+				"1E+2", "3.14159265358979323846", "0e400", "1e-400"
+			};
+
+			for (const char* text : texts)
+			{
+				// Act
+				const Json::Value root = Parse(string("[") + text + "]");
+
+				// Assert
+				Assert::AreEqual(Bits(strtod(text, nullptr)), Bits(root[0].asDouble()), wstring(text, text + strlen(text)).c_str());
+			}
+		}
+
+		TEST_METHOD(Parse_Integers_KeepIntegerType)
+		{
+			// Act
+			const Json::Value root = Parse("[0, -1, 9223372036854775807, -9223372036854775808, 18446744073709551615, 18446744073709551616]");
+
+			// Assert
+			Assert::IsTrue(root[0].isInt());
+			Assert::AreEqual(static_cast<Json::Int64>(-1), root[1].asInt64());
+			Assert::AreEqual(numeric_limits<Json::Int64>::max(), root[2].asInt64());
+			Assert::AreEqual(numeric_limits<Json::Int64>::min(), root[3].asInt64());
+			Assert::AreEqual(numeric_limits<Json::UInt64>::max(), root[4].asUInt64());
+			Assert::IsTrue(root[5].isDouble());
+			Assert::AreEqual(18446744073709551616.0, root[5].asDouble());
+		}
+
+		TEST_METHOD(WriteAndParse_CommaDecimalLocale_UsesPoint)
+		{
+			// Arrange
+			const char* previous = setlocale(LC_NUMERIC, nullptr);
+			const string saved = previous == nullptr ? "C" : previous;
+			if (setlocale(LC_NUMERIC, "de_DE.UTF-8") == nullptr && setlocale(LC_NUMERIC, "German_Germany.1252") == nullptr)
+			{
+				Logger::WriteMessage("No locale with a comma decimal point is installed; skipping.");
+				return;
+			}
+
+			// Act
+			const string shortest = Json::valueToString(0.5);
+			const string exponent = Json::valueToString(6.02e23);
+			const double parsed = Parse("[1.0000000000000000000000001e-30]")[0].asDouble();
+			setlocale(LC_NUMERIC, saved.c_str());
+
+			// Assert
+			Assert::AreEqual(string("0.5"), shortest);
+			Assert::AreEqual(string("6.02e+23"), exponent);
+			Assert::AreEqual(1e-30, parsed);
+		}
+	};
+}
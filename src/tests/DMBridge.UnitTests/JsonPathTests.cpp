@@ -0,0 +1,254 @@
+/*
+Copyright 2018 Microsoft
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH
+THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#include "stdafx.h"
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+#include "CppUnitTest.h"
+#include "DMBridgeException.h"
+#include "JsonPath.h"
+#include "JsonPushParser.h"
+#include "JsonTokenizer.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace std;
+using namespace Utils;
+
+namespace
+{
+	// Shaped like the output of limpet -enrollmentinfo -json, with names that
+	// need escaping in a pointer and members that look like indexes.
+	const char Document[] =
+		"[ { \"attestation\": { \"type\": \"tpm\", \"tpm\": { \"endorsementKey\": \"AToAAQALAAMAsgAg\" } },\n"
+		"    \"registrationId\": \"c4c5bb05\",\n"
+		"    \"a/b\": { \"~c\": 1 }, \"0\": \"zero\", \"01\": \"leading zero\", \"*\": \"star\",\n"
+		"    \"slots\": [ { \"id\": 1, \"keys\": [ \"k1\", \"k2\" ] }, { \"id\": 2 }, { \"id\": 3, \"keys\": [] } ] },\n"
+		"  { \"registrationId\": \"second\", \"slots\": 7 },\n"
+		"  \"not an object\" ]";
+
+	const char* const Pointers[] = {
+		"", "/0", "/0/attestation/tpm/endorsementKey", "/0/registrationId", "/1/registrationId",
+		"/0/a~1b/~0c", "/0/0", "/0/01", "/0/slots/1/id", "/0/slots/3", "/0/slots/-", "/0/missing/x",
+		"/*/registrationId", "/0/slots/*/id", "/0/slots/*/keys/*", "/*", "/*/*/*", "/2/x", "/0/attestation/type/x",
+	};
+
+	Json::Value Parse(const string& text)
+	{
+		Json::CharReaderBuilder builder;
+		unique_ptr<Json::CharReader> reader(builder.newCharReader());
+		Json::Value root;
+		string errors;
+		Assert::IsTrue(reader->parse(text.data(), text.data() + text.size(), &root, &errors));
+		return root;
+	}
+
+	vector<JsonPath> AllPaths()
+	{
+		vector<JsonPath> paths;
+		for (const char* pointer : Pointers)
+		{
+			paths.emplace_back(pointer);
+		}
+		return paths;
+	}
+
+	// Asserts that the extractor matched what FindAll() finds in the document.
+	// A wildcard over an object matches in document order in one and by
+	// member name in the other, so the order is not compared.
+	void AssertMatchesFindAll(const JsonPathExtractor& extractor, const vector<JsonPath>& paths, const Json::Value& root)
+	{
+		for (size_t path = 0; path < paths.size(); ++path)
+		{
+			vector<const Json::Value*> expected;
+			paths[path].FindAll(root, expected);
+			vector<Json::Value> matches = extractor.Matches(path);
+			Assert::AreEqual(expected.size(), matches.size());
+			for (const Json::Value* value : expected)
+			{
+				auto match = find(matches.begin(), matches.end(), *value);
+				Assert::IsTrue(match != matches.end());
+				matches.erase(match);
+			}
+		}
+	}
+}
+
+namespace DMBridgeUnitTests
+{
+	TEST_CLASS(JsonPathTests)
+	{
+	public:
+		TEST_METHOD(Find_Pointer_FollowsMembersAndElements)
+		{
+			// Arrange
+			const Json::Value root = Parse(Document);
+
+			// Act & Assert
+			Assert::IsTrue(JsonPath("").Find(root) == &root);
+			Assert::AreEqual(string("AToAAQALAAMAsgAg"), JsonPath("/0/attestation/tpm/endorsementKey").Find(root)->asString());
+			Assert::AreEqual(string("second"), JsonPath("/1/registrationId").Find(root)->asString());
+			Assert::AreEqual(1, JsonPath("/0/a~1b/~0c").Find(root)->asInt());
+			Assert::AreEqual(2, JsonPath("/0/slots/1/id").Find(root)->asInt());
+			Assert::AreEqual(string("zero"), JsonPath("/0/0").Find(root)->asString());
+			Assert::AreEqual(string("leading zero"), JsonPath("/0/01").Find(root)->asString());
+		}
+
+		TEST_METHOD(Find_NothingThere_ReturnsNull)
+		{
+			// Arrange
+			const Json::Value root = Parse(Document);
+			const char* const missing[] = {
+				"/3", "/-", "/01", "/0/slots/3", "/0/slots/-", "/0/missing", "/0/missing/x",
+				"/2/x", "/0/attestation/type/x", "/0/registrationId/0", "/0/slots/0/keys/2",
+			};
+
+			// Act & Assert
+			for (const char* pointer : missing)
+			{
+				Assert::IsNull(JsonPath(pointer).Find(root));
+			}
+		}
+
+		TEST_METHOD(Find_Wildcards_ReturnsFirstMatch)
+		{
+			// Arrange
+			const Json::Value root = Parse(Document);
+
+			// Act & Assert
+			Assert::AreEqual(string("c4c5bb05"), JsonPath("/*/registrationId").Find(root)->asString());
+			Assert::AreEqual(string("k1"), JsonPath("/0/slots/*/keys/*").Find(root)->asString());
+			Assert::AreEqual(string("tpm"), JsonPath("/0/*/type").Find(root)->asString());
+			Assert::IsNull(JsonPath("/0/slots/*/missing").Find(root));
+			Assert::IsTrue(JsonPath("/0/*").HasWildcards());
+			Assert::IsFalse(JsonPath("/0/~0").HasWildcards());
+		}
+
+		TEST_METHOD(FindAll_Wildcards_ReturnsEveryMatchInOrder)
+		{
+			// Arrange
+			const Json::Value root = Parse(Document);
+			vector<const Json::Value*> ids;
+			vector<const Json::Value*> keys;
+
+			// Act
+			JsonPath("/0/slots/*/id").FindAll(root, ids);
+			JsonPath("/0/slots/*/keys/*").FindAll(root, keys);
+
+			// Assert
+			Assert::AreEqual(size_t(3), ids.size());
+			for (int i = 0; i < 3; ++i)
+			{
+				Assert::AreEqual(i + 1, ids[i]->asInt());
+			}
+			Assert::AreEqual(size_t(2), keys.size());
+			Assert::AreEqual(string("k2"), keys[1]->asString());
+		}
+
+		TEST_METHOD(Find_NonConstRoot_ValueCanBeChangedInPlace)
+		{
+			// Arrange
+			Json::Value root = Parse(Document);
+			const JsonPath path("/0/slots/2/keys");
+
+			// Act
+			path.Find(root)->append("k3");
+
+			// Assert
+			Assert::AreEqual(string("k3"), root[0]["slots"][2]["keys"][0].asString());
+		}
+
+		TEST_METHOD(Find_NonConstCopy_ChangesOnlyTheCopy)
+		{
+			// Arrange
+			const Json::Value root = Parse(Document);
+			Json::Value copy(root);
+
+			// Act
+			*JsonPath("/0/slots/*/keys/*").Find(copy) = "changed";
+			*JsonPath("/0/attestation/tpm/endorsementKey").Find(copy) = "changed";
+
+			// Assert
+			Assert::IsTrue(Parse(Document) == root);
+			Assert::AreEqual(string("changed"), copy[0]["slots"][0]["keys"][0].asString());
+			Assert::AreEqual(string("changed"), copy[0]["attestation"]["tpm"]["endorsementKey"].asString());
+			Assert::IsNull(JsonPath("/0/slots/*/missing").Find(copy));
+		}
+
+		TEST_METHOD(Compile_NotAPointer_Throws)
+		{
+			const char* const malformed[] = { "a", "a/b", "/~", "/a~2", "/~a/b" };
+			for (const char* pointer : malformed)
+			{
+				Assert::ExpectException<DMBridgeExceptionWithErrorCode>([pointer]() { JsonPath path(pointer); });
+			}
+		}
+
+		TEST_METHOD(Extract_Buffer_MatchesFindAll)
+		{
+			// Arrange
+			const string text = Document;
+			const vector<JsonPath> paths = AllPaths();
+			JsonPathExtractor extractor(paths);
+
+			// Act
+			extractor.Extract(text.data(), text.data() + text.size());
+
+			// Assert
+			AssertMatchesFindAll(extractor, paths, Parse(text));
+			Assert::AreEqual(string("c4c5bb05"), extractor.Find(3)->asString());
+			Assert::IsNull(extractor.Find(9));
+		}
+
+		TEST_METHOD(Extract_PushParserAnyPieceSize_MatchesFindAll)
+		{
+			// Arrange
+			const string text = Document;
+			const vector<JsonPath> paths = AllPaths();
+			const Json::Value root = Parse(text);
+
+			for (size_t pieceSize = 1; pieceSize <= text.size(); pieceSize += 7)
+			{
+				JsonPathExtractor extractor(paths);
+				JsonPushParser parser(extractor);
+
+				// Act
+				for (size_t offset = 0; offset < text.size(); offset += pieceSize)
+				{
+					parser.Feed(text.data() + offset, min(pieceSize, text.size() - offset));
+				}
+				parser.Finish();
+
+				// Assert
+				AssertMatchesFindAll(extractor, paths, root);
+			}
+		}
+
+		TEST_METHOD(Extract_NoPaths_ReadsWholeDocument)
+		{
+			// Arrange
+			const string valid = Document;
+			const string truncated = valid.substr(0, valid.size() - 1);
+			JsonPathExtractor extractor({});
+			JsonPathExtractor truncatedExtractor({ JsonPath("/9") });
+
+			// Act & Assert
+			extractor.Extract(valid.data(), valid.data() + valid.size());
+			Assert::ExpectException<JsonSyntaxError>([&]() { truncatedExtractor.Extract(truncated.data(), truncated.data() + truncated.size()); });
+		}
+	};
+}
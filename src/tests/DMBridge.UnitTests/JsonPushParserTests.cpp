@@ -0,0 +1,260 @@
+/*
+Copyright 2018 Microsoft
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH
+THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#include "stdafx.h"
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+#include "CppUnitTest.h"
+#include "JsonPushParser.h"
+#include "JsonTokenizer.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace std;
+using namespace Utils;
+
+namespace
+{
+	// Comments, escapes split across pieces, numbers at the integer limits
+	// and a repeated key; everything the parser keeps between pieces.
+	const char Document[] =
+		"// config\n"
+		"{\n"
+		"\t\"name\": \"a\\\"b\\\\c\\n\\u00e9\\ud83d\\ude00\", /* block * comment */\n"
+		"\t\"numbers\": [ 0, -0, 7, -12, 2147483647, 2147483648, 9223372036854775807, -9223372036854775808,\n"
+		"\t\t18446744073709551615, 18446744073709551616, 1.5, -2.5e-3, 6.02E+23, 1e400 ],\n"
+		"\t\"flags\": [ true, false, null ],\n"
+		"\t\"empty\": [ {}, [] ],\n"
+		"\t\"name\": \"last\"\n"
+		"}\n";
+
+	Json::Value ParseWithReader(const string& text)
+	{
+		Json::CharReaderBuilder builder;
+		unique_ptr<Json::CharReader> reader(builder.newCharReader());
+		Json::Value root;
+		string errors;
+		Assert::IsTrue(reader->parse(text.data(), text.data() + text.size(), &root, &errors));
+		return root;
+	}
+
+	// Feeds the text in pieces of 'pieceSize' bytes.
+	Json::Value ParseInPieces(const string& text, size_t pieceSize)
+	{
+		JsonValueBuilder builder;
+		JsonPushParser parser(builder);
+		for (size_t offset = 0; offset < text.size(); offset += pieceSize)
+		{
+			parser.Feed(text.data() + offset, min(pieceSize, text.size() - offset));
+		}
+		parser.Finish();
+		return builder.Root();
+	}
+
+	JsonSyntaxError ParseError(const string& text, size_t pieceSize)
+	{
+		try
+		{
+			ParseInPieces(text, pieceSize);
+		}
+		catch (const JsonSyntaxError& e)
+		{
+			return e;
+		}
+		Assert::Fail(L"No JsonSyntaxError was thrown.");
+		return JsonSyntaxError("", 0, 0, 0);
+	}
+
+	class TokenRecorder : public IJsonHandler
+	{
+	public:
+		void OnToken(JsonToken token, const string& text) override
+		{
+			tokens.push_back(make_pair(token, text));
+		}
+
+		vector<pair<JsonToken, string>> tokens;
+	};
+}
+
+namespace DMBridgeUnitTests
+{
+	TEST_CLASS(JsonPushParserTests)
+	{
+	public:
+		TEST_METHOD(Feed_AnyPieceSize_BuildsWhatTheReaderBuilds)
+		{
+			// Arrange
+			const string text = Document;
+			const Json::Value expected = ParseWithReader(text);
+
+			for (size_t pieceSize = 1; pieceSize <= text.size(); ++pieceSize)
+			{
+				// Act
+				Json::Value root = ParseInPieces(text, pieceSize);
+
+				// Assert
+				Assert::IsTrue(expected == root);
+			}
+		}
+
+		TEST_METHOD(Feed_SplitAnywhere_BuildsWhatTheReaderBuilds)
+		{
+			// Arrange
+			const string text = Document;
+			const Json::Value expected = ParseWithReader(text);
+
+			for (size_t split = 0; split <= text.size(); ++split)
+			{
+				JsonValueBuilder builder;
+				JsonPushParser parser(builder);
+
+				// Act
+				parser.Feed(text.data(), split);
+				parser.Feed(text.data() + split, text.size() - split);
+				parser.Finish();
+
+				// Assert
+				Assert::IsTrue(expected == builder.Root());
+			}
+		}
+
+		TEST_METHOD(Feed_Tokens_MatchTheTokenizer)
+		{
+			// Arrange
+			const string text = Document;
+			JsonTokenizer tokenizer(text.data(), text.data() + text.size());
+			vector<pair<JsonToken, string>> expected;
+			for (JsonToken token = tokenizer.Next(); token != JsonToken::End; token = tokenizer.Next())
+			{
+				bool hasText = token == JsonToken::Key || token == JsonToken::String || token == JsonToken::Number;
+				expected.push_back(make_pair(token, hasText ? tokenizer.Text() : string()));
+			}
+			TokenRecorder recorder;
+			JsonPushParser parser(recorder);
+
+			// Act
+			for (char c : text)
+			{
+				parser.Feed(&c, 1);
+			}
+			parser.Finish();
+
+			// Assert
+			Assert::IsTrue(expected == recorder.tokens);
+		}
+
+		TEST_METHOD(Feed_NumberAtTheEnd_IsReportedByFinish)
+		{
+			// Arrange
+			TokenRecorder recorder;
+			JsonPushParser parser(recorder);
+
+			// Act
+			parser.Feed("12", 2);
+			size_t beforeFinish = recorder.tokens.size();
+			parser.Feed("34", 2);
+			parser.Finish();
+
+			// Assert
+			Assert::AreEqual(size_t(0), beforeFinish);
+			Assert::AreEqual(size_t(1), recorder.tokens.size());
+			Assert::AreEqual(string("1234"), recorder.tokens[0].second);
+			Assert::IsTrue(parser.IsDone());
+		}
+
+		TEST_METHOD(Feed_AfterRoot_IgnoresTheRest)
+		{
+			// Arrange
+			TokenRecorder recorder;
+			JsonPushParser parser(recorder);
+
+			// Act
+			parser.Feed("[1] ", 4);
+			parser.Feed("not json", 8);
+			parser.Finish();
+
+			// Assert
+			Assert::IsTrue(parser.IsDone());
+			Assert::AreEqual(size_t(3), recorder.tokens.size());
+		}
+
+		TEST_METHOD(Feed_Malformed_ReportsLineAndColumn)
+		{
+			for (size_t pieceSize : { size_t(1), size_t(3), size_t(64) })
+			{
+				// Act
+				JsonSyntaxError missingColon = ParseError("{\n  \"a\" 1\n}", pieceSize);
+				JsonSyntaxError trailingComma = ParseError("[ 1,\n\t]", pieceSize);
+				JsonSyntaxError badLiteral = ParseError("{ \"a\": tru }", pieceSize);
+				JsonSyntaxError badEscape = ParseError("[\"ab\\x\"]", pieceSize);
+				JsonSyntaxError badNumber = ParseError("[ 1.e5 ]", pieceSize);
+
+				// Assert
+				Assert::AreEqual(size_t(2), missingColon.Line());
+				Assert::AreEqual(size_t(7), missingColon.Column());
+				Assert::AreEqual(size_t(2), trailingComma.Line());
+				Assert::AreEqual(size_t(2), trailingComma.Column());
+				Assert::AreEqual(size_t(1), badLiteral.Line());
+				Assert::AreEqual(size_t(8), badLiteral.Column());
+				Assert::AreEqual(size_t(6), badEscape.Column());
+				Assert::AreEqual(size_t(5), badNumber.Column());
+			}
+		}
+
+		TEST_METHOD(Finish_Incomplete_Throws)
+		{
+			const char* incomplete[] = {
+				"",
+				"  // only a comment",
+				"{ \"a\": 1",
+				"{ \"a\"",
+				"[ \"abc",
+				"[ \"\\u12",
+				"[ \"\\ud83d",
+				"[ 1e",
+				"-",
+				"[ nul",
+				"[ 1 /* open",
+			};
+
+			for (const char* text : incomplete)
+			{
+				// Act
+				JsonSyntaxError error = ParseError(text, 1);
+
+				// Assert
+				Assert::AreEqual(size_t(1), error.Line());
+			}
+		}
+
+		TEST_METHOD(Feed_DeepNesting_StopsAtTheLimit)
+		{
+			// Arrange
+			const string withinLimit = string(JsonPushParser::MaxDepth, '[') + string(JsonPushParser::MaxDepth, ']');
+			const string tooDeep = string(JsonPushParser::MaxDepth + 1, '[');
+
+			// Act
+			Json::Value root = ParseInPieces(withinLimit, 7);
+			JsonSyntaxError error = ParseError(tooDeep, 7);
+
+			// Assert
+			Assert::IsTrue(root.isArray());
+			Assert::AreEqual(size_t(JsonPushParser::MaxDepth + 1), error.Column());
+		}
+	};
+}
@@ -0,0 +1,478 @@
+/*
+Copyright 2018 Microsoft
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH
+THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#include "stdafx.h"
+#include <memory>
+#include <random>
+#include <string>
+#include "CppUnitTest.h"
+#include "json/json.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace std;
+
+namespace
+{
+	// The reader scans whitespace and strings 16 or 32 bytes at a time, so
+	// these tests move the interesting character across both block sizes.
+	const size_t MaxOffset = 70;
+
+	bool TryParse(const string& text, Json::Value& root)
+	{
+		Json::CharReaderBuilder builder;
+		unique_ptr<Json::CharReader> reader(builder.newCharReader());
+		string errors;
+		return reader->parse(text.data(), text.data() + text.size(), &root, &errors);
+	}
+
+	// Everything a parse produced, with the tree flattened to text so that two
+	// parses can be compared, offsets and comments included.
+	struct Outcome
+	{
+		bool parsed;
+		string errors;
+		string tree;
+		string thrown;
+	};
+
+	string Describe(const Json::Value& value)
+	{
+		string text = to_string(value.type()) + "@" + to_string(value.getOffsetStart()) + "-" + to_string(value.getOffsetLimit());
+		for (int placement = 0; placement < Json::numberOfCommentPlacement; ++placement)
+		{
+			if (value.hasComment(static_cast<Json::CommentPlacement>(placement)))
+			{
+				text += " /" + to_string(placement) + value.getComment(static_cast<Json::CommentPlacement>(placement));
+			}
+		}
+		if (value.isObject() || value.isArray())
+		{
+			text += value.isObject() ? "{" : "[";
+			for (Json::Value::const_iterator it = value.begin(); it != value.end(); ++it)
+			{
+				text += it.name() + ":" + Describe(*it) + ",";
+			}
+			return text + (value.isObject() ? "}" : "]");
+		}
+		return text + " " + value.toStyledString();
+	}
+
+	Outcome ParseWith(Json::CharReaderBuilder builder, bool iterative, const string& text)
+	{
+		builder["iterative"] = iterative;
+		unique_ptr<Json::CharReader> reader(builder.newCharReader());
+		Outcome outcome = {};
+		try
+		{
+			Json::Value root;
+			outcome.parsed = reader->parse(text.data(), text.data() + text.size(), &root, &outcome.errors);
+			outcome.tree = Describe(root);
+		}
+		catch (const exception& e)
+		{
+			outcome.thrown = e.what();
+		}
+		return outcome;
+	}
+
+	// Documents both readers are given: mostly well formed, nesting every
+	// kind of value and comment, then sometimes broken in a few places.
+	class DocumentGenerator
+	{
+	public:
+		explicit DocumentGenerator(unsigned seed) : _random(seed) {}
+
+		string Next()
+		{
+			string text;
+			AppendValue(text, 0);
+			int mutations = Pick(4) == 0 ? 0 : Pick(4);
+			for (int i = 0; i < mutations && !text.empty(); ++i)
+			{
+				static const char Noise[] = "{}[],:\"'/*\n 0-.eE5tfnNI";
+				size_t at = Pick(static_cast<int>(text.size()));
+				switch (Pick(3))
+				{
+				case 0:
+					text.erase(at, 1);
+					break;
+				case 1:
+					text.insert(at, 1, Noise[Pick(sizeof(Noise) - 1)]);
+					break;
+				default:
+					text.insert(at, text.substr(Pick(static_cast<int>(text.size())), Pick(8)));
+					break;
+				}
+			}
+			return text;
+		}
+
+	private:
+		int Pick(int count)
+		{
+			return uniform_int_distribution<int>(0, count - 1)(_random);
+		}
+
+		void AppendGap(string& text)
+		{
+			static const char* const Gaps[] = { "", "", "", " ", "\n\t", " /* c */ ", "// c\n", "/*\n*/" };
+			text += Gaps[Pick(sizeof(Gaps) / sizeof(Gaps[0]))];
+		}
+
+		void AppendName(string& text)
+		{
+			static const char* const Names[] = { "\"a\"", "\"b\"", "\"\"", "\"a\"", "\"long member name here\"", "\"\\u00e9\\n\"", "'q'", "7", "-1.5" };
+			text += Names[Pick(sizeof(Names) / sizeof(Names[0]))];
+		}
+
+		void AppendValue(string& text, int depth)
+		{
+			static const char* const Scalars[] = {
+				"0", "-12", "3.25", "1e300", "-0.0", "18446744073709551615", "-9223372036854775808", "1.5e-7",
+				"true", "false", "null", "\"\"", "\"text\"", "\"a string longer than sixteen\"", "\"\\\"\\\\\\/\\b\\f\\u20AC\\ud83d\\ude00\"",
+				"'single'", "NaN", "Infinity", "-Infinity" };
+			AppendGap(text);
+			int kind = depth < 12 ? Pick(5) : 4;
+			if (kind == 0 || kind == 1)
+			{
+				bool object = kind == 0;
+				text += object ? "{" : "[";
+				int members = Pick(5);
+				for (int i = 0; i < members; ++i)
+				{
+					if (i > 0)
+					{
+						text += ",";
+					}
+					if (object)
+					{
+						AppendGap(text);
+						AppendName(text);
+						AppendGap(text);
+						text += ":";
+					}
+					AppendValue(text, depth + 1);
+				}
+				AppendGap(text);
+				text += object ? "}" : "]";
+			}
+			else
+			{
+				text += Scalars[Pick(sizeof(Scalars) / sizeof(Scalars[0]))];
+			}
+			AppendGap(text);
+		}
+
+		mt19937 _random;
+	};
+
+	vector<Json::CharReaderBuilder> Configurations()
+	{
+		vector<Json::CharReaderBuilder> builders(6);
+		Json::CharReaderBuilder::strictMode(&builders[1].settings_);
+		builders[2]["allowDroppedNullPlaceholders"] = true;
+		builders[2]["allowNumericKeys"] = true;
+		builders[2]["allowSingleQuotes"] = true;
+		builders[2]["allowSpecialFloats"] = true;
+		builders[3]["collectComments"] = false;
+		builders[3]["rejectDupKeys"] = true;
+		builders[3]["failIfExtra"] = true;
+		builders[3]["internKeys"] = true;
+		builders[4]["arena"] = true;
+		builders[4]["allowNumericKeys"] = true;
+		builders[5]["stackLimit"] = 4;
+		return builders;
+	}
+
+	// The member of the object is at depth + 2.
+	string Nested(size_t depth)
+	{
+		return string(depth, '[') + "{\"a\":1}" + string(depth, ']');
+	}
+
+	Json::CharReader* NewInterningReader()
+	{
+		Json::CharReaderBuilder builder;
+		builder["internKeys"] = true;
+		return builder.newCharReader();
+	}
+
+	Json::Value Parse(Json::CharReader& reader, const string& text)
+	{
+		Json::Value root;
+		string errors;
+		Assert::IsTrue(reader.parse(text.data(), text.data() + text.size(), &root, &errors));
+		return root;
+	}
+}
+
+namespace DMBridgeUnitTests
+{
+	TEST_CLASS(JsonReaderTests)
+	{
+	public:
+		TEST_METHOD(Parse_WhitespaceRunsOfAnyLength_SkipsThem)
+		{
+			for (size_t length = 0; length < MaxOffset; ++length)
+			{
+				// Arrange
+				const string padding = string(length, ' ') + string(length % 3, '\t') + string(length % 2, '\n');
+				const string text = padding + "{" + padding + "\"a\"" + padding + ":" + padding + "[1," + padding + "2]" + padding + "}" + padding;
+				Json::Value root;
+
+				// Act
+				bool parsed = TryParse(text, root);
+
+				// Assert
+				Assert::IsTrue(parsed);
+				Assert::AreEqual(2, root["a"][1].asInt());
+			}
+		}
+
+		TEST_METHOD(Parse_EscapeAtAnyOffset_DecodesString)
+		{
+			for (size_t offset = 0; offset < MaxOffset; ++offset)
+			{
+				// Arrange
+				const string prefix(offset, 'x');
+				const string text = "[\"" + prefix + "\\\"q\\\\\\n\\u0041" + prefix + "\"]";
+				Json::Value root;
+
+				// Act
+				bool parsed = TryParse(text, root);
+
+				// Assert
+				Assert::IsTrue(parsed);
+				Assert::AreEqual(prefix + "\"q\\\nA" + prefix, root[0].asString());
+			}
+		}
+
+		TEST_METHOD(Parse_QuoteAtAnyOffset_EndsString)
+		{
+			for (size_t offset = 0; offset < MaxOffset; ++offset)
+			{
+				// Arrange
+				const string value(offset, 'v');
+				const string text = "{\"k\":\"" + value + "\",\"n\":1}";
+				Json::Value root;
+
+				// Act
+				bool parsed = TryParse(text, root);
+
+				// Assert
+				Assert::IsTrue(parsed);
+				Assert::AreEqual(value, root["k"].asString());
+				Assert::AreEqual(1, root["n"].asInt());
+			}
+		}
+
+		TEST_METHOD(Parse_ControlCharacterInString_KeepsIt)
+		{
+			// Arrange
+			const string value = string(40, 'c') + "\t" + string(20, 'c');
+			Json::Value root;
+
+			// Act
+			bool parsed = TryParse("[\"" + value + "\"]", root);
+
+			// Assert
+			Assert::IsTrue(parsed);
+			Assert::AreEqual(value, root[0].asString());
+		}
+
+		TEST_METHOD(Parse_UnterminatedString_Fails)
+		{
+			for (size_t offset = 0; offset < MaxOffset; ++offset)
+			{
+				// Arrange
+				const string text = "[\"" + string(offset, 'u');
+				Json::Value root;
+
+				// Act
+				bool parsed = TryParse(text, root);
+
+				// Assert
+				Assert::IsFalse(parsed);
+			}
+		}
+
+		TEST_METHOD(Parse_Iterative_MatchesRecursiveReader)
+		{
+			// Arrange
+			DocumentGenerator documents(20181019);
+			const vector<Json::CharReaderBuilder> builders = Configurations();
+
+			for (int i = 0; i < 4000; ++i)
+			{
+				const string text = documents.Next();
+				for (const Json::CharReaderBuilder& builder : builders)
+				{
+					// Act
+					Outcome recursive = ParseWith(builder, false, text);
+					Outcome iterative = ParseWith(builder, true, text);
+
+					// Assert
+					Assert::AreEqual(recursive.parsed, iterative.parsed);
+					Assert::AreEqual(recursive.errors, iterative.errors);
+					Assert::AreEqual(recursive.tree, iterative.tree);
+					Assert::AreEqual(recursive.thrown, iterative.thrown);
+				}
+			}
+		}
+
+		TEST_METHOD(Parse_IterativeDeepNesting_ReadsToTheLimit)
+		{
+			// Arrange
+			Json::CharReaderBuilder builder;
+			builder["iterative"] = true;
+			builder["stackLimit"] = 5000;
+			unique_ptr<Json::CharReader> reader(builder.newCharReader());
+			const string deepest = Nested(4998);
+			const string tooDeep = Nested(4999);
+			Json::Value root;
+			string errors;
+
+			// Act
+			bool parsed = reader->parse(deepest.data(), deepest.data() + deepest.size(), &root, &errors);
+
+			// Assert
+			Assert::IsTrue(parsed);
+			const Json::Value* value = &root;
+			for (int depth = 0; depth < 4998; ++depth)
+			{
+				value = &(*value)[0];
+			}
+			Assert::AreEqual(1, (*value)["a"].asInt());
+			Assert::ExpectException<Json::RuntimeError>([&]()
+			{
+				reader->parse(tooDeep.data(), tooDeep.data() + tooDeep.size(), &root, &errors);
+			});
+		}
+
+		TEST_METHOD(Parse_InternKeys_MatchesPlainReader)
+		{
+			// Arrange
+			DocumentGenerator documents(20181101);
+			Json::CharReaderBuilder plain;
+			Json::CharReaderBuilder interning;
+			interning["internKeys"] = true;
+			unique_ptr<Json::CharReader> reader(interning.newCharReader());
+			Json::Value previous;
+			Json::Value plainPrevious;
+
+			for (int i = 0; i < 2000; ++i)
+			{
+				const string text = documents.Next();
+				Outcome expected = ParseWith(plain, false, text);
+				Outcome actual = {};
+				Json::Value root;
+
+				// Act
+				try
+				{
+					actual.parsed = reader->parse(text.data(), text.data() + text.size(), &root, &actual.errors);
+					actual.tree = Describe(root);
+				}
+				catch (const exception& e)
+				{
+					actual.thrown = e.what();
+				}
+
+				// Assert
+				Assert::AreEqual(expected.parsed, actual.parsed);
+				Assert::AreEqual(expected.errors, actual.errors);
+				Assert::AreEqual(expected.tree, actual.tree);
+				Assert::AreEqual(expected.thrown, actual.thrown);
+				if (actual.parsed)
+				{
+					Json::Value plainRoot;
+					TryParse(text, plainRoot);
+					Assert::AreEqual(plainPrevious == plainRoot, previous == root);
+					previous = root;
+					plainPrevious = plainRoot;
+				}
+			}
+		}
+
+		TEST_METHOD(Parse_InternKeys_SharesNamesAcrossDocuments)
+		{
+			// Arrange
+			unique_ptr<Json::CharReader> reader(NewInterningReader());
+			unique_ptr<Json::CharReader> other(NewInterningReader());
+			const string text = "{\"registrationId\":\"a\",\"endorsementKey\":\"b\"}";
+			const char* end = nullptr;
+
+			// Act
+			Json::Value first = Parse(*reader, text);
+			Json::Value second = Parse(*reader, "[" + text + "]")[0];
+			Json::Value elsewhere = Parse(*other, text);
+			Json::Value renamed = Parse(*reader, "{\"registrationId\":\"a\",\"endorsementKeys\":\"b\"}");
+			reader.reset();
+			other.reset();
+
+			// Assert
+			Assert::IsTrue(first.begin().memberName(&end) == second.begin().memberName(&end));
+			Assert::IsFalse(first.begin().memberName(&end) == elsewhere.begin().memberName(&end));
+			Assert::IsTrue(first == second);
+			Assert::IsTrue(first == elsewhere);
+			Assert::IsFalse(first == renamed);
+			Assert::AreEqual(string("endorsementKey"), first.begin().name());
+			Assert::AreEqual(string("a"), second["registrationId"].asString());
+		}
+
+		TEST_METHOD(Parse_InternKeys_CopiesAndChangesOutliveReader)
+		{
+			// Arrange
+			unique_ptr<Json::CharReader> reader(NewInterningReader());
+			Json::Value root = Parse(*reader, "{\"metric\":[{\"name\":\"cpu\",\"value\":1},{\"name\":\"ram\",\"value\":2}]}");
+			reader.reset();
+			Json::Value expected;
+			Assert::IsTrue(TryParse("{\"metric\":[{\"value\":1},{\"name\":\"ram\",\"value\":3}]}", expected));
+
+			// Act
+			Json::Value copy = root;
+			copy["metric"][1]["value"] = 3;
+			copy["metric"][0].removeMember("name");
+			root = Json::Value();
+
+			// Assert
+			Assert::IsTrue(copy == expected);
+		}
+
+		TEST_METHOD(Parse_InternKeys_ManyOrLongNames_KeepsThemAll)
+		{
+			// Arrange
+			unique_ptr<Json::CharReader> reader(NewInterningReader());
+			string text = "{";
+			for (int i = 0; i < 6000; ++i)
+			{
+				text += "\"" + string(i % 300, 'k') + to_string(i) + "\":" + to_string(i) + ",";
+			}
+			text.back() = '}';
+			Json::Value expected;
+			Assert::IsTrue(TryParse(text, expected));
+
+			// Act
+			Json::Value root = Parse(*reader, text);
+			Json::Value again = Parse(*reader, text);
+
+			// Assert
+			Assert::IsTrue(expected == root);
+			Assert::IsTrue(root == again);
+			Assert::AreEqual(5999, root[string(299, 'k') + "5999"].asInt());
+		}
+	};
+}
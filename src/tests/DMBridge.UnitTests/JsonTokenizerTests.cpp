@@ -0,0 +1,320 @@
+/*
+Copyright 2018 Microsoft
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH
+THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "stdafx.h"
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+#include "CppUnitTest.h"
+#include "JsonTokenizer.h"
+#include "json/json.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace std;
+using namespace Utils;
+
+namespace
+{
+	vector<JsonToken> Tokenize(const string& text, JsonSyntax syntax = JsonSyntax::Lenient)
+	{
+		JsonTokenizer tokenizer(text.data(), text.data() + text.size(), syntax);
+		vector<JsonToken> tokens;
+		for (JsonToken token = tokenizer.Next(); token != JsonToken::End; token = tokenizer.Next())
+		{
+			tokens.push_back(token);
+		}
+		return tokens;
+	}
+
+	JsonSyntaxError TokenizeError(const string& text, JsonSyntax syntax = JsonSyntax::Lenient)
+	{
+		try
+		{
+			Tokenize(text, syntax);
+		}
+		catch (const JsonSyntaxError& e)
+		{
+			return e;
+		}
+		Assert::Fail(L"No JsonSyntaxError was thrown.");
+		return JsonSyntaxError("", 0, 0, 0);
+	}
+
+	vector<JsonDiagnostic> Validate(const string& text, JsonSyntax syntax = JsonSyntax::Lenient)
+	{
+		return ValidateJson(text.data(), text.data() + text.size(), syntax);
+	}
+
+	string FirstString(const string& text)
+	{
+		JsonTokenizer tokenizer(text.data(), text.data() + text.size());
+		tokenizer.Next();
+		return tokenizer.Text();
+	}
+}
+
+namespace DMBridgeUnitTests
+{
+	TEST_CLASS(JsonTokenizerTests)
+	{
+	public:
+		TEST_METHOD(Next_Document_ReturnsTokensInOrder)
+		{
+			// Act
+			vector<JsonToken> tokens = Tokenize("{ \"a\": [ 1, \"x\", true, false, null ], \"b\": {} }");
+
+			// Assert
+			vector<JsonToken> expected = {
+				JsonToken::BeginObject,
+				JsonToken::Key, JsonToken::BeginArray,
+				JsonToken::Number, JsonToken::String, JsonToken::True, JsonToken::False, JsonToken::Null,
+				JsonToken::EndArray,
+				JsonToken::Key, JsonToken::BeginObject, JsonToken::EndObject,
+				JsonToken::EndObject,
+			};
+			Assert::IsTrue(expected == tokens);
+		}
+
+		TEST_METHOD(Next_Scalars_HaveText)
+		{
+			// Arrange
+			string text = "[ \"key\", -12.5e+3 ]";
+			JsonTokenizer tokenizer(text.data(), text.data() + text.size());
+
+			// Act
+			tokenizer.Next();
+			tokenizer.Next();
+			string str = tokenizer.Text();
+			tokenizer.Next();
+			string number = tokenizer.Text();
+
+			// Assert
+			Assert::AreEqual(string("key"), str);
+			Assert::AreEqual(string("-12.5e+3"), number);
+		}
+
+		TEST_METHOD(Next_Escapes_AreDecoded)
+		{
+			// Assert
+			Assert::AreEqual(string("a\"b\\c/d\b\f\n\r\t"), FirstString("\"a\\\"b\\\\c\\/d\\b\\f\\n\\r\\t\""));
+			Assert::AreEqual(string("\xC3\xA9\xE2\x82\xAC"), FirstString("\"\\u00e9\\u20AC\""));
+			Assert::AreEqual(string("\xF0\x9F\x98\x80"), FirstString("\"\\ud83d\\ude00\""));
+		}
+
+		TEST_METHOD(Next_Comments_AreSkipped)
+		{
+			// Act
+			vector<JsonToken> tokens = Tokenize("// settings\n{ /* none */ }");
+
+			// Assert
+			Assert::AreEqual(size_t(2), tokens.size());
+		}
+
+		TEST_METHOD(Next_AfterRoot_IgnoresTheRest)
+		{
+			// Act
+			vector<JsonToken> tokens = Tokenize("{} not json");
+
+			// Assert
+			Assert::AreEqual(size_t(2), tokens.size());
+		}
+
+		TEST_METHOD(Next_Malformed_ReportsLineAndColumn)
+		{
+			// Act
+			JsonSyntaxError missingColon = TokenizeError("{\n  \"a\" 1\n}");
+			JsonSyntaxError trailingComma = TokenizeError("[ 1,\n\t]");
+			JsonSyntaxError badLiteral = TokenizeError("{ \"a\": tru }");
+			JsonSyntaxError unterminated = TokenizeError("[\n\"abc");
+
+			// Assert
+			Assert::AreEqual(size_t(2), missingColon.Line());
+			Assert::AreEqual(size_t(7), missingColon.Column());
+			Assert::AreEqual(size_t(2), trailingComma.Line());
+			Assert::AreEqual(size_t(2), trailingComma.Column());
+			Assert::AreEqual(size_t(1), badLiteral.Line());
+			Assert::AreEqual(size_t(8), badLiteral.Column());
+			Assert::AreEqual(size_t(2), unterminated.Line());
+			Assert::AreEqual(size_t(1), unterminated.Column());
+			Assert::AreEqual(size_t(8), missingColon.Offset());
+			Assert::AreEqual(size_t(6), trailingComma.Offset());
+			Assert::AreEqual(string("Line 2, Column 7: Expected ':' after a member name"), string(missingColon.what()));
+		}
+
+		TEST_METHOD(Next_Malformed_Throws)
+		{
+			// Assert
+			for (const string text : { "", "{", "[1 2]", "{\"a\":1,}", "{1:2}", "-", "1.", "\"\\x\"", "\"\\ud83d\"", "/* open" })
+			{
+				wstring message(text.begin(), text.end());
+				Assert::ExpectException<JsonSyntaxError>([&text]() { Tokenize(text); }, message.c_str());
+			}
+		}
+
+		TEST_METHOD(Next_MalformedNumbers_ThrowWhereTheReaderReadsThem)
+		{
+			// Arrange
+			Json::CharReaderBuilder builder;
+			unique_ptr<Json::CharReader> reader(builder.newCharReader());
+
+			// Assert
+			for (const string text : { "-", "[-]", "{\"a\":-}", "[-,1]", "1.", "[1.,2]", "1e", "1e+", "[-1.e-]" })
+			{
+				wstring message(text.begin(), text.end());
+				Json::Value root;
+				string errors;
+				Assert::IsTrue(reader->parse(text.data(), text.data() + text.size(), &root, &errors), message.c_str());
+				Assert::ExpectException<JsonSyntaxError>([&text]() { Tokenize(text); }, message.c_str());
+				Assert::AreEqual(size_t(1), Validate(text).size(), message.c_str());
+			}
+			Assert::AreEqual(string("Expected a digit in a number"), Validate("{\"a\":-}")[0].message);
+		}
+
+		TEST_METHOD(Next_Strict_RejectsWhatLenientSkips)
+		{
+			// Assert
+			for (const string text : { "// c\n{}", "{ /* c */ }", "{} not json", "{\"a\":1,\"a\":2}", "[{\"b\":{},\"c\":1,\"b\":[]}]" })
+			{
+				wstring message(text.begin(), text.end());
+				Assert::ExpectException<JsonSyntaxError>([&text]() { Tokenize(text, JsonSyntax::Strict); }, message.c_str());
+				Assert::AreEqual(size_t(0), Validate(text).size(), message.c_str());
+			}
+			Assert::AreEqual(size_t(16), Tokenize("{\"a\":{\"a\":1,\"b\":2},\"b\":[{\"a\":3}]}", JsonSyntax::Strict).size());
+		}
+
+		TEST_METHOD(Next_StrictRepeatedName_ReportsTheRepeat)
+		{
+			// Act
+			JsonSyntaxError e = TokenizeError("{\n  \"a\": 1,\n  \"b\": 2,\n  \"a\": 3\n}", JsonSyntax::Strict);
+
+			// Assert
+			Assert::AreEqual(size_t(4), e.Line());
+			Assert::AreEqual(size_t(3), e.Column());
+			Assert::AreEqual(size_t(24), e.Offset());
+			Assert::AreEqual(string("Duplicate member name 'a'"), e.Message());
+		}
+
+		TEST_METHOD(ValidateJson_SeveralErrors_ReportsEachOnceInOrder)
+		{
+			// Arrange
+			const string text =
+				"{\n"
+				"  \"api\": [ \"tpm\", , \"metrics\" ],\n"
+				"  \"servicemanager\": { \"whitelist\": [ \"w32time\" ] \"x\": \"}\" },\n"
+				"  \"bad\": tru,\n"
+				"  \"ok\": 1\n"
+				"}";
+
+			// Act
+			vector<JsonDiagnostic> diagnostics = Validate(text);
+
+			// Assert
+			Assert::AreEqual(size_t(3), diagnostics.size());
+			Assert::AreEqual(string("Line 2, Column 19, Offset 20: Expected a value"), diagnostics[0].ToString());
+			Assert::AreEqual(string("Line 3, Column 50, Offset 84: Expected ',' or '}' after an object member"), diagnostics[1].ToString());
+			Assert::AreEqual(string("Line 4, Column 10, Offset 105: Expected a value"), diagnostics[2].ToString());
+		}
+
+		TEST_METHOD(ValidateJson_StrictRepeatedNames_ReportsEveryRepeat)
+		{
+			// Act
+			vector<JsonDiagnostic> diagnostics = Validate("{\"a\":1,\"b\":2,\"a\":3,\"b\":[/**/],\"a\":5} x", JsonSyntax::Strict);
+
+			// Assert
+			vector<size_t> offsets;
+			for (const JsonDiagnostic& diagnostic : diagnostics)
+			{
+				offsets.push_back(diagnostic.offset);
+			}
+			Assert::IsTrue(vector<size_t>({ 13, 19, 24, 30, 37 }) == offsets);
+			Assert::AreEqual(string("Duplicate member name 'b'"), diagnostics[1].message);
+			Assert::AreEqual(string("Comments are not allowed"), diagnostics[2].message);
+			Assert::AreEqual(string("Expected nothing after the root value"), diagnostics[4].message);
+		}
+
+		TEST_METHOD(ValidateJson_DamagedDocuments_FirstErrorMatchesTokenizer)
+		{
+			// Arrange
+			const string valid =
+				"// config\n{ \"api\": [ \"tpm\", \"metrics\" ], \"servicemanager\": { \"whitelist\": [ \"w32time\", \"a\\\"b\" ] },\n"
+				"  \"limits\": [ 1, -2.5e3, true, false, null, {}, [[]] ] /* end */ }";
+			mt19937 random(20181101);
+			static const char Noise[] = "{}[],:\"\\/*\n 0-.etfnu";
+			Assert::AreEqual(size_t(0), Validate(valid).size());
+
+			for (int i = 0; i < 5000; ++i)
+			{
+				string text = valid;
+				for (int damage = uniform_int_distribution<int>(1, 4)(random); damage > 0; --damage)
+				{
+					size_t at = uniform_int_distribution<size_t>(0, text.size() - 1)(random);
+					if (random() % 2 == 0)
+					{
+						text.erase(at, 1 + random() % 3);
+					}
+					else
+					{
+						text.insert(at, 1, Noise[random() % (sizeof(Noise) - 1)]);
+					}
+				}
+
+				// Act
+				vector<JsonDiagnostic> diagnostics = Validate(text);
+
+				// Assert
+				bool thrown = false;
+				try
+				{
+					Tokenize(text);
+				}
+				catch (const JsonSyntaxError& e)
+				{
+					thrown = true;
+					Assert::IsFalse(diagnostics.empty());
+					Assert::AreEqual(e.Offset(), diagnostics[0].offset);
+					Assert::AreEqual(e.Message(), diagnostics[0].message);
+				}
+				Assert::AreEqual(thrown, !diagnostics.empty());
+			}
+		}
+
+		TEST_METHOD(Next_TooDeep_Throws)
+		{
+			// Arrange
+			string deep(JsonTokenizer::MaxDepth + 1, '[');
+
+			// Assert
+			Assert::ExpectException<JsonSyntaxError>([&deep]() { Tokenize(deep); });
+		}
+
+		TEST_METHOD(SkipValue_Container_SkipsToItsEnd)
+		{
+			// Arrange
+			string text = "{ \"skip\": { \"a\": [ [], {}, \"]\" ] }, \"keep\": 1 }";
+			JsonTokenizer tokenizer(text.data(), text.data() + text.size());
+			tokenizer.Next();
+			tokenizer.Next();
+
+			// Act
+			tokenizer.SkipValue(tokenizer.Next());
+			JsonToken next = tokenizer.Next();
+
+			// Assert
+			Assert::IsTrue(next == JsonToken::Key);
+			Assert::AreEqual(string("keep"), tokenizer.Text());
+		}
+	};
+}
@@ -0,0 +1,463 @@
+/*
+Copyright 2018 Microsoft
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH
+THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#include "stdafx.h"
+#include <memory>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "CppUnitTest.h"
+#include "json/json.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace std;
+
+namespace
+{
+	// Json::Value keeps strings and member names of up to 15 characters inline.
+	const string ShortText(15, 's');
+	const string LongText(16, 'l');
+
+	Json::Value Parse(const string& text, bool arena)
+	{
+		Json::CharReaderBuilder builder;
+		builder["arena"] = arena;
+		unique_ptr<Json::CharReader> reader(builder.newCharReader());
+		Json::Value root;
+		string errors;
+		Assert::IsTrue(reader->parse(text.data(), text.data() + text.size(), &root, &errors));
+		return root;
+	}
+
+	const string ArenaDocument =
+		"{\"" + LongText + "\":[\"" + ShortText + "\",\"" + LongText + "\",{\"n\":1}],\"s\":\"" + LongText + "\",\"b\":true}";
+
+	// Wide enough to get a member index once it has been looked up in.
+	const int WideMembers = 100;
+
+	string MemberName(int i)
+	{
+		// Half of the names are kept inline and half on the heap.
+		return (i % 2 ? LongText : string("m")) + to_string(i);
+	}
+
+	Json::Value WideObject()
+	{
+		Json::Value object(Json::objectValue);
+		for (int i = 0; i < WideMembers; ++i)
+		{
+			object[MemberName(i)] = i;
+		}
+		return object;
+	}
+
+	// Looks up every member name enough times for the index to be built.
+	void LookUpAll(const Json::Value& object)
+	{
+		for (int pass = 0; pass < 2; ++pass)
+		{
+			for (int i = 0; i <= WideMembers; ++i)
+			{
+				const string name = MemberName(i);
+				object.find(name.data(), name.data() + name.size());
+			}
+		}
+	}
+}
+
+namespace DMBridgeUnitTests
+{
+	TEST_CLASS(JsonValueTests)
+	{
+	public:
+		TEST_METHOD(AsString_InlineAndHeapStrings_ReturnsText)
+		{
+			// Arrange
+			Json::Value empty("");
+			Json::Value shortValue(ShortText);
+			Json::Value longValue(LongText);
+
+			// Act & Assert
+			Assert::AreEqual(string(), empty.asString());
+			Assert::AreEqual(ShortText, shortValue.asString());
+			Assert::AreEqual(LongText, longValue.asString());
+			Assert::AreEqual(ShortText, string(shortValue.asCString()));
+		}
+
+		TEST_METHOD(AsString_InlineStringWithNul_KeepsLength)
+		{
+			// Arrange
+			const string text("a\0b", 3);
+
+			// Act
+			Json::Value value(text);
+
+			// Assert
+			Assert::AreEqual(text, value.asString());
+		}
+
+		TEST_METHOD(CopyAndMove_InlineString_KeepsText)
+		{
+			// Arrange
+			Json::Value original(ShortText);
+
+			// Act
+			Json::Value copy(original);
+			Json::Value moved(move(original));
+			Json::Value assigned;
+			assigned = copy;
+
+			// Assert
+			Assert::AreEqual(ShortText, copy.asString());
+			Assert::AreEqual(ShortText, moved.asString());
+			Assert::AreEqual(ShortText, assigned.asString());
+			Assert::IsTrue(original.isNull());
+		}
+
+		TEST_METHOD(Swap_InlineAndHeapStrings_ExchangesText)
+		{
+			// Arrange
+			Json::Value shortValue(ShortText);
+			Json::Value longValue(LongText);
+
+			// Act
+			shortValue.swap(longValue);
+
+			// Assert
+			Assert::AreEqual(LongText, shortValue.asString());
+			Assert::AreEqual(ShortText, longValue.asString());
+		}
+
+		TEST_METHOD(Compare_InlineAndHeapStrings_OrdersByText)
+		{
+			// Arrange
+			Json::Value a(string(15, 'a'));
+			Json::Value b(string(16, 'a'));
+			Json::Value c("b");
+
+			// Act & Assert
+			Assert::IsTrue(a < b);
+			Assert::IsTrue(b < c);
+			Assert::IsTrue(a == Json::Value(string(15, 'a')));
+			Assert::IsFalse(a == b);
+		}
+
+		TEST_METHOD(Members_InlineAndHeapKeys_SurviveCopies)
+		{
+			// Arrange
+			Json::Value root(Json::objectValue);
+			root[ShortText] = 1;
+			root[LongText] = 2;
+			root[""] = 3;
+
+			// Act
+			Json::Value copy(root);
+			Json::Value moved(move(root));
+
+			// Assert
+			for (const Json::Value* value : { &copy, &moved })
+			{
+				Assert::AreEqual(3u, value->size());
+				Assert::AreEqual(1, (*value)[ShortText].asInt());
+				Assert::AreEqual(2, (*value)[LongText].asInt());
+				Assert::AreEqual(3, (*value)[""].asInt());
+			}
+			Assert::IsTrue(copy == moved);
+			Json::Value::Members names = copy.getMemberNames();
+			Assert::AreEqual(string(), names[0]);
+			Assert::AreEqual(LongText, names[1]);
+			Assert::AreEqual(ShortText, names[2]);
+		}
+
+		TEST_METHOD(Parse_Document_KeepsMemberReferencesAcrossInserts)
+		{
+			// Arrange
+			const string text = "{\"name\":\"" + ShortText + "\",\"description\":\"" + LongText + "\",\"list\":[\"x\",\"y\"]}";
+			Json::Value root = Parse(text, false);
+
+			// Act
+			const Json::Value& name = root["name"];
+			for (int i = 0; i < 100; ++i)
+			{
+				root["member" + to_string(i)] = i;
+			}
+
+			// Assert
+			Assert::AreEqual(ShortText, name.asString());
+			Assert::AreEqual(LongText, root["description"].asString());
+			Assert::AreEqual(string("y"), root["list"][1].asString());
+		}
+
+		TEST_METHOD(Parse_Arena_MatchesHeapParse)
+		{
+			// Act
+			Json::Value arena = Parse(ArenaDocument, true);
+			Json::Value heap = Parse(ArenaDocument, false);
+
+			// Assert
+			Assert::IsTrue(arena == heap);
+			Assert::AreEqual(LongText, arena[LongText][1].asString());
+			Assert::AreEqual(1, arena[LongText][2]["n"].asInt());
+		}
+
+		TEST_METHOD(Parse_Arena_CopiesOutliveDocument)
+		{
+			// Arrange
+			Json::Value list;
+			Json::Value text;
+
+			// Act
+			{
+				Json::Value root = Parse(ArenaDocument, true);
+				list = root[LongText];
+				text = root["s"];
+			}
+
+			// Assert
+			Assert::AreEqual(3u, list.size());
+			Assert::AreEqual(LongText, list[1].asString());
+			Assert::AreEqual(LongText, text.asString());
+		}
+
+		TEST_METHOD(Parse_Arena_RemovedMembersOutliveDocument)
+		{
+			// Arrange
+			Json::Value list;
+			Json::Value text;
+			Json::Value element;
+
+			// Act
+			{
+				Json::Value root = Parse(ArenaDocument, true);
+				Assert::IsTrue(root[LongText].removeIndex(2, &element));
+				Assert::IsTrue(root.removeMember(LongText, &list));
+				Assert::IsTrue(root.removeMember("s", &text));
+				Assert::AreEqual(1u, root.size());
+			}
+
+			// Assert
+			Assert::AreEqual(2u, list.size());
+			Assert::AreEqual(LongText, list[1].asString());
+			Assert::AreEqual(LongText, text.asString());
+			Assert::AreEqual(1, element["n"].asInt());
+		}
+
+		TEST_METHOD(Parse_Arena_DocumentCanBeModified)
+		{
+			// Arrange
+			Json::Value root = Parse(ArenaDocument, true);
+
+			// Act
+			root[LongText + "added"] = LongText;
+			root["s"] = Json::Value(Json::objectValue);
+			root["s"]["inner"] = ShortText;
+			root[LongText].append(LongText);
+			Json::Value moved(move(root));
+
+			// Assert
+			Assert::AreEqual(LongText, moved[LongText + "added"].asString());
+			Assert::AreEqual(ShortText, moved["s"]["inner"].asString());
+			Assert::AreEqual(4u, moved[LongText].size());
+			Assert::IsTrue(root.isNull());
+		}
+
+		TEST_METHOD(Find_WideObject_FindsEveryMemberAndNoOther)
+		{
+			// Arrange
+			const Json::Value object = WideObject();
+			LookUpAll(object);
+
+			// Act & Assert
+			for (int i = 0; i < WideMembers; ++i)
+			{
+				const string name = MemberName(i);
+				const Json::Value* member = object.find(name.data(), name.data() + name.size());
+				Assert::IsNotNull(member);
+				Assert::AreEqual(i, member->asInt());
+				Assert::AreEqual(i, object[Json::StaticKey(name.data(), name.data() + name.size())].asInt());
+			}
+			const string missing = MemberName(WideMembers);
+			Assert::IsNull(object.find(missing.data(), missing.data() + missing.size()));
+			Assert::IsNull(object.find(Json::StaticKey("")));
+			Assert::IsTrue(object[Json::StaticKey("m")].isNull());
+		}
+
+		TEST_METHOD(Find_WideObjectChangedAfterLookups_SeesChanges)
+		{
+			// Arrange
+			Json::Value object = WideObject();
+			LookUpAll(object);
+			const string added = MemberName(WideMembers);
+			const string removed = MemberName(7);
+
+			// Act
+			object[added] = -1;
+			LookUpAll(object);
+			object.removeMember(removed);
+			const Json::Value constObject(object);
+			LookUpAll(object);
+			object.clear();
+
+			// Assert
+			Assert::AreEqual(-1, constObject.find(Json::StaticKey(added.c_str()))->asInt());
+			Assert::IsNull(constObject.find(Json::StaticKey(removed.c_str())));
+			Assert::AreEqual(8, constObject[Json::StaticKey(MemberName(8).c_str())].asInt());
+			Assert::IsNull(object.find(Json::StaticKey(added.c_str())));
+			Assert::AreEqual(0u, object.size());
+		}
+
+		TEST_METHOD(Subscript_StaticKey_FindsOrAddsMember)
+		{
+			// Arrange
+			static const Json::StaticKey existing("code");
+			static const Json::StaticKey added("message");
+			Json::Value object(Json::objectValue);
+			object["code"] = 5;
+
+			// Act
+			object[existing] = 6;
+			object[added] = LongText;
+
+			// Assert
+			Assert::AreEqual(2u, object.size());
+			Assert::AreEqual(6, object["code"].asInt());
+			Assert::AreEqual(LongText, object["message"].asString());
+			Assert::AreEqual(LongText, object.find(added)->asString());
+		}
+
+		TEST_METHOD(Copy_ConstReference_OutlivesChangedAndDroppedCopy)
+		{
+			// Arrange
+			Json::Value document = Parse(ArenaDocument, false);
+			const Json::Value& constDocument = document;
+			const Json::Value& member = constDocument["s"];
+
+			// Act
+			Json::Value* copy = new Json::Value(document);
+			document["b"] = false;
+			delete copy;
+
+			// Assert
+			Assert::IsTrue(&member == &constDocument["s"]);
+			Assert::AreEqual(LongText, string(member.asCString()));
+			Assert::IsFalse(constDocument["b"].asBool());
+		}
+
+		TEST_METHOD(SharedValue_Copies_ShareOneDocument)
+		{
+			// Arrange
+			Json::SharedValue section;
+			Json::SharedValue copy;
+			{
+				Json::SharedValue document(Parse(ArenaDocument, true));
+				copy = document;
+				section = document.get(LongText);
+
+				// Assert
+				Assert::IsTrue(&*copy == &*document);
+				Assert::IsTrue(&*section == &(*document)[LongText]);
+			}
+			Assert::AreEqual(LongText, section.get(1)->asString());
+			Assert::AreEqual(1, section.get(2).get("n")->asInt());
+			Assert::IsTrue(section.get(3)->isNull());
+			Assert::IsTrue(copy.get("missing")->isNull());
+			Assert::IsTrue(Json::SharedValue()->isNull());
+			Assert::IsTrue(*copy == Parse(ArenaDocument, false));
+		}
+
+		TEST_METHOD(Copy_AfterReferenceHandedOut_IsNotChangedThroughIt)
+		{
+			// Arrange
+			Json::Value object = Parse("{\"k\":1}", false);
+			Json::Value array = Parse("[1]", false);
+			Json::Value& member = object["k"];
+			Json::Value::iterator element = array.begin();
+
+			// Act
+			const Json::Value objectCopy(object);
+			const Json::Value arrayCopy(array);
+			member = 2;
+			*element = 2;
+
+			// Assert
+			Assert::AreEqual(1, objectCopy["k"].asInt());
+			Assert::AreEqual(1, arrayCopy[0].asInt());
+			Assert::AreEqual(2, object["k"].asInt());
+			Assert::AreEqual(2, array[0].asInt());
+		}
+
+		TEST_METHOD(Copy_RemoveAndResize_LeaveOriginal)
+		{
+			// Arrange
+			const Json::Value root = Parse("{\"o\":{\"a\":1,\"b\":2},\"l\":[1,2,3]}", false);
+			Json::Value object(root["o"]);
+			Json::Value list(root["l"]);
+			Json::Value cleared(root["l"]);
+			Json::Value removed;
+
+			// Act
+			object.removeMember("a");
+			list.removeIndex(0, &removed);
+			list.resize(1);
+			cleared.clear();
+
+			// Assert
+			Assert::IsTrue(root == Parse("{\"o\":{\"a\":1,\"b\":2},\"l\":[1,2,3]}", false));
+			Assert::AreEqual(1u, object.size());
+			Assert::AreEqual(1u, list.size());
+			Assert::AreEqual(2, list[0].asInt());
+			Assert::AreEqual(0u, cleared.size());
+		}
+
+		TEST_METHOD(SharedValue_ConcurrentCopies_EachChangeOnlyTheirOwn)
+		{
+			// Arrange
+			const Json::Value root = Parse(ArenaDocument, false);
+			const Json::SharedValue shared(root);
+			vector<thread> threads;
+			vector<char> correct(4, false);
+
+			// Act
+			for (int t = 0; t < 4; ++t)
+			{
+				threads.emplace_back([&shared, &correct, t]()
+				{
+					bool ok = true;
+					for (int i = 0; i < 1000; ++i)
+					{
+						Json::SharedValue section = Json::SharedValue(shared).get(LongText);
+						Json::Value copy(*section);
+						copy[2]["n"] = t * 1000 + i;
+						ok = ok && copy[2]["n"].asInt() == t * 1000 + i && section.get(2).get("n")->asInt() == 1;
+					}
+					correct[t] = ok;
+				});
+			}
+			for (thread& t : threads)
+			{
+				t.join();
+			}
+
+			// Assert
+			for (char ok : correct)
+			{
+				Assert::IsTrue(ok);
+			}
+			Assert::IsTrue(root == *shared);
+		}
+	};
+}
@@ -0,0 +1,201 @@
+/*
+Copyright 2018 Microsoft
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH
+THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#include "stdafx.h"
+#include <cstdio>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "CppUnitTest.h"
+#include "json/json.h"
+
+#if defined(_MSC_VER)
+#define fileno _fileno
+#endif
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace std;
+
+namespace
+{
+	Json::Value Parse(const string& text)
+	{
+		Json::CharReaderBuilder builder;
+		builder["collectComments"] = true;
+		unique_ptr<Json::CharReader> reader(builder.newCharReader());
+		Json::Value root;
+		string errors;
+		Assert::IsTrue(reader->parse(text.data(), text.data() + text.size(), &root, &errors));
+		return root;
+	}
+
+	const string CommentedDocument =
+		"// before\n"
+		"{\n"
+		"\t\"a\" : 1, // same line\n"
+		"\t\"b\" : [ 1, 2, 3 ],\n"
+		"\t\"c\" : { \"d\" : [ { \"e\" : null } ], \"f\" : \"text\" }\n"
+		"}\n";
+
+	struct Chunks
+	{
+		vector<string> received;
+		bool succeed = true;
+	};
+
+	bool CollectChunk(void* context, char const* data, size_t size)
+	{
+		Chunks& chunks = *static_cast<Chunks*>(context);
+		chunks.received.push_back(string(data, size));
+		return chunks.succeed;
+	}
+}
+
+namespace DMBridgeUnitTests
+{
+	TEST_CLASS(JsonWriterTests)
+	{
+	public:
+		TEST_METHOD(WriteString_SameAsStreamWrite)
+		{
+			// Arrange
+			const Json::Value root = Parse(CommentedDocument);
+			Json::StreamWriterBuilder builder;
+			unique_ptr<Json::StreamWriter> writer(builder.newStreamWriter());
+			ostringstream stream;
+
+			// Act
+			const string written = Json::writeString(builder, root);
+			writer->write(root, &stream);
+
+			// Assert
+			Assert::AreEqual(stream.str(), written);
+			Assert::IsTrue(written.find("// before") == 0);
+			Assert::IsTrue(written.find("// same line") != string::npos);
+		}
+
+		TEST_METHOD(WriteString_DeepNesting_IndentsEveryLevel)
+		{
+			// Arrange
+			const int depth = 20;
+			Json::Value root(Json::objectValue);
+			Json::Value* current = &root;
+			for (int level = 0; level < depth; ++level)
+			{
+				current = &(*current)["n"];
+			}
+			*current = 1;
+			Json::StreamWriterBuilder builder;
+			builder["indentation"] = "  ";
+
+			// Act
+			const string written = Json::writeString(builder, root);
+
+			// Assert
+			Assert::IsTrue(written.find("\n" + string(2 * depth, ' ') + "\"n\" : 1\n") != string::npos);
+			Assert::IsTrue(written.find("\n" + string(2 * (depth - 1), ' ') + "}\n") != string::npos);
+			Assert::AreEqual(root, Parse(written));
+		}
+
+		TEST_METHOD(WriteString_EscapeAtAnyOffset_Escapes)
+		{
+			Json::StreamWriterBuilder builder;
+			for (size_t offset = 0; offset < 70; ++offset)
+			{
+				// Arrange
+				const string padding(offset, 'x');
+				const Json::Value root(padding + "\"\\\n\x01" "\xC3\xA9" + padding);
+
+				// Act
+				const string written = Json::writeString(builder, root);
+
+				// Assert
+				Assert::AreEqual("\"" + padding + "\\\"\\\\\\n\\u0001\\u00e9" + padding + "\"", written);
+			}
+		}
+
+		TEST_METHOD(WriteBuffer_WithSink_PassesChunksInOrder)
+		{
+			// Arrange
+			Chunks chunks;
+			Json::WriteBuffer buffer(CollectChunk, &chunks, 8);
+			const string large(20, 'L');
+
+			// Act
+			buffer.append("abc", 3);
+			buffer.append('d');
+			buffer.append("efghij", 6);
+			buffer.append(large);
+			buffer.append('z');
+			bool flushed = buffer.flush();
+
+			// Assert
+			Assert::IsTrue(flushed);
+			string joined;
+			for (const string& chunk : chunks.received)
+			{
+				Assert::IsTrue(chunk.size() <= 8 || chunk == large);
+				joined += chunk;
+			}
+			Assert::AreEqual("abcdefghij" + large + "z", joined);
+		}
+
+		TEST_METHOD(WriteBuffer_SinkFails_FlushReturnsFalse)
+		{
+			// Arrange
+			Chunks chunks;
+			chunks.succeed = false;
+			Json::WriteBuffer buffer(CollectChunk, &chunks, 4);
+
+			// Act
+			buffer.append("0123456789", 10);
+			bool flushed = buffer.flush();
+
+			// Assert
+			Assert::IsFalse(flushed);
+		}
+
+		TEST_METHOD(WriteToDescriptor_LargeDocument_WritesWholeDocument)
+		{
+			// Arrange
+			Json::Value root(Json::arrayValue);
+			for (int i = 0; i < 1000; ++i)
+			{
+				root.append("item " + to_string(i));
+			}
+			Json::StreamWriterBuilder builder;
+			FILE* file = tmpfile();
+			Assert::IsNotNull(file);
+
+			// Act
+			bool written = Json::writeToDescriptor(builder, root, fileno(file), 1024);
+
+			// Assert
+			Assert::IsTrue(written);
+			rewind(file);
+			string contents;
+			char block[4096];
+			size_t read;
+			while ((read = fread(block, 1, sizeof(block), file)) != 0)
+			{
+				contents.append(block, read);
+			}
+			fclose(file);
+			Assert::AreEqual(Json::writeString(builder, root), contents);
+		}
+	};
+}
@@ -0,0 +1,76 @@
+/*
+Copyright 2018 Microsoft
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH
+THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "stdafx.h"
+#include <sstream>
+#include "CppUnitTest.h"
+#include "DMBridgeUnitTests.h"
+#include "StringUtils.h"
+#include "json/json.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace std;
+
+namespace DMBridgeUnitTests
+{
+	TEST_CLASS(MetricsTests)
+	{
+	private:
+		handle_t hRpcBinding = nullptr;
+	public:
+		TEST_METHOD_INITIALIZE(Setup)
+		{
+			RpcSetup(&hRpcBinding);
+		}
+		TEST_METHOD_CLEANUP(TearDown)
+		{
+			RpcTearDown(&hRpcBinding);
+		}
+
+		TEST_METHOD(GetRpcMetrics_AfterCall_ListsMethod)
+		{
+			// Arrange
+			INT32 level;
+			::GetTelemetryLevelRpc(hRpcBinding, &level);
+			int size = 0;
+			wchar_t* metricsJson = nullptr;
+
+			// Act
+			HRESULT ret = ::GetRpcMetricsRpc(hRpcBinding, &size, &metricsJson);
+
+			// Assert
+			Assert::AreEqual(S_OK, ret);
+			Assert::IsNotNull(metricsJson);
+
+			Json::Value root;
+			string errorsList;
+			istringstream metricsStream(Utils::WideToMultibyte(metricsJson));
+			Json::CharReaderBuilder builder;
+			Assert::IsTrue(Json::parseFromStream(builder, metricsStream, &root, &errorsList));
+			midl_user_free(metricsJson);
+
+			bool found = false;
+			for (const Json::Value& method : root["methods"])
+			{
+				if (method["name"].asString() == "GetTelemetryLevelRpc")
+				{
+					found = true;
+					Assert::IsTrue(method["success"].asUInt64() + method["error"].asUInt64() > 0);
+				}
+			}
+			Assert::IsTrue(found);
+		}
+	};
+}
@@ -0,0 +1,211 @@
+/*
+Copyright 2018 Microsoft
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH
+THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+// Runs the bridge classes in-process against a MemoryRegistryStore. Only built
+// by the portable CMake build: the Visual Studio project reaches these classes
+// over RPC, and linking the DMBridge sources into it would clash with the RPC
+// client stubs.
+
+#include "stdafx.h"
+#include <fstream>
+#include <memory>
+#include "CppUnitTest.h"
+#include "Constants.h"
+#include "ComputerName.h"
+#include "ConfigUtils.h"
+#include "DMBridgeException.h"
+#include "Fakes.h"
+#include "RegistryStore.h"
+#include "RegistryUtils.h"
+#include "TelemetryLevel.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace std;
+
+constexpr wchar_t TelemetryLevelKey[] = L"Software\\Microsoft\\Windows\\CurrentVersion\\Policies\\DataCollection";
+constexpr wchar_t TelemetryLevelValue[] = L"AllowTelemetry";
+constexpr wchar_t CompNameKey[] = L"system\\currentcontrolset\\control\\computername\\computername";
+constexpr wchar_t ActiveCompNameKey[] = L"system\\currentcontrolset\\control\\computername\\activecomputername";
+constexpr wchar_t CompNameValue[] = L"ComputerName";
+constexpr wchar_t TcpNameKey[] = L"system\\currentcontrolset\\services\\tcpip\\parameters";
+constexpr wchar_t TcpNameValue[] = L"NV HostName";
+constexpr wchar_t ConfigFileName[] = L"RegistryStoreInjectionTests.json";
+
+namespace
+{
+	// Rejects every write, as a registry without write access would.
+	class ReadOnlyRegistryStore : public Utils::MemoryRegistryStore
+	{
+	protected:
+		void OnWrite(const ValueMap&) override
+		{
+			throw DMBridgeExceptionWithErrorCode("Store is read-only", ERROR_ACCESS_DENIED);
+		}
+	};
+}
+
+namespace DMBridgeUnitTests
+{
+	TEST_CLASS(RegistryStoreInjectionTests)
+	{
+	private:
+		shared_ptr<Utils::MemoryRegistryStore> _store;
+
+	public:
+		TEST_METHOD_INITIALIZE(Setup)
+		{
+			_store = make_shared<Utils::MemoryRegistryStore>();
+			TelemetryLevel::ApplyRegistryStore(_store);
+			ComputerName::ApplyRegistryStore(_store);
+		}
+		TEST_METHOD_CLEANUP(TearDown)
+		{
+			TelemetryLevel::ApplyRegistryStore(make_shared<Utils::Win32RegistryStore>());
+			ComputerName::ApplyRegistryStore(make_shared<Utils::Win32RegistryStore>());
+			Utils::CloseRegistryKeys();
+			Fakes::FakeRegistry::Reset();
+			DeleteFile(ConfigFileName);
+		}
+
+		TEST_METHOD(TelemetryLevel_SetThenGet_UsesStore)
+		{
+			// Arrange
+			uint64_t registryCalls = Fakes::FakeRegistry::CallCount();
+			INT32 level = -1;
+			unsigned long storedLevel = 0;
+
+			// Act
+			HRESULT setResult = TelemetryLevel::Set(2);
+			HRESULT getResult = TelemetryLevel::Get(&level);
+
+			// Assert
+			Assert::AreEqual(S_OK, setResult);
+			Assert::AreEqual(S_OK, getResult);
+			Assert::AreEqual(2, static_cast<int>(level));
+			Assert::AreEqual(static_cast<long>(ERROR_SUCCESS), static_cast<long>(_store->TryReadValue(TelemetryLevelKey, TelemetryLevelValue, storedLevel)));
+			Assert::AreEqual(2ul, storedLevel);
+			Assert::AreEqual(registryCalls, Fakes::FakeRegistry::CallCount());
+		}
+
+		TEST_METHOD(TelemetryLevel_WriteRejected_ReturnsError)
+		{
+			// Arrange
+			TelemetryLevel::ApplyRegistryStore(make_shared<ReadOnlyRegistryStore>());
+
+			// Act
+			HRESULT result = TelemetryLevel::Set(1);
+
+			// Assert
+			Assert::AreEqual(HRESULT_FROM_WIN32(ERROR_ACCESS_DENIED), result);
+		}
+
+		TEST_METHOD(ComputerName_Set_WritesEveryKey)
+		{
+			// Arrange
+			wstring name;
+
+			// Act
+			HRESULT result = ComputerName::Set(L"NewName");
+
+			// Assert
+			Assert::AreEqual(S_OK, result);
+			Assert::AreEqual(static_cast<long>(ERROR_SUCCESS), static_cast<long>(_store->TryReadValue(CompNameKey, CompNameValue, name)));
+			Assert::AreEqual(wstring(L"NewName"), name);
+			Assert::AreEqual(static_cast<long>(ERROR_SUCCESS), static_cast<long>(_store->TryReadValue(ActiveCompNameKey, CompNameValue, name)));
+			Assert::AreEqual(wstring(L"NewName"), name);
+			Assert::AreEqual(static_cast<long>(ERROR_SUCCESS), static_cast<long>(_store->TryReadValue(TcpNameKey, TcpNameValue, name)));
+			Assert::AreEqual(wstring(L"NewName"), name);
+		}
+
+		TEST_METHOD(ComputerName_WriteRejected_ReturnsError)
+		{
+			// Arrange
+			ComputerName::ApplyRegistryStore(make_shared<ReadOnlyRegistryStore>());
+
+			// Act
+			HRESULT result = ComputerName::Set(L"NewName");
+
+			// Assert
+			Assert::AreEqual(HRESULT_FROM_WIN32(ERROR_ACCESS_DENIED), result);
+		}
+
+		TEST_METHOD(ComputerName_RegistryWriteFails_LeavesNamesUnchanged)
+		{
+			// Arrange
+			ComputerName::ApplyRegistryStore(make_shared<Utils::Win32RegistryStore>());
+			Fakes::FakeRegistry::SetValue(CompNameKey, CompNameValue, wstring(L"OldName"));
+			Fakes::FakeRegistry::SetValue(ActiveCompNameKey, CompNameValue, wstring(L"OldName"));
+			Fakes::FakeRegistry::FailWrites(TcpNameKey, ERROR_ACCESS_DENIED);
+			wstring name;
+
+			// Act
+			HRESULT result = ComputerName::Set(L"NewName");
+
+			// Assert
+			Assert::AreEqual(HRESULT_FROM_WIN32(ERROR_ACCESS_DENIED), result);
+			Assert::AreEqual(wstring(L"OldName"), Utils::ReadRegistryValue(CompNameKey, CompNameValue));
+			Assert::AreEqual(wstring(L"OldName"), Utils::ReadRegistryValue(ActiveCompNameKey, CompNameValue));
+			Assert::AreEqual(static_cast<long>(ERROR_FILE_NOT_FOUND), static_cast<long>(Utils::TryReadRegistryValue(TcpNameKey, TcpNameValue, name)));
+		}
+
+		TEST_METHOD(ComputerName_IsRenamePending_ComparesStoreWithActiveName)
+		{
+			// Arrange
+			Fakes::FakeSystem::SetComputerName(L"OldName");
+			BOOL pendingBefore = TRUE;
+			BOOL pendingAfter = FALSE;
+
+			// Act
+			_store->WriteValue(CompNameKey, CompNameValue, L"oldname");
+			HRESULT beforeResult = ComputerName::IsRenamePending(&pendingBefore);
+			ComputerName::Set(L"NewName");
+			HRESULT afterResult = ComputerName::IsRenamePending(&pendingAfter);
+
+			// Assert
+			Assert::AreEqual(S_OK, beforeResult);
+			Assert::AreEqual(S_OK, afterResult);
+			Assert::IsFalse(pendingBefore != FALSE);
+			Assert::IsTrue(pendingAfter != FALSE);
+		}
+
+		TEST_METHOD(ComputerName_IsRenamePending_MissingValue_ReturnsError)
+		{
+			// Arrange
+			BOOL pending = TRUE;
+
+			// Act
+			HRESULT result = ComputerName::IsRenamePending(&pending);
+
+			// Assert
+			Assert::AreEqual(HRESULT_FROM_WIN32(ERROR_FILE_NOT_FOUND), result);
+		}
+
+		TEST_METHOD(LoadConfigFile_ReadsPathFromStore)
+		{
+			// Arrange
+			{
+				ofstream file(Utils::FileStreamName(ConfigFileName));
+				file << "{ \"source\": \"store\" }";
+			}
+			_store->WriteValue(IoTDMRegistryRoot, RegConfigFile, ConfigFileName);
+
+			// Act
+			Json::Value config = ConfigUtils::LoadConfigFile(*_store);
+
+			// Assert
+			Assert::AreEqual(string("store"), config["source"].asString());
+		}
+	};
+}
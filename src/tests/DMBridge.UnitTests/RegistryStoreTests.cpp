@@ -0,0 +1,197 @@
+/*
+Copyright 2018 Microsoft
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH
+THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "stdafx.h"
+#include <fstream>
+#include "CppUnitTest.h"
+#include "DMBridgeException.h"
+#include "RegistryStore.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace std;
+
+constexpr wchar_t TestKey[] = L"Software\\Microsoft\\IoTDMBridge\\Tests";
+constexpr wchar_t StoreFileName[] = L"RegistryStoreTests.json";
+
+namespace
+{
+	// Rejects every write, as a file that cannot be saved would.
+	class RejectingRegistryStore : public Utils::MemoryRegistryStore
+	{
+	protected:
+		void OnWrite(const ValueMap&) override
+		{
+			throw DMBridgeExceptionWithErrorCode("Write rejected", ERROR_WRITE_FAULT);
+		}
+	};
+}
+
+namespace DMBridgeUnitTests
+{
+	TEST_CLASS(RegistryStoreTests)
+	{
+	public:
+		TEST_METHOD_INITIALIZE(Setup)
+		{
+			DeleteFile(StoreFileName);
+		}
+		TEST_METHOD_CLEANUP(TearDown)
+		{
+			DeleteFile(StoreFileName);
+		}
+
+		TEST_METHOD(MemoryStore_ReadsBackWrittenValues)
+		{
+			// Arrange
+			Utils::MemoryRegistryStore store;
+			wstring stringValue;
+			unsigned long dwordValue = 0;
+
+			// Act
+			store.WriteValue(TestKey, L"String", L"value");
+			store.WriteValue(TestKey, L"Dword", 42ul);
+
+			// Assert
+			Assert::AreEqual(static_cast<long>(ERROR_SUCCESS), static_cast<long>(store.TryReadValue(TestKey, L"String", stringValue)));
+			Assert::AreEqual(wstring(L"value"), stringValue);
+			Assert::AreEqual(static_cast<long>(ERROR_SUCCESS), static_cast<long>(store.TryReadValue(TestKey, L"Dword", dwordValue)));
+			Assert::AreEqual(42ul, dwordValue);
+		}
+
+		TEST_METHOD(MemoryStore_NamesAreCaseInsensitive)
+		{
+			// Arrange
+			Utils::MemoryRegistryStore store;
+			wstring value;
+
+			// Act
+			store.WriteValue(L"SOFTWARE\\Test", L"Name", L"first");
+			store.WriteValue(L"software\\test", L"NAME", L"second");
+
+			// Assert
+			Assert::AreEqual(static_cast<long>(ERROR_SUCCESS), static_cast<long>(store.TryReadValue(L"Software\\Test", L"name", value)));
+			Assert::AreEqual(wstring(L"second"), value);
+		}
+
+		TEST_METHOD(MemoryStore_MissingValue_NotFound)
+		{
+			// Arrange
+			Utils::MemoryRegistryStore store;
+			wstring value = L"unchanged";
+
+			// Act
+			LSTATUS status = store.TryReadValue(TestKey, L"Missing", value);
+
+			// Assert
+			Assert::AreEqual(static_cast<long>(ERROR_FILE_NOT_FOUND), static_cast<long>(status));
+			Assert::AreEqual(wstring(L"unchanged"), value);
+		}
+
+		TEST_METHOD(MemoryStore_WrongType_Unsupported)
+		{
+			// Arrange
+			Utils::MemoryRegistryStore store;
+			store.WriteValue(TestKey, L"String", L"value");
+			unsigned long value = 0;
+
+			// Act
+			LSTATUS status = store.TryReadValue(TestKey, L"String", value);
+
+			// Assert
+			Assert::AreEqual(static_cast<long>(ERROR_UNSUPPORTED_TYPE), static_cast<long>(status));
+		}
+
+		TEST_METHOD(MemoryStore_WriteValues_WritesEveryValue)
+		{
+			// Arrange
+			Utils::MemoryRegistryStore store;
+			wstring first;
+			wstring second;
+
+			// Act
+			store.WriteValues({ { TestKey, L"First", L"1" }, { TestKey, L"Second", L"2" } });
+
+			// Assert
+			Assert::AreEqual(static_cast<long>(ERROR_SUCCESS), static_cast<long>(store.TryReadValue(TestKey, L"First", first)));
+			Assert::AreEqual(wstring(L"1"), first);
+			Assert::AreEqual(static_cast<long>(ERROR_SUCCESS), static_cast<long>(store.TryReadValue(TestKey, L"Second", second)));
+			Assert::AreEqual(wstring(L"2"), second);
+		}
+
+		TEST_METHOD(MemoryStore_WriteValuesRejected_WritesNothing)
+		{
+			// Arrange
+			RejectingRegistryStore store;
+			wstring value;
+
+			// Act
+			Assert::ExpectException<DMBridgeExceptionWithErrorCode>([&store]()
+			{
+				store.WriteValues({ { TestKey, L"First", L"1" }, { TestKey, L"Second", L"2" } });
+			});
+
+			// Assert
+			Assert::AreEqual(static_cast<long>(ERROR_FILE_NOT_FOUND), static_cast<long>(store.TryReadValue(TestKey, L"First", value)));
+		}
+
+		TEST_METHOD(FileStore_PersistsAcrossInstances)
+		{
+			// Arrange
+			{
+				Utils::FileRegistryStore store(StoreFileName);
+				store.WriteValue(TestKey, L"String", L"persisted");
+				store.WriteValue(TestKey, L"Dword", 7ul);
+			}
+			wstring stringValue;
+			unsigned long dwordValue = 0;
+
+			// Act
+			Utils::FileRegistryStore reloaded(StoreFileName);
+
+			// Assert
+			Assert::AreEqual(static_cast<long>(ERROR_SUCCESS), static_cast<long>(reloaded.TryReadValue(TestKey, L"String", stringValue)));
+			Assert::AreEqual(wstring(L"persisted"), stringValue);
+			Assert::AreEqual(static_cast<long>(ERROR_SUCCESS), static_cast<long>(reloaded.TryReadValue(TestKey, L"Dword", dwordValue)));
+			Assert::AreEqual(7ul, dwordValue);
+		}
+
+		TEST_METHOD(FileStore_MissingFile_StartsEmpty)
+		{
+			// Arrange
+			wstring value;
+
+			// Act
+			Utils::FileRegistryStore store(StoreFileName);
+
+			// Assert
+			Assert::AreEqual(static_cast<long>(ERROR_FILE_NOT_FOUND), static_cast<long>(store.TryReadValue(TestKey, L"String", value)));
+		}
+
+		TEST_METHOD(FileStore_CorruptFile_Throws)
+		{
+			// Arrange
+			{
+				ofstream file(Utils::FileStreamName(StoreFileName));
+				file << "{ not json";
+			}
+
+			// Act & Assert
+			Assert::ExpectException<DMBridgeExceptionWithErrorCode>([]()
+			{
+				Utils::FileRegistryStore store(StoreFileName);
+			});
+		}
+	};
+}
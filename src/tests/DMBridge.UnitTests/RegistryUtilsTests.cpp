@@ -0,0 +1,238 @@
+/*
+Copyright 2018 Microsoft
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH
+THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+// Checks how many registry calls RegistryUtils makes, against the fake
+// registry in ../Portable/Fakes. Only built by the portable CMake build.
+
+#include "stdafx.h"
+#include "CppUnitTest.h"
+#include "DMBridgeException.h"
+#include "Fakes.h"
+#include "RegistryUtils.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace std;
+
+constexpr wchar_t TestKey[] = L"Software\\Microsoft\\IoTDMBridge\\Tests";
+constexpr wchar_t OtherTestKey[] = L"Software\\Microsoft\\IoTDMBridge\\Tests\\Other";
+
+namespace DMBridgeUnitTests
+{
+	TEST_CLASS(RegistryUtilsTests)
+	{
+	public:
+		TEST_METHOD_INITIALIZE(Setup)
+		{
+			Utils::CloseRegistryKeys();
+			Fakes::FakeRegistry::Reset();
+		}
+		TEST_METHOD_CLEANUP(TearDown)
+		{
+			Utils::CloseRegistryKeys();
+		}
+
+		TEST_METHOD(ReadDword_OpenKey_SingleCall)
+		{
+			// Arrange
+			Fakes::FakeRegistry::SetValue(TestKey, L"Dword", 5ul);
+			unsigned long value = 0;
+			Utils::TryReadRegistryValue(TestKey, L"Dword", value);
+			uint64_t calls = Fakes::FakeRegistry::CallCount();
+
+			// Act
+			LSTATUS status = Utils::TryReadRegistryValue(TestKey, L"Dword", value);
+
+			// Assert
+			Assert::AreEqual(static_cast<long>(ERROR_SUCCESS), static_cast<long>(status));
+			Assert::AreEqual(5ul, value);
+			Assert::AreEqual(uint64_t(1), Fakes::FakeRegistry::CallCount() - calls);
+		}
+
+		TEST_METHOD(ReadString_OpenKey_SingleCall)
+		{
+			// Arrange
+			Fakes::FakeRegistry::SetValue(TestKey, L"String", wstring(L"short"));
+			wstring value;
+			Utils::TryReadRegistryValue(TestKey, L"String", value);
+			uint64_t calls = Fakes::FakeRegistry::CallCount();
+
+			// Act
+			LSTATUS status = Utils::TryReadRegistryValue(TestKey, L"String", value);
+
+			// Assert
+			Assert::AreEqual(static_cast<long>(ERROR_SUCCESS), static_cast<long>(status));
+			Assert::AreEqual(wstring(L"short"), value);
+			Assert::AreEqual(uint64_t(1), Fakes::FakeRegistry::CallCount() - calls);
+		}
+
+		TEST_METHOD(ReadString_LongerThanStackBuffer_ReadsWholeValue)
+		{
+			// Arrange
+			wstring expected(1000, L'x');
+			Fakes::FakeRegistry::SetValue(TestKey, L"String", expected);
+			wstring value;
+
+			// Act
+			LSTATUS status = Utils::TryReadRegistryValue(TestKey, L"String", value);
+
+			// Assert
+			Assert::AreEqual(static_cast<long>(ERROR_SUCCESS), static_cast<long>(status));
+			Assert::AreEqual(expected, value);
+		}
+
+		TEST_METHOD(ReadValue_MissingKey_FoundOnceCreated)
+		{
+			// Arrange
+			unsigned long value = 0;
+			LSTATUS missingStatus = Utils::TryReadRegistryValue(TestKey, L"Dword", value);
+			Fakes::FakeRegistry::SetValue(TestKey, L"Dword", 3ul);
+
+			// Act
+			LSTATUS status = Utils::TryReadRegistryValue(TestKey, L"Dword", value);
+
+			// Assert
+			Assert::AreEqual(static_cast<long>(ERROR_FILE_NOT_FOUND), static_cast<long>(missingStatus));
+			Assert::AreEqual(static_cast<long>(ERROR_SUCCESS), static_cast<long>(status));
+			Assert::AreEqual(3ul, value);
+		}
+
+		TEST_METHOD(WriteValue_OpenKey_SingleCall)
+		{
+			// Arrange
+			Utils::WriteRegistryValue(TestKey, L"Dword", 1ul);
+			uint64_t calls = Fakes::FakeRegistry::CallCount();
+
+			// Act
+			Utils::WriteRegistryValue(TestKey, L"Dword", 2ul);
+			Utils::WriteRegistryValue(TestKey, L"String", L"value");
+
+			// Assert
+			Assert::AreEqual(uint64_t(2), Fakes::FakeRegistry::CallCount() - calls);
+			Assert::AreEqual(wstring(L"value"), Utils::ReadRegistryValue(TestKey, L"String"));
+		}
+
+		TEST_METHOD(WriteValue_KeyDeleted_RecreatesKey)
+		{
+			// Arrange
+			unsigned long value = 0;
+			Utils::WriteRegistryValue(TestKey, L"Dword", 1ul);
+			Utils::TryReadRegistryValue(TestKey, L"Dword", value);
+			Fakes::FakeRegistry::DeleteKey(TestKey);
+
+			// Act
+			Utils::WriteRegistryValue(TestKey, L"Dword", 2ul);
+			LSTATUS status = Utils::TryReadRegistryValue(TestKey, L"Dword", value);
+
+			// Assert
+			Assert::AreEqual(static_cast<long>(ERROR_SUCCESS), static_cast<long>(status));
+			Assert::AreEqual(2ul, value);
+		}
+
+		TEST_METHOD(WriteValues_WritesEveryValue)
+		{
+			// Arrange
+			vector<Utils::RegistryValueWrite> values = {
+				{ TestKey, L"First", L"1" },
+				{ TestKey, L"Second", L"2" },
+				{ OtherTestKey, L"Third", L"3" }
+			};
+
+			// Act
+			Utils::WriteRegistryValues(values);
+
+			// Assert
+			Assert::AreEqual(wstring(L"1"), Utils::ReadRegistryValue(TestKey, L"First"));
+			Assert::AreEqual(wstring(L"2"), Utils::ReadRegistryValue(TestKey, L"Second"));
+			Assert::AreEqual(wstring(L"3"), Utils::ReadRegistryValue(OtherTestKey, L"Third"));
+		}
+
+		TEST_METHOD(WriteValues_OpenKeys_TwoCallsPerValue)
+		{
+			// Arrange
+			vector<Utils::RegistryValueWrite> values = {
+				{ TestKey, L"First", L"1" },
+				{ OtherTestKey, L"Second", L"2" }
+			};
+			Utils::WriteRegistryValues(values);
+			uint64_t calls = Fakes::FakeRegistry::CallCount();
+
+			// Act
+			Utils::WriteRegistryValues(values);
+
+			// Assert
+			Assert::AreEqual(uint64_t(4), Fakes::FakeRegistry::CallCount() - calls);
+		}
+
+		TEST_METHOD(WriteValues_WriteFails_RestoresEarlierValues)
+		{
+			// Arrange
+			Fakes::FakeRegistry::SetValue(TestKey, L"First", wstring(L"old"));
+			Fakes::FakeRegistry::SetValue(OtherTestKey, L"Third", wstring(L"old"));
+			Fakes::FakeRegistry::FailWrites(OtherTestKey, ERROR_ACCESS_DENIED);
+			vector<Utils::RegistryValueWrite> values = {
+				{ TestKey, L"First", L"new" },
+				{ TestKey, L"Second", L"new" },
+				{ OtherTestKey, L"Third", L"new" }
+			};
+			wstring second;
+
+			// Act
+			long error = ERROR_SUCCESS;
+			try
+			{
+				Utils::WriteRegistryValues(values);
+			}
+			catch (const DMBridgeExceptionWithErrorCode& e)
+			{
+				error = e.ErrorCode();
+			}
+
+			// Assert
+			Assert::AreEqual(static_cast<long>(ERROR_ACCESS_DENIED), error);
+			Assert::AreEqual(wstring(L"old"), Utils::ReadRegistryValue(TestKey, L"First"));
+			Assert::AreEqual(static_cast<long>(ERROR_FILE_NOT_FOUND), static_cast<long>(Utils::TryReadRegistryValue(TestKey, L"Second", second)));
+			Assert::AreEqual(wstring(L"old"), Utils::ReadRegistryValue(OtherTestKey, L"Third"));
+		}
+
+		TEST_METHOD(WriteValues_KeyDeleted_RecreatesKey)
+		{
+			// Arrange
+			vector<Utils::RegistryValueWrite> values = { { TestKey, L"First", L"1" } };
+			Utils::WriteRegistryValues(values);
+			Fakes::FakeRegistry::DeleteKey(TestKey);
+
+			// Act
+			Utils::WriteRegistryValues(values);
+
+			// Assert
+			Assert::AreEqual(wstring(L"1"), Utils::ReadRegistryValue(TestKey, L"First"));
+		}
+
+		TEST_METHOD(CloseRegistryKeys_ClosesEveryKey)
+		{
+			// Arrange
+			uint64_t openKeys = Fakes::FakeRegistry::OpenKeyCount();
+			unsigned long value = 0;
+			Utils::WriteRegistryValue(TestKey, L"Dword", 1ul);
+			Utils::TryReadRegistryValue(TestKey, L"Dword", value);
+
+			// Act
+			Utils::CloseRegistryKeys();
+
+			// Assert
+			Assert::AreEqual(openKeys, Fakes::FakeRegistry::OpenKeyCount());
+		}
+	};
+}
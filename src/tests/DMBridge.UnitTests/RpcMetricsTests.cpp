@@ -0,0 +1,170 @@
+/*
+Copyright 2018 Microsoft
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH
+THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "stdafx.h"
+#include <thread>
+#include <vector>
+#include "CppUnitTest.h"
+#include "RpcMetrics.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace std;
+
+namespace DMBridgeUnitTests
+{
+	TEST_CLASS(RpcMetricsTests)
+	{
+	public:
+		TEST_METHOD(LatencyBuckets_IndexOf_WithinBounds)
+		{
+			const uint64_t values[] = { 0, 1, 15, 16, 17, 31, 32, 1000, 123456789, Utils::LatencyBuckets::MaxValue };
+			for (uint64_t value : values)
+			{
+				// Act
+				size_t index = Utils::LatencyBuckets::IndexOf(value);
+
+				// Assert
+				Assert::IsTrue(index < Utils::LatencyBuckets::Count);
+				Assert::IsTrue(Utils::LatencyBuckets::LowerBound(index) <= value);
+				Assert::IsTrue(Utils::LatencyBuckets::UpperBound(index) >= value);
+			}
+		}
+
+		TEST_METHOD(LatencyBuckets_IndexOf_ClampsLargeValues)
+		{
+			// Act
+			size_t index = Utils::LatencyBuckets::IndexOf(UINT64_MAX);
+
+			// Assert
+			Assert::AreEqual(Utils::LatencyBuckets::Count - 1, index);
+		}
+
+		TEST_METHOD(Record_CountsSuccessAndError)
+		{
+			// Arrange
+			Utils::RpcMethodMetrics method("Record_CountsSuccessAndError");
+
+			// Act
+			method.Record(100, true);
+			method.Record(200, true);
+			method.Record(300, false);
+			Utils::RpcMethodSnapshot snapshot = method.Snapshot();
+
+			// Assert
+			Assert::AreEqual(2ull, static_cast<unsigned long long>(snapshot.successCount));
+			Assert::AreEqual(1ull, static_cast<unsigned long long>(snapshot.errorCount));
+			Assert::AreEqual(200ull, static_cast<unsigned long long>(snapshot.MeanNanoseconds()));
+			Assert::AreEqual(300ull, static_cast<unsigned long long>(snapshot.maxNanoseconds));
+		}
+
+		TEST_METHOD(Snapshot_AccumulatesAcrossCalls)
+		{
+			// Arrange
+			Utils::RpcMethodMetrics method("Snapshot_AccumulatesAcrossCalls");
+			method.Record(10, true);
+			method.Snapshot();
+
+			// Act
+			method.Record(20, true);
+			Utils::RpcMethodSnapshot snapshot = method.Snapshot();
+
+			// Assert
+			Assert::AreEqual(2ull, static_cast<unsigned long long>(snapshot.Count()));
+			Assert::AreEqual(30ull, static_cast<unsigned long long>(snapshot.totalNanoseconds));
+		}
+
+		TEST_METHOD(Percentile_WithinBucketError)
+		{
+			// Arrange
+			Utils::RpcMethodMetrics method("Percentile_WithinBucketError");
+			for (uint64_t i = 1; i <= 1000; ++i)
+			{
+				method.Record(i * 1000, true);
+			}
+
+			// Act
+			Utils::RpcMethodSnapshot snapshot = method.Snapshot();
+			uint64_t p50 = snapshot.PercentileNanoseconds(50.0);
+			uint64_t p99 = snapshot.PercentileNanoseconds(99.0);
+
+			// Assert
+			Assert::IsTrue(p50 >= 500000 && p50 <= 500000 + 500000 / 16);
+			Assert::IsTrue(p99 >= 990000 && p99 <= 1000000);
+		}
+
+		TEST_METHOD(Snapshot_ConcurrentWriters_Consistent)
+		{
+			// Arrange
+			constexpr int WriterCount = 4;
+			constexpr int RecordsPerWriter = 20000;
+			Utils::RpcMethodMetrics method("Snapshot_ConcurrentWriters_Consistent");
+			vector<thread> writers;
+
+			// Act
+			for (int w = 0; w < WriterCount; ++w)
+			{
+				writers.emplace_back([&method, w]()
+				{
+					for (int i = 0; i < RecordsPerWriter; ++i)
+					{
+						method.Record(static_cast<uint64_t>(i + w), (i % 10) != 0);
+					}
+				});
+			}
+
+			// Every intermediate snapshot must agree with its own histogram.
+			for (int i = 0; i < 100; ++i)
+			{
+				Utils::RpcMethodSnapshot snapshot = method.Snapshot();
+				uint64_t bucketTotal = 0;
+				for (uint64_t bucket : snapshot.buckets)
+				{
+					bucketTotal += bucket;
+				}
+				Assert::AreEqual(static_cast<unsigned long long>(snapshot.Count()), static_cast<unsigned long long>(bucketTotal));
+			}
+
+			for (thread& writer : writers)
+			{
+				writer.join();
+			}
+			Utils::RpcMethodSnapshot snapshot = method.Snapshot();
+
+			// Assert
+			Assert::AreEqual(static_cast<unsigned long long>(WriterCount * RecordsPerWriter), static_cast<unsigned long long>(snapshot.Count()));
+			Assert::AreEqual(static_cast<unsigned long long>(WriterCount * RecordsPerWriter / 10), static_cast<unsigned long long>(snapshot.errorCount));
+		}
+
+		TEST_METHOD(Scope_WithoutComplete_RecordsError)
+		{
+			// Arrange
+			Utils::RpcMethodMetrics method("Scope_WithoutComplete_RecordsError");
+
+			// Act
+			{
+				Utils::RpcMetricsScope scope(method);
+			}
+			{
+				Utils::RpcMetricsScope scope(method);
+				scope.Complete(S_OK);
+			}
+			Utils::RpcMethodSnapshot snapshot = method.Snapshot();
+
+			// Assert
+			Assert::AreEqual(1ull, static_cast<unsigned long long>(snapshot.successCount));
+			Assert::AreEqual(1ull, static_cast<unsigned long long>(snapshot.errorCount));
+		}
+	};
+}
@@ -0,0 +1,283 @@
+/*
+Copyright 2018 Microsoft
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH
+THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+// Runs TelemetryLevel in-process against the fake registries. Only built by
+// the portable CMake build, for the same reason as RegistryStoreInjectionTests.cpp.
+
+#include "stdafx.h"
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include "CppUnitTest.h"
+#include "Fakes.h"
+#include "RegistryStore.h"
+#include "RegistryUtils.h"
+#include "TelemetryLevel.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace std;
+
+constexpr wchar_t TelemetryLevelKey[] = L"Software\\Microsoft\\Windows\\CurrentVersion\\Policies\\DataCollection";
+constexpr wchar_t TelemetryLevelValue[] = L"AllowTelemetry";
+
+namespace
+{
+	INT32 GetLevel()
+	{
+		INT32 level = -1;
+		HRESULT hr = TelemetryLevel::Get(&level);
+		Assert::AreEqual(S_OK, hr);
+		return level;
+	}
+}
+
+namespace DMBridgeUnitTests
+{
+	TEST_CLASS(TelemetryLevelCacheTests)
+	{
+	public:
+		TEST_METHOD_CLEANUP(TearDown)
+		{
+			TelemetryLevel::ApplyRegistryStore(make_shared<Utils::Win32RegistryStore>());
+			Utils::CloseRegistryKeys();
+			Fakes::FakeRegistry::Reset();
+		}
+
+		TEST_METHOD(TelemetryLevel_ValueMissing_ReturnsZero)
+		{
+			// Arrange
+			TelemetryLevel::ApplyRegistryStore(make_shared<Fakes::FakeRegistryStore>());
+
+			// Act
+			INT32 level = GetLevel();
+
+			// Assert
+			Assert::AreEqual(0, level);
+		}
+
+		TEST_METHOD(TelemetryLevel_ReadFails_ReturnsError)
+		{
+			// Arrange
+			auto store = make_shared<Fakes::FakeRegistryStore>();
+			store->FailReads(ERROR_ACCESS_DENIED);
+			TelemetryLevel::ApplyRegistryStore(store);
+			TelemetryLevel::StartWatching();
+			INT32 level = -1;
+
+			// Act
+			HRESULT hr = TelemetryLevel::Get(&level);
+
+			// Assert
+			Assert::AreEqual(HRESULT_FROM_WIN32(ERROR_ACCESS_DENIED), hr);
+			Assert::AreEqual(-1, level);
+		}
+
+		TEST_METHOD(TelemetryLevel_Watching_ReadFailed_RetriesRead)
+		{
+			// Arrange
+			auto store = make_shared<Fakes::FakeRegistryStore>(Fakes::FakeRegistryStore::Notify::Never);
+			store->WriteValue(TelemetryLevelKey, TelemetryLevelValue, 2ul);
+			store->FailReads(ERROR_ACCESS_DENIED);
+			TelemetryLevel::ApplyRegistryStore(store);
+			TelemetryLevel::StartWatching();
+			store->FailReads(ERROR_SUCCESS);
+
+			// Act
+			INT32 level = GetLevel();
+
+			// Assert
+			Assert::AreEqual(2, level);
+		}
+
+		TEST_METHOD(TelemetryLevel_NotWatching_ReadsEveryCall)
+		{
+			// Arrange
+			auto store = make_shared<Fakes::FakeRegistryStore>();
+			store->WriteValue(TelemetryLevelKey, TelemetryLevelValue, 1ul);
+			TelemetryLevel::ApplyRegistryStore(store);
+			uint64_t readsBefore = store->Reads();
+
+			// Act
+			GetLevel();
+			GetLevel();
+
+			// Assert
+			Assert::AreEqual(uint64_t(2), store->Reads() - readsBefore);
+		}
+
+		TEST_METHOD(TelemetryLevel_Watching_ServesReadsFromCache)
+		{
+			// Arrange
+			auto store = make_shared<Fakes::FakeRegistryStore>();
+			store->WriteValue(TelemetryLevelKey, TelemetryLevelValue, 3ul);
+			TelemetryLevel::ApplyRegistryStore(store);
+			TelemetryLevel::StartWatching();
+			uint64_t readsBefore = store->Reads();
+
+			// Act
+			INT32 level = -1;
+			for (int i = 0; i < 100; ++i)
+			{
+				level = GetLevel();
+			}
+
+			// Assert
+			Assert::AreEqual(3, level);
+			Assert::AreEqual(uint64_t(0), store->Reads() - readsBefore);
+		}
+
+		TEST_METHOD(TelemetryLevel_Watching_LevelChanged_RefreshesCache)
+		{
+			// Arrange
+			auto store = make_shared<Fakes::FakeRegistryStore>();
+			store->WriteValue(TelemetryLevelKey, TelemetryLevelValue, 1ul);
+			TelemetryLevel::ApplyRegistryStore(store);
+			TelemetryLevel::StartWatching();
+			Assert::AreEqual(1, GetLevel());
+
+			// Act
+			store->WriteValue(TelemetryLevelKey, TelemetryLevelValue, 2ul);
+
+			// Assert
+			Assert::AreEqual(2, GetLevel());
+		}
+
+		TEST_METHOD(TelemetryLevel_Watching_Set_UpdatesCacheWithoutNotification)
+		{
+			// Arrange
+			auto store = make_shared<Fakes::FakeRegistryStore>(Fakes::FakeRegistryStore::Notify::Never);
+			store->WriteValue(TelemetryLevelKey, TelemetryLevelValue, 1ul);
+			TelemetryLevel::ApplyRegistryStore(store);
+			TelemetryLevel::StartWatching();
+			uint64_t readsBefore = store->Reads();
+
+			// Act
+			HRESULT hr = TelemetryLevel::Set(3);
+
+			// Assert
+			Assert::AreEqual(S_OK, hr);
+			Assert::AreEqual(3, GetLevel());
+			Assert::AreEqual(uint64_t(0), store->Reads() - readsBefore);
+		}
+
+		TEST_METHOD(TelemetryLevel_Watching_SetDuringRefresh_KeepsTheSetLevel)
+		{
+			// Arrange
+			auto store = make_shared<Fakes::FakeRegistryStore>(Fakes::FakeRegistryStore::Notify::OnWatchThread);
+			store->WriteValue(TelemetryLevelKey, TelemetryLevelValue, 1ul);
+			TelemetryLevel::ApplyRegistryStore(store);
+			TelemetryLevel::StartWatching();
+
+			// The refresh for this change reads 2, then is held before it
+			// can publish it.
+			store->HoldNextRead();
+			store->WriteValue(TelemetryLevelKey, TelemetryLevelValue, 2ul);
+			store->WaitForHeldRead();
+
+			// Act
+			HRESULT hr = E_FAIL;
+			thread setter([&hr]() { hr = TelemetryLevel::Set(3); });
+			unsigned long stored = 0;
+			while (store->TryReadValue(TelemetryLevelKey, TelemetryLevelValue, stored) != ERROR_SUCCESS || stored != 3)
+			{
+				this_thread::yield();
+			}
+
+			// Let the held refresh publish, but not the one for Set()'s own
+			// write, which would hide what the held one did.
+			store->PauseNotifications();
+			store->ReleaseRead();
+			setter.join();
+			store->WaitWhileNotifying();
+
+			// Assert
+			Assert::AreEqual(S_OK, hr);
+			Assert::AreEqual(3, GetLevel());
+		}
+
+		TEST_METHOD(TelemetryLevel_WatchingRegistry_LevelChanged_RefreshesCache)
+		{
+			// Arrange
+			Fakes::FakeRegistry::SetValue(TelemetryLevelKey, TelemetryLevelValue, 1ul);
+			TelemetryLevel::StartWatching();
+			Assert::AreEqual(1, GetLevel());
+
+			// Act
+			Fakes::FakeRegistry::SetValue(TelemetryLevelKey, TelemetryLevelValue, 2ul);
+
+			// Assert
+			// The notification arrives on the watch thread.
+			auto deadline = chrono::steady_clock::now() + chrono::seconds(5);
+			while (GetLevel() != 2 && chrono::steady_clock::now() < deadline)
+			{
+				this_thread::sleep_for(chrono::milliseconds(1));
+			}
+			Assert::AreEqual(2, GetLevel());
+		}
+
+		TEST_METHOD(TelemetryLevel_ConcurrentGetsAndSets_ReadersSeeValidLevels)
+		{
+			// Arrange
+			constexpr int ReaderCount = 4;
+			constexpr int SetCount = 400;
+			auto store = make_shared<Fakes::FakeRegistryStore>();
+			store->WriteValue(TelemetryLevelKey, TelemetryLevelValue, 0ul);
+			TelemetryLevel::ApplyRegistryStore(store);
+			TelemetryLevel::StartWatching();
+			atomic<bool> done(false);
+			atomic<uint64_t> failures(0);
+			atomic<uint64_t> reads(0);
+
+			// Act
+			vector<thread> readers;
+			for (int t = 0; t < ReaderCount; ++t)
+			{
+				readers.emplace_back([&]()
+				{
+					while (!done)
+					{
+						INT32 level = -1;
+						if (FAILED(TelemetryLevel::Get(&level)) || level < 0 || level > 3)
+						{
+							++failures;
+						}
+						++reads;
+					}
+				});
+			}
+
+			HRESULT setResult = S_OK;
+			for (int i = 0; i < SetCount && SUCCEEDED(setResult); ++i)
+			{
+				setResult = TelemetryLevel::Set(i % 4);
+			}
+			while (reads < ReaderCount)
+			{
+				this_thread::yield();
+			}
+			done = true;
+			for (thread& reader : readers)
+			{
+				reader.join();
+			}
+
+			// Assert
+			Assert::AreEqual(S_OK, setResult);
+			Assert::AreEqual(uint64_t(0), failures.load());
+			Assert::AreEqual((SetCount - 1) % 4, GetLevel());
+		}
+	};
+}
@@ -0,0 +1,142 @@
+/*
+Copyright 2018 Microsoft
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH
+THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "stdafx.h"
+#include <sstream>
+#include <thread>
+#include "CppUnitTest.h"
+#include "Tracing.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace std;
+
+namespace DMBridgeUnitTests
+{
+	TEST_CLASS(TracingTests)
+	{
+	public:
+		TEST_METHOD_CLEANUP(TearDown)
+		{
+			Utils::Tracer::Instance().Stop();
+		}
+
+		TEST_METHOD(Span_Disabled_RecordsNothing)
+		{
+			// Arrange
+			Utils::Tracer& tracer = Utils::Tracer::Instance();
+			tracer.Start();
+			tracer.Stop();
+
+			// Act
+			{
+				TRACE_SPAN(span, "test");
+				Assert::IsFalse(span.IsActive());
+			}
+
+			// Assert
+			Assert::AreEqual(0u, tracer.ExportChromeTrace()["traceEvents"].size());
+		}
+
+		TEST_METHOD(Span_Enabled_RecordsCompleteEvent)
+		{
+			// Arrange
+			Utils::Tracer& tracer = Utils::Tracer::Instance();
+			tracer.Start();
+
+			// Act
+			{
+				TRACE_SPAN(span, "test");
+				span.SetDetail(L"Software\\", L"Value");
+			}
+			tracer.Stop();
+
+			// Assert
+			Json::Value events = tracer.ExportChromeTrace()["traceEvents"];
+			Assert::AreEqual(1u, events.size());
+			Assert::AreEqual(string("test"), events[0]["cat"].asString());
+			Assert::AreEqual(string("X"), events[0]["ph"].asString());
+			Assert::AreEqual(string("Software\\Value"), events[0]["args"]["detail"].asString());
+			Assert::IsTrue(events[0]["dur"].asDouble() >= 0.0);
+		}
+
+		TEST_METHOD(Start_ClearsPreviousEvents)
+		{
+			// Arrange
+			Utils::Tracer& tracer = Utils::Tracer::Instance();
+			tracer.Start();
+			{
+				TRACE_SPAN(span, "test");
+			}
+
+			// Act
+			tracer.Start();
+			tracer.Stop();
+
+			// Assert
+			Assert::AreEqual(0u, tracer.ExportChromeTrace()["traceEvents"].size());
+		}
+
+		TEST_METHOD(Spans_FromThreads_HaveDistinctThreadIds)
+		{
+			// Arrange
+			Utils::Tracer& tracer = Utils::Tracer::Instance();
+			tracer.Start();
+
+			// Act
+			{
+				TRACE_SPAN(span, "test");
+			}
+			thread worker([]()
+			{
+				TRACE_SPAN(span, "test");
+			});
+			worker.join();
+			tracer.Stop();
+
+			// Assert
+			Json::Value events = tracer.ExportChromeTrace()["traceEvents"];
+			Assert::AreEqual(2u, events.size());
+			Assert::AreNotEqual(events[0]["tid"].asUInt(), events[1]["tid"].asUInt());
+		}
+
+		TEST_METHOD(WriteChromeTrace_MatchesExport)
+		{
+			// Arrange
+			Utils::Tracer& tracer = Utils::Tracer::Instance();
+			tracer.Start();
+			{
+				TRACE_SPAN(span, "test");
+				span.SetDetail(L"quote \" backslash \\ tab \t");
+			}
+			tracer.Stop();
+
+			// Act
+			ostringstream stream;
+			tracer.WriteChromeTrace(stream);
+
+			// Assert
+			Json::Value written;
+			string errorsList;
+			istringstream writtenStream(stream.str());
+			Json::CharReaderBuilder builder;
+			Assert::IsTrue(Json::parseFromStream(builder, writtenStream, &written, &errorsList));
+
+			Json::Value exported = tracer.ExportChromeTrace();
+			Assert::AreEqual(exported["traceEvents"].size(), written["traceEvents"].size());
+			Assert::AreEqual(exported["traceEvents"][0]["args"]["detail"].asString(), written["traceEvents"][0]["args"]["detail"].asString());
+			Assert::AreEqual(exported["traceEvents"][0]["ts"].asDouble(), written["traceEvents"][0]["ts"].asDouble(), 0.001);
+		}
+	};
+}
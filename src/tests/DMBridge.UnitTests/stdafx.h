@@ -15,7 +15,9 @@ THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #pragma once
 
 
+#ifdef _WIN32
 #include "targetver.h"
+#endif
 
 // Headers for SharedUtilities 
 #include <stdio.h>
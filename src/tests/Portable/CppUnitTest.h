@@ -0,0 +1,263 @@
+/*
+Copyright 2018 Microsoft
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH
+THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+// The part of the Visual Studio CppUnitTest framework the unit tests use, so
+// the tests that do not need the RPC server can also run under CTest. Tests
+// register themselves at static initialization; UnitTestMain.cpp runs them.
+
+#include <cmath>
+#include <cstring>
+#include <cwchar>
+#include <functional>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace Microsoft { namespace VisualStudio { namespace CppUnitTestFramework
+{
+	class AssertFailedException
+	{
+	public:
+		AssertFailedException(const std::wstring& message) :
+			_message(message)
+		{}
+
+		const std::wstring& Message() const
+		{
+			return _message;
+		}
+
+	private:
+		std::wstring _message;
+	};
+
+	// One instance of the test class is created per test method, as in Visual Studio.
+	struct TestMethodInfo
+	{
+		std::string className;
+		std::string methodName;
+		std::function<void()> run;
+	};
+
+	inline std::vector<TestMethodInfo>& TestMethods()
+	{
+		static std::vector<TestMethodInfo> methods;
+		return methods;
+	}
+
+	template<class T>
+	class TestClass
+	{
+	public:
+		typedef T ThisClass;
+
+		virtual ~TestClass() {}
+
+		virtual void MethodInitialize() {}
+		virtual void MethodCleanup() {}
+
+		static void Register(const char* className, const char* methodName, void (T::*method)())
+		{
+			TestMethods().push_back({ className, methodName, [method]()
+			{
+				std::unique_ptr<T> instance(new T());
+				instance->MethodInitialize();
+				try
+				{
+					((*instance).*method)();
+				}
+				catch (...)
+				{
+					instance->MethodCleanup();
+					throw;
+				}
+				instance->MethodCleanup();
+			} });
+		}
+	};
+
+	namespace Details
+	{
+		template<class T, class = void>
+		struct IsStreamable : std::false_type {};
+
+		template<class T>
+		struct IsStreamable<T, decltype(void(std::declval<std::wostream&>() << std::declval<const T&>()))> : std::true_type {};
+
+		template<class T>
+		typename std::enable_if<IsStreamable<T>::value, std::wstring>::type ToString(const T& value)
+		{
+			std::wostringstream stream;
+			stream << value;
+			return stream.str();
+		}
+
+		template<class T>
+		typename std::enable_if<!IsStreamable<T>::value, std::wstring>::type ToString(const T&)
+		{
+			return L"<value>";
+		}
+
+		inline std::wstring ToString(const std::string& value)
+		{
+			return std::wstring(value.begin(), value.end());
+		}
+
+		inline std::wstring ToString(const char* value)
+		{
+			return value == nullptr ? L"(null)" : ToString(std::string(value));
+		}
+	}
+
+	class Assert
+	{
+	public:
+		template<class T>
+		static void AreEqual(const T& expected, const T& actual, const wchar_t* message = nullptr)
+		{
+			if (!(expected == actual))
+			{
+				Fail(L"AreEqual failed. Expected <" + Details::ToString(expected) + L"> Actual <" + Details::ToString(actual) + L">", message);
+			}
+		}
+
+		static void AreEqual(const wchar_t* expected, const wchar_t* actual, const wchar_t* message = nullptr)
+		{
+			AreEqual(std::wstring(expected), std::wstring(actual), message);
+		}
+
+		static void AreEqual(const char* expected, const char* actual, const wchar_t* message = nullptr)
+		{
+			AreEqual(std::string(expected), std::string(actual), message);
+		}
+
+		static void AreEqual(double expected, double actual, double tolerance, const wchar_t* message = nullptr)
+		{
+			if (std::fabs(expected - actual) > tolerance)
+			{
+				Fail(L"AreEqual failed. Expected <" + Details::ToString(expected) + L"> Actual <" + Details::ToString(actual) + L">", message);
+			}
+		}
+
+		template<class T>
+		static void AreNotEqual(const T& notExpected, const T& actual, const wchar_t* message = nullptr)
+		{
+			if (notExpected == actual)
+			{
+				Fail(L"AreNotEqual failed. Not expected <" + Details::ToString(notExpected) + L">", message);
+			}
+		}
+
+		static void IsTrue(bool condition, const wchar_t* message = nullptr)
+		{
+			if (!condition)
+			{
+				Fail(L"IsTrue failed.", message);
+			}
+		}
+
+		static void IsFalse(bool condition, const wchar_t* message = nullptr)
+		{
+			if (condition)
+			{
+				Fail(L"IsFalse failed.", message);
+			}
+		}
+
+		template<class T>
+		static void IsNull(const T* pointer, const wchar_t* message = nullptr)
+		{
+			if (pointer != nullptr)
+			{
+				Fail(L"IsNull failed.", message);
+			}
+		}
+
+		template<class T>
+		static void IsNotNull(const T* pointer, const wchar_t* message = nullptr)
+		{
+			if (pointer == nullptr)
+			{
+				Fail(L"IsNotNull failed.", message);
+			}
+		}
+
+		template<class E, class F>
+		static void ExpectException(F function, const wchar_t* message = nullptr)
+		{
+			try
+			{
+				function();
+			}
+			catch (const E&)
+			{
+				return;
+			}
+			catch (...)
+			{
+				Fail(L"ExpectException failed. A different exception was thrown.", message);
+			}
+			Fail(L"ExpectException failed. No exception was thrown.", message);
+		}
+
+		static void Fail(const wchar_t* message = nullptr)
+		{
+			Fail(L"Assert failed.", message);
+		}
+
+	private:
+		static void Fail(const std::wstring& failure, const wchar_t* message)
+		{
+			throw AssertFailedException(message == nullptr ? failure : failure + L" " + message);
+		}
+	};
+
+	class Logger
+	{
+	public:
+		static void WriteMessage(const wchar_t* message);
+		static void WriteMessage(const char* message);
+	};
+}}}
+
+#define TEST_CLASS(className) \
+	class className; \
+	inline const char* TestClassName(const className*) { return #className; } \
+	class className : public ::Microsoft::VisualStudio::CppUnitTestFramework::TestClass<className>
+
+// The registrar's constructor body is compiled once the test class is
+// complete, so it can take the address of the method declared after it.
+#define TEST_METHOD(methodName) \
+	struct methodName##_Registrar \
+	{ \
+		methodName##_Registrar() \
+		{ \
+			Register(TestClassName(static_cast<const ThisClass*>(nullptr)), #methodName, &ThisClass::methodName); \
+		} \
+	}; \
+	inline static methodName##_Registrar methodName##_Registration; \
+	void methodName()
+
+#define TEST_METHOD_INITIALIZE(methodName) \
+	void MethodInitialize() override { methodName(); } \
+	void methodName()
+
+#define TEST_METHOD_CLEANUP(methodName) \
+	void MethodCleanup() override { methodName(); } \
+	void methodName()
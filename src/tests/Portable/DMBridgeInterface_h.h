@@ -0,0 +1,34 @@
+/*
+Copyright 2018 Microsoft
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH
+THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+// Stand-in for the MIDL generated DMBridgeInterface_h.h. The interface specs
+// are opaque tokens outside Windows; the bridge only stores and compares them.
+#include "Win32Compat.h"
+
+typedef void* handle_t;
+typedef void* RPC_IF_HANDLE;
+
+extern RPC_IF_HANDLE ComputerName_v1_0_s_ifspec;
+extern RPC_IF_HANDLE NTService_v1_0_s_ifspec;
+extern RPC_IF_HANDLE Telemetry_v1_0_s_ifspec;
+extern RPC_IF_HANDLE Tpm_v1_0_s_ifspec;
+extern RPC_IF_HANDLE ShutdownMgmt_v1_0_s_ifspec;
+extern RPC_IF_HANDLE UwpAppMgmt_v1_0_s_ifspec;
+extern RPC_IF_HANDLE Metrics_v1_0_s_ifspec;
+
+void* __RPC_USER midl_user_allocate(size_t size);
+void __RPC_USER midl_user_free(void* pointer);
@@ -0,0 +1,87 @@
+/*
+Copyright 2018 Microsoft
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH
+THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "stdafx.h"
+#include <algorithm>
+#include <atomic>
+#include "DMProcess.h"
+#include "Fakes.h"
+
+using namespace std;
+
+// Replaces DMProcess.cpp: commands are answered by the installed handler
+// instead of being run.
+namespace
+{
+	mutex handlerLock;
+	Fakes::FakeProcess::Handler handler;
+	atomic<uint64_t> launchCount(0);
+}
+
+namespace Fakes
+{
+	void FakeProcess::Reset()
+	{
+		lock_guard<mutex> guard(handlerLock);
+		handler = nullptr;
+	}
+
+	void FakeProcess::SetHandler(const Handler& newHandler)
+	{
+		lock_guard<mutex> guard(handlerLock);
+		handler = newHandler;
+	}
+
+	uint64_t FakeProcess::LaunchCount()
+	{
+		return launchCount;
+	}
+}
+
+void Process::Launch(const wstring& commandString, unsigned long& returnCode, string& output)
+{
+	++launchCount;
+	returnCode = 0;
+
+	Fakes::FakeProcess::Handler currentHandler;
+	{
+		lock_guard<mutex> guard(handlerLock);
+		currentHandler = handler;
+	}
+	output = currentHandler ? currentHandler(commandString, returnCode) : string();
+}
+
+void Process::Launch(const wstring& commandString, unsigned long& returnCode, const OutputHandler& onOutput)
+{
+	string output;
+	Launch(commandString, returnCode, output);
+
+	// In pieces the size of the real pipe's buffer.
+	const size_t pipeBufferSize = 4096;
+	for (size_t offset = 0; offset < output.size(); offset += pipeBufferSize)
+	{
+		onOutput(output.data() + offset, min(pipeBufferSize, output.size() - offset));
+	}
+}
+
+bool Process::IsProcessRunning(const wstring&)
+{
+	return false;
+}
+
+wstring Process::GetProcessExePath(DWORD)
+{
+	return wstring();
+}
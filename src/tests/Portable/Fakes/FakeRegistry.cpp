@@ -0,0 +1,489 @@
+/*
+Copyright 2018 Microsoft
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH
+THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "stdafx.h"
+#include <atomic>
+#include <map>
+#include <memory>
+#include "Fakes.h"
+
+using namespace std;
+
+namespace
+{
+	struct RegistryValue
+	{
+		DWORD type;
+		vector<BYTE> data;
+	};
+
+	struct OpenKey
+	{
+		wstring path;
+		REGSAM access;
+
+		// Set when the key is deleted while the handle is open; as in Windows,
+		// the handle then fails every call with ERROR_KEY_DELETED.
+		bool deleted;
+	};
+
+	// A pending RegNotifyChangeKeyValue(); signaled and dropped on the first
+	// change, as in Windows.
+	struct Notification
+	{
+		HKEY key;
+		wstring path;
+		bool watchSubtree;
+		HANDLE event;
+	};
+
+	// Keys and value names are case-insensitive; both are stored lower-cased.
+	struct RegistryState
+	{
+		mutex lock;
+		map<wstring, map<wstring, RegistryValue>> keys;
+		map<HKEY, OpenKey> openKeys;
+		map<wstring, LSTATUS> failingWrites;
+		vector<Notification> notifications;
+		uintptr_t nextHandle = 1;
+	};
+
+	RegistryState& State()
+	{
+		static RegistryState state;
+		return state;
+	}
+
+	atomic<uint64_t> callCount(0);
+
+	wstring Lower(LPCWSTR s)
+	{
+		wstring lower = s == nullptr ? L"" : s;
+		for (wchar_t& c : lower)
+		{
+			c = towlower(c);
+		}
+		return lower;
+	}
+
+	// Resolves a key handle plus optional sub key to a full path. Calls that
+	// use the handle itself, without a sub key, need 'access' on it. Must be
+	// called with the lock held.
+	LSTATUS ResolvePath(RegistryState& state, HKEY key, LPCWSTR subKey, REGSAM access, wstring& path)
+	{
+		if (key == HKEY_LOCAL_MACHINE)
+		{
+			path = L"hklm";
+		}
+		else if (key == HKEY_CURRENT_USER)
+		{
+			path = L"hkcu";
+		}
+		else if (key == HKEY_CLASSES_ROOT)
+		{
+			path = L"hkcr";
+		}
+		else
+		{
+			auto it = state.openKeys.find(key);
+			if (it == state.openKeys.end())
+			{
+				return ERROR_INVALID_HANDLE;
+			}
+			if (it->second.deleted)
+			{
+				return ERROR_KEY_DELETED;
+			}
+			bool hasSubKey = subKey != nullptr && *subKey != L'\0';
+			if (!hasSubKey && (it->second.access & access) != access)
+			{
+				return ERROR_ACCESS_DENIED;
+			}
+			path = it->second.path;
+		}
+
+		if (subKey != nullptr && *subKey != L'\0')
+		{
+			path += L"\\" + Lower(subKey);
+		}
+		return ERROR_SUCCESS;
+	}
+
+	bool IsSameOrSubKey(const wstring& path, const wstring& parent)
+	{
+		return path == parent || (path.size() > parent.size() && path.compare(0, parent.size(), parent) == 0 && path[parent.size()] == L'\\');
+	}
+
+	// Signals the notifications that 'matches' selects. Must be called with
+	// the lock held.
+	template<class Matches>
+	void SignalNotifications(RegistryState& state, Matches matches)
+	{
+		auto& notifications = state.notifications;
+		for (auto it = notifications.begin(); it != notifications.end();)
+		{
+			if (matches(*it))
+			{
+				SetEvent(it->event);
+				it = notifications.erase(it);
+			}
+			else
+			{
+				++it;
+			}
+		}
+	}
+
+	// Signals the notifications of the key at 'path' and of the keys above
+	// it that watch their sub tree.
+	void NotifyChange(RegistryState& state, const wstring& path)
+	{
+		SignalNotifications(state, [&path](const Notification& notification)
+		{
+			return notification.path == path || (notification.watchSubtree && IsSameOrSubKey(path, notification.path));
+		});
+	}
+
+	HKEY OpenHandle(RegistryState& state, const wstring& path, REGSAM access)
+	{
+		HKEY handle = reinterpret_cast<HKEY>(state.nextHandle++);
+		state.openKeys[handle] = OpenKey{ path, access, false };
+		return handle;
+	}
+
+	// Removes the key at 'path' with its sub keys. Must be called with the
+	// lock held.
+	void DeleteKey(RegistryState& state, const wstring& path)
+	{
+		for (auto it = state.keys.begin(); it != state.keys.end();)
+		{
+			if (IsSameOrSubKey(it->first, path))
+			{
+				it = state.keys.erase(it);
+			}
+			else
+			{
+				++it;
+			}
+		}
+		for (auto& openKey : state.openKeys)
+		{
+			if (IsSameOrSubKey(openKey.second.path, path))
+			{
+				openKey.second.deleted = true;
+			}
+		}
+		SignalNotifications(state, [&path](const Notification& notification)
+		{
+			return IsSameOrSubKey(notification.path, path) || (notification.watchSubtree && IsSameOrSubKey(path, notification.path));
+		});
+	}
+
+	LSTATUS StoreValue(RegistryState& state, const wstring& path, LPCWSTR valueName, DWORD type, const void* data, DWORD dataSize)
+	{
+		const BYTE* bytes = reinterpret_cast<const BYTE*>(data);
+		state.keys[path][Lower(valueName)] = RegistryValue{ type, vector<BYTE>(bytes, bytes + dataSize) };
+		NotifyChange(state, path);
+		return ERROR_SUCCESS;
+	}
+
+	// Store for the Reg* calls, which can be made to fail.
+	LSTATUS WriteValue(RegistryState& state, const wstring& path, LPCWSTR valueName, DWORD type, const void* data, DWORD dataSize)
+	{
+		auto failing = state.failingWrites.find(path);
+		if (failing != state.failingWrites.end())
+		{
+			return failing->second;
+		}
+		return StoreValue(state, path, valueName, type, data, dataSize);
+	}
+
+	LSTATUS LoadValue(RegistryState& state, const wstring& path, LPCWSTR valueName, DWORD flags, DWORD* type, void* data, DWORD* dataSize)
+	{
+		auto key = state.keys.find(path);
+		if (key == state.keys.end())
+		{
+			return ERROR_FILE_NOT_FOUND;
+		}
+		auto value = key->second.find(Lower(valueName));
+		if (value == key->second.end())
+		{
+			return ERROR_FILE_NOT_FOUND;
+		}
+
+		const RegistryValue& stored = value->second;
+		if ((flags == RRF_RT_REG_SZ && stored.type != REG_SZ) ||
+			(flags == RRF_RT_REG_DWORD && stored.type != REG_DWORD))
+		{
+			return ERROR_UNSUPPORTED_TYPE;
+		}
+
+		if (type != nullptr)
+		{
+			*type = stored.type;
+		}
+		if (dataSize == nullptr)
+		{
+			return data == nullptr ? ERROR_SUCCESS : ERROR_INVALID_PARAMETER;
+		}
+
+		DWORD available = *dataSize;
+		*dataSize = static_cast<DWORD>(stored.data.size());
+		if (data == nullptr)
+		{
+			return ERROR_SUCCESS;
+		}
+		if (available < stored.data.size())
+		{
+			return ERROR_MORE_DATA;
+		}
+		memcpy(data, stored.data.data(), stored.data.size());
+		return ERROR_SUCCESS;
+	}
+}
+
+namespace Fakes
+{
+	void FakeRegistry::Reset()
+	{
+		RegistryState& state = State();
+		lock_guard<mutex> guard(state.lock);
+		state.keys.clear();
+		state.failingWrites.clear();
+		for (auto& openKey : state.openKeys)
+		{
+			openKey.second.deleted = true;
+		}
+		SignalNotifications(state, [](const Notification&) { return true; });
+	}
+
+	void FakeRegistry::DeleteKey(const wstring& subKey)
+	{
+		RegistryState& state = State();
+		lock_guard<mutex> guard(state.lock);
+		::DeleteKey(state, L"hklm\\" + Lower(subKey.c_str()));
+	}
+
+	void FakeRegistry::FailWrites(const wstring& subKey, long error)
+	{
+		RegistryState& state = State();
+		lock_guard<mutex> guard(state.lock);
+		wstring path = L"hklm\\" + Lower(subKey.c_str());
+		if (error == ERROR_SUCCESS)
+		{
+			state.failingWrites.erase(path);
+		}
+		else
+		{
+			state.failingWrites[path] = error;
+		}
+	}
+
+	void FakeRegistry::SetValue(const wstring& subKey, const wstring& valueName, const wstring& value)
+	{
+		RegistryState& state = State();
+		lock_guard<mutex> guard(state.lock);
+		StoreValue(state, L"hklm\\" + Lower(subKey.c_str()), valueName.c_str(), REG_SZ, value.c_str(), static_cast<DWORD>((value.size() + 1) * sizeof(wchar_t)));
+	}
+
+	void FakeRegistry::SetValue(const wstring& subKey, const wstring& valueName, unsigned long value)
+	{
+		RegistryState& state = State();
+		lock_guard<mutex> guard(state.lock);
+		StoreValue(state, L"hklm\\" + Lower(subKey.c_str()), valueName.c_str(), REG_DWORD, &value, sizeof(value));
+	}
+
+	uint64_t FakeRegistry::CallCount()
+	{
+		return callCount;
+	}
+
+	uint64_t FakeRegistry::OpenKeyCount()
+	{
+		RegistryState& state = State();
+		lock_guard<mutex> guard(state.lock);
+		return state.openKeys.size();
+	}
+}
+
+LSTATUS RegCreateKeyEx(HKEY key, LPCWSTR subKey, DWORD, LPWSTR, DWORD, REGSAM access, void*, PHKEY result, DWORD* disposition)
+{
+	++callCount;
+	RegistryState& state = State();
+	lock_guard<mutex> guard(state.lock);
+
+	wstring path;
+	LSTATUS status = ResolvePath(state, key, subKey, 0, path);
+	if (status != ERROR_SUCCESS)
+	{
+		return status;
+	}
+
+	bool existed = state.keys.count(path) != 0;
+	state.keys[path];
+	if (disposition != nullptr)
+	{
+		*disposition = existed ? REG_OPENED_EXISTING_KEY : REG_CREATED_NEW_KEY;
+	}
+	*result = OpenHandle(state, path, access);
+	return ERROR_SUCCESS;
+}
+
+LSTATUS RegOpenKeyEx(HKEY key, LPCWSTR subKey, DWORD, REGSAM access, PHKEY result)
+{
+	++callCount;
+	RegistryState& state = State();
+	lock_guard<mutex> guard(state.lock);
+
+	wstring path;
+	LSTATUS status = ResolvePath(state, key, subKey, 0, path);
+	if (status != ERROR_SUCCESS)
+	{
+		return status;
+	}
+	if (state.keys.count(path) == 0)
+	{
+		return ERROR_FILE_NOT_FOUND;
+	}
+	*result = OpenHandle(state, path, access);
+	return ERROR_SUCCESS;
+}
+
+LSTATUS RegOpenKey(HKEY key, LPCWSTR subKey, PHKEY result)
+{
+	return RegOpenKeyEx(key, subKey, 0, KEY_ALL_ACCESS, result);
+}
+
+LSTATUS RegCloseKey(HKEY key)
+{
+	++callCount;
+	RegistryState& state = State();
+	lock_guard<mutex> guard(state.lock);
+
+	// Closing a key signals its pending notifications.
+	SignalNotifications(state, [key](const Notification& notification)
+	{
+		return notification.key == key;
+	});
+	return state.openKeys.erase(key) == 0 ? ERROR_INVALID_HANDLE : ERROR_SUCCESS;
+}
+
+LSTATUS RegSetValueEx(HKEY key, LPCWSTR valueName, DWORD, DWORD type, const BYTE* data, DWORD dataSize)
+{
+	++callCount;
+	RegistryState& state = State();
+	lock_guard<mutex> guard(state.lock);
+
+	wstring path;
+	LSTATUS status = ResolvePath(state, key, nullptr, KEY_SET_VALUE, path);
+	if (status != ERROR_SUCCESS)
+	{
+		return status;
+	}
+	return WriteValue(state, path, valueName, type, data, dataSize);
+}
+
+LSTATUS RegSetKeyValue(HKEY key, LPCWSTR subKey, LPCWSTR valueName, DWORD type, const void* data, DWORD dataSize)
+{
+	++callCount;
+	RegistryState& state = State();
+	lock_guard<mutex> guard(state.lock);
+
+	wstring path;
+	LSTATUS status = ResolvePath(state, key, subKey, KEY_SET_VALUE, path);
+	if (status != ERROR_SUCCESS)
+	{
+		return status;
+	}
+	return WriteValue(state, path, valueName, type, data, dataSize);
+}
+
+LSTATUS RegGetValue(HKEY key, LPCWSTR subKey, LPCWSTR valueName, DWORD flags, DWORD* type, void* data, DWORD* dataSize)
+{
+	++callCount;
+	RegistryState& state = State();
+	lock_guard<mutex> guard(state.lock);
+
+	wstring path;
+	LSTATUS status = ResolvePath(state, key, subKey, KEY_QUERY_VALUE, path);
+	if (status != ERROR_SUCCESS)
+	{
+		return status;
+	}
+	return LoadValue(state, path, valueName, flags, type, data, dataSize);
+}
+
+LSTATUS RegQueryValueEx(HKEY key, LPCWSTR valueName, DWORD*, DWORD* type, BYTE* data, DWORD* dataSize)
+{
+	++callCount;
+	RegistryState& state = State();
+	lock_guard<mutex> guard(state.lock);
+
+	wstring path;
+	LSTATUS status = ResolvePath(state, key, nullptr, KEY_QUERY_VALUE, path);
+	if (status != ERROR_SUCCESS)
+	{
+		return status;
+	}
+	return LoadValue(state, path, valueName, RRF_RT_ANY, type, data, dataSize);
+}
+
+LSTATUS RegDeleteKeyValue(HKEY key, LPCWSTR subKey, LPCWSTR valueName)
+{
+	++callCount;
+	RegistryState& state = State();
+	lock_guard<mutex> guard(state.lock);
+
+	wstring path;
+	LSTATUS status = ResolvePath(state, key, subKey, KEY_SET_VALUE, path);
+	if (status != ERROR_SUCCESS)
+	{
+		return status;
+	}
+	auto keyIt = state.keys.find(path);
+	if (keyIt == state.keys.end() || keyIt->second.erase(Lower(valueName)) == 0)
+	{
+		return ERROR_FILE_NOT_FOUND;
+	}
+	NotifyChange(state, path);
+	return ERROR_SUCCESS;
+}
+
+LSTATUS RegDeleteValue(HKEY key, LPCWSTR valueName)
+{
+	return RegDeleteKeyValue(key, nullptr, valueName);
+}
+
+// Only asynchronous notification of value changes is supported.
+LSTATUS RegNotifyChangeKeyValue(HKEY key, BOOL watchSubtree, DWORD, HANDLE event, BOOL asynchronous)
+{
+	++callCount;
+	if (!asynchronous || event == NULL)
+	{
+		return ERROR_INVALID_PARAMETER;
+	}
+
+	RegistryState& state = State();
+	lock_guard<mutex> guard(state.lock);
+
+	wstring path;
+	LSTATUS status = ResolvePath(state, key, nullptr, KEY_NOTIFY, path);
+	if (status != ERROR_SUCCESS)
+	{
+		return status;
+	}
+	state.notifications.push_back(Notification{ key, path, watchSubtree != FALSE, event });
+	return ERROR_SUCCESS;
+}
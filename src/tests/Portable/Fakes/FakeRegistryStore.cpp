@@ -0,0 +1,189 @@
+/*
+Copyright 2018 Microsoft
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH
+THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "stdafx.h"
+#include "Fakes.h"
+
+using namespace std;
+
+namespace Fakes
+{
+	FakeRegistryStore::FakeRegistryStore(Notify notify) :
+		_notify(notify),
+		_readError(ERROR_SUCCESS),
+		_reads(0),
+		_holdNext(false),
+		_held(false),
+		_paused(false),
+		_notifying(false),
+		_stopping(false)
+	{
+		if (_notify == Notify::OnWatchThread)
+		{
+			_watchThread = thread(&FakeRegistryStore::WatchThread, this);
+		}
+	}
+
+	// Notifications not yet delivered are dropped.
+	FakeRegistryStore::~FakeRegistryStore()
+	{
+		{
+			lock_guard<mutex> lock(_holdMutex);
+			_holdNext = false;
+		}
+		ReleaseRead();
+		if (_watchThread.joinable())
+		{
+			{
+				lock_guard<mutex> lock(_notificationsMutex);
+				_stopping = true;
+			}
+			_notificationsChanged.notify_all();
+			_watchThread.join();
+		}
+	}
+
+	LSTATUS FakeRegistryStore::TryReadValue(const wstring& subKey, const wstring& propName, wstring& propValue) const
+	{
+		++_reads;
+		LSTATUS status = _readError;
+		if (status == ERROR_SUCCESS)
+		{
+			status = MemoryRegistryStore::TryReadValue(subKey, propName, propValue);
+		}
+		HoldIfAsked();
+		return status;
+	}
+
+	LSTATUS FakeRegistryStore::TryReadValue(const wstring& subKey, const wstring& propName, unsigned long& propValue) const
+	{
+		++_reads;
+		LSTATUS status = _readError;
+		if (status == ERROR_SUCCESS)
+		{
+			status = MemoryRegistryStore::TryReadValue(subKey, propName, propValue);
+		}
+		HoldIfAsked();
+		return status;
+	}
+
+	void FakeRegistryStore::WatchKey(const wstring& subKey, const function<void()>& onChange)
+	{
+		switch (_notify)
+		{
+		case Notify::OnWritingThread:
+			MemoryRegistryStore::WatchKey(subKey, onChange);
+			break;
+		case Notify::OnWatchThread:
+			MemoryRegistryStore::WatchKey(subKey, [this, onChange]()
+			{
+				{
+					lock_guard<mutex> lock(_notificationsMutex);
+					_notifications.push_back(onChange);
+				}
+				_notificationsChanged.notify_all();
+			});
+			break;
+		case Notify::Never:
+			break;
+		}
+	}
+
+	void FakeRegistryStore::FailReads(LSTATUS error)
+	{
+		_readError = error;
+	}
+
+	uint64_t FakeRegistryStore::Reads() const
+	{
+		return _reads;
+	}
+
+	void FakeRegistryStore::HoldNextRead()
+	{
+		lock_guard<mutex> lock(_holdMutex);
+		_holdNext = true;
+	}
+
+	void FakeRegistryStore::WaitForHeldRead()
+	{
+		unique_lock<mutex> lock(_holdMutex);
+		_holdChanged.wait(lock, [this]() { return _held; });
+	}
+
+	void FakeRegistryStore::ReleaseRead()
+	{
+		{
+			lock_guard<mutex> lock(_holdMutex);
+			_held = false;
+		}
+		_holdChanged.notify_all();
+	}
+
+	void FakeRegistryStore::PauseNotifications()
+	{
+		lock_guard<mutex> lock(_notificationsMutex);
+		_paused = true;
+	}
+
+	void FakeRegistryStore::ResumeNotifications()
+	{
+		{
+			lock_guard<mutex> lock(_notificationsMutex);
+			_paused = false;
+		}
+		_notificationsChanged.notify_all();
+	}
+
+	void FakeRegistryStore::WaitWhileNotifying()
+	{
+		unique_lock<mutex> lock(_notificationsMutex);
+		_notificationsChanged.wait(lock, [this]() { return !_notifying; });
+	}
+
+	void FakeRegistryStore::HoldIfAsked() const
+	{
+		unique_lock<mutex> lock(_holdMutex);
+		if (!_holdNext)
+		{
+			return;
+		}
+		_holdNext = false;
+		_held = true;
+		_holdChanged.notify_all();
+		_holdChanged.wait(lock, [this]() { return !_held; });
+	}
+
+	void FakeRegistryStore::WatchThread()
+	{
+		unique_lock<mutex> lock(_notificationsMutex);
+		for (;;)
+		{
+			_notificationsChanged.wait(lock, [this]() { return _stopping || (!_paused && !_notifications.empty()); });
+			if (_stopping)
+			{
+				return;
+			}
+			function<void()> onChange = move(_notifications.front());
+			_notifications.pop_front();
+			_notifying = true;
+			lock.unlock();
+			onChange();
+			lock.lock();
+			_notifying = false;
+			_notificationsChanged.notify_all();
+		}
+	}
+}
@@ -0,0 +1,257 @@
+/*
+Copyright 2018 Microsoft
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH
+THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "stdafx.h"
+#include <atomic>
+#include <map>
+#include "Fakes.h"
+#include "StringUtils.h"
+
+using namespace std;
+
+namespace
+{
+	struct Service
+	{
+		DWORD state;
+		DWORD startType;
+	};
+
+	// An SC_HANDLE points at one of these; managers have an empty name.
+	struct OpenHandle
+	{
+		wstring serviceName;
+		DWORD access;
+	};
+
+	struct ScmState
+	{
+		mutex lock;
+		map<wstring, Service, Utils::CaseInsensitiveLess> services;
+	};
+
+	ScmState& State()
+	{
+		static ScmState state;
+		return state;
+	}
+
+	atomic<uint64_t> callCount(0);
+
+	OpenHandle* FromHandle(SC_HANDLE handle)
+	{
+		return reinterpret_cast<OpenHandle*>(handle);
+	}
+
+	// Must be called with the lock held.
+	Service* Find(ScmState& state, SC_HANDLE handle, DWORD requiredAccess)
+	{
+		OpenHandle* open = FromHandle(handle);
+		if (open == nullptr || open->serviceName.empty())
+		{
+			SetLastError(ERROR_INVALID_HANDLE);
+			return nullptr;
+		}
+		if ((open->access & requiredAccess) != requiredAccess)
+		{
+			SetLastError(ERROR_ACCESS_DENIED);
+			return nullptr;
+		}
+		auto it = state.services.find(open->serviceName);
+		if (it == state.services.end())
+		{
+			SetLastError(ERROR_SERVICE_DOES_NOT_EXIST);
+			return nullptr;
+		}
+		return &it->second;
+	}
+}
+
+namespace Fakes
+{
+	void FakeServiceControlManager::Reset()
+	{
+		ScmState& state = State();
+		lock_guard<mutex> guard(state.lock);
+		state.services.clear();
+	}
+
+	void FakeServiceControlManager::AddService(const wstring& serviceName, unsigned long state, unsigned long startType)
+	{
+		ScmState& scm = State();
+		lock_guard<mutex> guard(scm.lock);
+		scm.services[serviceName] = Service{ state, startType };
+	}
+
+	unsigned long FakeServiceControlManager::GetState(const wstring& serviceName)
+	{
+		ScmState& state = State();
+		lock_guard<mutex> guard(state.lock);
+		auto it = state.services.find(serviceName);
+		return it == state.services.end() ? 0 : it->second.state;
+	}
+
+	unsigned long FakeServiceControlManager::GetStartType(const wstring& serviceName)
+	{
+		ScmState& state = State();
+		lock_guard<mutex> guard(state.lock);
+		auto it = state.services.find(serviceName);
+		return it == state.services.end() ? 0 : it->second.startType;
+	}
+
+	uint64_t FakeServiceControlManager::CallCount()
+	{
+		return callCount;
+	}
+}
+
+SC_HANDLE OpenSCManager(LPCWSTR, LPCWSTR, DWORD desiredAccess)
+{
+	++callCount;
+	return reinterpret_cast<SC_HANDLE>(new OpenHandle{ wstring(), desiredAccess });
+}
+
+SC_HANDLE OpenService(SC_HANDLE serviceManager, LPCWSTR serviceName, DWORD desiredAccess)
+{
+	++callCount;
+	if (serviceManager == nullptr || !FromHandle(serviceManager)->serviceName.empty())
+	{
+		SetLastError(ERROR_INVALID_HANDLE);
+		return nullptr;
+	}
+
+	ScmState& state = State();
+	lock_guard<mutex> guard(state.lock);
+	if (state.services.find(serviceName) == state.services.end())
+	{
+		SetLastError(ERROR_SERVICE_DOES_NOT_EXIST);
+		return nullptr;
+	}
+	return reinterpret_cast<SC_HANDLE>(new OpenHandle{ serviceName, desiredAccess });
+}
+
+BOOL CloseServiceHandle(SC_HANDLE handle)
+{
+	++callCount;
+	if (handle == nullptr)
+	{
+		SetLastError(ERROR_INVALID_HANDLE);
+		return FALSE;
+	}
+	delete FromHandle(handle);
+	return TRUE;
+}
+
+BOOL QueryServiceStatus(SC_HANDLE handle, SERVICE_STATUS* serviceStatus)
+{
+	++callCount;
+	ScmState& state = State();
+	lock_guard<mutex> guard(state.lock);
+	Service* service = Find(state, handle, SERVICE_QUERY_STATUS);
+	if (service == nullptr)
+	{
+		return FALSE;
+	}
+
+	ZeroMemory(serviceStatus, sizeof(*serviceStatus));
+	serviceStatus->dwCurrentState = service->state;
+	return TRUE;
+}
+
+BOOL QueryServiceConfig(SC_HANDLE handle, QUERY_SERVICE_CONFIG* serviceConfig, DWORD bufferSize, DWORD* bytesNeeded)
+{
+	++callCount;
+	ScmState& state = State();
+	lock_guard<mutex> guard(state.lock);
+	Service* service = Find(state, handle, SERVICE_QUERY_CONFIG);
+	if (service == nullptr)
+	{
+		return FALSE;
+	}
+
+	*bytesNeeded = sizeof(QUERY_SERVICE_CONFIG);
+	if (serviceConfig == nullptr || bufferSize < sizeof(QUERY_SERVICE_CONFIG))
+	{
+		SetLastError(ERROR_INSUFFICIENT_BUFFER);
+		return FALSE;
+	}
+
+	ZeroMemory(serviceConfig, sizeof(*serviceConfig));
+	serviceConfig->dwStartType = service->startType;
+	return TRUE;
+}
+
+BOOL StartService(SC_HANDLE handle, DWORD, LPCWSTR*)
+{
+	++callCount;
+	ScmState& state = State();
+	lock_guard<mutex> guard(state.lock);
+	Service* service = Find(state, handle, SERVICE_START);
+	if (service == nullptr)
+	{
+		return FALSE;
+	}
+	if (service->state == SERVICE_RUNNING)
+	{
+		SetLastError(ERROR_SERVICE_ALREADY_RUNNING);
+		return FALSE;
+	}
+
+	service->state = SERVICE_RUNNING;
+	return TRUE;
+}
+
+BOOL ControlService(SC_HANDLE handle, DWORD control, SERVICE_STATUS* serviceStatus)
+{
+	++callCount;
+	ScmState& state = State();
+	lock_guard<mutex> guard(state.lock);
+	Service* service = Find(state, handle, control == SERVICE_CONTROL_STOP ? SERVICE_STOP : SERVICE_USER_DEFINED_CONTROL);
+	if (service == nullptr)
+	{
+		return FALSE;
+	}
+	if (service->state != SERVICE_RUNNING)
+	{
+		SetLastError(ERROR_SERVICE_NOT_ACTIVE);
+		return FALSE;
+	}
+
+	if (control == SERVICE_CONTROL_STOP)
+	{
+		service->state = SERVICE_STOPPED;
+	}
+	ZeroMemory(serviceStatus, sizeof(*serviceStatus));
+	serviceStatus->dwCurrentState = service->state;
+	return TRUE;
+}
+
+BOOL ChangeServiceConfig(SC_HANDLE handle, DWORD, DWORD startType, DWORD, LPCWSTR, LPCWSTR, DWORD*, LPCWSTR, LPCWSTR, LPCWSTR, LPCWSTR)
+{
+	++callCount;
+	ScmState& state = State();
+	lock_guard<mutex> guard(state.lock);
+	Service* service = Find(state, handle, SERVICE_CHANGE_CONFIG);
+	if (service == nullptr)
+	{
+		return FALSE;
+	}
+
+	if (startType != SERVICE_NO_CHANGE)
+	{
+		service->startType = startType;
+	}
+	return TRUE;
+}
@@ -0,0 +1,56 @@
+/*
+Copyright 2018 Microsoft
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH
+THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "stdafx.h"
+#include <atomic>
+#include "Fakes.h"
+
+using namespace std;
+
+namespace
+{
+	mutex computerNameLock;
+	wstring computerName = L"MINWINPC";
+	atomic<uint64_t> computerNameCalls(0);
+}
+
+namespace Fakes
+{
+	void FakeSystem::SetComputerName(const wstring& newComputerName)
+	{
+		lock_guard<mutex> guard(computerNameLock);
+		computerName = newComputerName;
+	}
+
+	uint64_t FakeSystem::ComputerNameCallCount()
+	{
+		return computerNameCalls;
+	}
+}
+
+BOOL GetComputerNameEx(COMPUTER_NAME_FORMAT, wchar_t* buffer, DWORD* size)
+{
+	++computerNameCalls;
+	lock_guard<mutex> guard(computerNameLock);
+	if (*size <= computerName.size())
+	{
+		*size = static_cast<DWORD>(computerName.size() + 1);
+		SetLastError(ERROR_MORE_DATA);
+		return FALSE;
+	}
+	wcscpy_s(buffer, *size, computerName.c_str());
+	*size = static_cast<DWORD>(computerName.size());
+	return TRUE;
+}
@@ -0,0 +1,166 @@
+/*
+Copyright 2018 Microsoft
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH
+THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include "RegistryStore.h"
+
+// Control surface of the in-memory fakes that stand in for the registry, the
+// service control manager and process launch on non-Windows builds. Every
+// fake counts the API calls it serves so benchmarks and tests can tell how
+// much system traffic an operation causes. The counts are cumulative; take
+// the difference around an operation to measure it.
+namespace Fakes
+{
+	class FakeRegistry
+	{
+	public:
+		// Removes every key and value. Keys still open fail every further
+		// call with ERROR_KEY_DELETED, as they do in Windows.
+		static void Reset();
+
+		// Removes an HKEY_LOCAL_MACHINE key with its values and sub keys.
+		static void DeleteKey(const std::wstring& subKey);
+
+		// Makes every value write to an HKEY_LOCAL_MACHINE key fail with
+		// 'error' until it is called again with ERROR_SUCCESS or Reset().
+		static void FailWrites(const std::wstring& subKey, long error);
+
+		// Seed HKEY_LOCAL_MACHINE values without counting as calls.
+		static void SetValue(const std::wstring& subKey, const std::wstring& valueName, const std::wstring& value);
+		static void SetValue(const std::wstring& subKey, const std::wstring& valueName, unsigned long value);
+
+		// Number of Reg* calls served.
+		static uint64_t CallCount();
+
+		// Number of keys currently opened and not yet closed.
+		static uint64_t OpenKeyCount();
+	};
+
+	class FakeServiceControlManager
+	{
+	public:
+		// Removes every service.
+		static void Reset();
+
+		// Registers a service; state and startType take the SERVICE_* values.
+		static void AddService(const std::wstring& serviceName, unsigned long state, unsigned long startType);
+
+		static unsigned long GetState(const std::wstring& serviceName);
+		static unsigned long GetStartType(const std::wstring& serviceName);
+
+		// Number of SCM calls served.
+		static uint64_t CallCount();
+	};
+
+	class FakeProcess
+	{
+	public:
+		// Computes the output and exit code of a launched command line.
+		typedef std::function<std::string(const std::wstring& commandString, unsigned long& returnCode)> Handler;
+
+		// Restores the default handler, which outputs nothing and exits with 0.
+		static void Reset();
+		static void SetHandler(const Handler& handler);
+
+		// Number of Process::Launch() calls.
+		static uint64_t LaunchCount();
+	};
+
+	class FakeSystem
+	{
+	public:
+		// Name returned by GetComputerNameEx().
+		static void SetComputerName(const std::wstring& computerName);
+
+		// Number of GetComputerNameEx() calls served.
+		static uint64_t ComputerNameCallCount();
+	};
+
+	// A MemoryRegistryStore for tests of the classes that cache what they
+	// read from the registry. It counts the reads, can fail them or hold one
+	// back, and can leave out the change notifications so that only the
+	// class itself updates its cache.
+	class FakeRegistryStore : public Utils::MemoryRegistryStore
+	{
+	public:
+		enum class Notify
+		{
+			OnWritingThread,
+			// One at a time, in order, on a thread of the store's own, as
+			// Win32RegistryStore does.
+			OnWatchThread,
+			Never,
+		};
+
+		explicit FakeRegistryStore(Notify notify = Notify::OnWritingThread);
+		~FakeRegistryStore();
+
+		LSTATUS TryReadValue(const std::wstring& subKey, const std::wstring& propName, std::wstring& propValue) const override;
+		LSTATUS TryReadValue(const std::wstring& subKey, const std::wstring& propName, unsigned long& propValue) const override;
+
+		void WatchKey(const std::wstring& subKey, const std::function<void()>& onChange) override;
+
+		// Fails every read with 'error' until it is called again with
+		// ERROR_SUCCESS.
+		void FailReads(LSTATUS error);
+
+		// Number of reads, failed or not.
+		uint64_t Reads() const;
+
+		// Makes the next read wait, once it has read the value, until
+		// ReleaseRead() is called.
+		void HoldNextRead();
+		// Waits until a read is being held.
+		void WaitForHeldRead();
+		void ReleaseRead();
+
+		// With Notify::OnWatchThread, keeps the notifications queued from
+		// when the one being delivered, if any, returns.
+		void PauseNotifications();
+		void ResumeNotifications();
+		// Waits until no notification is being delivered.
+		void WaitWhileNotifying();
+
+	private:
+		void HoldIfAsked() const;
+		void WatchThread();
+
+		Notify _notify;
+		std::atomic<LSTATUS> _readError;
+		mutable std::atomic<uint64_t> _reads;
+
+		mutable std::mutex _holdMutex;
+		mutable std::condition_variable _holdChanged;
+		mutable bool _holdNext;
+		mutable bool _held;
+
+		std::mutex _notificationsMutex;
+		std::condition_variable _notificationsChanged;
+		std::deque<std::function<void()>> _notifications;
+		bool _paused;
+		bool _notifying;
+		bool _stopping;
+		std::thread _watchThread;
+	};
+}
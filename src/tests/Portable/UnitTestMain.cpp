@@ -0,0 +1,116 @@
+/*
+Copyright 2018 Microsoft
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH
+THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "stdafx.h"
+#include <cstring>
+#include <iostream>
+#include "CppUnitTest.h"
+#include "StringUtils.h"
+
+using namespace std;
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+static bool verbose = false;
+
+void Microsoft::VisualStudio::CppUnitTestFramework::Logger::WriteMessage(const wchar_t* message)
+{
+	if (verbose)
+	{
+		wcerr << message << endl;
+	}
+}
+
+void Microsoft::VisualStudio::CppUnitTestFramework::Logger::WriteMessage(const char* message)
+{
+	WriteMessage(Utils::MultibyteToWide(message).c_str());
+}
+
+static void PrintUsage()
+{
+	wcout << L"Usage: DMBridge.UnitTests [--filter {substring}] [--verbose]" << endl;
+	wcout << L" --filter   only run tests whose Class::Method name contains {substring}." << endl;
+	wcout << L" --verbose  keep the bridge's console logging on." << endl;
+}
+
+// Results go to wcout: the bridge's logger has already claimed the console
+// for wide output.
+int main(int argc, char* argv[])
+{
+	string filter;
+	for (int i = 1; i < argc; ++i)
+	{
+		if (strcmp(argv[i], "--filter") == 0 && i + 1 < argc)
+		{
+			filter = argv[++i];
+		}
+		else if (strcmp(argv[i], "--verbose") == 0)
+		{
+			verbose = true;
+		}
+		else
+		{
+			PrintUsage();
+			return 1;
+		}
+	}
+
+	size_t passed = 0;
+	size_t failed = 0;
+	for (const TestMethodInfo& method : TestMethods())
+	{
+		string name = method.className + "::" + method.methodName;
+		if (!filter.empty() && name.find(filter) == string::npos)
+		{
+			continue;
+		}
+
+		wstring failure;
+		if (!verbose)
+		{
+			wcout.setstate(ios::badbit);
+		}
+		try
+		{
+			method.run();
+		}
+		catch (const AssertFailedException& e)
+		{
+			failure = e.Message();
+		}
+		catch (const exception& e)
+		{
+			failure = L"Unhandled exception: " + Utils::MultibyteToWide(e.what());
+		}
+		catch (...)
+		{
+			failure = L"Unhandled exception.";
+		}
+		wcout.clear();
+
+		if (failure.empty())
+		{
+			++passed;
+			wcout << L"  Passed  " << Utils::MultibyteToWide(name.c_str()) << endl;
+		}
+		else
+		{
+			++failed;
+			wcout << L"  FAILED  " << Utils::MultibyteToWide(name.c_str()) << endl << L"          " << failure << endl;
+		}
+	}
+
+	wcout << passed << L" passed, " << failed << L" failed" << endl;
+	return failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,571 @@
+/*
+Copyright 2018 Microsoft
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH
+THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "stdafx.h"
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <ctime>
+#include <functional>
+#include <map>
+#include <set>
+#include <string>
+#include <thread>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "StringUtils.h"
+
+using namespace std;
+
+static thread_local DWORD lastError = ERROR_SUCCESS;
+
+DWORD GetLastError()
+{
+	return lastError;
+}
+
+void SetLastError(DWORD error)
+{
+	lastError = error;
+}
+
+// Only CP_UTF8 is supported; wchar_t holds whole code points on these platforms.
+static void EncodeUtf8(uint32_t codePoint, string& output)
+{
+	if (codePoint < 0x80)
+	{
+		output += static_cast<char>(codePoint);
+	}
+	else if (codePoint < 0x800)
+	{
+		output += static_cast<char>(0xC0 | (codePoint >> 6));
+		output += static_cast<char>(0x80 | (codePoint & 0x3F));
+	}
+	else if (codePoint < 0x10000)
+	{
+		output += static_cast<char>(0xE0 | (codePoint >> 12));
+		output += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+		output += static_cast<char>(0x80 | (codePoint & 0x3F));
+	}
+	else
+	{
+		output += static_cast<char>(0xF0 | (codePoint >> 18));
+		output += static_cast<char>(0x80 | ((codePoint >> 12) & 0x3F));
+		output += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+		output += static_cast<char>(0x80 | (codePoint & 0x3F));
+	}
+}
+
+static void DecodeUtf8(const char* input, size_t length, wstring& output)
+{
+	const unsigned char* bytes = reinterpret_cast<const unsigned char*>(input);
+	size_t i = 0;
+	while (i < length)
+	{
+		unsigned char lead = bytes[i];
+		size_t trailing = lead < 0x80 ? 0 : lead < 0xE0 ? 1 : lead < 0xF0 ? 2 : 3;
+		uint32_t codePoint = trailing == 0 ? lead : lead & (0x3F >> trailing);
+		if (lead >= 0x80 && lead < 0xC0)
+		{
+			// Stray continuation byte.
+			output += L'\xFFFD';
+			++i;
+			continue;
+		}
+
+		size_t consumed = 1;
+		while (consumed <= trailing && i + consumed < length && (bytes[i + consumed] & 0xC0) == 0x80)
+		{
+			codePoint = (codePoint << 6) | (bytes[i + consumed] & 0x3F);
+			++consumed;
+		}
+		output += consumed == trailing + 1 ? static_cast<wchar_t>(codePoint) : L'\xFFFD';
+		i += consumed;
+	}
+}
+
+int WideCharToMultiByte(unsigned int, DWORD, const wchar_t* wide, int wideLength, char* multibyte, int multibyteSize, const char*, BOOL*)
+{
+	size_t length = wideLength < 0 ? wcslen(wide) + 1 : static_cast<size_t>(wideLength);
+	string converted;
+	for (size_t i = 0; i < length; ++i)
+	{
+		EncodeUtf8(static_cast<uint32_t>(wide[i]), converted);
+	}
+
+	if (multibyteSize == 0)
+	{
+		return static_cast<int>(converted.size());
+	}
+	if (converted.size() > static_cast<size_t>(multibyteSize))
+	{
+		SetLastError(ERROR_INSUFFICIENT_BUFFER);
+		return 0;
+	}
+	memcpy(multibyte, converted.data(), converted.size());
+	return static_cast<int>(converted.size());
+}
+
+int MultiByteToWideChar(unsigned int, DWORD, const char* multibyte, int multibyteLength, wchar_t* wide, int wideSize)
+{
+	size_t length = multibyteLength < 0 ? strlen(multibyte) + 1 : static_cast<size_t>(multibyteLength);
+	wstring converted;
+	DecodeUtf8(multibyte, length, converted);
+
+	if (wideSize == 0)
+	{
+		return static_cast<int>(converted.size());
+	}
+	if (converted.size() > static_cast<size_t>(wideSize))
+	{
+		SetLastError(ERROR_INSUFFICIENT_BUFFER);
+		return 0;
+	}
+	wmemcpy(wide, converted.data(), converted.size());
+	return static_cast<int>(converted.size());
+}
+
+errno_t wcscpy_s(wchar_t* destination, size_t destinationSize, const wchar_t* source)
+{
+	if (destination == nullptr || source == nullptr || destinationSize == 0)
+	{
+		return EINVAL;
+	}
+	size_t length = wcslen(source);
+	if (length >= destinationSize)
+	{
+		destination[0] = L'\0';
+		return ERANGE;
+	}
+	wmemcpy(destination, source, length + 1);
+	return 0;
+}
+
+void GetLocalTime(SYSTEMTIME* systemTime)
+{
+	chrono::system_clock::time_point now = chrono::system_clock::now();
+	time_t seconds = chrono::system_clock::to_time_t(now);
+	tm local;
+	localtime_r(&seconds, &local);
+
+	systemTime->wYear = static_cast<WORD>(local.tm_year + 1900);
+	systemTime->wMonth = static_cast<WORD>(local.tm_mon + 1);
+	systemTime->wDayOfWeek = static_cast<WORD>(local.tm_wday);
+	systemTime->wDay = static_cast<WORD>(local.tm_mday);
+	systemTime->wHour = static_cast<WORD>(local.tm_hour);
+	systemTime->wMinute = static_cast<WORD>(local.tm_min);
+	systemTime->wSecond = static_cast<WORD>(local.tm_sec);
+	systemTime->wMilliseconds = static_cast<WORD>(chrono::duration_cast<chrono::milliseconds>(now.time_since_epoch()).count() % 1000);
+}
+
+void Sleep(DWORD milliseconds)
+{
+	this_thread::sleep_for(chrono::milliseconds(milliseconds));
+}
+
+// Pseudo handle, as on Windows; GetThreadId() only accepts this one.
+HANDLE GetCurrentThread()
+{
+	return reinterpret_cast<HANDLE>(-2);
+}
+
+DWORD GetThreadId(HANDLE)
+{
+	return static_cast<DWORD>(hash<thread::id>()(this_thread::get_id()) & 0xFFFFFFFF);
+}
+
+// Every event shares one condition variable; a waiter woken by an event it
+// is not waiting for just checks its own events again.
+namespace
+{
+	struct Event
+	{
+		bool manualReset;
+		bool signaled;
+	};
+
+	mutex eventLock;
+	condition_variable eventSignaled;
+	set<Event*> events;
+
+	Event* FindEvent(HANDLE handle)
+	{
+		auto it = events.find(static_cast<Event*>(handle));
+		return it == events.end() ? nullptr : *it;
+	}
+}
+
+// Defined with the file functions below.
+static void CloseFileObject(HANDLE handle);
+
+BOOL CloseHandle(HANDLE handle)
+{
+	{
+		lock_guard<mutex> guard(eventLock);
+		Event* event = FindEvent(handle);
+		if (event != nullptr)
+		{
+			events.erase(event);
+			delete event;
+			return TRUE;
+		}
+	}
+	CloseFileObject(handle);
+	return TRUE;
+}
+
+HANDLE CreateEvent(void*, BOOL manualReset, BOOL initialState, LPCWSTR)
+{
+	lock_guard<mutex> guard(eventLock);
+	Event* event = new Event{ manualReset != FALSE, initialState != FALSE };
+	events.insert(event);
+	return event;
+}
+
+BOOL SetEvent(HANDLE handle)
+{
+	lock_guard<mutex> guard(eventLock);
+	Event* event = FindEvent(handle);
+	if (event == nullptr)
+	{
+		SetLastError(ERROR_INVALID_HANDLE);
+		return FALSE;
+	}
+	event->signaled = true;
+	eventSignaled.notify_all();
+	return TRUE;
+}
+
+BOOL ResetEvent(HANDLE handle)
+{
+	lock_guard<mutex> guard(eventLock);
+	Event* event = FindEvent(handle);
+	if (event == nullptr)
+	{
+		SetLastError(ERROR_INVALID_HANDLE);
+		return FALSE;
+	}
+	event->signaled = false;
+	return TRUE;
+}
+
+DWORD WaitForSingleObject(HANDLE handle, DWORD milliseconds)
+{
+	return WaitForMultipleObjects(1, &handle, FALSE, milliseconds);
+}
+
+DWORD WaitForMultipleObjects(DWORD count, const HANDLE* handles, BOOL waitAll, DWORD milliseconds)
+{
+	if (waitAll)
+	{
+		SetLastError(ERROR_INVALID_PARAMETER);
+		return WAIT_FAILED;
+	}
+
+	unique_lock<mutex> guard(eventLock);
+	auto deadline = chrono::steady_clock::now() + chrono::milliseconds(milliseconds);
+	for (;;)
+	{
+		for (DWORD i = 0; i < count; ++i)
+		{
+			Event* event = FindEvent(handles[i]);
+			if (event == nullptr)
+			{
+				SetLastError(ERROR_INVALID_HANDLE);
+				return WAIT_FAILED;
+			}
+			if (event->signaled)
+			{
+				if (!event->manualReset)
+				{
+					event->signaled = false;
+				}
+				return WAIT_OBJECT_0 + i;
+			}
+		}
+
+		if (milliseconds == INFINITE)
+		{
+			eventSignaled.wait(guard);
+		}
+		else if (eventSignaled.wait_until(guard, deadline) == cv_status::timeout)
+		{
+			return WAIT_TIMEOUT;
+		}
+	}
+}
+
+BOOL MoveFileEx(LPCWSTR existingFileName, LPCWSTR newFileName, DWORD)
+{
+	// rename() always replaces the destination.
+	if (rename(Utils::WideToMultibyte(existingFileName).c_str(), Utils::WideToMultibyte(newFileName).c_str()) != 0)
+	{
+		SetLastError(errno == ENOENT ? ERROR_FILE_NOT_FOUND : ERROR_ACCESS_DENIED);
+		return FALSE;
+	}
+	return TRUE;
+}
+
+BOOL DeleteFile(LPCWSTR fileName)
+{
+	if (remove(Utils::WideToMultibyte(fileName).c_str()) != 0)
+	{
+		SetLastError(errno == ENOENT ? ERROR_FILE_NOT_FOUND : ERROR_ACCESS_DENIED);
+		return FALSE;
+	}
+	return TRUE;
+}
+
+BOOL GetFileAttributesEx(LPCWSTR fileName, GET_FILEEX_INFO_LEVELS, void* fileInformation)
+{
+	struct stat status;
+	if (stat(Utils::WideToMultibyte(fileName).c_str(), &status) != 0)
+	{
+		SetLastError(errno == ENOENT ? ERROR_FILE_NOT_FOUND : ERROR_ACCESS_DENIED);
+		return FALSE;
+	}
+
+	// In 100ns intervals, as FILETIME counts them; the epoch does not matter
+	// for comparisons.
+	uint64_t lastWrite = static_cast<uint64_t>(status.st_mtim.tv_sec) * 10000000 + status.st_mtim.tv_nsec / 100;
+	uint64_t size = static_cast<uint64_t>(status.st_size);
+
+	WIN32_FILE_ATTRIBUTE_DATA* data = static_cast<WIN32_FILE_ATTRIBUTE_DATA*>(fileInformation);
+	*data = WIN32_FILE_ATTRIBUTE_DATA();
+	data->ftLastWriteTime.dwLowDateTime = static_cast<DWORD>(lastWrite & 0xFFFFFFFF);
+	data->ftLastWriteTime.dwHighDateTime = static_cast<DWORD>(lastWrite >> 32);
+	data->nFileSizeLow = static_cast<DWORD>(size & 0xFFFFFFFF);
+	data->nFileSizeHigh = static_cast<DWORD>(size >> 32);
+	return TRUE;
+}
+
+// File and file mapping handles both wrap a descriptor. A mapping has its
+// own, so it stays usable after its file is closed, as on Windows.
+namespace
+{
+	struct FileObject
+	{
+		int descriptor;
+	};
+
+	mutex fileLock;
+	set<FileObject*> fileObjects;
+	map<const void*, size_t> views;
+
+	FileObject* FindFileObject(HANDLE handle)
+	{
+		auto it = fileObjects.find(static_cast<FileObject*>(handle));
+		return it == fileObjects.end() ? nullptr : *it;
+	}
+
+	// Called with fileLock held.
+	HANDLE AddFileObject(int descriptor)
+	{
+		FileObject* file = new FileObject{ descriptor };
+		fileObjects.insert(file);
+		return file;
+	}
+
+	// Called with fileLock held.
+	bool TryGetSize(FileObject* file, uint64_t& size)
+	{
+		struct stat status;
+		if (file == nullptr || fstat(file->descriptor, &status) != 0)
+		{
+			SetLastError(ERROR_INVALID_HANDLE);
+			return false;
+		}
+		size = static_cast<uint64_t>(status.st_size);
+		return true;
+	}
+}
+
+static void CloseFileObject(HANDLE handle)
+{
+	lock_guard<mutex> guard(fileLock);
+	FileObject* file = FindFileObject(handle);
+	if (file != nullptr)
+	{
+		close(file->descriptor);
+		fileObjects.erase(file);
+		delete file;
+	}
+}
+
+HANDLE CreateFile(LPCWSTR fileName, DWORD, DWORD, void*, DWORD, DWORD, HANDLE)
+{
+	int descriptor = open(Utils::WideToMultibyte(fileName).c_str(), O_RDONLY | O_CLOEXEC);
+	if (descriptor < 0)
+	{
+		SetLastError(errno == ENOENT ? ERROR_FILE_NOT_FOUND : ERROR_ACCESS_DENIED);
+		return INVALID_HANDLE_VALUE;
+	}
+
+	lock_guard<mutex> guard(fileLock);
+	return AddFileObject(descriptor);
+}
+
+BOOL GetFileSizeEx(HANDLE file, LARGE_INTEGER* fileSize)
+{
+	lock_guard<mutex> guard(fileLock);
+	uint64_t size = 0;
+	if (!TryGetSize(FindFileObject(file), size))
+	{
+		return FALSE;
+	}
+	fileSize->QuadPart = static_cast<int64_t>(size);
+	return TRUE;
+}
+
+BOOL ReadFile(HANDLE file, void* buffer, DWORD numberOfBytesToRead, DWORD* numberOfBytesRead, void*)
+{
+	lock_guard<mutex> guard(fileLock);
+	FileObject* fileObject = FindFileObject(file);
+	if (fileObject == nullptr)
+	{
+		SetLastError(ERROR_INVALID_HANDLE);
+		return FALSE;
+	}
+
+	// Reads until the count or the end of the file, as ReadFile() does for
+	// a file on disk.
+	DWORD total = 0;
+	while (total < numberOfBytesToRead)
+	{
+		ssize_t count = read(fileObject->descriptor, static_cast<char*>(buffer) + total, numberOfBytesToRead - total);
+		if (count < 0)
+		{
+			SetLastError(ERROR_ACCESS_DENIED);
+			return FALSE;
+		}
+		if (count == 0)
+		{
+			break;
+		}
+		total += static_cast<DWORD>(count);
+	}
+	*numberOfBytesRead = total;
+	return TRUE;
+}
+
+HANDLE CreateFileMapping(HANDLE file, void*, DWORD, DWORD, DWORD, LPCWSTR)
+{
+	lock_guard<mutex> guard(fileLock);
+	FileObject* fileObject = FindFileObject(file);
+	uint64_t size = 0;
+	if (!TryGetSize(fileObject, size))
+	{
+		return NULL;
+	}
+	if (size == 0)
+	{
+		// Windows cannot map an empty file either.
+		SetLastError(ERROR_FILE_INVALID);
+		return NULL;
+	}
+
+	int descriptor = fcntl(fileObject->descriptor, F_DUPFD_CLOEXEC, 0);
+	if (descriptor < 0)
+	{
+		SetLastError(ERROR_NOT_ENOUGH_MEMORY);
+		return NULL;
+	}
+	return AddFileObject(descriptor);
+}
+
+void* MapViewOfFile(HANDLE fileMapping, DWORD, DWORD, DWORD, size_t numberOfBytesToMap)
+{
+	lock_guard<mutex> guard(fileLock);
+	FileObject* mapping = FindFileObject(fileMapping);
+	uint64_t size = numberOfBytesToMap;
+	if (size == 0 && !TryGetSize(mapping, size))
+	{
+		return NULL;
+	}
+
+	void* view = mapping == nullptr ? MAP_FAILED : mmap(nullptr, static_cast<size_t>(size), PROT_READ, MAP_PRIVATE, mapping->descriptor, 0);
+	if (view == MAP_FAILED)
+	{
+		SetLastError(mapping == nullptr ? ERROR_INVALID_HANDLE : ERROR_NOT_ENOUGH_MEMORY);
+		return NULL;
+	}
+	views[view] = static_cast<size_t>(size);
+	return view;
+}
+
+BOOL UnmapViewOfFile(const void* baseAddress)
+{
+	lock_guard<mutex> guard(fileLock);
+	auto it = views.find(baseAddress);
+	if (it == views.end())
+	{
+		SetLastError(ERROR_INVALID_PARAMETER);
+		return FALSE;
+	}
+	munmap(const_cast<void*>(it->first), it->second);
+	views.erase(it);
+	return TRUE;
+}
+
+unsigned int GetSystemDirectoryW(wchar_t* buffer, unsigned int size)
+{
+	const wchar_t systemDirectory[] = L"C:\\Windows\\System32";
+	if (size < _countof(systemDirectory))
+	{
+		return _countof(systemDirectory);
+	}
+	wcscpy_s(buffer, size, systemDirectory);
+	return _countof(systemDirectory) - 1;
+}
+
+DWORD GetModuleFileName(HANDLE, wchar_t* fileName, DWORD size)
+{
+	const wchar_t moduleFileName[] = L"C:\\Windows\\System32\\DMBridge.exe";
+	if (wcscpy_s(fileName, size, moduleFileName) != 0)
+	{
+		SetLastError(ERROR_INSUFFICIENT_BUFFER);
+		return size;
+	}
+	SetLastError(ERROR_SUCCESS);
+	return _countof(moduleFileName) - 1;
+}
+
+RPC_STATUS RpcBindingFree(RPC_BINDING_HANDLE* binding)
+{
+	*binding = nullptr;
+	return 0;
+}
+
+void* __RPC_USER midl_user_allocate(size_t size)
+{
+	return malloc(size);
+}
+
+void __RPC_USER midl_user_free(void* pointer)
+{
+	free(pointer);
+}
+
+// Distinct, otherwise meaningless, interface specs.
+static char interfaceSpecs[7];
+RPC_IF_HANDLE ComputerName_v1_0_s_ifspec = &interfaceSpecs[0];
+RPC_IF_HANDLE NTService_v1_0_s_ifspec = &interfaceSpecs[1];
+RPC_IF_HANDLE Telemetry_v1_0_s_ifspec = &interfaceSpecs[2];
+RPC_IF_HANDLE Tpm_v1_0_s_ifspec = &interfaceSpecs[3];
+RPC_IF_HANDLE ShutdownMgmt_v1_0_s_ifspec = &interfaceSpecs[4];
+RPC_IF_HANDLE UwpAppMgmt_v1_0_s_ifspec = &interfaceSpecs[5];
+RPC_IF_HANDLE Metrics_v1_0_s_ifspec = &interfaceSpecs[6];
@@ -0,0 +1,326 @@
+/*
+Copyright 2018 Microsoft
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH
+THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+// The subset of the Win32 API the bridge sources use, declared so they can be
+// built unmodified on other platforms. Registry and service control calls are
+// served by the in-memory fakes under Fakes/; everything else is implemented
+// in Win32Compat.cpp on top of the C++ standard library.
+
+#ifdef _WIN32
+#error Win32Compat.h is only meant for non-Windows builds.
+#endif
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cwchar>
+#include <cwctype>
+
+// Calling conventions, SAL annotations and storage classes.
+#define WINAPI
+#define __stdcall
+#define __RPC_USER
+#define __RPC_FAR
+#define _In_
+#define _In_opt_
+#define _Out_
+#define _Out_opt_
+#define _Outptr_
+#define _Inout_
+#define __declspec(x) __declspec_##x
+#define __declspec_selectany inline
+#define __FUNCTIONW__ L"" __FUNCTION__
+
+// Basic types. DWORD is an unsigned long so that the overloads and the
+// reinterpret_casts of registry data in RegistryUtils keep their meaning.
+typedef unsigned long DWORD;
+typedef long LONG;
+typedef LONG LSTATUS;
+typedef int32_t HRESULT;
+typedef int BOOL;
+typedef int32_t INT32;
+typedef unsigned char BYTE;
+typedef BYTE* LPBYTE;
+typedef unsigned short WORD;
+typedef wchar_t WCHAR;
+typedef const wchar_t* LPCWSTR;
+typedef wchar_t* LPWSTR;
+typedef int errno_t;
+typedef DWORD REGSAM;
+typedef void* HANDLE;
+typedef void* RPC_BINDING_HANDLE;
+typedef struct HKEY__* HKEY;
+typedef HKEY* PHKEY;
+typedef struct SC_HANDLE__* SC_HANDLE;
+
+#define TRUE 1
+#define FALSE 0
+#define MAX_PATH 260
+#define MAX_COMPUTERNAME_LENGTH 15
+#define CP_UTF8 65001
+#define INFINITE 0xFFFFFFFF
+#define ARRAYSIZE(a) (sizeof(a) / sizeof((a)[0]))
+
+#define _countof(array) (sizeof(array) / sizeof((array)[0]))
+#define ZeroMemory(destination, length) memset((destination), 0, (length))
+
+// Errors.
+#define ERROR_SUCCESS 0L
+#define ERROR_FILE_NOT_FOUND 2L
+#define ERROR_ACCESS_DENIED 5L
+#define ERROR_INVALID_HANDLE 6L
+#define ERROR_NOT_ENOUGH_MEMORY 8L
+#define ERROR_INVALID_DATA 13L
+#define ERROR_WRITE_FAULT 29L
+#define ERROR_GEN_FAILURE 31L
+#define ERROR_INVALID_PARAMETER 87L
+#define ERROR_INSUFFICIENT_BUFFER 122L
+#define ERROR_BAD_ARGUMENTS 160L
+#define ERROR_MORE_DATA 234L
+#define ERROR_FILE_INVALID 1006L
+#define ERROR_KEY_DELETED 1018L
+#define ERROR_INVALID_COMPUTERNAME 1210L
+#define ERROR_INVALID_SERVICENAME 1213L
+#define ERROR_SERVICE_ALREADY_RUNNING 1056L
+#define ERROR_SERVICE_DOES_NOT_EXIST 1060L
+#define ERROR_SERVICE_NOT_ACTIVE 1062L
+#define ERROR_UNSUPPORTED_TYPE 1630L
+
+#define S_OK ((HRESULT)0L)
+#define S_FALSE ((HRESULT)1L)
+#define E_FAIL ((HRESULT)0x80004005L)
+#define E_OUTOFMEMORY ((HRESULT)0x8007000EL)
+#define E_INVALIDARG ((HRESULT)0x80070057L)
+#define SUCCEEDED(hr) (((HRESULT)(hr)) >= 0)
+#define FAILED(hr) (((HRESULT)(hr)) < 0)
+
+inline HRESULT HRESULT_FROM_WIN32(unsigned long error)
+{
+	return (HRESULT)(error) <= 0 ? (HRESULT)(error) : (HRESULT)(((error) & 0x0000FFFF) | (7 << 16) | 0x80000000);
+}
+
+DWORD GetLastError();
+void SetLastError(DWORD error);
+
+// Strings.
+int WideCharToMultiByte(unsigned int codePage, DWORD flags, const wchar_t* wide, int wideLength, char* multibyte, int multibyteSize, const char* defaultChar, BOOL* usedDefaultChar);
+int MultiByteToWideChar(unsigned int codePage, DWORD flags, const char* multibyte, int multibyteLength, wchar_t* wide, int wideSize);
+errno_t wcscpy_s(wchar_t* destination, size_t destinationSize, const wchar_t* source);
+
+#define _wcsicmp wcscasecmp
+#define _wcsnicmp wcsncasecmp
+#define swprintf_s swprintf
+
+// Time and threads.
+typedef struct _SYSTEMTIME
+{
+	WORD wYear;
+	WORD wMonth;
+	WORD wDayOfWeek;
+	WORD wDay;
+	WORD wHour;
+	WORD wMinute;
+	WORD wSecond;
+	WORD wMilliseconds;
+} SYSTEMTIME;
+
+void GetLocalTime(SYSTEMTIME* systemTime);
+void Sleep(DWORD milliseconds);
+HANDLE GetCurrentThread();
+DWORD GetThreadId(HANDLE thread);
+BOOL CloseHandle(HANDLE handle);
+
+// Events. WaitForMultipleObjects() only supports waiting for any one event.
+#define WAIT_OBJECT_0 0x00000000L
+#define WAIT_TIMEOUT 0x00000102L
+#define WAIT_FAILED 0xFFFFFFFF
+
+HANDLE CreateEvent(void* eventAttributes, BOOL manualReset, BOOL initialState, LPCWSTR name);
+BOOL SetEvent(HANDLE event);
+BOOL ResetEvent(HANDLE event);
+DWORD WaitForSingleObject(HANDLE handle, DWORD milliseconds);
+DWORD WaitForMultipleObjects(DWORD count, const HANDLE* handles, BOOL waitAll, DWORD milliseconds);
+
+// Files. GetFileAttributesEx() only fills in the size and last write time.
+// Files can only be opened and mapped for reading, and a view always starts
+// at the beginning of the file.
+#define MOVEFILE_REPLACE_EXISTING 0x00000001
+#define GENERIC_READ 0x80000000
+#define FILE_SHARE_READ 0x00000001
+#define OPEN_EXISTING 3
+#define FILE_ATTRIBUTE_NORMAL 0x00000080
+#define PAGE_READONLY 0x02
+#define FILE_MAP_READ 0x0004
+#define INVALID_HANDLE_VALUE ((HANDLE)(intptr_t)-1)
+
+typedef struct _LARGE_INTEGER
+{
+	int64_t QuadPart;
+} LARGE_INTEGER;
+
+typedef struct _FILETIME
+{
+	DWORD dwLowDateTime;
+	DWORD dwHighDateTime;
+} FILETIME;
+
+typedef struct _WIN32_FILE_ATTRIBUTE_DATA
+{
+	DWORD dwFileAttributes;
+	FILETIME ftCreationTime;
+	FILETIME ftLastAccessTime;
+	FILETIME ftLastWriteTime;
+	DWORD nFileSizeHigh;
+	DWORD nFileSizeLow;
+} WIN32_FILE_ATTRIBUTE_DATA;
+
+typedef enum _GET_FILEEX_INFO_LEVELS
+{
+	GetFileExInfoStandard,
+} GET_FILEEX_INFO_LEVELS;
+
+BOOL MoveFileEx(LPCWSTR existingFileName, LPCWSTR newFileName, DWORD flags);
+BOOL DeleteFile(LPCWSTR fileName);
+BOOL GetFileAttributesEx(LPCWSTR fileName, GET_FILEEX_INFO_LEVELS infoLevel, void* fileInformation);
+HANDLE CreateFile(LPCWSTR fileName, DWORD desiredAccess, DWORD shareMode, void* securityAttributes,
+	DWORD creationDisposition, DWORD flagsAndAttributes, HANDLE templateFile);
+BOOL GetFileSizeEx(HANDLE file, LARGE_INTEGER* fileSize);
+BOOL ReadFile(HANDLE file, void* buffer, DWORD numberOfBytesToRead, DWORD* numberOfBytesRead, void* overlapped);
+HANDLE CreateFileMapping(HANDLE file, void* attributes, DWORD protect, DWORD maximumSizeHigh, DWORD maximumSizeLow, LPCWSTR name);
+void* MapViewOfFile(HANDLE fileMapping, DWORD desiredAccess, DWORD fileOffsetHigh, DWORD fileOffsetLow, size_t numberOfBytesToMap);
+BOOL UnmapViewOfFile(const void* baseAddress);
+
+// System information.
+typedef enum _COMPUTER_NAME_FORMAT
+{
+	ComputerNameNetBIOS,
+	ComputerNameDnsHostname,
+	ComputerNameDnsDomain,
+	ComputerNameDnsFullyQualified,
+	ComputerNamePhysicalNetBIOS,
+	ComputerNamePhysicalDnsHostname,
+	ComputerNamePhysicalDnsDomain,
+	ComputerNamePhysicalDnsFullyQualified,
+} COMPUTER_NAME_FORMAT;
+
+BOOL GetComputerNameEx(COMPUTER_NAME_FORMAT nameType, wchar_t* buffer, DWORD* size);
+unsigned int GetSystemDirectoryW(wchar_t* buffer, unsigned int size);
+DWORD GetModuleFileName(HANDLE module, wchar_t* fileName, DWORD size);
+
+// Registry.
+#define HKEY_CLASSES_ROOT ((HKEY)(uintptr_t)0x80000000)
+#define HKEY_CURRENT_USER ((HKEY)(uintptr_t)0x80000001)
+#define HKEY_LOCAL_MACHINE ((HKEY)(uintptr_t)0x80000002)
+
+#define REG_NONE 0
+#define REG_SZ 1
+#define REG_DWORD 4
+#define RRF_RT_REG_SZ 0x00000002
+#define RRF_RT_REG_DWORD 0x00000010
+#define RRF_RT_ANY 0x0000ffff
+#define RRF_NOEXPAND 0x10000000
+#define REG_OPTION_NON_VOLATILE 0x00000000
+#define REG_NOTIFY_CHANGE_NAME 0x00000001
+#define REG_NOTIFY_CHANGE_LAST_SET 0x00000004
+#define REG_CREATED_NEW_KEY 0x00000001
+#define REG_OPENED_EXISTING_KEY 0x00000002
+#define KEY_QUERY_VALUE 0x0001
+#define KEY_SET_VALUE 0x0002
+#define KEY_NOTIFY 0x0010
+#define KEY_READ 0x20019
+#define KEY_WRITE 0x20006
+#define KEY_ALL_ACCESS 0xF003F
+
+LSTATUS RegCreateKeyEx(HKEY key, LPCWSTR subKey, DWORD reserved, LPWSTR keyClass, DWORD options, REGSAM desiredAccess, void* securityAttributes, PHKEY result, DWORD* disposition);
+LSTATUS RegOpenKey(HKEY key, LPCWSTR subKey, PHKEY result);
+LSTATUS RegOpenKeyEx(HKEY key, LPCWSTR subKey, DWORD options, REGSAM desiredAccess, PHKEY result);
+LSTATUS RegCloseKey(HKEY key);
+LSTATUS RegSetValueEx(HKEY key, LPCWSTR valueName, DWORD reserved, DWORD type, const BYTE* data, DWORD dataSize);
+LSTATUS RegSetKeyValue(HKEY key, LPCWSTR subKey, LPCWSTR valueName, DWORD type, const void* data, DWORD dataSize);
+LSTATUS RegGetValue(HKEY key, LPCWSTR subKey, LPCWSTR valueName, DWORD flags, DWORD* type, void* data, DWORD* dataSize);
+LSTATUS RegQueryValueEx(HKEY key, LPCWSTR valueName, DWORD* reserved, DWORD* type, BYTE* data, DWORD* dataSize);
+LSTATUS RegDeleteKeyValue(HKEY key, LPCWSTR subKey, LPCWSTR valueName);
+LSTATUS RegDeleteValue(HKEY key, LPCWSTR valueName);
+LSTATUS RegNotifyChangeKeyValue(HKEY key, BOOL watchSubtree, DWORD notifyFilter, HANDLE event, BOOL asynchronous);
+
+// Service control manager.
+#define SERVICES_ACTIVE_DATABASE L"ServicesActive"
+#define SC_MANAGER_CONNECT 0x0001
+#define SC_MANAGER_ALL_ACCESS 0xF003F
+#define SERVICE_QUERY_CONFIG 0x0001
+#define SERVICE_CHANGE_CONFIG 0x0002
+#define SERVICE_QUERY_STATUS 0x0004
+#define SERVICE_START 0x0010
+#define SERVICE_STOP 0x0020
+#define SERVICE_USER_DEFINED_CONTROL 0x0100
+#define SERVICE_ALL_ACCESS 0xF01FF
+
+#define SERVICE_STOPPED 0x00000001
+#define SERVICE_START_PENDING 0x00000002
+#define SERVICE_STOP_PENDING 0x00000003
+#define SERVICE_RUNNING 0x00000004
+
+#define SERVICE_CONTROL_STOP 0x00000001
+#define SERVICE_CONTROL_INTERROGATE 0x00000004
+#define SERVICE_CONTROL_SHUTDOWN 0x00000005
+
+#define SERVICE_BOOT_START 0x00000000
+#define SERVICE_SYSTEM_START 0x00000001
+#define SERVICE_AUTO_START 0x00000002
+#define SERVICE_DEMAND_START 0x00000003
+#define SERVICE_DISABLED 0x00000004
+#define SERVICE_NO_CHANGE 0xffffffff
+
+typedef struct _SERVICE_STATUS
+{
+	DWORD dwServiceType;
+	DWORD dwCurrentState;
+	DWORD dwControlsAccepted;
+	DWORD dwWin32ExitCode;
+	DWORD dwServiceSpecificExitCode;
+	DWORD dwCheckPoint;
+	DWORD dwWaitHint;
+} SERVICE_STATUS;
+
+typedef struct _QUERY_SERVICE_CONFIG
+{
+	DWORD dwServiceType;
+	DWORD dwStartType;
+	DWORD dwErrorControl;
+	LPWSTR lpBinaryPathName;
+	LPWSTR lpLoadOrderGroup;
+	DWORD dwTagId;
+	LPWSTR lpDependencies;
+	LPWSTR lpServiceStartName;
+	LPWSTR lpDisplayName;
+} QUERY_SERVICE_CONFIG;
+
+SC_HANDLE OpenSCManager(LPCWSTR machineName, LPCWSTR databaseName, DWORD desiredAccess);
+SC_HANDLE OpenService(SC_HANDLE serviceManager, LPCWSTR serviceName, DWORD desiredAccess);
+BOOL CloseServiceHandle(SC_HANDLE service);
+BOOL QueryServiceStatus(SC_HANDLE service, SERVICE_STATUS* serviceStatus);
+BOOL QueryServiceConfig(SC_HANDLE service, QUERY_SERVICE_CONFIG* serviceConfig, DWORD bufferSize, DWORD* bytesNeeded);
+BOOL StartService(SC_HANDLE service, DWORD argumentCount, LPCWSTR* arguments);
+BOOL ControlService(SC_HANDLE service, DWORD control, SERVICE_STATUS* serviceStatus);
+BOOL ChangeServiceConfig(SC_HANDLE service, DWORD serviceType, DWORD startType, DWORD errorControl,
+	LPCWSTR binaryPathName, LPCWSTR loadOrderGroup, DWORD* tagId, LPCWSTR dependencies,
+	LPCWSTR serviceStartName, LPCWSTR password, LPCWSTR displayName);
+
+// RPC.
+typedef long RPC_STATUS;
+RPC_STATUS RpcBindingFree(RPC_BINDING_HANDLE* binding);